@@ -14,7 +14,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
-#include <search.h>
 #include <assert.h>
 
 #include "uthash.h"
@@ -22,18 +21,19 @@
 #include "darshan.h"
 
 int darshan_add_record_ref(void **hash_head_p, void *handle, size_t handle_sz,
-    void *rec_ref_p)
+    void *rec_ref_p, darshan_module_id mod_id)
 {
     struct darshan_record_ref_tracker *ref_tracker;
     struct darshan_record_ref_tracker *ref_tracker_head =
         *(struct darshan_record_ref_tracker **)hash_head_p;
     void *handle_p;
 
-    /* allocate a reference tracker, with room to store the handle at the end */
-    ref_tracker = malloc(sizeof(*ref_tracker) + handle_sz);
+    /* allocate a reference tracker from the module's arena, with room to
+     * store the handle at the end
+     */
+    ref_tracker = darshan_core_arena_alloc(mod_id, sizeof(*ref_tracker) + handle_sz);
     if(!ref_tracker)
         return(0);
-    memset(ref_tracker, 0, sizeof(*ref_tracker) + handle_sz);
 
     /* initialize the reference tracker and add it to the hash table */
     ref_tracker->rec_ref_p = rec_ref_p;
@@ -60,7 +60,7 @@ void *darshan_delete_record_ref(void **hash_head_p, void *handle, size_t handle_
     HASH_DELETE(hlink, ref_tracker_head, ref_tracker);
     *hash_head_p = ref_tracker_head;
     rec_ref_p = ref_tracker->rec_ref_p;
-    free(ref_tracker);
+    darshan_core_arena_free(ref_tracker);
 
     return(rec_ref_p);
 }
@@ -76,8 +76,8 @@ void darshan_clear_record_refs(void **hash_head_p, int free_flag)
     {
         HASH_DELETE(hlink, ref_tracker_head, ref_tracker);
         if(free_flag)
-            free(ref_tracker->rec_ref_p);
-        free(ref_tracker);
+            darshan_core_arena_free(ref_tracker->rec_ref_p);
+        darshan_core_arena_free(ref_tracker);
     }
     *hash_head_p = ref_tracker_head;
 
@@ -194,58 +194,144 @@ void darshan_record_sort(void *rec_buf, int rec_count, int rec_size)
     return;
 }
 
-static int darshan_common_vals_compare(const void *a_p, const void *b_p)
+struct darshan_common_val_counter *darshan_track_common_val_counters(
+    struct darshan_common_val_table *common_val_table, int64_t *vals, int nvals)
 {
-    const struct darshan_common_val_counter* a = a_p;
-    const struct darshan_common_val_counter* b = b_p;
+    struct darshan_common_val_counter *counter;
+    uint64_t hash = 0;
+    unsigned int slot;
+    int ndx;
+    int i;
+
+    assert(nvals <= DARSHAN_COMMON_VAL_MAX_NCOUNTERS);
+
+    /* multiplicative hash over the set of values */
+    for(i = 0; i < nvals; i++)
+        hash = (hash ^ (uint64_t)vals[i]) * 0x9E3779B97F4A7C15ULL;
+    slot = (unsigned int)(hash >> 32) & (DARSHAN_COMMON_VAL_TABLE_SLOTS - 1);
+
+    /* linear probe until we find this val or an empty slot; the table is
+     * never more than half full, so an empty slot is always found
+     */
+    while((ndx = common_val_table->slots[slot]) != 0)
+    {
+        counter = &common_val_table->counters[ndx - 1];
+        if(counter->nvals == nvals &&
+            !memcmp(counter->vals, vals, sizeof(*vals) * nvals))
+        {
+            counter->freq++;
+            return(counter);
+        }
+        slot = (slot + 1) & (DARSHAN_COMMON_VAL_TABLE_SLOTS - 1);
+    }
+
+    /* we can add a new one as long as we haven't hit the limit */
+    if(common_val_table->count >= DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT)
+        return(NULL);
+
+    counter = &common_val_table->counters[common_val_table->count];
+    memcpy(counter->vals, vals, sizeof(*vals) * nvals);
+    counter->nvals = nvals;
+    counter->freq = 1;
+    common_val_table->slots[slot] = ++common_val_table->count;
 
-    return(memcmp(a->vals, b->vals, sizeof(*(a->vals)) * a->nvals));
+    return(counter);
 }
 
-struct darshan_common_val_counter *darshan_track_common_val_counters(
-    void **common_val_root, int64_t *vals, int nvals, int *common_val_count)
+static struct darshan_path_trie *darshan_path_trie_node(char c)
 {
-    struct darshan_common_val_counter* counter;
-    struct darshan_common_val_counter* found = NULL;
-    struct darshan_common_val_counter tmp_counter;
-    void* tmp;
+    struct darshan_path_trie *node;
 
-    assert(nvals <= DARSHAN_COMMON_VAL_MAX_NCOUNTERS);
+    node = calloc(1, sizeof(*node));
+    if(node)
+    {
+        node->c = c;
+        node->value = -1;
+    }
+
+    return(node);
+}
+
+int darshan_path_trie_insert(struct darshan_path_trie **trie_p,
+    const char *prefix, int flags, int value)
+{
+    struct darshan_path_trie *node, *child;
 
-    /* check to see if this val is already recorded */
-    memcpy(tmp_counter.vals, vals, sizeof(*vals) * nvals);
-    tmp_counter.nvals = nvals;
-    tmp_counter.freq = 1;
-    tmp = tfind(&tmp_counter, common_val_root, darshan_common_vals_compare);
-    if(tmp)
+    if(!*trie_p)
     {
-        found = *(struct darshan_common_val_counter**)tmp;
-        found->freq++;
+        *trie_p = darshan_path_trie_node('\0');
+        if(!*trie_p)
+            return(-1);
     }
-    else if(*common_val_count < DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT)
+
+    node = *trie_p;
+    for(; *prefix; prefix++)
     {
-        /* we can add a new one as long as we haven't hit the limit */
-        counter = malloc(sizeof(*counter));
-        if(!counter)
+        for(child = node->child; child; child = child->sibling)
+        {
+            if(child->c == *prefix)
+                break;
+        }
+        if(!child)
         {
-            return(NULL);
+            child = darshan_path_trie_node(*prefix);
+            if(!child)
+                return(-1);
+            child->sibling = node->child;
+            node->child = child;
         }
+        node = child;
+    }
 
-        memcpy(counter->vals, vals, sizeof(*vals) * nvals);
-        counter->nvals = nvals;
-        counter->freq = 1;
+    node->flags |= flags;
+    if(node->value == -1)
+        node->value = value;
 
-        tmp = tsearch(counter, common_val_root, darshan_common_vals_compare);
-        found = *(struct darshan_common_val_counter**)tmp;
-        /* if we get a new answer out here we are in trouble; this was
-         * already checked with the tfind()
-         */
-        assert(found == counter);
+    return(0);
+}
 
-        (*common_val_count)++;
+int darshan_path_trie_match(struct darshan_path_trie *trie, const char *path,
+    int *flags)
+{
+    struct darshan_path_trie *node = trie;
+    int value = -1;
+
+    *flags = 0;
+    if(!path)
+        return(-1);
+
+    while(node)
+    {
+        *flags |= node->flags;
+        if(node->value != -1)
+            value = node->value;
+        if(!*path)
+            break;
+
+        for(node = node->child; node; node = node->sibling)
+        {
+            if(node->c == *path)
+                break;
+        }
+        path++;
     }
 
-    return(found);
+    return(value);
+}
+
+void darshan_path_trie_destroy(struct darshan_path_trie *trie)
+{
+    struct darshan_path_trie *next;
+
+    while(trie)
+    {
+        darshan_path_trie_destroy(trie->child);
+        next = trie->sibling;
+        free(trie);
+        trie = next;
+    }
+
+    return;
 }
 
 #ifdef HAVE_MPI
@@ -269,6 +355,205 @@ void darshan_variance_reduce(void *invec, void *inoutvec, int *len,
 
     return;
 }
+
+static int darshan_partial_record_compare(const void *a_p, const void *b_p)
+{
+    const struct darshan_partial_shared_rec *a = a_p;
+    const struct darshan_partial_shared_rec *b = b_p;
+
+    if(a->id > b->id)
+        return(1);
+    if(a->id < b->id)
+        return(-1);
+
+    return(0);
+}
+
+/* sort partially shared records by the process that reduces them */
+static int darshan_partial_record_root_compare(const void *a_p, const void *b_p)
+{
+    const struct darshan_partial_shared_rec *a = a_p;
+    const struct darshan_partial_shared_rec *b = b_p;
+
+    if(a->root > b->root)
+        return(1);
+    if(a->root < b->root)
+        return(-1);
+
+    return(darshan_partial_record_compare(a_p, b_p));
+}
+
+static int darshan_base_record_id_compare(const void *a_p, const void *b_p)
+{
+    const struct darshan_base_record *a = a_p;
+    const struct darshan_base_record *b = b_p;
+
+    if(a->id > b->id)
+        return(1);
+    if(a->id < b->id)
+        return(-1);
+
+    return(0);
+}
+
+struct darshan_partial_shared_rec *darshan_partial_record_lookup(
+    struct darshan_partial_shared_rec *partial_recs, int partial_rec_count,
+    darshan_record_id id)
+{
+    struct darshan_partial_shared_rec key;
+
+    key.id = id;
+    return(bsearch(&key, partial_recs, partial_rec_count,
+        sizeof(*partial_recs), darshan_partial_record_compare));
+}
+
+int darshan_partial_record_exchange(MPI_Comm comm, int tag, void *rec_buf,
+    int *inout_rec_count, int rec_size,
+    struct darshan_partial_shared_rec *partial_recs, int partial_rec_count,
+    void **recv_recs, int *recv_rec_count)
+{
+    char *recs = rec_buf;
+    char *send_buf = NULL, *recv_buf = NULL, *drain_buf;
+    struct darshan_base_record *base_rec;
+    struct darshan_partial_shared_rec *partial_rec;
+    struct darshan_partial_shared_rec *sends = NULL;
+    MPI_Request *reqs = NULL;
+    MPI_Status status;
+    int send_cnt = 0, recv_cnt = 0, recv_bytes;
+    int nreqs = 0;
+    int rec_count = *inout_rec_count;
+    int rank;
+    int ret = 0;
+    int i, j;
+
+    PMPI_Comm_rank(comm, &rank);
+
+    /* sort records so that every process lists them in the same order */
+    darshan_record_sort(rec_buf, rec_count, rec_size);
+
+    /* count records to send elsewhere and to receive from others */
+    for(i = 0; i < partial_rec_count; i++)
+    {
+        if(partial_recs[i].root == rank)
+            recv_cnt += partial_recs[i].rank_count - 1;
+        else
+            send_cnt++;
+    }
+
+    if(send_cnt > 0)
+    {
+        sends = malloc(send_cnt * sizeof(*sends));
+        send_buf = malloc(send_cnt * rec_size);
+        reqs = malloc(send_cnt * sizeof(*reqs));
+        if(!sends || !send_buf || !reqs)
+        {
+            /* keep our records rank-local, and send an empty message in
+             * place of each one so the processes reducing them do not wait
+             */
+            for(i = 0; i < partial_rec_count; i++)
+            {
+                if(partial_recs[i].root != rank)
+                    PMPI_Send(NULL, 0, MPI_BYTE, partial_recs[i].root, tag,
+                        comm);
+            }
+            send_cnt = 0;
+        }
+    }
+
+    if(send_cnt > 0)
+    {
+        /* group records to send by destination, and drop them locally */
+        for(i = 0, j = 0; i < partial_rec_count; i++)
+        {
+            if(partial_recs[i].root != rank)
+                sends[j++] = partial_recs[i];
+        }
+        qsort(sends, send_cnt, sizeof(*sends), darshan_partial_record_root_compare);
+        for(i = 0, j = 0; i < rec_count; i++)
+        {
+            base_rec = (struct darshan_base_record *)(recs + (i * rec_size));
+            if(base_rec->rank >= 0)
+            {
+                partial_rec = darshan_partial_record_lookup(partial_recs,
+                    partial_rec_count, base_rec->id);
+                if(partial_rec && (partial_rec->root != rank))
+                {
+                    partial_rec = bsearch(partial_rec, sends, send_cnt,
+                        sizeof(*sends), darshan_partial_record_root_compare);
+                    memcpy(send_buf + ((partial_rec - sends) * rec_size),
+                        base_rec, rec_size);
+                    continue;
+                }
+            }
+            if(i != j)
+                memmove(recs + (j * rec_size), base_rec, rec_size);
+            j++;
+        }
+        assert(rec_count - j == send_cnt);
+        *inout_rec_count = j;
+
+        /* send one message to each destination */
+        for(i = 0, j = 0; i < send_cnt; i = j)
+        {
+            while(j < send_cnt && sends[j].root == sends[i].root)
+                j++;
+            PMPI_Isend(send_buf + (i * rec_size), (j - i) * rec_size, MPI_BYTE,
+                sends[i].root, tag, comm, &reqs[nreqs++]);
+        }
+    }
+
+    /* receive copies of the records we reduce, in any order; an empty
+     * message stands for a record its sender kept rank-local
+     */
+    if(recv_cnt > 0)
+    {
+        recv_buf = malloc(recv_cnt * rec_size);
+        if(!recv_buf)
+            ret = -1;
+    }
+    for(i = 0, j = 0; i < recv_cnt; )
+    {
+        PMPI_Probe(MPI_ANY_SOURCE, tag, comm, &status);
+        PMPI_Get_count(&status, MPI_BYTE, &recv_bytes);
+        if(recv_bytes > 0 && recv_buf)
+        {
+            PMPI_Recv(recv_buf + (j * rec_size), recv_bytes, MPI_BYTE,
+                status.MPI_SOURCE, tag, comm, MPI_STATUS_IGNORE);
+            j += recv_bytes / rec_size;
+        }
+        else if(recv_bytes > 0)
+        {
+            /* no room to keep the records; receive and drop them so that
+             * their sender can complete (or stop waiting for the rest if
+             * even that is not possible)
+             */
+            drain_buf = malloc(recv_bytes);
+            if(!drain_buf)
+                break;
+            PMPI_Recv(drain_buf, recv_bytes, MPI_BYTE, status.MPI_SOURCE,
+                tag, comm, MPI_STATUS_IGNORE);
+            free(drain_buf);
+        }
+        else
+        {
+            PMPI_Recv(NULL, 0, MPI_BYTE, status.MPI_SOURCE, tag, comm,
+                MPI_STATUS_IGNORE);
+            recv_bytes = rec_size;
+        }
+        i += recv_bytes / rec_size;
+    }
+    if(j > 0)
+        qsort(recv_buf, j, rec_size, darshan_base_record_id_compare);
+
+    PMPI_Waitall(nreqs, reqs, MPI_STATUSES_IGNORE);
+
+    free(sends);
+    free(send_buf);
+    free(reqs);
+    *recv_recs = recv_buf;
+    *recv_rec_count = j;
+    return(ret);
+}
 #endif
 
 /*
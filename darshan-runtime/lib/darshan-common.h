@@ -142,6 +142,40 @@ struct darshan_common_val_counter
     int freq;
 };
 
+/* number of hash slots in a common value table (must be a power of 2 and
+ * larger than DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT)
+ */
+#define DARSHAN_COMMON_VAL_TABLE_SLOTS 64
+#if DARSHAN_COMMON_VAL_TABLE_SLOTS <= DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT
+#error "DARSHAN_COMMON_VAL_TABLE_SLOTS must exceed DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT"
+#endif
+
+/* fixed-capacity open-addressing hash table of common value counters,
+ * meant to be embedded directly in a module's record reference structure.
+ * 'slots' holds the (1-based) index of the counter hashed to each slot, or
+ * 0 if the slot is empty, so a zero-initialized table is ready for use.
+ */
+struct darshan_common_val_table
+{
+    int count;
+    uint8_t slots[DARSHAN_COMMON_VAL_TABLE_SLOTS];
+    struct darshan_common_val_counter counters[DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT];
+};
+
+/* node of a prefix trie over path strings.  Each node corresponds to the
+ * prefix spelled by the characters on the way to it from the root (which
+ * stands for the empty prefix); the children of a node are kept in a
+ * sibling list, as path prefix sets branch very little.
+ */
+struct darshan_path_trie
+{
+    char c;     /* last character of this node's prefix */
+    int flags;  /* bitwise OR of the flags of prefixes ending here */
+    int value;  /* value of the prefix ending here, or -1 */
+    struct darshan_path_trie *child;
+    struct darshan_path_trie *sibling;
+};
+
 /* i/o type (read or write) */
 enum darshan_io_type
 {
@@ -195,6 +229,8 @@ static inline void *darshan_lookup_record_ref(void *hash_head, void *handle, siz
  * Add the given record reference pointer, 'rec_ref_p' to the hash
  * table whose address is stored in the 'hash_head_p' pointer. The
  * hash is generated from the given 'handle', with size 'handle_sz'.
+ * The reference tracker is allocated from the arena of the module
+ * identified by 'mod_id'.
  * If the record reference is successfully added, 1 is returned,
  * otherwise, 0 is returned.
  */
@@ -202,7 +238,8 @@ int darshan_add_record_ref(
     void **hash_head_p,
     void *handle,
     size_t handle_sz,
-    void *rec_ref_p);
+    void *rec_ref_p,
+    darshan_module_id mod_id);
 
 /* darshan_delete_record_ref()
  *
@@ -221,7 +258,7 @@ void *darshan_delete_record_ref(
  *
  * Clear all record references from the hash table stored in the
  * 'hash_head_p' pointer. If 'free_flag' is set, the corresponding
- * record_reference_pointer is also freed.
+ * record reference pointer is also returned to its module arena.
  */
 void darshan_clear_record_refs(
     void **hash_head_p,
@@ -268,21 +305,51 @@ void darshan_record_sort(
 
 /* darshan_track_common_val_counters()
  *
- * Potentially increment an existing common value counter or allocate
+ * Potentially increment an existing common value counter or add
  * a new one to keep track of commonly occuring values. Example use
  * cases would be to track the most frequent access sizes or strides
- * used by a specific module, for instance. 'common_val_root' is the
- * root pointer for the tree which stores common value info,
- * 'common_val_count' is a pointer to the number of nodes in the
- * tree (i.e., the number of allocated common value counters), 'vals'
- * is the set of new values to attempt to add, and 'nvals' is the
- * total number of values in the 'vals' pointer.
+ * used by a specific module, for instance. 'common_val_table' is the
+ * table which stores common value info, 'vals' is the set of new values
+ * to attempt to add, and 'nvals' is the total number of values in the
+ * 'vals' pointer. Returns the updated counter, or NULL if the value is
+ * not already tracked and the table is full. No memory is allocated.
  */
 struct darshan_common_val_counter *darshan_track_common_val_counters(
-    void **common_val_root,
+    struct darshan_common_val_table *common_val_table,
     int64_t *vals,
-    int nvals,
-    int *common_val_count);
+    int nvals);
+
+/* darshan_path_trie_insert()
+ *
+ * Add 'prefix' to the prefix trie pointed to by 'trie_p', creating the
+ * trie if '*trie_p' is NULL. 'flags' are OR'd into any flags already set
+ * for the prefix, and 'value' (if not -1) is only stored if the prefix
+ * has no value yet. Returns 0 on success, -1 on memory allocation failure.
+ */
+int darshan_path_trie_insert(
+    struct darshan_path_trie **trie_p,
+    const char *prefix,
+    int flags,
+    int value);
+
+/* darshan_path_trie_match()
+ *
+ * Match 'path' against all prefixes in 'trie' in a single pass over the
+ * path. Returns the value of the longest matching prefix that has one
+ * (-1 if none do), and sets 'flags' to the bitwise OR of the flags of all
+ * matching prefixes.
+ */
+int darshan_path_trie_match(
+    struct darshan_path_trie *trie,
+    const char *path,
+    int *flags);
+
+/* darshan_path_trie_destroy()
+ *
+ * Free all memory associated with the given prefix trie.
+ */
+void darshan_path_trie_destroy(
+    struct darshan_path_trie *trie);
 
 #ifdef HAVE_MPI
 /* darshan_variance_reduce()
@@ -301,6 +368,47 @@ void darshan_variance_reduce(
     void *inoutvec,
     int *len,
     MPI_Datatype *dt);
+
+/* darshan_partial_record_lookup()
+ *
+ * Find the record with identifier 'id' in the 'partial_recs' array of
+ * 'partial_rec_count' partially shared records (sorted by record id).
+ * Returns NULL if the record is not partially shared.
+ */
+struct darshan_partial_shared_rec *darshan_partial_record_lookup(
+    struct darshan_partial_shared_rec *partial_recs,
+    int partial_rec_count,
+    darshan_record_id id);
+
+/* darshan_partial_record_exchange()
+ *
+ * Send records shared by a subset of processes (given in 'partial_recs')
+ * to the lowest ranked process that opened them, so they can be reduced
+ * there. 'rec_buf' holds '*inout_rec_count' fixed-length records of size
+ * 'rec_size'; on output it is sorted as by darshan_record_sort(), records
+ * sent to other processes are dropped from it, and '*inout_rec_count' is
+ * updated. The records received from other processes are returned in
+ * '*recv_recs' (to be freed by the caller) sorted by record id, with their
+ * count in '*recv_rec_count'. 'tag' must be unique to the calling module.
+ * If a process cannot allocate memory to send its records, it keeps them
+ * in 'rec_buf' (rank-local) and the receiving processes reduce the records
+ * of the other processes only. Returns 0 on success, or -1 if this process
+ * could not allocate memory to receive records from others, in which case
+ * those records are dropped and the records it would have reduced should be
+ * left rank-local.
+ * NOTE: this only uses point-to-point communication on 'comm', so only
+ * processes that opened partially shared records need to call it.
+ */
+int darshan_partial_record_exchange(
+    MPI_Comm comm,
+    int tag,
+    void *rec_buf,
+    int *inout_rec_count,
+    int rec_size,
+    struct darshan_partial_shared_rec *partial_recs,
+    int partial_rec_count,
+    void **recv_recs,
+    int *recv_rec_count);
 #endif
 
 #endif /* __DARSHAN_COMMON_H */
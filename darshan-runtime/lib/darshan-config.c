@@ -79,6 +79,54 @@ static uint64_t darshan_module_csv_to_flags(char *mod_csv)
     return(mod_flags);
 }
 
+/* helper to find the length of the literal prefix shared by all names
+ * matching an anchored regex, so that names can be checked against it
+ * before evaluating the regex
+ */
+static size_t darshan_regex_prefix_len(const char *regex_str)
+{
+    size_t len = 0;
+
+    /* unanchored regexes and alternations have no common prefix */
+    if(regex_str[0] != '^' || strchr(regex_str, '|'))
+        return(0);
+
+    regex_str++;
+    while(regex_str[len] && !strchr(".[]()*+?{}\\^$", regex_str[len]))
+        len++;
+    /* the last literal character is optional if followed by these quantifiers */
+    if(len && regex_str[len] && strchr("*?{", regex_str[len]))
+        len--;
+
+    return(len);
+}
+
+/* helper to convert a compression method name to a log compression type */
+static void darshan_comp_str_to_type(char *comp_str,
+    enum darshan_comp_type *comp_type)
+{
+    if(!comp_str)
+        return;
+
+    if(strcmp(comp_str, "zlib") == 0)
+        *comp_type = DARSHAN_ZLIB_COMP;
+    else if(strcmp(comp_str, "zstd") == 0)
+    {
+#ifdef HAVE_LIBZSTD
+        *comp_type = DARSHAN_ZSTD_COMP;
+#else
+        darshan_core_fprintf(stderr, "darshan library warning: "\
+            "zstd compression not supported by this build, using zlib\n");
+        *comp_type = DARSHAN_ZLIB_COMP;
+#endif
+    }
+    else
+        darshan_core_fprintf(stderr, "darshan library warning: "\
+            "unknown compression method \"%s\" in Darshan config\n", comp_str);
+
+    return;
+}
+
 void darshan_init_config(struct darshan_config *cfg)
 {
     cfg->mod_mem = DARSHAN_MOD_MEM_MAX;
@@ -92,6 +140,7 @@ void darshan_init_config(struct darshan_config *cfg)
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
     cfg->mmap_log_path = strdup(DARSHAN_DEF_MMAP_LOG_PATH);
 #endif
+    cfg->snapshot_path = strdup(DARSHAN_DEF_SNAPSHOT_PATH);
     /* enable all modules except DXT by default */
     DARSHAN_MOD_FLAG_SET(cfg->mod_disabled, DXT_POSIX_MOD);
     DARSHAN_MOD_FLAG_SET(cfg->mod_disabled, DXT_MPIIO_MOD);
@@ -114,6 +163,9 @@ void darshan_init_config(struct darshan_config *cfg)
 #ifndef DARSHAN_USE_APMPI
     DARSHAN_MOD_FLAG_SET(cfg->mod_disabled, DARSHAN_APMPI_MOD);
 #endif
+    cfg->comp_type = DARSHAN_ZLIB_COMP;
+    cfg->comp_threads = 1;
+    cfg->comp_level = DARSHAN_DEF_COMP_LEVEL;
     cfg->exclude_dirs = darshan_path_exclusions;
     cfg->include_dirs = darshan_path_inclusions;
 
@@ -223,6 +275,13 @@ void darshan_parse_config_env(struct darshan_config *cfg)
         cfg->mmap_log_path = strdup(envstr);
     }
 #endif
+    /* allow override of Darshan's snapshot log directory */
+    envstr = getenv(DARSHAN_SNAPSHOT_PATH_OVERRIDE);
+    if(envstr)
+    {
+        free(cfg->snapshot_path);
+        cfg->snapshot_path = strdup(envstr);
+    }
     /* allow override of Darshan's default directory exclusions */
     envstr = getenv("DARSHAN_EXCLUDE_DIRS");
     if(envstr)
@@ -298,6 +357,7 @@ void darshan_parse_config_env(struct darshan_config *cfg)
                     free(regex);
                     continue;
                 }
+                regex->prefix_len = darshan_regex_prefix_len(token);
                 ret = regcomp(&regex->regex, token, REG_EXTENDED);
                 if(!ret)
                 {
@@ -333,6 +393,7 @@ void darshan_parse_config_env(struct darshan_config *cfg)
                     free(regex);
                     continue;
                 }
+                regex->prefix_len = darshan_regex_prefix_len(token);
                 ret = regcomp(&regex->regex, token, REG_EXTENDED);
                 if(!ret)
                 {
@@ -448,6 +509,69 @@ void darshan_parse_config_env(struct darshan_config *cfg)
         cfg->internal_timing_flag = 1;
     if(getenv("DARSHAN_DISABLE_SHARED_REDUCTION"))
         cfg->disable_shared_redux_flag = 1;
+    envstr = getenv("DARSHAN_PARTIAL_SHARED_REDUCTION");
+    if(envstr)
+    {
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, int, cfg->partial_shared_redux, success);
+        if(!success || cfg->partial_shared_redux < 2)
+            cfg->partial_shared_redux = 0;
+    }
+    if(getenv("DARSHAN_POSIX_THREAD_CACHE"))
+        cfg->posix_thread_cache_flag = 1;
+    if(getenv("DARSHAN_HEATMAP_THREAD_BINS"))
+        cfg->heatmap_thread_bins_flag = 1;
+    envstr = getenv("DARSHAN_HEATMAP_BINS");
+    if(envstr)
+    {
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, int, cfg->heatmap_nbins, success);
+        if(!success || cfg->heatmap_nbins < 0)
+            cfg->heatmap_nbins = 0;
+    }
+    envstr = getenv("DARSHAN_HEATMAP_MIN_BIN_WIDTH");
+    if(envstr)
+    {
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, cfg->heatmap_min_bin_width, success);
+        if(!success || cfg->heatmap_min_bin_width < 0)
+            cfg->heatmap_min_bin_width = 0;
+    }
+    envstr = getenv("DARSHAN_HEATMAP_PER_FILE");
+    if(envstr)
+    {
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, int, cfg->heatmap_per_file, success);
+        if(!success || cfg->heatmap_per_file < 0)
+            cfg->heatmap_per_file = 0;
+    }
+    if(getenv("DARSHAN_RECORD_INDEX"))
+        cfg->rec_index_flag = 1;
+    envstr = getenv("DARSHAN_COMP_THREADS");
+    if(envstr)
+    {
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, int, cfg->comp_threads, success);
+        if(cfg->comp_threads < 1)
+            cfg->comp_threads = 1;
+    }
+    envstr = getenv("DARSHAN_COMP_LEVEL");
+    if(envstr)
+    {
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, int, cfg->comp_level, success);
+        if(!success || cfg->comp_level < -1 || cfg->comp_level > DARSHAN_MAX_COMP_LEVEL)
+            cfg->comp_level = DARSHAN_DEF_COMP_LEVEL;
+    }
+    darshan_comp_str_to_type(getenv("DARSHAN_COMP_TYPE"), &cfg->comp_type);
+    envstr = getenv("DARSHAN_LOG_AGGREGATORS");
+    if(envstr)
+    {
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, int, cfg->log_aggregators, success);
+        if(!success || cfg->log_aggregators < 0)
+            cfg->log_aggregators = 0;
+    }
+    envstr = getenv("DARSHAN_SNAPSHOT_INTERVAL");
+    if(envstr)
+    {
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, int, cfg->snapshot_interval, success);
+        if(!success || cfg->snapshot_interval < 0)
+            cfg->snapshot_interval = 0;
+    }
 
     /* apply disabled/enabled module flags */
     cfg->mod_disabled |= cfg->mod_disabled_flags;
@@ -565,6 +689,15 @@ void darshan_parse_config_file(struct darshan_config *cfg)
                 }
             }
 #endif
+            else if(strcmp(key, "SNAPSHOT_PATH") == 0)
+            {
+                val = strtok(NULL, " \t");
+                if(val)
+                {
+                    free(cfg->snapshot_path);
+                    cfg->snapshot_path = strdup(val);
+                }
+            }
             else if(strcmp(key, "APP_EXCLUDE") == 0)
             {
                 val = strtok(NULL, " \t");
@@ -581,6 +714,7 @@ void darshan_parse_config_file(struct darshan_config *cfg)
                             free(regex);
                             break;
                         }
+                        regex->prefix_len = darshan_regex_prefix_len(token);
                         ret = regcomp(&regex->regex, token, REG_EXTENDED);
                         if(!ret)
                         {
@@ -614,6 +748,7 @@ void darshan_parse_config_file(struct darshan_config *cfg)
                             free(regex);
                             break;
                         }
+                        regex->prefix_len = darshan_regex_prefix_len(token);
                         ret = regcomp(&regex->regex, token, REG_EXTENDED);
                         if(!ret)
                         {
@@ -730,6 +865,7 @@ void darshan_parse_config_file(struct darshan_config *cfg)
                                 break;
                             }
                             regex->mod_flags = tmp_mod_flags;
+                            regex->prefix_len = darshan_regex_prefix_len(token);
                             ret = regcomp(&regex->regex, token, REG_EXTENDED);
                             if(!ret)
                             {
@@ -769,6 +905,7 @@ void darshan_parse_config_file(struct darshan_config *cfg)
                                 break;
                             }
                             regex->mod_flags = tmp_mod_flags;
+                            regex->prefix_len = darshan_regex_prefix_len(token);
                             ret = regcomp(&regex->regex, token, REG_EXTENDED);
                             if(!ret)
                             {
@@ -829,6 +966,73 @@ void darshan_parse_config_file(struct darshan_config *cfg)
                 cfg->internal_timing_flag = 1;
             else if(strcmp(key, "DISABLE_SHARED_REDUCTION") == 0)
                 cfg->disable_shared_redux_flag = 1;
+            else if(strcmp(key, "PARTIAL_SHARED_REDUCTION") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, int, cfg->partial_shared_redux, success);
+                if(!success || cfg->partial_shared_redux < 2)
+                    cfg->partial_shared_redux = 0;
+            }
+            else if(strcmp(key, "POSIX_THREAD_CACHE") == 0)
+                cfg->posix_thread_cache_flag = 1;
+            else if(strcmp(key, "HEATMAP_THREAD_BINS") == 0)
+                cfg->heatmap_thread_bins_flag = 1;
+            else if(strcmp(key, "HEATMAP_BINS") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, int, cfg->heatmap_nbins, success);
+                if(!success || cfg->heatmap_nbins < 0)
+                    cfg->heatmap_nbins = 0;
+            }
+            else if(strcmp(key, "HEATMAP_MIN_BIN_WIDTH") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, double, cfg->heatmap_min_bin_width, success);
+                if(!success || cfg->heatmap_min_bin_width < 0)
+                    cfg->heatmap_min_bin_width = 0;
+            }
+            else if(strcmp(key, "HEATMAP_PER_FILE") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, int, cfg->heatmap_per_file, success);
+                if(!success || cfg->heatmap_per_file < 0)
+                    cfg->heatmap_per_file = 0;
+            }
+            else if(strcmp(key, "RECORD_INDEX") == 0)
+                cfg->rec_index_flag = 1;
+            else if(strcmp(key, "COMP_THREADS") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, int, cfg->comp_threads, success);
+                if(cfg->comp_threads < 1)
+                    cfg->comp_threads = 1;
+            }
+            else if(strcmp(key, "COMP_LEVEL") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, int, cfg->comp_level, success);
+                if(!success || cfg->comp_level < -1 || cfg->comp_level > DARSHAN_MAX_COMP_LEVEL)
+                    cfg->comp_level = DARSHAN_DEF_COMP_LEVEL;
+            }
+            else if(strcmp(key, "COMP_TYPE") == 0)
+            {
+                val = strtok(NULL, " \t");
+                darshan_comp_str_to_type(val, &cfg->comp_type);
+            }
+            else if(strcmp(key, "LOG_AGGREGATORS") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, int, cfg->log_aggregators, success);
+                if(!success || cfg->log_aggregators < 0)
+                    cfg->log_aggregators = 0;
+            }
+            else if(strcmp(key, "SNAPSHOT_INTERVAL") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, int, cfg->snapshot_interval, success);
+                if(!success || cfg->snapshot_interval < 0)
+                    cfg->snapshot_interval = 0;
+            }
             else
             {
                 darshan_core_fprintf(stderr, "darshan library warning: "\
@@ -859,6 +1063,13 @@ void darshan_dump_config(struct darshan_config *cfg)
     fprintf(stderr, "# MODMEM = %ld MiB\n", cfg->mod_mem / 1024 / 1024);
     fprintf(stderr, "# NAMEMEM = %ld KiB\n", cfg->name_mem / 1024);
     fprintf(stderr, "# MEM_ALIGNMENT = %d bytes\n", cfg->mem_alignment);
+    fprintf(stderr, "# COMP_TYPE = %s\n",
+        (cfg->comp_type == DARSHAN_ZSTD_COMP) ? "zstd" : "zlib");
+    fprintf(stderr, "# COMP_THREADS = %d\n", cfg->comp_threads);
+    fprintf(stderr, "# COMP_LEVEL = %d\n", cfg->comp_level);
+    fprintf(stderr, "# LOG_AGGREGATORS = %d\n", cfg->log_aggregators);
+    fprintf(stderr, "# RECORD_INDEX = %s\n", cfg->rec_index_flag ? "yes" : "no");
+    fprintf(stderr, "# PARTIAL_SHARED_REDUCTION = %d\n", cfg->partial_shared_redux);
     fprintf(stderr, "# JOBID = %s\n", cfg->jobid_env);
     fprintf(stderr, "# LOGHINTS = %s\n", (strlen(cfg->log_hints) > 0) ?
         cfg->log_hints : "NONE");
@@ -868,6 +1079,8 @@ void darshan_dump_config(struct darshan_config *cfg)
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
     fprintf(stderr, "# MMAP_LOGPATH = %s\n", cfg->mmap_log_path);
 #endif
+    fprintf(stderr, "# SNAPSHOT_INTERVAL = %d s\n", cfg->snapshot_interval);
+    fprintf(stderr, "# SNAPSHOT_PATH = %s\n", cfg->snapshot_path);
     fprintf(stderr, "# EXCLUDE_DIRS = ");
     if(!cfg->user_exclude_dirs)
         path_exclusions = cfg->exclude_dirs;
@@ -937,6 +1150,17 @@ void darshan_dump_config(struct darshan_config *cfg)
         if(cfg->mod_max_records_override[i] > 0)
             fprintf(stderr, "#      - MAX_RECORDS = %lu\n",
                 cfg->mod_max_records_override[i]);
+        if(i == DARSHAN_POSIX_MOD && cfg->posix_thread_cache_flag)
+            fprintf(stderr, "#      - THREAD_CACHE = ENABLED\n");
+        if(i == DARSHAN_HEATMAP_MOD && cfg->heatmap_thread_bins_flag)
+            fprintf(stderr, "#      - THREAD_BINS = ENABLED\n");
+        if(i == DARSHAN_HEATMAP_MOD && cfg->heatmap_nbins > 0)
+            fprintf(stderr, "#      - BINS = %d\n", cfg->heatmap_nbins);
+        if(i == DARSHAN_HEATMAP_MOD && cfg->heatmap_min_bin_width > 0)
+            fprintf(stderr, "#      - MIN_BIN_WIDTH = %.6lf\n",
+                cfg->heatmap_min_bin_width);
+        if(i == DARSHAN_HEATMAP_MOD && cfg->heatmap_per_file > 0)
+            fprintf(stderr, "#      - PER_FILE = %d\n", cfg->heatmap_per_file);
         if(cfg->rec_exclusion_list)
         {
             first = 1;
@@ -991,6 +1215,7 @@ void darshan_free_config(
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
     free(cfg->mmap_log_path);
 #endif
+    free(cfg->snapshot_path);
     if(cfg->user_exclude_dirs)
     {   while((path = cfg->user_exclude_dirs[tmp_index++]))
             free(path);
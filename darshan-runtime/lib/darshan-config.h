@@ -22,6 +22,8 @@ struct darshan_config
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
     char *mmap_log_path;
 #endif
+    char *snapshot_path;
+    int snapshot_interval;
     uint64_t mod_disabled_flags;
     uint64_t mod_enabled_flags;
     uint64_t mod_disabled;
@@ -39,6 +41,17 @@ struct darshan_config
     struct dxt_trigger *unaligned_io_trigger;
     int internal_timing_flag;
     int disable_shared_redux_flag;
+    int partial_shared_redux;
+    int posix_thread_cache_flag;
+    int heatmap_thread_bins_flag;
+    int heatmap_nbins;
+    double heatmap_min_bin_width;
+    int heatmap_per_file;
+    enum darshan_comp_type comp_type;
+    int comp_threads;
+    int comp_level;
+    int log_aggregators;
+    int rec_index_flag;
     int dump_config_flag;
 };
 
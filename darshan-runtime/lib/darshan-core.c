@@ -30,9 +30,14 @@
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <sys/vfs.h>
+#include <sys/syscall.h>
+#include <signal.h>
 #include <ctype.h>
 #include <regex.h>
 #include <zlib.h>
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
 #include <errno.h>
 #include <assert.h>
 
@@ -72,6 +77,88 @@ static int parent_pid;
 static struct darshan_core_mnt_data mnt_data_array[DARSHAN_MAX_MNTS];
 static int mnt_data_count = 0;
 
+/* per-module arenas used to allocate module runtime structures; these are
+ * kept outside of the core runtime structure so that modules can return
+ * memory to them during their cleanup, after the core has been torn down.
+ * Each arena has its own lock for allocations and frees; the global arena
+ * lock only serializes creating and releasing the arenas.
+ */
+#define DARSHAN_ARENA_SLAB_SIZE (64*1024)
+#define DARSHAN_ARENA_SMALL_MAX 256
+#define DARSHAN_ARENA_NCLASSES 22 /* 16 B steps up to 256 B, then powers of 2 up to 16 KiB */
+#define DARSHAN_ARENA_LARGE_CLASS DARSHAN_ARENA_NCLASSES
+struct darshan_core_arena_slab
+{
+    struct darshan_core_arena_slab *next;
+    size_t size; /* also pads slab header to 16 bytes */
+};
+struct darshan_core_arena_hdr
+{
+    uint32_t size;
+    uint16_t mod_id;
+    uint16_t size_class;
+    uint64_t pad; /* keep allocations 16-byte aligned */
+};
+struct darshan_core_arena
+{
+    pthread_mutex_t mutex;
+    int created;
+    struct darshan_core_arena_slab *slabs;
+    char *slab_cur;
+    size_t slab_avail;
+    void *free_lists[DARSHAN_ARENA_NCLASSES];
+    size_t reserved_bytes;
+    size_t used_bytes;
+    size_t peak_used_bytes;
+    uint64_t nallocs;
+};
+static struct darshan_core_arena darshan_core_arenas[DARSHAN_KNOWN_MODULE_COUNT];
+static pthread_mutex_t darshan_core_arena_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* periodic snapshot logs: each log region is split into chunks that are
+ * compressed independently, and the compressed data of a chunk is reused
+ * by later snapshots for as long as its contents are unchanged
+ */
+struct darshan_snapshot_chunk
+{
+    uint64_t hash; /* hash of the uncompressed chunk data */
+    int uncomp_len;
+    int comp_len;
+    char *comp_buf;
+};
+struct darshan_snapshot_region
+{
+    struct darshan_snapshot_chunk *chunks;
+    int nchunks;
+    int chunk_alloc;
+};
+/* region 0 holds the name records, region i+1 the data of module i */
+#define DARSHAN_SNAPSHOT_NREGIONS (DARSHAN_KNOWN_MODULE_COUNT + 1)
+static struct
+{
+    int running;
+    int stop;
+    int pid;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int seq;
+    char path[__DARSHAN_PATH_MAX];
+    /* name records are front coded in the order they were registered, so
+     * the encoding only grows as new names are registered
+     */
+    char *name_enc_buf;
+    size_t name_enc_len;
+    size_t name_enc_size;
+    size_t name_mem_done;
+    const char *prev_name;
+    struct darshan_snapshot_region regions[DARSHAN_SNAPSHOT_NREGIONS];
+    char *comp_buf;
+} darshan_snapshot = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
 #ifdef DARSHAN_BGQ
 extern void bgq_runtime_initialize();
 #endif
@@ -114,8 +201,10 @@ static int darshan_should_instrument_app(
     struct darshan_core_runtime *core);
 static int darshan_should_instrument_rank(
     struct darshan_core_runtime *core);
-static void darshan_fs_info_from_path(
-    const char *path, struct darshan_fs_info *fs_info);
+static int darshan_build_path_trie(
+    struct darshan_core_runtime *core);
+static void darshan_fs_info_from_mnt(
+    int mnt_idx, struct darshan_fs_info *fs_info);
 static int darshan_update_name_record_ref(
     struct darshan_core_runtime *core, darshan_record_id rec_id,
     const char *name, darshan_module_id mod_id);
@@ -124,7 +213,8 @@ static void darshan_get_user_name(
 #ifdef HAVE_MPI
 static void darshan_get_shared_records(
     struct darshan_core_runtime *core, darshan_record_id **shared_recs,
-    int *shared_rec_cnt);
+    int *shared_rec_cnt, darshan_record_id **partial_recs,
+    int *partial_rec_cnt);
 #endif
 static void darshan_get_logfile_name(
     char* logfile_name, struct darshan_core_runtime* core);
@@ -141,17 +231,57 @@ static int darshan_log_write_header(
     darshan_core_log_fh log_fh, struct darshan_core_runtime *core);
 static int darshan_log_append(
     darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
-    void *buf, int count, uint64_t *inout_off);
+    int region_id, void *buf, int count, uint64_t *inout_off);
+static int darshan_encode_name_record(
+    char *enc_p, const char *prev_name, struct darshan_name_record *name_rec);
+static int darshan_log_write_index(
+    darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
+    void *index, int count, int entry_size,
+    int (*compare)(const void *, const void *), struct darshan_log_map *map_p,
+    uint64_t *inout_off);
+static void darshan_add_chunks(
+    struct darshan_core_runtime *core, int region_id, uint64_t off,
+    int *chunk_lens, int nchunks, int uncomp_len);
+static int darshan_log_chunk_compare(
+    const void *a_p, const void *b_p);
+static void darshan_add_rec_index(
+    struct darshan_core_runtime *core, int region_id, uint64_t off,
+    int len, int uncomp_len);
+static int darshan_log_rec_index_compare(
+    const void *a_p, const void *b_p);
+#ifdef HAVE_MPI
+static void darshan_log_stage(
+    struct darshan_core_runtime *core, int region_id, int len);
+static int darshan_log_write_aggregated(
+    darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
+    uint64_t *inout_off);
+#endif
 void darshan_log_close(
     darshan_core_log_fh log_fh);
 void darshan_log_finalize(
     char *logfile_name, double start_log_time);
 static int darshan_deflate_buffer(
     void **pointers, int *lengths, int count, char *comp_buf,
-    int *comp_buf_length);
+    int *comp_buf_length, int comp_type, int comp_level);
+#ifdef HAVE_LIBZSTD
+static int darshan_zstd_buffer(
+    void **pointers, int *lengths, int count, char *comp_buf,
+    int *comp_buf_length, int comp_level);
+#endif
+static int darshan_deflate_buffer_chunked(
+    char *buf, int length, char *comp_buf, int *comp_buf_length,
+    int *chunk_lengths, int comp_type, int comp_level, int nthreads);
 static void darshan_core_cleanup(
     struct darshan_core_runtime* core);
+static void darshan_core_arena_create_all(
+    void);
+static void darshan_core_arena_release_all(
+    void);
 static void darshan_core_fork_child_cb(void);
+static void darshan_core_snapshot_start(
+    struct darshan_core_runtime *core, int jobid);
+static void darshan_core_snapshot_stop(
+    void);
 #ifdef HAVE_MPI
 static void darshan_core_reduce_min_time(
     void* in_time_v, void* inout_time_v,
@@ -305,6 +435,7 @@ void darshan_core_initialize(int argc, char **argv)
         init_core->log_hdr_p->comp_type = DARSHAN_NO_COMP;
         init_core->log_hdr_p->name_map.off =
             ((char *)init_core->log_name_p - (char *)init_core->log_hdr_p);
+        init_core->log_hdr_p->name_enc = DARSHAN_NAME_ENC_PLAIN;
 #endif
 
         /* set known header fields for the log file */
@@ -327,6 +458,15 @@ void darshan_core_initialize(int argc, char **argv)
         /* collect information about command line and mounted file systems */
         darshan_get_exe_and_mounts(init_core, argc, argv);
 
+        if(darshan_build_path_trie(init_core) < 0)
+        {
+#ifdef __DARSHAN_ENABLE_MMAP_LOGS
+            unlink(init_core->mmap_log_name);
+#endif
+            darshan_core_cleanup(init_core);
+            return;
+        }
+
         if(!darshan_should_instrument_app(init_core))
         {
             /* do not instrument excluded applications */
@@ -353,16 +493,16 @@ void darshan_core_initialize(int argc, char **argv)
             pthread_atfork(NULL, NULL, &darshan_core_fork_child_cb);
         }
 
-#ifdef HAVE_LDMS
         /* check if user turns on LDMS -- pass init_core to darshan-ldms connector initialization*/
         if (getenv("DARSHAN_LDMS_ENABLE"))
             darshan_ldms_connector_initialize(init_core);
-#endif
 
         /* if darshan was successfully initialized, set the global pointer
          * and record absolute start time so that we can later generate
          * relative times with this as a reference point.
          */
+        darshan_core_arena_create_all();
+
         __DARSHAN_CORE_LOCK();
         __darshan_core = init_core;
         __darshan_core_wtime_offset = init_start;
@@ -375,6 +515,10 @@ void darshan_core_initialize(int argc, char **argv)
             (*mod_static_init_fns[i])();
             i++;
         }
+
+        /* start writing periodic snapshot logs, if requested */
+        if(init_core->config.snapshot_interval > 0)
+            darshan_core_snapshot_start(init_core, jobid);
     }
 
     if(__darshan_core->config.internal_timing_flag)
@@ -416,9 +560,11 @@ void darshan_core_shutdown(int write_log)
     double mod1[DARSHAN_KNOWN_MODULE_COUNT] = {0};
     double mod2[DARSHAN_KNOWN_MODULE_COUNT] = {0};
     double header1 = 0, header2 = 0;
+    double agg1 = 0, agg2 = 0;
     double tm_end;
     int active_mods[DARSHAN_KNOWN_MODULE_COUNT] = {0};
     uint64_t gz_fp = 0;
+    int agg_write = 0;
     char *logfile_name = NULL;
     darshan_core_log_fh log_fh;
     int log_created = 0;
@@ -432,8 +578,19 @@ void darshan_core_shutdown(int write_log)
     darshan_record_id *shared_recs = NULL;
     darshan_record_id *mod_shared_recs = NULL;
     int shared_rec_cnt = 0;
+    darshan_record_id *partial_recs = NULL;
+    struct darshan_partial_shared_rec *mod_partial_recs = NULL;
+    int partial_rec_cnt = 0;
 #endif
 
+    /* publish any buffered LDMS connector events while darshan-core can
+     * still resolve their record names
+     */
+    darshan_ldms_connector_shutdown();
+
+    /* stop taking snapshots, which read darshan-core state */
+    darshan_core_snapshot_stop();
+
     /* disable darhan-core while we shutdown */
     __DARSHAN_CORE_LOCK();
     if(!__darshan_core)
@@ -525,10 +682,12 @@ void darshan_core_shutdown(int write_log)
         PMPI_Op_free(&ts_max_op);
 
         /* get a list of records which are shared across all processes */
-        darshan_get_shared_records(final_core, &shared_recs, &shared_rec_cnt);
+        darshan_get_shared_records(final_core, &shared_recs, &shared_rec_cnt,
+            &partial_recs, &partial_rec_cnt);
 
         mod_shared_recs = malloc(shared_rec_cnt * sizeof(darshan_record_id));
-        assert(mod_shared_recs);
+        mod_partial_recs = malloc(partial_rec_cnt * sizeof(*mod_partial_recs));
+        assert(mod_shared_recs && mod_partial_recs);
     }
 #endif
 
@@ -575,7 +734,14 @@ void darshan_core_shutdown(int write_log)
     if(internal_timing_flag)
         job2 = darshan_core_wtime_absolute();
     /* error out if unable to write job information */
-    DARSHAN_CHECK_ERR(ret, "unable to write job record to file %s", logfile_name);
+    /* NOTE: aggregated log writes defer all error checks until the staged
+     * log data is written, to avoid a collective for each log region
+     */
+#ifdef HAVE_MPI
+    agg_write = using_mpi && (final_core->config.log_aggregators > 0);
+#endif
+    if(!agg_write)
+        DARSHAN_CHECK_ERR(ret, "unable to write job record to file %s", logfile_name);
 
     if(internal_timing_flag)
         rec1 = darshan_core_wtime_absolute();
@@ -586,7 +752,8 @@ void darshan_core_shutdown(int write_log)
         rec2 = darshan_core_wtime_absolute();
     final_core->log_hdr_p->name_map.len = gz_fp - final_core->log_hdr_p->name_map.off;
     /* error out if unable to write name records */
-    DARSHAN_CHECK_ERR(ret, "unable to write name records to log file %s", logfile_name);
+    if(!agg_write)
+        DARSHAN_CHECK_ERR(ret, "unable to write name records to log file %s", logfile_name);
 
     /* give DXT module a chance to filter trace records according to user config */
     if(final_core->config.small_io_trigger)
@@ -658,6 +825,35 @@ void darshan_core_shutdown(int write_log)
                             mod_shared_recs, mod_shared_rec_cnt);
                     }
                 }
+
+                /* set the list of records this module shares with a subset
+                 * of processes
+                 */
+                mod_shared_rec_cnt = 0;
+                for(j = 0; j < partial_rec_cnt; j++)
+                {
+                    HASH_FIND(hlink, final_core->name_hash, &partial_recs[j],
+                        sizeof(darshan_record_id), ref);
+                    assert(ref);
+
+                    if(DARSHAN_MOD_FLAG_ISSET(ref->partial_mod_flags, i))
+                    {
+                        mod_partial_recs[mod_shared_rec_cnt].id = partial_recs[j];
+                        mod_partial_recs[mod_shared_rec_cnt].root = ref->min_rank;
+                        mod_partial_recs[mod_shared_rec_cnt].rank_count =
+                            ref->shared_rank_count;
+                        mod_shared_rec_cnt++;
+                    }
+                }
+
+                /* allow the module to reduce files shared by a subset of
+                 * processes onto the lowest rank that opened them
+                 */
+                if(this_mod->mod_funcs.mod_partial_redux_func && (mod_shared_rec_cnt > 0))
+                {
+                    this_mod->mod_funcs.mod_partial_redux_func(mod_buf,
+                        final_core->mpi_comm, mod_partial_recs, mod_shared_rec_cnt);
+                }
             }
 #endif
 
@@ -667,7 +863,7 @@ void darshan_core_shutdown(int write_log)
 
         /* append this module's data to the darshan log */
         final_core->log_hdr_p->mod_map[i].off = gz_fp;
-        ret = darshan_log_append(log_fh, final_core, mod_buf, mod_buf_sz, &gz_fp);
+        ret = darshan_log_append(log_fh, final_core, i, mod_buf, mod_buf_sz, &gz_fp);
         final_core->log_hdr_p->mod_map[i].len =
             gz_fp - final_core->log_hdr_p->mod_map[i].off;
 
@@ -675,8 +871,46 @@ void darshan_core_shutdown(int write_log)
             mod2[i] = darshan_core_wtime_absolute();
 
         /* error out if unable to write module data */
-        DARSHAN_CHECK_ERR(ret, "unable to write %s module data to log file %s",
-            darshan_module_names[i], logfile_name);
+        if(!agg_write)
+            DARSHAN_CHECK_ERR(ret, "unable to write %s module data to log file %s",
+                darshan_module_names[i], logfile_name);
+    }
+
+#ifdef HAVE_MPI
+    /* write all staged log data if using aggregated log writes */
+    if(agg_write)
+    {
+        if(internal_timing_flag)
+            agg1 = darshan_core_wtime_absolute();
+        ret = darshan_log_write_aggregated(log_fh, final_core, &gz_fp);
+        if(internal_timing_flag)
+            agg2 = darshan_core_wtime_absolute();
+        DARSHAN_CHECK_ERR(ret, "unable to write log data to file %s", logfile_name);
+    }
+#endif
+
+    /* write an index of compressed chunks if log data was compressed in
+     * chunks by multiple threads
+     */
+    if(final_core->config.comp_threads > 1)
+    {
+        ret = darshan_log_write_index(log_fh, final_core, final_core->chunk_index,
+            final_core->chunk_count, sizeof(struct darshan_log_chunk),
+            darshan_log_chunk_compare, &final_core->log_hdr_p->chunk_map,
+            &gz_fp);
+        DARSHAN_CHECK_ERR(ret, "unable to write chunk index to log file %s",
+            logfile_name);
+    }
+
+    /* write an index of each process's module data, if requested */
+    if(final_core->config.rec_index_flag)
+    {
+        ret = darshan_log_write_index(log_fh, final_core, final_core->rec_index,
+            final_core->rec_index_count, sizeof(struct darshan_log_rec_index),
+            darshan_log_rec_index_compare, &final_core->log_hdr_p->rec_index_map,
+            &gz_fp);
+        DARSHAN_CHECK_ERR(ret, "unable to write record index to log file %s",
+            logfile_name);
     }
 
     if(internal_timing_flag)
@@ -698,15 +932,27 @@ void darshan_core_shutdown(int write_log)
         double header_tm;
         double job_tm;
         double rec_tm;
+        double agg_tm;
         double mod_tm[DARSHAN_KNOWN_MODULE_COUNT];
         double all_tm;
+        unsigned long long arena_mem[2*DARSHAN_KNOWN_MODULE_COUNT];
 
         tm_end = darshan_core_wtime_absolute();
 
+        /* reserved and peak in-use arena memory for each module */
+        for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+        {
+            pthread_mutex_lock(&darshan_core_arenas[i].mutex);
+            arena_mem[2*i] = darshan_core_arenas[i].reserved_bytes;
+            arena_mem[2*i+1] = darshan_core_arenas[i].peak_used_bytes;
+            pthread_mutex_unlock(&darshan_core_arenas[i].mutex);
+        }
+
         open_tm = open2 - open1;
         header_tm = header2 - header1;
         job_tm = job2 - job1;
         rec_tm = rec2 - rec1;
+        agg_tm = agg2 - agg1;
         all_tm = tm_end - start_log_time;
         for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
         {
@@ -724,12 +970,16 @@ void darshan_core_shutdown(int write_log)
                     MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
                 PMPI_Reduce(MPI_IN_PLACE, &job_tm, 1,
                     MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
+                PMPI_Reduce(MPI_IN_PLACE, &agg_tm, 1,
+                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
                 PMPI_Reduce(MPI_IN_PLACE, &rec_tm, 1,
                     MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
                 PMPI_Reduce(MPI_IN_PLACE, &all_tm, 1,
                     MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
                 PMPI_Reduce(MPI_IN_PLACE, mod_tm, DARSHAN_KNOWN_MODULE_COUNT,
                     MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
+                PMPI_Reduce(MPI_IN_PLACE, arena_mem, 2*DARSHAN_KNOWN_MODULE_COUNT,
+                    MPI_UNSIGNED_LONG_LONG, MPI_MAX, 0, final_core->mpi_comm);
             }
             else
             {
@@ -739,12 +989,16 @@ void darshan_core_shutdown(int write_log)
                     MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
                 PMPI_Reduce(&job_tm, &job_tm, 1,
                     MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
+                PMPI_Reduce(&agg_tm, &agg_tm, 1,
+                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
                 PMPI_Reduce(&rec_tm, &rec_tm, 1,
                     MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
                 PMPI_Reduce(&all_tm, &all_tm, 1,
                     MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
                 PMPI_Reduce(mod_tm, mod_tm, DARSHAN_KNOWN_MODULE_COUNT,
                     MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
+                PMPI_Reduce(arena_mem, arena_mem, 2*DARSHAN_KNOWN_MODULE_COUNT,
+                    MPI_UNSIGNED_LONG_LONG, MPI_MAX, 0, final_core->mpi_comm);
 
                 /* let rank 0 report the timing info */
                 goto cleanup;
@@ -757,6 +1011,8 @@ void darshan_core_shutdown(int write_log)
         darshan_core_fprintf(stderr, "darshan:job_write\t%d\t%f\n", nprocs, job_tm);
         darshan_core_fprintf(stderr, "darshan:hash_write\t%d\t%f\n", nprocs, rec_tm);
         darshan_core_fprintf(stderr, "darshan:header_write\t%d\t%f\n", nprocs, header_tm);
+        if(agg_write)
+            darshan_core_fprintf(stderr, "darshan:aggregated_write\t%d\t%f\n", nprocs, agg_tm);
         for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
         {
             if(active_mods[i])
@@ -764,6 +1020,14 @@ void darshan_core_shutdown(int write_log)
                     darshan_module_names[i], nprocs, mod_tm[i]);
         }
         darshan_core_fprintf(stderr, "darshan:core_shutdown\t%d\t%f\n", nprocs, all_tm);
+        darshan_core_fprintf(stderr, "#darshan:<module>_arena\t<nprocs>\t<reserved KiB>\t<peak used KiB>\n");
+        for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+        {
+            if(arena_mem[2*i])
+                darshan_core_fprintf(stderr, "darshan:%s_arena\t%d\t%.1f\t%.1f\n",
+                    darshan_module_names[i], nprocs, arena_mem[2*i] / 1024.0,
+                    arena_mem[2*i+1] / 1024.0);
+        }
     }
 
 cleanup:
@@ -776,6 +1040,8 @@ cleanup:
     {
         free(shared_recs);
         free(mod_shared_recs);
+        free(partial_recs);
+        free(mod_partial_recs);
     }
 #endif
     free(logfile_name);
@@ -1283,20 +1549,54 @@ static int darshan_should_instrument_rank(struct darshan_core_runtime *core)
     return(1);
 }
 
-static void darshan_fs_info_from_path(const char *path, struct darshan_fs_info *fs_info)
+/* flags of the path prefixes in the core's path trie */
+#define DARSHAN_PATH_EXCLUDED 1
+#define DARSHAN_PATH_INCLUDED 2
+
+/* builds a prefix trie over the mount points and the path exclusions and
+ * inclusions, so that each new record name can be matched against all of
+ * them in a single pass over the name
+ */
+static int darshan_build_path_trie(struct darshan_core_runtime *core)
 {
+    char **path_exclusions;
+    int tmp_index = 0;
     int i;
-    fs_info->fs_type = -1;
-    fs_info->block_size = -1;
+    int ret = 0;
+
+    /* mount points are sorted from longest to shortest path, so inserting
+     * them in order keeps the first of any mount points with the same path
+     */
+    for(i = 0; i < mnt_data_count && ret == 0; i++)
+        ret = darshan_path_trie_insert(&core->path_trie,
+            mnt_data_array[i].path, 0, i);
 
-    for(i=0; i<mnt_data_count; i++)
+    /* if user has set DARSHAN_EXCLUDE_DIRS, override the default exclusions
+     * and ignore the default inclusions
+     */
+    path_exclusions = core->config.user_exclude_dirs;
+    if(!path_exclusions)
     {
-        if(!(strncmp(mnt_data_array[i].path, path, strlen(mnt_data_array[i].path))))
-        {
-            *fs_info = mnt_data_array[i].fs_info;
-            return;
-        }
+        path_exclusions = core->config.exclude_dirs;
+        while(core->config.include_dirs[tmp_index] && ret == 0)
+            ret = darshan_path_trie_insert(&core->path_trie,
+                core->config.include_dirs[tmp_index++], DARSHAN_PATH_INCLUDED, -1);
     }
+    tmp_index = 0;
+    while(path_exclusions[tmp_index] && ret == 0)
+        ret = darshan_path_trie_insert(&core->path_trie,
+            path_exclusions[tmp_index++], DARSHAN_PATH_EXCLUDED, -1);
+
+    return(ret);
+}
+
+static void darshan_fs_info_from_mnt(int mnt_idx, struct darshan_fs_info *fs_info)
+{
+    fs_info->fs_type = -1;
+    fs_info->block_size = -1;
+
+    if(mnt_idx >= 0)
+        *fs_info = mnt_data_array[mnt_idx].fs_info;
 
     return;
 }
@@ -1436,82 +1736,215 @@ static void darshan_get_user_name(char *cuser)
 }
 
 #ifdef HAVE_MPI
-static void darshan_get_shared_records(struct darshan_core_runtime *core,
-    darshan_record_id **shared_recs, int *shared_rec_cnt)
+/* a record id and the modules that accessed it, sent to the record's owner */
+struct darshan_shared_rec_query
 {
-    int i, j;
-    int tmp_cnt = HASH_CNT(hlink, core->name_hash);
-    struct darshan_core_name_record_ref *tmp, *ref;
-    darshan_record_id *id_array;
-    uint64_t *mod_flags;
-    uint64_t *global_mod_flags;
+    darshan_record_id id;
+    uint64_t mod_flags;
+};
 
-    /* broadcast root's number of records to all other processes */
-    PMPI_Bcast(&tmp_cnt, 1, MPI_INT, 0, core->mpi_comm);
+/* the owner's answer: modules that accessed the record on every process
+ * (0 if not globally shared), modules to reduce over the subset of
+ * processes that opened it (0 if none), how many processes opened it, and
+ * the lowest rank among them
+ */
+struct darshan_shared_rec_reply
+{
+    uint64_t global_mod_flags;
+    uint64_t partial_mod_flags;
+    int64_t rank_count;
+    int64_t min_rank;
+};
 
-    /* use root record count to allocate data structures */
-    id_array = malloc(tmp_cnt * sizeof(darshan_record_id));
-    mod_flags = malloc(tmp_cnt * sizeof(uint64_t));
-    global_mod_flags = malloc(tmp_cnt * sizeof(uint64_t));
-    *shared_recs = malloc(tmp_cnt * sizeof(darshan_record_id));
-    assert(id_array && mod_flags && global_mod_flags && *shared_recs);
+struct darshan_shared_rec_count
+{
+    darshan_record_id id;
+    uint64_t mod_flags;
+    int64_t rank_count;
+    int64_t min_rank;
+    UT_hash_handle hlink;
+};
 
-    memset(mod_flags, 0, tmp_cnt * sizeof(uint64_t));
-    memset(global_mod_flags, 0, tmp_cnt * sizeof(uint64_t));
-    memset(*shared_recs, 0, tmp_cnt * sizeof(darshan_record_id));
+static int darshan_record_id_compare(const void *a_p, const void *b_p)
+{
+    darshan_record_id a = *(const darshan_record_id *)a_p;
+    darshan_record_id b = *(const darshan_record_id *)b_p;
 
-    /* first, determine list of records root process has opened */
-    if(my_rank == 0)
+    if(a < b) return(-1);
+    if(a > b) return(1);
+    return(0);
+}
+
+/* determine which records were opened by every process. Each record id is
+ * assigned to an owner process by hash, every process sends its records to
+ * their owners, and owners count how many processes opened each record.
+ * Every process learns the rank count of each of its records, so records
+ * shared by only a subset of processes can be identified as well. If
+ * partial shared reductions are enabled, such records are marked for
+ * reduction onto the lowest rank that opened them.
+ */
+static void darshan_get_shared_records(struct darshan_core_runtime *core,
+    darshan_record_id **shared_recs, int *shared_rec_cnt,
+    darshan_record_id **partial_recs, int *partial_rec_cnt)
+{
+    int i, j, k;
+    int local_cnt = HASH_CNT(hlink, core->name_hash);
+    int min_partial = core->config.partial_shared_redux;
+    int recv_cnt;
+    struct darshan_core_name_record_ref *tmp, *ref;
+    struct darshan_core_name_record_ref **send_refs;
+    struct darshan_shared_rec_query *send_buf, *recv_buf;
+    struct darshan_shared_rec_reply *reply_send_buf, *reply_recv_buf;
+    struct darshan_shared_rec_count *counts = NULL, *count, *tmp_count;
+    struct darshan_shared_rec_count *count_array;
+    int *send_counts, *send_displs, *recv_counts, *recv_displs;
+    int *offsets;
+
+    send_counts = calloc(nprocs, sizeof(*send_counts));
+    send_displs = malloc(nprocs * sizeof(*send_displs));
+    recv_counts = malloc(nprocs * sizeof(*recv_counts));
+    recv_displs = malloc(nprocs * sizeof(*recv_displs));
+    offsets = malloc(nprocs * sizeof(*offsets));
+    send_buf = malloc(local_cnt * sizeof(*send_buf));
+    send_refs = malloc(local_cnt * sizeof(*send_refs));
+    reply_recv_buf = malloc(local_cnt * sizeof(*reply_recv_buf));
+    *shared_recs = malloc(local_cnt * sizeof(darshan_record_id));
+    *partial_recs = malloc(local_cnt * sizeof(darshan_record_id));
+    assert(send_counts && send_displs && recv_counts && recv_displs &&
+        offsets && send_buf && send_refs && reply_recv_buf && *shared_recs &&
+        *partial_recs);
+
+    /* sort local records by owner */
+    HASH_ITER(hlink, core->name_hash, ref, tmp)
     {
-        i = 0;
-        HASH_ITER(hlink, core->name_hash, ref, tmp)
-        {
-            id_array[i++] = ref->name_record->id;
-        }
+        send_counts[ref->name_record->id % nprocs]++;
+    }
+    for(i = 0, j = 0; i < nprocs; i++)
+    {
+        send_displs[i] = offsets[i] = j;
+        j += send_counts[i];
+    }
+    HASH_ITER(hlink, core->name_hash, ref, tmp)
+    {
+        j = offsets[ref->name_record->id % nprocs]++;
+        send_buf[j].id = ref->name_record->id;
+        send_buf[j].mod_flags = ref->mod_flags;
+        send_refs[j] = ref;
     }
 
-    /* broadcast root's list of records to all other processes */
-    PMPI_Bcast(id_array, (tmp_cnt * sizeof(darshan_record_id)),
-        MPI_BYTE, 0, core->mpi_comm);
+    /* exchange records with their owners; counts are exchanged in entries,
+     * then scaled to bytes for the MPI_BYTE Alltoallv below
+     */
+    PMPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT,
+        core->mpi_comm);
+    for(i = 0, recv_cnt = 0; i < nprocs; i++)
+    {
+        recv_displs[i] = recv_cnt;
+        recv_cnt += recv_counts[i];
+    }
+    recv_buf = malloc(recv_cnt * sizeof(*recv_buf));
+    reply_send_buf = malloc(recv_cnt * sizeof(*reply_send_buf));
+    count_array = malloc(recv_cnt * sizeof(*count_array));
+    assert(recv_buf && reply_send_buf && count_array);
+    for(i = 0; i < nprocs; i++)
+    {
+        send_counts[i] *= sizeof(*send_buf);
+        send_displs[i] *= sizeof(*send_buf);
+        recv_counts[i] *= sizeof(*send_buf);
+        recv_displs[i] *= sizeof(*send_buf);
+    }
+    PMPI_Alltoallv(send_buf, send_counts, send_displs, MPI_BYTE,
+        recv_buf, recv_counts, recv_displs, MPI_BYTE, core->mpi_comm);
 
-    /* everyone looks to see if they opened the same records as root */
-    for(i=0; i<tmp_cnt; i++)
+    /* count the processes that opened each record we own, and the modules
+     * that accessed it on all of them
+     */
+    for(k = 0, j = 0; k < nprocs; k++)
     {
-        HASH_FIND(hlink, core->name_hash, &id_array[i], sizeof(darshan_record_id), ref);
-        if(ref)
+        /* records received from rank k */
+        for(i = recv_displs[k] / sizeof(*send_buf);
+            i < (recv_displs[k] + recv_counts[k]) / sizeof(*send_buf); i++)
         {
-            /* we opened that record too, save the mod_flags */
-            mod_flags[i] = ref->mod_flags;
+            HASH_FIND(hlink, counts, &recv_buf[i].id, sizeof(darshan_record_id), count);
+            if(!count)
+            {
+                count = &count_array[j++];
+                count->id = recv_buf[i].id;
+                count->mod_flags = recv_buf[i].mod_flags;
+                count->rank_count = 0;
+                count->min_rank = k;
+                HASH_ADD(hlink, counts, id, sizeof(darshan_record_id), count);
+            }
+            count->mod_flags &= recv_buf[i].mod_flags;
+            count->rank_count++;
         }
     }
+    for(i = 0; i < recv_cnt; i++)
+    {
+        HASH_FIND(hlink, counts, &recv_buf[i].id, sizeof(darshan_record_id), count);
+        reply_send_buf[i].rank_count = count->rank_count;
+        reply_send_buf[i].min_rank = count->min_rank;
+        reply_send_buf[i].global_mod_flags =
+            (count->rank_count == nprocs) ? count->mod_flags : 0;
+        reply_send_buf[i].partial_mod_flags =
+            (min_partial && count->rank_count >= min_partial &&
+             count->rank_count < nprocs) ? count->mod_flags : 0;
+    }
+    HASH_ITER(hlink, counts, count, tmp_count)
+    {
+        HASH_DELETE(hlink, counts, count);
+    }
 
-    /* now allreduce so everyone agrees which records are shared and
-     * which modules accessed them collectively
-     */
-    PMPI_Allreduce(mod_flags, global_mod_flags, tmp_cnt,
-        MPI_UINT64_T, MPI_BAND, core->mpi_comm);
+    /* send the answers back, in the order the records were received */
+    for(i = 0; i < nprocs; i++)
+    {
+        send_counts[i] = (send_counts[i] / sizeof(*send_buf)) * sizeof(*reply_send_buf);
+        send_displs[i] = (send_displs[i] / sizeof(*send_buf)) * sizeof(*reply_send_buf);
+        recv_counts[i] = (recv_counts[i] / sizeof(*send_buf)) * sizeof(*reply_send_buf);
+        recv_displs[i] = (recv_displs[i] / sizeof(*send_buf)) * sizeof(*reply_send_buf);
+    }
+    PMPI_Alltoallv(reply_send_buf, recv_counts, recv_displs, MPI_BYTE,
+        reply_recv_buf, send_counts, send_displs, MPI_BYTE, core->mpi_comm);
 
     j = 0;
-    for(i=0; i<tmp_cnt; i++)
+    k = 0;
+    for(i = 0; i < local_cnt; i++)
     {
-        if(global_mod_flags[i] != 0)
-        {
-            (*shared_recs)[j++] = id_array[i];
-
-            /* set global_mod_flags so we know which modules collectively
-             * accessed this module. we need this info to support shared
-             * record reductions
-             */
-            HASH_FIND(hlink, core->name_hash, &id_array[i], sizeof(darshan_record_id), ref);
-            assert(ref);
-            ref->global_mod_flags = global_mod_flags[i];
-        }
+        ref = send_refs[i];
+        ref->shared_rank_count = reply_recv_buf[i].rank_count;
+        ref->partial_mod_flags = reply_recv_buf[i].partial_mod_flags;
+        ref->min_rank = reply_recv_buf[i].min_rank;
+
+        /* set global_mod_flags so we know which modules collectively
+         * accessed this module. we need this info to support shared
+         * record reductions
+         */
+        ref->global_mod_flags = reply_recv_buf[i].global_mod_flags;
+        if(ref->global_mod_flags != 0)
+            (*shared_recs)[j++] = ref->name_record->id;
+        if(ref->partial_mod_flags != 0)
+            (*partial_recs)[k++] = ref->name_record->id;
     }
     *shared_rec_cnt = j;
-
-    free(id_array);
-    free(mod_flags);
-    free(global_mod_flags);
+    *partial_rec_cnt = k;
+
+    /* every process must list shared records in the same order */
+    qsort(*shared_recs, *shared_rec_cnt, sizeof(darshan_record_id),
+        darshan_record_id_compare);
+    qsort(*partial_recs, *partial_rec_cnt, sizeof(darshan_record_id),
+        darshan_record_id_compare);
+
+    free(send_counts);
+    free(send_displs);
+    free(recv_counts);
+    free(recv_displs);
+    free(offsets);
+    free(send_buf);
+    free(send_refs);
+    free(recv_buf);
+    free(reply_send_buf);
+    free(reply_recv_buf);
+    free(count_array);
     return;
 }
 #endif
@@ -1724,11 +2157,19 @@ static int darshan_log_write_job_record(darshan_core_log_fh log_fh,
 
     /* compress the job info and the trailing mount/exe data */
     ret = darshan_deflate_buffer(pointers, lengths, 2,
-        core->comp_buf, &comp_buf_sz);
+        core->comp_buf, &comp_buf_sz, core->config.comp_type,
+        core->config.comp_level);
     if(ret)
     {
         DARSHAN_WARN("error compressing job record");
     }
+#ifdef HAVE_MPI
+    else if(using_mpi && core->config.log_aggregators > 0)
+    {
+        /* stage the job record to be written with all other log data */
+        darshan_log_stage(core, -2, comp_buf_sz);
+    }
+#endif
     else
     {
         /* write the job information, preallocing space for the log header */
@@ -1771,101 +2212,97 @@ static int darshan_log_write_job_record(darshan_core_log_fh log_fh,
     return(ret);
 }
 
+static int darshan_name_record_compare(const void *a_p, const void *b_p)
+{
+    const struct darshan_name_record *a = *(struct darshan_name_record * const *)a_p;
+    const struct darshan_name_record *b = *(struct darshan_name_record * const *)b_p;
+
+    return(strcmp(a->name, b->name));
+}
+
+/* front code a name record into 'enc_p', such that it only stores the
+ * suffix of its name that is not shared with 'prev_name'. Encoded records
+ * are at most a byte larger than the name record. Returns the encoded size.
+ */
+static int darshan_encode_name_record(char *enc_p, const char *prev_name,
+    struct darshan_name_record *name_rec)
+{
+    const char *name = name_rec->name;
+    char *start_p = enc_p;
+    int prefix_len, suffix_len;
+
+    for(prefix_len = 0; (prefix_len < DARSHAN_NAME_PREFIX_MAX) &&
+        prev_name[prefix_len] &&
+        (prev_name[prefix_len] == name[prefix_len]); prefix_len++);
+    suffix_len = strlen(name + prefix_len) + 1;
+
+    memcpy(enc_p, &name_rec->id, sizeof(darshan_record_id));
+    enc_p += sizeof(darshan_record_id);
+    if(prefix_len < 0x80)
+        *enc_p++ = prefix_len;
+    else
+    {
+        *enc_p++ = 0x80 | (prefix_len >> 8);
+        *enc_p++ = prefix_len & 0xFF;
+    }
+    memcpy(enc_p, name + prefix_len, suffix_len);
+    enc_p += suffix_len;
+
+    return(enc_p - start_p);
+}
+
+/* write name records sorted by name and front coded, such that each name
+ * only stores the suffix it does not share with the previous name
+ */
 static int darshan_log_write_name_record_hash(darshan_core_log_fh log_fh,
     struct darshan_core_runtime *core, uint64_t *inout_off)
 {
-    int name_rec_buf_len;
+    struct darshan_core_name_record_ref *ref, *tmp;
+    struct darshan_name_record **name_recs;
+    int name_rec_cnt = 0;
+    const char *prev_name = "";
+    char *enc_buf, *enc_p;
+    int enc_len = 0;
+    int i;
     int ret;
 
-    name_rec_buf_len = core->name_mem_used;
-#ifdef HAVE_MPI
-    if(using_mpi && (my_rank > 0))
+    /* front coding adds at most a byte to each record */
+    name_recs = malloc((HASH_CNT(hlink, core->name_hash) + 1) * sizeof(*name_recs));
+    enc_buf = malloc(core->name_mem_used + HASH_CNT(hlink, core->name_hash));
+    if(name_recs && enc_buf)
     {
-        struct darshan_core_name_record_ref *ref;
-        struct darshan_name_record *name_rec;
-        char *my_buf, *shared_buf;
-        char *tmp_p;
-        int rec_len;
-        int shared_buf_len;
-
-        /* remove globally shared name records from non-zero ranks */
-
-        name_rec = core->log_name_p;
-        my_buf = core->log_name_p;
-        shared_buf = core->comp_buf;
-        shared_buf_len = 0;
-        while(name_rec_buf_len > 0)
+        HASH_ITER(hlink, core->name_hash, ref, tmp)
         {
-            HASH_FIND(hlink, core->name_hash, &(name_rec->id),
-                sizeof(darshan_record_id), ref);
-            assert(ref);
-            rec_len = sizeof(darshan_record_id) + strlen(name_rec->name) + 1;
-
-            if(ref->global_mod_flags)
-            {
-                /* this record is shared globally, move to the temporary
-                 * shared record buffer and update hash references
-                 */
-                HASH_DELETE(hlink, core->name_hash, ref);
-                memcpy(shared_buf, name_rec, rec_len);
-                ref->name_record = (struct darshan_name_record *)shared_buf;
-                HASH_ADD(hlink, core->name_hash, name_record->id,
-                    sizeof(darshan_record_id), ref);
-
-                shared_buf += rec_len;
-                shared_buf_len += rec_len;
-            }
-            else
-            {
-                /* this record is not shared, but we still may need to
-                 * move it forward in our buffer and update hash references
-                 */
-                if(my_buf != (char *)name_rec)
-                {
-                    HASH_DELETE(hlink, core->name_hash, ref);
-                    memcpy(my_buf, name_rec, rec_len);
-                    ref->name_record =(struct darshan_name_record *)my_buf;
-                    HASH_ADD(hlink, core->name_hash, name_record->id,
-                        sizeof(darshan_record_id), ref);
-                }
-                my_buf += rec_len;
-            }
-
-            tmp_p = (char *)name_rec + rec_len;
-            name_rec = (struct darshan_name_record *)tmp_p;
-            name_rec_buf_len -= rec_len;
+#ifdef HAVE_MPI
+            /* only the lowest rank that opened a record stores its name */
+            if(using_mpi && (ref->min_rank != my_rank))
+                continue;
+#endif
+            name_recs[name_rec_cnt++] = ref->name_record;
         }
-        name_rec_buf_len = core->name_mem_used - shared_buf_len;
+        qsort(name_recs, name_rec_cnt, sizeof(*name_recs),
+            darshan_name_record_compare);
 
-        /* append the shared records back to the end of the name record
-         * buffer and update hash table references so we can still
-         * reference these records as modules shutdown
-         */
-        name_rec = (struct darshan_name_record *)core->comp_buf;
-        while(shared_buf_len > 0)
+        enc_p = enc_buf;
+        for(i = 0; i < name_rec_cnt; i++)
         {
-            HASH_FIND(hlink, core->name_hash, &(name_rec->id),
-                sizeof(darshan_record_id), ref);
-            assert(ref);
-            rec_len = sizeof(darshan_record_id) + strlen(name_rec->name) + 1;
-
-            HASH_DELETE(hlink, core->name_hash, ref);
-            memcpy(my_buf, name_rec, rec_len);
-            ref->name_record = (struct darshan_name_record *)my_buf;
-            HASH_ADD(hlink, core->name_hash, name_record->id,
-                sizeof(darshan_record_id), ref);
-
-            tmp_p = (char *)name_rec + rec_len;
-            name_rec = (struct darshan_name_record *)tmp_p;
-            my_buf += rec_len;
-            shared_buf_len -= rec_len;
+            enc_p += darshan_encode_name_record(enc_p, prev_name, name_recs[i]);
+            prev_name = name_recs[i]->name;
         }
+        enc_len = enc_p - enc_buf;
+    }
+    else
+    {
+        DARSHAN_WARN("unable to allocate name record buffer");
     }
-#endif
 
     /* collectively write out the record hash to the darshan log */
-    ret = darshan_log_append(log_fh, core, core->log_name_p,
-        name_rec_buf_len, inout_off);
+    ret = darshan_log_append(log_fh, core, -1, enc_buf, enc_len, inout_off);
+    if(!name_recs || !enc_buf)
+        ret = -1;
+
+    free(name_recs);
+    free(enc_buf);
     return(ret);
 }
 
@@ -1874,7 +2311,8 @@ static int darshan_log_write_header(darshan_core_log_fh log_fh,
 {
     int ret;
 
-    core->log_hdr_p->comp_type = DARSHAN_ZLIB_COMP;
+    core->log_hdr_p->comp_type = core->config.comp_type;
+    core->log_hdr_p->name_enc = DARSHAN_NAME_ENC_FRONT_CODED;
 
 #ifdef HAVE_MPI
     MPI_Status status;
@@ -1942,14 +2380,34 @@ static int darshan_log_write_header(darshan_core_log_fh log_fh,
  *       This variable is only valid on the root rank (rank 0).
  */
 static int darshan_log_append(darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
-    void *buf, int count, uint64_t *inout_off)
+    int region_id, void *buf, int count, uint64_t *inout_off)
 {
     int comp_buf_sz = core->config.mod_mem;
+    int nchunks = 1;
+    int *chunk_lens = &comp_buf_sz;
     int ret;
 
-    /* compress the input buffer */
-    ret = darshan_deflate_buffer((void **)&buf, &count, 1,
-        core->comp_buf, &comp_buf_sz);
+    /* compress the input buffer, splitting it into independently
+     * compressed chunks if multiple compression threads are configured
+     */
+    if(core->config.comp_threads > 1 && count > DARSHAN_COMP_CHUNK_SIZE)
+    {
+        nchunks = (count + DARSHAN_COMP_CHUNK_SIZE - 1) / DARSHAN_COMP_CHUNK_SIZE;
+        chunk_lens = malloc(nchunks * sizeof(*chunk_lens));
+        if(chunk_lens)
+            ret = darshan_deflate_buffer_chunked(buf, count, core->comp_buf,
+                &comp_buf_sz, chunk_lens, core->config.comp_type,
+                core->config.comp_level,
+                core->config.comp_threads);
+        else
+            ret = -1;
+    }
+    else
+    {
+        ret = darshan_deflate_buffer((void **)&buf, &count, 1,
+            core->comp_buf, &comp_buf_sz, core->config.comp_type,
+        core->config.comp_level);
+    }
     if(ret < 0)
         comp_buf_sz = 0;
 
@@ -1957,6 +2415,22 @@ static int darshan_log_append(darshan_core_log_fh log_fh, struct darshan_core_ru
     MPI_Offset send_off, my_off;
     MPI_Status status;
 
+    if(using_mpi && core->config.log_aggregators > 0)
+    {
+        /* defer the write until all log regions have been staged, so they
+         * can all be written at once by the aggregators. Chunk offsets are
+         * relative to this process's data for the region until then.
+         */
+        if(ret == 0 && core->config.comp_threads > 1)
+            darshan_add_chunks(core, region_id, 0, chunk_lens, nchunks, count);
+        if(ret == 0 && core->config.rec_index_flag)
+            darshan_add_rec_index(core, region_id, 0, comp_buf_sz, count);
+        if(chunk_lens != &comp_buf_sz)
+            free(chunk_lens);
+        darshan_log_stage(core, region_id, (ret == 0) ? comp_buf_sz : -1);
+        return(0);
+    }
+
     if(using_mpi)
     {
         /* figure out where everyone is writing using scan */
@@ -1970,6 +2444,13 @@ static int darshan_log_append(darshan_core_log_fh log_fh, struct darshan_core_ru
         /* scan is inclusive; subtract local size back out */
         my_off -= comp_buf_sz;
 
+        if(ret == 0 && core->config.comp_threads > 1)
+            darshan_add_chunks(core, region_id, my_off, chunk_lens, nchunks, count);
+        if(ret == 0 && core->config.rec_index_flag)
+            darshan_add_rec_index(core, region_id, my_off, comp_buf_sz, count);
+        if(chunk_lens != &comp_buf_sz)
+            free(chunk_lens);
+
         if(ret == 0)
         {
             /* no compression errors, proceed with the collective write */
@@ -2011,6 +2492,15 @@ static int darshan_log_append(darshan_core_log_fh log_fh, struct darshan_core_ru
     }
 #endif
 
+    if(ret == 0 && core->config.comp_threads > 1)
+        darshan_add_chunks(core, region_id, *inout_off, chunk_lens, nchunks, count);
+    if(ret == 0 && core->config.rec_index_flag)
+        darshan_add_rec_index(core, region_id, *inout_off, comp_buf_sz, count);
+    if(chunk_lens != &comp_buf_sz)
+        free(chunk_lens);
+    if(ret < 0)
+        return(-1);
+
     ret = pwrite(log_fh.nompi_fd, core->comp_buf, comp_buf_sz, *inout_off);
     if(ret != comp_buf_sz)
         return(-1);
@@ -2018,41 +2508,482 @@ static int darshan_log_append(darshan_core_log_fh log_fh, struct darshan_core_ru
     return(0);
 }
 
-void darshan_log_close(darshan_core_log_fh log_fh)
-{
 #ifdef HAVE_MPI
-    if(using_mpi)
+/* copy 'len' bytes of compressed data for the given log region (-2 for the
+ * job record, -1 for name records, or a module id) from the compression
+ * buffer to the staging buffer. Regions must be staged in increasing order.
+ * A negative length records a compression error, which is reported when the
+ * staged data is written.
+ */
+static void darshan_log_stage(struct darshan_core_runtime *core,
+    int region_id, int len)
+{
+    char *tmp_buf;
+    size_t new_size;
+
+    if(len < 0)
     {
-        PMPI_File_close(&log_fh.mpi_fh);
+        core->agg_err = 1;
         return;
     }
-#endif
 
-    close(log_fh.nompi_fd);
+    if(core->agg_buf_used + len > core->agg_buf_size)
+    {
+        new_size = core->agg_buf_size ? core->agg_buf_size : (1024 * 1024);
+        while(new_size < core->agg_buf_used + len)
+            new_size *= 2;
+        tmp_buf = realloc(core->agg_buf, new_size);
+        if(!tmp_buf)
+        {
+            core->agg_err = 1;
+            return;
+        }
+        core->agg_buf = tmp_buf;
+        core->agg_buf_size = new_size;
+    }
+
+    memcpy(core->agg_buf + core->agg_buf_used, core->comp_buf, len);
+    core->agg_buf_used += len;
+    core->agg_region_len[region_id + 2] += len;
+
     return;
 }
 
-void darshan_log_finalize(char *logfile_name, double start_log_time)
+/* write out all log regions staged by darshan_log_stage(), filling in the
+ * header's region map. Processes are split into 'log_aggregators' groups of
+ * consecutive ranks, so each group's data for a region is contiguous in the
+ * log; one process in each group gathers the group's data and writes it
+ * with a single contiguous write per region.
+ */
+static int darshan_log_write_aggregated(darshan_core_log_fh log_fh,
+    struct darshan_core_runtime *core, uint64_t *inout_off)
 {
-#ifdef HAVE_MPI
-    if(using_mpi && (my_rank > 0))
-        return;
-#endif
+    MPI_Offset scan_in[DARSHAN_AGG_REGION_COUNT + 1];
+    MPI_Offset scan_out[DARSHAN_AGG_REGION_COUNT + 1];
+    MPI_Offset region_off[DARSHAN_AGG_REGION_COUNT + 2];
+    MPI_Offset my_off[DARSHAN_AGG_REGION_COUNT];
+    MPI_Comm agg_comm;
+    MPI_Status status;
+    uint64_t *group_lens = NULL;
+    char *group_buf = NULL;
+    char *out_buf = NULL;
+    int *counts = NULL;
+    int *displs = NULL;
+    int nagg, agg_rank, agg_size;
+    int my_bytes;
+    int64_t my_bytes64, group_bytes = 0;
+    int alloc_ok = 1;
+    uint64_t pos, len;
+    int i, j, k;
+    int ret = 0;
 
-    /* finalize the darshan log file by renaming from *.darshan_partial
-     * to *-<logwritetime>.darshan, indicating that this log file is complete
-     * and ready for analysis
+    if(core->agg_buf_used > INT_MAX)
+        core->agg_err = 1;
+
+    /* a single scan gives each process its offset within every region, and
+     * the last process the size of each region and the number of errors
      */
-        mode_t chmod_mode = S_IRUSR;
-#ifdef __DARSHAN_GROUP_READABLE_LOGS
-        chmod_mode |= S_IRGRP;
-#endif
+    for(k = 0; k < DARSHAN_AGG_REGION_COUNT; k++)
+        scan_in[k] = core->agg_region_len[k];
+    scan_in[DARSHAN_AGG_REGION_COUNT] = core->agg_err;
+    PMPI_Scan(scan_in, scan_out, DARSHAN_AGG_REGION_COUNT + 1, MPI_OFFSET,
+        MPI_SUM, core->mpi_comm);
+    for(k = 0; k < DARSHAN_AGG_REGION_COUNT; k++)
+        my_off[k] = scan_out[k] - scan_in[k];
+
+    /* regions are laid out back to back following the log header */
+    if(my_rank == (nprocs-1))
+    {
+        region_off[0] = sizeof(struct darshan_header);
+        for(k = 0; k < DARSHAN_AGG_REGION_COUNT; k++)
+            region_off[k+1] = region_off[k] + scan_out[k];
+        region_off[DARSHAN_AGG_REGION_COUNT+1] = scan_out[DARSHAN_AGG_REGION_COUNT];
+    }
+    PMPI_Bcast(region_off, DARSHAN_AGG_REGION_COUNT + 2, MPI_OFFSET,
+        (nprocs-1), core->mpi_comm);
+    if(region_off[DARSHAN_AGG_REGION_COUNT+1] > 0)
+        return(-1);
 
-    if(getenv("DARSHAN_LOGFILE"))
+    for(k = 0; k < DARSHAN_AGG_REGION_COUNT; k++)
+        my_off[k] += region_off[k];
+    for(i = 0; i < core->chunk_count; i++)
+        core->chunk_index[i].off += my_off[core->chunk_index[i].region_id + 2];
+    for(i = 0; i < core->rec_index_count; i++)
+        core->rec_index[i].off += my_off[core->rec_index[i].region_id + 2];
+
+    core->log_hdr_p->name_map.off = region_off[1];
+    core->log_hdr_p->name_map.len = region_off[2] - region_off[1];
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
     {
-        chmod(logfile_name, chmod_mode);
+        /* modules without any data keep a zero offset */
+        if(region_off[i+3] == region_off[i+2])
+            continue;
+        core->log_hdr_p->mod_map[i].off = region_off[i+2];
+        core->log_hdr_p->mod_map[i].len = region_off[i+3] - region_off[i+2];
     }
-    else
+    *inout_off = region_off[DARSHAN_AGG_REGION_COUNT];
+
+    /* gather each group's staged data at its lowest rank */
+    nagg = (core->config.log_aggregators < nprocs) ?
+        core->config.log_aggregators : nprocs;
+    PMPI_Comm_split(core->mpi_comm, (int)(((int64_t)my_rank * nagg) / nprocs),
+        my_rank, &agg_comm);
+    PMPI_Comm_rank(agg_comm, &agg_rank);
+    PMPI_Comm_size(agg_comm, &agg_size);
+
+    my_bytes = core->agg_buf_used;
+    my_bytes64 = my_bytes;
+    PMPI_Reduce(&my_bytes64, &group_bytes, 1, MPI_INT64_T, MPI_SUM, 0, agg_comm);
+    if(agg_rank == 0)
+    {
+        group_lens = malloc(agg_size * DARSHAN_AGG_REGION_COUNT * sizeof(*group_lens));
+        counts = malloc(agg_size * sizeof(*counts));
+        displs = malloc(agg_size * sizeof(*displs));
+        if(!group_lens || !counts || !displs || group_bytes > INT_MAX)
+            alloc_ok = 0;
+        else
+        {
+            group_buf = malloc(group_bytes);
+            out_buf = malloc(group_bytes);
+            if(group_bytes && (!group_buf || !out_buf))
+                alloc_ok = 0;
+        }
+    }
+    PMPI_Bcast(&alloc_ok, 1, MPI_INT, 0, agg_comm);
+    if(alloc_ok)
+    {
+        PMPI_Gather(core->agg_region_len, DARSHAN_AGG_REGION_COUNT, MPI_UINT64_T,
+            group_lens, DARSHAN_AGG_REGION_COUNT, MPI_UINT64_T, 0, agg_comm);
+        PMPI_Gather(&my_bytes, 1, MPI_INT, counts, 1, MPI_INT, 0, agg_comm);
+        if(agg_rank == 0)
+        {
+            pos = 0;
+            for(j = 0; j < agg_size; j++)
+            {
+                displs[j] = pos;
+                pos += counts[j];
+            }
+        }
+        PMPI_Gatherv(core->agg_buf, my_bytes, MPI_BYTE, group_buf, counts,
+            displs, MPI_BYTE, 0, agg_comm);
+    }
+    else
+        ret = -1;
+    PMPI_Comm_free(&agg_comm);
+
+    if(agg_rank == 0 && alloc_ok)
+    {
+        /* reorder the group's data by region, so each region can be written
+         * from a contiguous buffer
+         */
+        pos = 0;
+        for(k = 0; k < DARSHAN_AGG_REGION_COUNT; k++)
+        {
+            uint64_t region_start = pos;
+
+            for(j = 0; j < agg_size; j++)
+            {
+                uint64_t src = displs[j];
+
+                for(i = 0; i < k; i++)
+                    src += group_lens[j * DARSHAN_AGG_REGION_COUNT + i];
+                len = group_lens[j * DARSHAN_AGG_REGION_COUNT + k];
+                memcpy(out_buf + pos, group_buf + src, len);
+                pos += len;
+            }
+
+            len = pos - region_start;
+            if(len == 0)
+                continue;
+            if(PMPI_File_write_at(log_fh.mpi_fh, my_off[k], out_buf + region_start,
+                len, MPI_BYTE, &status) != MPI_SUCCESS)
+                ret = -1;
+        }
+    }
+
+    free(group_lens);
+    free(counts);
+    free(displs);
+    free(group_buf);
+    free(out_buf);
+
+    return(ret);
+}
+#endif
+
+/* add the chunks of a compressed buffer written at offset 'off' of the log
+ * to this process's chunk index
+ */
+static void darshan_add_chunks(struct darshan_core_runtime *core, int region_id,
+    uint64_t off, int *chunk_lens, int nchunks, int uncomp_len)
+{
+    struct darshan_log_chunk *tmp_index;
+    int new_size;
+    int i;
+
+    if(uncomp_len == 0)
+        return;
+
+    if(core->chunk_count + nchunks > core->chunk_index_size)
+    {
+        new_size = core->chunk_index_size ? core->chunk_index_size * 2 : 16;
+        while(new_size < core->chunk_count + nchunks)
+            new_size *= 2;
+        tmp_index = realloc(core->chunk_index, new_size * sizeof(*tmp_index));
+        if(!tmp_index)
+            return;
+        core->chunk_index = tmp_index;
+        core->chunk_index_size = new_size;
+    }
+
+    for(i = 0; i < nchunks; i++)
+    {
+        core->chunk_index[core->chunk_count].region_id = region_id;
+        core->chunk_index[core->chunk_count].off = off;
+        core->chunk_index[core->chunk_count].len = chunk_lens[i];
+        if(i < nchunks - 1)
+            core->chunk_index[core->chunk_count].uncomp_len = DARSHAN_COMP_CHUNK_SIZE;
+        else
+            core->chunk_index[core->chunk_count].uncomp_len =
+                uncomp_len - (uint64_t)(nchunks - 1) * DARSHAN_COMP_CHUNK_SIZE;
+        off += chunk_lens[i];
+        core->chunk_count++;
+    }
+
+    return;
+}
+
+static int darshan_log_chunk_compare(const void *a_p, const void *b_p)
+{
+    const struct darshan_log_chunk *a = a_p;
+    const struct darshan_log_chunk *b = b_p;
+
+    if(a->region_id != b->region_id)
+        return((a->region_id < b->region_id) ? -1 : 1);
+    if(a->off != b->off)
+        return((a->off < b->off) ? -1 : 1);
+    return(0);
+}
+
+/* add an entry for the 'len' bytes of compressed module data written at
+ * offset 'off' of the log to this process's record index. The entry covers
+ * every record this process registered with the module, except for those
+ * that the module's shared record reductions moved to another process.
+ */
+static void darshan_add_rec_index(struct darshan_core_runtime *core,
+    int region_id, uint64_t off, int len, int uncomp_len)
+{
+    struct darshan_core_name_record_ref *ref, *tmp;
+    struct darshan_log_rec_index *tmp_index;
+    struct darshan_log_rec_index *entry;
+    darshan_record_id id;
+    int skip_global = 0;
+    int skip_partial = 0;
+    int new_size;
+
+    if(region_id < 0 || uncomp_len == 0)
+        return;
+
+    if(core->rec_index_count == core->rec_index_size)
+    {
+        new_size = core->rec_index_size ? core->rec_index_size * 2 : 16;
+        tmp_index = realloc(core->rec_index, new_size * sizeof(*tmp_index));
+        if(!tmp_index)
+            return;
+        core->rec_index = tmp_index;
+        core->rec_index_size = new_size;
+    }
+
+#ifdef HAVE_MPI
+    if(using_mpi && core->mod_array[region_id])
+    {
+        struct darshan_module_funcs *funcs = &core->mod_array[region_id]->mod_funcs;
+
+        /* NOTE: the HEATMAP module keeps its shared records on every rank */
+        skip_global = (my_rank > 0) && funcs->mod_redux_func &&
+            !core->config.disable_shared_redux_flag &&
+            (region_id != DARSHAN_HEATMAP_MOD);
+        skip_partial = (funcs->mod_partial_redux_func != NULL);
+    }
+#endif
+
+    entry = &core->rec_index[core->rec_index_count];
+    memset(entry, 0, sizeof(*entry));
+    entry->region_id = region_id;
+    entry->rank = my_rank;
+    entry->off = off;
+    entry->len = len;
+    entry->uncomp_len = uncomp_len;
+    entry->min_id = UINT64_MAX;
+
+    HASH_ITER(hlink, core->name_hash, ref, tmp)
+    {
+        if(!DARSHAN_MOD_FLAG_ISSET(ref->mod_flags, region_id))
+            continue;
+        if(skip_global && DARSHAN_MOD_FLAG_ISSET(ref->global_mod_flags, region_id))
+            continue;
+        if(skip_partial && DARSHAN_MOD_FLAG_ISSET(ref->partial_mod_flags, region_id) &&
+            (ref->min_rank != my_rank))
+            continue;
+
+        id = ref->name_record->id;
+        if(id < entry->min_id)
+            entry->min_id = id;
+        if(id > entry->max_id)
+            entry->max_id = id;
+        DARSHAN_REC_INDEX_FILTER_SET(entry->id_filter, id);
+    }
+    if(entry->min_id > entry->max_id)
+        entry->min_id = 0;
+
+    core->rec_index_count++;
+    return;
+}
+
+static int darshan_log_rec_index_compare(const void *a_p, const void *b_p)
+{
+    const struct darshan_log_rec_index *a = a_p;
+    const struct darshan_log_rec_index *b = b_p;
+
+    if(a->region_id != b->region_id)
+        return((a->region_id < b->region_id) ? -1 : 1);
+    if(a->off != b->off)
+        return((a->off < b->off) ? -1 : 1);
+    return(0);
+}
+
+/* gather every process's entries of an index (e.g., the chunk index) at
+ * rank 0, and write the combined index (uncompressed and sorted using
+ * 'compare') at the end of the log, setting its location in 'map_p'
+ * NOTE: inout_off is only valid on rank 0, as in darshan_log_append()
+ */
+static int darshan_log_write_index(darshan_core_log_fh log_fh,
+    struct darshan_core_runtime *core, void *index, int count, int entry_size,
+    int (*compare)(const void *, const void *), struct darshan_log_map *map_p,
+    uint64_t *inout_off)
+{
+    char *all_entries = index;
+    int all_count = count;
+    int ret;
+
+#ifdef HAVE_MPI
+    int *counts = NULL;
+    int *displs = NULL;
+    int i, j;
+    MPI_Status status;
+
+    if(using_mpi)
+    {
+        int my_bytes = count * entry_size;
+        int alloc_ok = 1;
+
+        all_entries = NULL;
+        all_count = 0;
+        PMPI_Reduce(&count, &all_count, 1, MPI_INT, MPI_SUM, 0, core->mpi_comm);
+        if(my_rank == 0)
+        {
+            counts = malloc(nprocs * sizeof(*counts));
+            displs = malloc(nprocs * sizeof(*displs));
+            all_entries = malloc((size_t)all_count * entry_size);
+            if(!counts || !displs || (all_count && !all_entries))
+                alloc_ok = 0;
+        }
+        /* skip the index entirely if rank 0 can't hold it */
+        PMPI_Bcast(&alloc_ok, 1, MPI_INT, 0, core->mpi_comm);
+        if(!alloc_ok)
+        {
+            free(counts);
+            free(displs);
+            free(all_entries);
+            return(my_rank == 0 ? -1 : 0);
+        }
+        PMPI_Gather(&my_bytes, 1, MPI_INT, counts, 1, MPI_INT, 0, core->mpi_comm);
+        if(my_rank == 0)
+        {
+            for(i = 0, j = 0; i < nprocs; i++)
+            {
+                displs[i] = j;
+                j += counts[i];
+            }
+        }
+        PMPI_Gatherv(index, my_bytes, MPI_BYTE, all_entries,
+            counts, displs, MPI_BYTE, 0, core->mpi_comm);
+        free(counts);
+        free(displs);
+
+        if(my_rank > 0)
+            return(0);
+
+        ret = 0;
+        if(all_count > 0)
+        {
+            qsort(all_entries, all_count, entry_size, compare);
+            ret = PMPI_File_write_at(log_fh.mpi_fh, *inout_off, all_entries,
+                all_count * entry_size, MPI_BYTE, &status);
+            if(ret != MPI_SUCCESS)
+                ret = -1;
+            else
+            {
+                map_p->off = *inout_off;
+                map_p->len = (uint64_t)all_count * entry_size;
+                *inout_off += map_p->len;
+            }
+        }
+        free(all_entries);
+        return(ret);
+    }
+#endif
+
+    if(all_count == 0)
+        return(0);
+
+    qsort(all_entries, all_count, entry_size, compare);
+    ret = pwrite(log_fh.nompi_fd, all_entries, all_count * entry_size,
+        *inout_off);
+    if(ret != all_count * entry_size)
+        return(-1);
+    map_p->off = *inout_off;
+    map_p->len = (uint64_t)all_count * entry_size;
+    *inout_off += map_p->len;
+
+    return(0);
+}
+
+void darshan_log_close(darshan_core_log_fh log_fh)
+{
+#ifdef HAVE_MPI
+    if(using_mpi)
+    {
+        PMPI_File_close(&log_fh.mpi_fh);
+        return;
+    }
+#endif
+
+    close(log_fh.nompi_fd);
+    return;
+}
+
+void darshan_log_finalize(char *logfile_name, double start_log_time)
+{
+#ifdef HAVE_MPI
+    if(using_mpi && (my_rank > 0))
+        return;
+#endif
+
+    /* finalize the darshan log file by renaming from *.darshan_partial
+     * to *-<logwritetime>.darshan, indicating that this log file is complete
+     * and ready for analysis
+     */
+        mode_t chmod_mode = S_IRUSR;
+#ifdef __DARSHAN_GROUP_READABLE_LOGS
+        chmod_mode |= S_IRGRP;
+#endif
+
+    if(getenv("DARSHAN_LOGFILE"))
+    {
+        chmod(logfile_name, chmod_mode);
+    }
+    else
     {
         char* tmp_index;
         double end_log_time;
@@ -2088,14 +3019,420 @@ void darshan_log_finalize(char *logfile_name, double start_log_time)
     return;
 }
 
+/* bring the compressed chunks of a snapshot region up to date with the
+ * 'len' bytes at 'buf', compressing only chunks whose contents changed
+ * since the last snapshot. Returns the number of chunks compressed, or -1
+ * on failure.
+ */
+static int darshan_snapshot_update_region(struct darshan_snapshot_region *region,
+    char *buf, size_t len, int comp_type, int comp_level)
+{
+    struct darshan_snapshot_chunk *chunk, *tmp_chunks;
+    int nchunks = (len + DARSHAN_SNAPSHOT_CHUNK_SIZE - 1) / DARSHAN_SNAPSHOT_CHUNK_SIZE;
+    int ncomp = 0;
+    void *chunk_p;
+    int chunk_len;
+    int comp_len;
+    char *tmp_buf;
+    uint64_t hash;
+    int ret;
+    int i;
+
+    if(nchunks > region->chunk_alloc)
+    {
+        tmp_chunks = realloc(region->chunks, nchunks * sizeof(*tmp_chunks));
+        if(!tmp_chunks)
+            return(-1);
+        memset(&tmp_chunks[region->chunk_alloc], 0,
+            (nchunks - region->chunk_alloc) * sizeof(*tmp_chunks));
+        region->chunks = tmp_chunks;
+        region->chunk_alloc = nchunks;
+    }
+
+    for(i = 0; i < nchunks; i++)
+    {
+        chunk = &region->chunks[i];
+        chunk_p = buf + (size_t)i * DARSHAN_SNAPSHOT_CHUNK_SIZE;
+        chunk_len = len - (size_t)i * DARSHAN_SNAPSHOT_CHUNK_SIZE;
+        if(chunk_len > DARSHAN_SNAPSHOT_CHUNK_SIZE)
+            chunk_len = DARSHAN_SNAPSHOT_CHUNK_SIZE;
+
+        hash = darshan_hash(chunk_p, chunk_len, 0);
+        if(chunk->comp_buf && chunk->uncomp_len == chunk_len && chunk->hash == hash)
+            continue;
+
+        comp_len = 2 * DARSHAN_SNAPSHOT_CHUNK_SIZE;
+        ret = darshan_deflate_buffer(&chunk_p, &chunk_len, 1,
+            darshan_snapshot.comp_buf, &comp_len, comp_type, comp_level);
+        if(ret < 0)
+            return(-1);
+        tmp_buf = realloc(chunk->comp_buf, comp_len);
+        if(!tmp_buf)
+            return(-1);
+        memcpy(tmp_buf, darshan_snapshot.comp_buf, comp_len);
+        chunk->comp_buf = tmp_buf;
+        chunk->comp_len = comp_len;
+        chunk->uncomp_len = chunk_len;
+        chunk->hash = hash;
+        ncomp++;
+    }
+    region->nchunks = nchunks;
+
+    return(ncomp);
+}
+
+static int darshan_snapshot_write(int fd, void *buf, size_t len)
+{
+    ssize_t ret;
+
+    /* call into the kernel directly, so snapshot I/O is not instrumented */
+    while(len > 0)
+    {
+        ret = syscall(SYS_write, fd, buf, len);
+        if(ret < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            return(-1);
+        }
+        buf = (char *)buf + ret;
+        len -= ret;
+    }
+
+    return(0);
+}
+
+/* write a snapshot of this process's current darshan-core state as a
+ * complete, self-contained log, replacing the previous snapshot
+ */
+static int darshan_core_write_snapshot(struct darshan_core_runtime *core)
+{
+    struct darshan_header hdr;
+    struct darshan_job job;
+    struct darshan_snapshot_region *region;
+    struct darshan_log_map *map_p;
+    struct darshan_log_chunk *index = NULL;
+    int index_count = 0;
+    char *mod_buf[DARSHAN_KNOWN_MODULE_COUNT] = {0};
+    size_t mod_len[DARSHAN_KNOWN_MODULE_COUNT] = {0};
+    struct darshan_name_record *name_rec;
+    size_t name_mem_used;
+    char tmp_path[__DARSHAN_PATH_MAX+8];
+    struct timespec ts;
+    void *job_pointers[2];
+    int job_lengths[2];
+    int job_comp_len;
+    char *job_comp_buf = NULL;
+    size_t new_size;
+    uint64_t off;
+    char *tmp_buf;
+    char *m;
+    int meta_remain;
+    int comp_type = core->config.comp_type;
+    int comp_level = core->config.comp_level;
+    int fd = -1;
+    int i, j;
+    int ret = -1;
+
+    /* capture the header, job data, and extent of the name records and of
+     * each module's records. Records are read afterwards without holding
+     * the core lock, so a snapshot may capture a record mid-update.
+     */
+    __DARSHAN_CORE_LOCK();
+    hdr = *core->log_hdr_p;
+    job = *core->log_job_p;
+    name_mem_used = core->name_mem_used;
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(!core->mod_array[i])
+            continue;
+        if((i == DXT_POSIX_MOD) || (i == DXT_MPIIO_MOD))
+        {
+            /* DXT traces are only assembled at shutdown */
+            DARSHAN_MOD_FLAG_SET(hdr.partial_flag, i);
+            continue;
+        }
+        mod_buf[i] = core->mod_array[i]->rec_buf_start;
+        mod_len[i] = (char *)core->mod_array[i]->rec_buf_p - mod_buf[i];
+    }
+    __DARSHAN_CORE_UNLOCK();
+
+    /* front code any names registered since the last snapshot */
+    if(name_mem_used > darshan_snapshot.name_mem_done)
+    {
+        new_size = darshan_snapshot.name_enc_len +
+            2 * (name_mem_used - darshan_snapshot.name_mem_done);
+        if(new_size > darshan_snapshot.name_enc_size)
+        {
+            tmp_buf = realloc(darshan_snapshot.name_enc_buf, new_size);
+            if(!tmp_buf)
+                return(-1);
+            darshan_snapshot.name_enc_buf = tmp_buf;
+            darshan_snapshot.name_enc_size = new_size;
+        }
+        while(darshan_snapshot.name_mem_done < name_mem_used)
+        {
+            name_rec = (struct darshan_name_record *)
+                ((char *)core->log_name_p + darshan_snapshot.name_mem_done);
+            darshan_snapshot.name_enc_len += darshan_encode_name_record(
+                darshan_snapshot.name_enc_buf + darshan_snapshot.name_enc_len,
+                darshan_snapshot.prev_name, name_rec);
+            darshan_snapshot.prev_name = name_rec->name;
+            darshan_snapshot.name_mem_done += sizeof(darshan_record_id) +
+                strlen(name_rec->name) + 1;
+        }
+    }
+
+    /* compress the chunks of each region that changed */
+    if(darshan_snapshot_update_region(&darshan_snapshot.regions[0],
+        darshan_snapshot.name_enc_buf, darshan_snapshot.name_enc_len,
+        comp_type, comp_level) < 0)
+        return(-1);
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(darshan_snapshot_update_region(&darshan_snapshot.regions[i+1],
+            mod_buf[i], mod_len[i], comp_type, comp_level) < 0)
+            return(-1);
+    }
+
+    /* the job data records when and which snapshot this is */
+    clock_gettime(CLOCK_REALTIME, &ts);
+    job.end_time_sec = (int64_t)ts.tv_sec;
+    job.end_time_nsec = (int64_t)ts.tv_nsec;
+    meta_remain = DARSHAN_JOB_METADATA_LEN - strlen(job.metadata) - 1;
+    if(meta_remain >= 22)
+    {
+        m = job.metadata + strlen(job.metadata);
+        sprintf(m, "snapshot=%d\n", darshan_snapshot.seq + 1);
+    }
+    job_pointers[0] = &job;
+    job_pointers[1] = core->log_exemnt_p;
+    job_lengths[0] = sizeof(job);
+    job_lengths[1] = strlen(core->log_exemnt_p) + 1;
+    job_comp_len = 2 * (job_lengths[0] + job_lengths[1]) + 1024;
+    job_comp_buf = malloc(job_comp_len);
+    index = malloc(DARSHAN_SNAPSHOT_NREGIONS * sizeof(*index) *
+        (1 + core->config.mod_mem / DARSHAN_SNAPSHOT_CHUNK_SIZE +
+        core->config.name_mem / DARSHAN_SNAPSHOT_CHUNK_SIZE));
+    if(!job_comp_buf || !index)
+        goto out;
+    if(darshan_deflate_buffer(job_pointers, job_lengths, 2, job_comp_buf,
+        &job_comp_len, comp_type, comp_level) < 0)
+        goto out;
+
+    /* write the new snapshot to a temporary file that then replaces the
+     * previous one, so a valid snapshot exists at all times
+     */
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", darshan_snapshot.path);
+    fd = syscall(SYS_openat, AT_FDCWD, tmp_path, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    if(fd < 0)
+        goto out;
+
+    hdr.comp_type = comp_type;
+    hdr.name_enc = DARSHAN_NAME_ENC_FRONT_CODED;
+    memset(&hdr.name_map, 0, sizeof(hdr.name_map));
+    memset(hdr.mod_map, 0, sizeof(hdr.mod_map));
+    memset(&hdr.chunk_map, 0, sizeof(hdr.chunk_map));
+    memset(&hdr.rec_index_map, 0, sizeof(hdr.rec_index_map));
+    if(darshan_snapshot_write(fd, &hdr, sizeof(hdr)) < 0 ||
+        darshan_snapshot_write(fd, job_comp_buf, job_comp_len) < 0)
+        goto out;
+    off = sizeof(hdr) + job_comp_len;
+
+    for(i = 0; i < DARSHAN_SNAPSHOT_NREGIONS; i++)
+    {
+        region = &darshan_snapshot.regions[i];
+        map_p = (i == 0) ? &hdr.name_map : &hdr.mod_map[i-1];
+        map_p->off = off;
+        for(j = 0; j < region->nchunks; j++)
+        {
+            if(darshan_snapshot_write(fd, region->chunks[j].comp_buf,
+                region->chunks[j].comp_len) < 0)
+                goto out;
+            index[index_count].region_id = i - 1;
+            index[index_count].off = off;
+            index[index_count].len = region->chunks[j].comp_len;
+            index[index_count].uncomp_len = region->chunks[j].uncomp_len;
+            index_count++;
+            off += region->chunks[j].comp_len;
+        }
+        map_p->len = off - map_p->off;
+    }
+
+    /* index the chunks, so readers can decompress them in parallel */
+    if(index_count > 0)
+    {
+        if(darshan_snapshot_write(fd, index, index_count * sizeof(*index)) < 0)
+            goto out;
+        hdr.chunk_map.off = off;
+        hdr.chunk_map.len = index_count * sizeof(*index);
+    }
+
+    if(syscall(SYS_pwrite64, fd, &hdr, sizeof(hdr), 0) != sizeof(hdr))
+        goto out;
+    ret = syscall(SYS_close, fd);
+    fd = -1;
+    if(ret == 0)
+        ret = renameat(AT_FDCWD, tmp_path, AT_FDCWD, darshan_snapshot.path);
+    if(ret == 0)
+        darshan_snapshot.seq++;
+
+out:
+    if(fd >= 0)
+    {
+        syscall(SYS_close, fd);
+        ret = -1;
+    }
+    if(ret < 0)
+        unlink(tmp_path);
+    free(job_comp_buf);
+    free(index);
+    return(ret);
+}
+
+static void *darshan_core_snapshot_thread(void *arg)
+{
+    struct darshan_core_runtime *core = arg;
+    struct timespec deadline;
+    double start, tm;
+    int warned = 0;
+    int ret;
+
+    pthread_mutex_lock(&darshan_snapshot.mutex);
+    while(!darshan_snapshot.stop)
+    {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += core->config.snapshot_interval;
+        do
+        {
+            ret = pthread_cond_timedwait(&darshan_snapshot.cond,
+                &darshan_snapshot.mutex, &deadline);
+        } while(!darshan_snapshot.stop && ret != ETIMEDOUT);
+        if(darshan_snapshot.stop)
+            break;
+        pthread_mutex_unlock(&darshan_snapshot.mutex);
+
+        start = darshan_core_wtime_absolute();
+        ret = darshan_core_write_snapshot(core);
+        tm = darshan_core_wtime_absolute() - start;
+        if(ret < 0 && !warned)
+        {
+            DARSHAN_WARN("unable to write snapshot log %s", darshan_snapshot.path);
+            warned = 1;
+        }
+        if(core->config.internal_timing_flag && my_rank == 0)
+            darshan_core_fprintf(stderr, "darshan:snapshot\t%d\t%f\n", nprocs, tm);
+
+        pthread_mutex_lock(&darshan_snapshot.mutex);
+    }
+    pthread_mutex_unlock(&darshan_snapshot.mutex);
+
+    return(NULL);
+}
+
+/* start a thread that writes a snapshot log of this process's state every
+ * 'snapshot_interval' seconds
+ */
+static void darshan_core_snapshot_start(struct darshan_core_runtime *core, int jobid)
+{
+    char cuser[L_cuserid] = {0};
+    sigset_t all_sigs, old_sigs;
+    int ret;
+
+    darshan_snapshot.comp_buf = malloc(2 * DARSHAN_SNAPSHOT_CHUNK_SIZE);
+    if(!darshan_snapshot.comp_buf)
+        return;
+
+    darshan_get_user_name(cuser);
+    snprintf(darshan_snapshot.path, __DARSHAN_PATH_MAX,
+        "%s/%s_%s_id%d_snapshot-%d-%d.darshan", core->config.snapshot_path,
+        cuser, __progname, jobid, core->pid, my_rank);
+    darshan_snapshot.prev_name = "";
+    darshan_snapshot.stop = 0;
+    darshan_snapshot.pid = core->pid;
+
+    /* keep application signals from being delivered to the snapshot thread */
+    sigfillset(&all_sigs);
+    pthread_sigmask(SIG_SETMASK, &all_sigs, &old_sigs);
+    ret = pthread_create(&darshan_snapshot.thread, NULL,
+        darshan_core_snapshot_thread, core);
+    pthread_sigmask(SIG_SETMASK, &old_sigs, NULL);
+    if(ret != 0)
+    {
+        DARSHAN_WARN("unable to start snapshot thread");
+        free(darshan_snapshot.comp_buf);
+        darshan_snapshot.comp_buf = NULL;
+        return;
+    }
+    darshan_snapshot.running = 1;
+
+    return;
+}
+
+static void darshan_core_snapshot_stop(void)
+{
+    int i, j;
+
+    if(!darshan_snapshot.running)
+        return;
+
+    /* the snapshot thread does not exist in a forked child process, and
+     * the parent's snapshot is not the child's to remove
+     */
+    if(darshan_snapshot.pid == getpid())
+    {
+        pthread_mutex_lock(&darshan_snapshot.mutex);
+        darshan_snapshot.stop = 1;
+        pthread_cond_signal(&darshan_snapshot.cond);
+        pthread_mutex_unlock(&darshan_snapshot.mutex);
+        pthread_join(darshan_snapshot.thread, NULL);
+
+        /* the snapshot is superseded by the log written at shutdown */
+        unlink(darshan_snapshot.path);
+    }
+    else
+    {
+        /* the mutex may have been held by the snapshot thread at fork time */
+        pthread_mutex_init(&darshan_snapshot.mutex, NULL);
+        pthread_cond_init(&darshan_snapshot.cond, NULL);
+    }
+
+    for(i = 0; i < DARSHAN_SNAPSHOT_NREGIONS; i++)
+    {
+        for(j = 0; j < darshan_snapshot.regions[i].chunk_alloc; j++)
+            free(darshan_snapshot.regions[i].chunks[j].comp_buf);
+        free(darshan_snapshot.regions[i].chunks);
+    }
+    memset(darshan_snapshot.regions, 0, sizeof(darshan_snapshot.regions));
+    free(darshan_snapshot.name_enc_buf);
+    darshan_snapshot.name_enc_buf = NULL;
+    darshan_snapshot.name_enc_len = 0;
+    darshan_snapshot.name_enc_size = 0;
+    darshan_snapshot.name_mem_done = 0;
+    free(darshan_snapshot.comp_buf);
+    darshan_snapshot.comp_buf = NULL;
+    darshan_snapshot.seq = 0;
+    darshan_snapshot.running = 0;
+
+    return;
+}
+
 static int darshan_deflate_buffer(void **pointers, int *lengths, int count,
-    char *comp_buf, int *comp_buf_length)
+    char *comp_buf, int *comp_buf_length, int comp_type, int comp_level)
 {
     int ret = 0;
     int i;
     int total_target = 0;
     z_stream tmp_stream;
 
+#ifdef HAVE_LIBZSTD
+    if(comp_type == DARSHAN_ZSTD_COMP)
+        return(darshan_zstd_buffer(pointers, lengths, count, comp_buf,
+            comp_buf_length, comp_level));
+#endif
+    if(comp_level > 9)
+        comp_level = 9;
+
     /* just return if there is no data */
     for(i = 0; i < count; i++)
     {
@@ -2120,7 +3457,7 @@ static int darshan_deflate_buffer(void **pointers, int *lengths, int count,
     /* TODO: check these parameters? */
 //    ret = deflateInit2(&tmp_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
 //        15 + 16, 8, Z_DEFAULT_STRATEGY);
-    ret = deflateInit(&tmp_stream, Z_DEFAULT_COMPRESSION);
+    ret = deflateInit(&tmp_stream, comp_level);
     if(ret != Z_OK)
     {
         return(-1);
@@ -2174,6 +3511,205 @@ static int darshan_deflate_buffer(void **pointers, int *lengths, int count,
     return(0);
 }
 
+#ifdef HAVE_LIBZSTD
+/* zstd equivalent of darshan_deflate_buffer(), producing a single frame */
+static int darshan_zstd_buffer(void **pointers, int *lengths, int count,
+    char *comp_buf, int *comp_buf_length, int comp_level)
+{
+    ZSTD_CCtx *cctx;
+    ZSTD_inBuffer in;
+    ZSTD_outBuffer out;
+    size_t zret;
+    int total = 0;
+    int i;
+
+    /* just return if there is no data */
+    for(i = 0; i < count; i++)
+        total += lengths[i];
+    if(total == 0)
+    {
+        *comp_buf_length = 0;
+        return(0);
+    }
+
+    cctx = ZSTD_createCCtx();
+    if(!cctx)
+        return(-1);
+    if(comp_level < 0)
+        comp_level = ZSTD_CLEVEL_DEFAULT;
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, comp_level);
+
+    out.dst = comp_buf;
+    out.size = (size_t)(*comp_buf_length);
+    out.pos = 0;
+
+    /* loop over the input pointers, ending the frame with the last one */
+    for(i = 0; i < count; i++)
+    {
+        ZSTD_EndDirective mode = (i == count - 1) ? ZSTD_e_end : ZSTD_e_continue;
+
+        in.src = pointers[i];
+        in.size = lengths[i];
+        in.pos = 0;
+        do
+        {
+            zret = ZSTD_compressStream2(cctx, &out, &in, mode);
+            /* running out of output space is treated as an error, as
+             * in darshan_deflate_buffer()
+             */
+            if(ZSTD_isError(zret) || (zret != 0 && out.pos == out.size))
+            {
+                ZSTD_freeCCtx(cctx);
+                return(-1);
+            }
+        } while(in.pos < in.size || (mode == ZSTD_e_end && zret != 0));
+    }
+    ZSTD_freeCCtx(cctx);
+
+    *comp_buf_length = out.pos;
+    return(0);
+}
+#endif
+
+/* shared state for threads compressing chunks of a buffer */
+struct darshan_deflate_chunk_state
+{
+    char *buf;
+    int length;
+    int nchunks;
+    char **chunk_bufs;
+    int *chunk_lengths;
+    int comp_type;
+    int comp_level;
+    int next_chunk;
+    int err;
+    pthread_mutex_t mutex;
+};
+
+static void *darshan_deflate_chunk_worker(void *arg)
+{
+    struct darshan_deflate_chunk_state *state = arg;
+    void *chunk_p;
+    int chunk_len;
+    int ret;
+    int i;
+
+    while(1)
+    {
+        pthread_mutex_lock(&state->mutex);
+        i = state->next_chunk++;
+        pthread_mutex_unlock(&state->mutex);
+        if(i >= state->nchunks)
+            break;
+
+        chunk_p = state->buf + (size_t)i * DARSHAN_COMP_CHUNK_SIZE;
+        chunk_len = state->length - i * DARSHAN_COMP_CHUNK_SIZE;
+        if(chunk_len > DARSHAN_COMP_CHUNK_SIZE)
+            chunk_len = DARSHAN_COMP_CHUNK_SIZE;
+        ret = darshan_deflate_buffer(&chunk_p, &chunk_len, 1,
+            state->chunk_bufs[i], &state->chunk_lengths[i], state->comp_type,
+            state->comp_level);
+        if(ret < 0)
+        {
+            pthread_mutex_lock(&state->mutex);
+            state->err = 1;
+            pthread_mutex_unlock(&state->mutex);
+        }
+    }
+
+    return(NULL);
+}
+
+/* compress a buffer as a sequence of independent zlib streams, one for each
+ * DARSHAN_COMP_CHUNK_SIZE bytes of input, using up to 'nthreads' threads.
+ * The compressed length of each chunk is returned in 'chunk_lengths'.
+ */
+static int darshan_deflate_buffer_chunked(char *buf, int length,
+    char *comp_buf, int *comp_buf_length, int *chunk_lengths, int comp_type,
+    int comp_level, int nthreads)
+{
+    struct darshan_deflate_chunk_state state;
+    pthread_t *threads;
+    int nstarted = 0;
+    uLong chunk_bound;
+    char *chunk_mem;
+    int total = 0;
+    int i;
+
+    memset(&state, 0, sizeof(state));
+    state.buf = buf;
+    state.length = length;
+    state.nchunks = (length + DARSHAN_COMP_CHUNK_SIZE - 1) / DARSHAN_COMP_CHUNK_SIZE;
+    state.chunk_lengths = chunk_lengths;
+    state.comp_type = comp_type;
+    state.comp_level = comp_level;
+    pthread_mutex_init(&state.mutex, NULL);
+    if(nthreads > state.nchunks)
+        nthreads = state.nchunks;
+
+    /* each chunk is compressed into its own staging buffer */
+#ifdef HAVE_LIBZSTD
+    if(comp_type == DARSHAN_ZSTD_COMP)
+        chunk_bound = ZSTD_compressBound(DARSHAN_COMP_CHUNK_SIZE);
+    else
+#endif
+    chunk_bound = compressBound(DARSHAN_COMP_CHUNK_SIZE);
+    chunk_mem = malloc(state.nchunks * chunk_bound);
+    state.chunk_bufs = malloc(state.nchunks * sizeof(*state.chunk_bufs));
+    threads = malloc(nthreads * sizeof(*threads));
+    if(!chunk_mem || !state.chunk_bufs || !threads)
+    {
+        free(chunk_mem);
+        free(state.chunk_bufs);
+        free(threads);
+        pthread_mutex_destroy(&state.mutex);
+        return(-1);
+    }
+    for(i = 0; i < state.nchunks; i++)
+    {
+        state.chunk_bufs[i] = chunk_mem + i * chunk_bound;
+        state.chunk_lengths[i] = chunk_bound;
+    }
+
+    /* the calling thread works on chunks too, and will compress all of
+     * them itself if helper threads cannot be created
+     */
+    for(i = 0; i < nthreads - 1; i++)
+    {
+        if(pthread_create(&threads[nstarted], NULL,
+            darshan_deflate_chunk_worker, &state) == 0)
+            nstarted++;
+    }
+    darshan_deflate_chunk_worker(&state);
+    for(i = 0; i < nstarted; i++)
+        pthread_join(threads[i], NULL);
+
+    /* concatenate the compressed chunks into the output buffer */
+    if(!state.err)
+    {
+        for(i = 0; i < state.nchunks; i++)
+        {
+            if(total + state.chunk_lengths[i] > *comp_buf_length)
+            {
+                state.err = 1;
+                break;
+            }
+            memcpy(comp_buf + total, state.chunk_bufs[i], state.chunk_lengths[i]);
+            total += state.chunk_lengths[i];
+        }
+    }
+
+    free(chunk_mem);
+    free(state.chunk_bufs);
+    free(threads);
+    pthread_mutex_destroy(&state.mutex);
+
+    if(state.err)
+        return(-1);
+    *comp_buf_length = total;
+    return(0);
+}
+
 /* free darshan core data structures to shutdown */
 static void darshan_core_cleanup(struct darshan_core_runtime* core)
 {
@@ -2212,13 +3748,23 @@ static void darshan_core_cleanup(struct darshan_core_runtime* core)
 
     if(core->comp_buf)
         free(core->comp_buf);
+    free(core->chunk_index);
+    free(core->rec_index);
+    darshan_path_trie_destroy(core->path_trie);
+#ifdef HAVE_MPI
+    free(core->agg_buf);
+#endif
     free(core);
 
+    darshan_core_arena_release_all();
+
     return;
 }
 
 static void darshan_core_fork_child_cb(void)
 {
+    int i;
+
     if(__darshan_core)
     {
         /* hold onto the original parent PID, which we will use as jobid if the user didn't
@@ -2228,6 +3774,14 @@ static void darshan_core_fork_child_cb(void)
         if(!orig_parent_pid)
             orig_parent_pid = parent_pid;
 
+        /* the arena locks may have been held by another thread at fork time */
+        pthread_mutex_init(&darshan_core_arena_mutex, NULL);
+        for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+        {
+            if(darshan_core_arenas[i].created)
+                pthread_mutex_init(&darshan_core_arenas[i].mutex, NULL);
+        }
+
         /* shutdown and re-init darshan, making sure to not write out a log file */
         darshan_core_shutdown(0);
         darshan_core_initialize(0, NULL);
@@ -2236,12 +3790,27 @@ static void darshan_core_fork_child_cb(void)
     return;
 }
 
-static int darshan_core_name_is_excluded(const char *name, darshan_module_id mod_id)
+/* matches a record name against a config regex, skipping the regex
+ * evaluation when the name does not start with the regex's literal prefix
+ */
+static int darshan_core_regex_match(struct darshan_core_regex *regex,
+    const char *name)
+{
+    if(regex->prefix_len &&
+        strncmp(name, regex->regex_str + 1, regex->prefix_len) != 0)
+        return(0);
+
+    return(regexec(&regex->regex, name, 0, NULL, 0) == 0);
+}
+
+/* 'path_flags' are the flags of the prefixes in the core's path trie
+ * that match the record name
+ */
+static int darshan_core_name_is_excluded(const char *name, darshan_module_id mod_id,
+    int path_flags)
 {
     int name_is_path;
     int name_excluded = 0, name_included = 0;
-    char *path_exclusion, *path_inclusion;
-    int tmp_index = 0;
     struct darshan_core_regex *regex;
 
     if(!name)
@@ -2253,30 +3822,12 @@ static int darshan_core_name_is_excluded(const char *name, darshan_module_id mod
        (mod_id == DARSHAN_HEATMAP_MOD) || (mod_id == DARSHAN_MDHIM_MOD))
         name_is_path = 0;
 
-    if(name_is_path)
+    if(name_is_path && (path_flags & DARSHAN_PATH_EXCLUDED))
     {
-        /* if record name is a path, check against either default or
-         * user-provided path exclusions
+        /* record name is a path matching either default or user-provided
+         * path exclusions
          */
-
-        /* if user has set DARSHAN_EXCLUDE_DIRS, override the default ones */
-        if (__darshan_core->config.user_exclude_dirs != NULL) {
-            while((path_exclusion = __darshan_core->config.user_exclude_dirs[tmp_index++])) {
-                if(!(strncmp(path_exclusion, name, strlen(path_exclusion)))) {
-                    name_excluded = 1;
-                    break;
-                }
-            }
-        }
-        else {
-            /* scan default exclusion list for paths to exclude */
-            while((path_exclusion = __darshan_core->config.exclude_dirs[tmp_index++])) {
-                if(!(strncmp(path_exclusion, name, strlen(path_exclusion)))) {
-                    name_excluded = 1;
-                    break;
-                }
-            }
-        }
+        name_excluded = 1;
     }
 
     if(!name_excluded)
@@ -2287,7 +3838,7 @@ static int darshan_core_name_is_excluded(const char *name, darshan_module_id mod
         LL_FOREACH(__darshan_core->config.rec_exclusion_list, regex)
         {
             if(DARSHAN_MOD_FLAG_ISSET(regex->mod_flags, mod_id) &&
-                (regexec(&regex->regex, name, 0, NULL, 0) == 0))
+                darshan_core_regex_match(regex, name))
             {
                 name_excluded = 1;
                 break;
@@ -2295,16 +3846,12 @@ static int darshan_core_name_is_excluded(const char *name, darshan_module_id mod
         }
     }
 
-    if(name_is_path && name_excluded && !__darshan_core->config.user_exclude_dirs)
+    if(name_is_path && name_excluded && (path_flags & DARSHAN_PATH_INCLUDED))
     {
-        /* if record name is a path, check against default path inclusions */
-        tmp_index = 0;
-        while((path_inclusion = __darshan_core->config.include_dirs[tmp_index++])) {
-            if(!(strncmp(path_inclusion, name, strlen(path_inclusion)))) {
-                name_included = 1;
-                break;
-            }
-        }
+        /* record name is a path matching default path inclusions (these
+         * are not in the path trie if the user set DARSHAN_EXCLUDE_DIRS)
+         */
+        name_included = 1;
     }
 
     if(name_excluded && !name_included)
@@ -2315,7 +3862,7 @@ static int darshan_core_name_is_excluded(const char *name, darshan_module_id mod
         LL_FOREACH(__darshan_core->config.rec_inclusion_list, regex)
         {
             if(DARSHAN_MOD_FLAG_ISSET(regex->mod_flags, mod_id) &&
-                (regexec(&regex->regex, name, 0, NULL, 0) == 0))
+                darshan_core_regex_match(regex, name))
             {
                 name_included = 1;
                 break;
@@ -2415,9 +3962,16 @@ extern void darshan_mpiio_shutdown_bench_setup(int);
 #ifdef HAVE_MPI
 void darshan_shutdown_bench(int argc, char **argv)
 {
-    /* clear out existing core runtime structure */
+    int i;
+
+    /* clear out existing core runtime structure, cleaning up any registered
+     * modules first since their state may reside in core-owned arenas
+     */
     if(__darshan_core)
     {
+        for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+            if(__darshan_core->mod_array[i])
+                __darshan_core->mod_array[i]->mod_funcs.mod_cleanup_func();
         darshan_core_cleanup(__darshan_core);
         __darshan_core = NULL;
     }
@@ -2647,6 +4201,8 @@ void *darshan_core_register_record(
     struct darshan_fs_info *fs_info)
 {
     void *rec_buf;
+    int mnt_idx;
+    int path_flags;
 
     __DARSHAN_CORE_LOCK();
     if(!__darshan_core)
@@ -2663,7 +4219,10 @@ void *darshan_core_register_record(
         return(NULL);
     }
 
-    if(darshan_core_name_is_excluded(name, mod_id))
+    /* match the name against all mount points and path exclusions at once */
+    mnt_idx = darshan_path_trie_match(__darshan_core->path_trie, name, &path_flags);
+
+    if(darshan_core_name_is_excluded(name, mod_id, path_flags))
     {
         /* do not register record if name matches any exclusion rules */
         __DARSHAN_CORE_UNLOCK();
@@ -2703,7 +4262,7 @@ void *darshan_core_register_record(
     __DARSHAN_CORE_UNLOCK();
 
     if(fs_info)
-        darshan_fs_info_from_path(name, fs_info);
+        darshan_fs_info_from_mnt(mnt_idx, fs_info);
 
     return(rec_buf);
 }
@@ -2723,6 +4282,194 @@ char *darshan_core_lookup_record_name(darshan_record_id rec_id)
     return(name);
 }
 
+const struct darshan_config *darshan_core_get_config()
+{
+    const struct darshan_config *cfg = NULL;
+
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        cfg = &__darshan_core->config;
+    __DARSHAN_CORE_UNLOCK();
+
+    return(cfg);
+}
+
+/* map a (header-inclusive) allocation size to an arena size class */
+static int darshan_core_arena_size_class(size_t size, size_t *class_size)
+{
+    int size_class;
+    size_t csize;
+
+    if(size <= DARSHAN_ARENA_SMALL_MAX)
+    {
+        size_class = (size + 15) / 16 - 1;
+        *class_size = (size_class + 1) * 16;
+        return(size_class);
+    }
+
+    size_class = DARSHAN_ARENA_SMALL_MAX / 16;
+    csize = DARSHAN_ARENA_SMALL_MAX * 2;
+    while(csize < size && size_class < DARSHAN_ARENA_NCLASSES - 1)
+    {
+        csize *= 2;
+        size_class++;
+    }
+    if(csize < size)
+    {
+        *class_size = size;
+        return(DARSHAN_ARENA_LARGE_CLASS);
+    }
+    *class_size = csize;
+    return(size_class);
+}
+
+void *darshan_core_arena_alloc(darshan_module_id mod_id, size_t size)
+{
+    struct darshan_core_arena *arena;
+    struct darshan_core_arena_slab *slab;
+    struct darshan_core_arena_hdr *hdr = NULL;
+    size_t class_size, slab_size;
+    int size_class;
+
+    if(mod_id >= DARSHAN_KNOWN_MODULE_COUNT)
+        return(NULL);
+    arena = &darshan_core_arenas[mod_id];
+    if(!arena->created)
+        return(NULL);
+    size_class = darshan_core_arena_size_class(size + sizeof(*hdr), &class_size);
+
+    pthread_mutex_lock(&arena->mutex);
+    if(size_class != DARSHAN_ARENA_LARGE_CLASS && arena->free_lists[size_class])
+    {
+        /* reuse a previously freed chunk of this size class */
+        hdr = arena->free_lists[size_class];
+        arena->free_lists[size_class] = *(void **)hdr;
+    }
+    else
+    {
+        if(size_class == DARSHAN_ARENA_LARGE_CLASS || arena->slab_avail < class_size)
+        {
+            /* large allocations get a dedicated slab; otherwise start a new
+             * slab, abandoning whatever remains of the current one
+             */
+            slab_size = sizeof(*slab) + class_size;
+            if(slab_size < DARSHAN_ARENA_SLAB_SIZE &&
+                size_class != DARSHAN_ARENA_LARGE_CLASS)
+                slab_size = DARSHAN_ARENA_SLAB_SIZE;
+            slab = malloc(slab_size);
+            if(!slab)
+            {
+                pthread_mutex_unlock(&arena->mutex);
+                return(NULL);
+            }
+            slab->size = slab_size;
+            LL_PREPEND(arena->slabs, slab);
+            arena->reserved_bytes += slab_size;
+            hdr = (struct darshan_core_arena_hdr *)(slab + 1);
+            if(size_class != DARSHAN_ARENA_LARGE_CLASS)
+            {
+                arena->slab_cur = (char *)hdr + class_size;
+                arena->slab_avail = slab_size - sizeof(*slab) - class_size;
+            }
+        }
+        else
+        {
+            hdr = (struct darshan_core_arena_hdr *)arena->slab_cur;
+            arena->slab_cur += class_size;
+            arena->slab_avail -= class_size;
+        }
+    }
+    arena->used_bytes += class_size;
+    if(arena->used_bytes > arena->peak_used_bytes)
+        arena->peak_used_bytes = arena->used_bytes;
+    arena->nallocs++;
+    pthread_mutex_unlock(&arena->mutex);
+
+    memset(hdr, 0, class_size);
+    hdr->size = class_size;
+    hdr->mod_id = mod_id;
+    hdr->size_class = size_class;
+
+    return(hdr + 1);
+}
+
+void darshan_core_arena_free(void *ptr)
+{
+    struct darshan_core_arena_hdr *hdr;
+    struct darshan_core_arena *arena;
+
+    if(!ptr)
+        return;
+
+    hdr = (struct darshan_core_arena_hdr *)ptr - 1;
+    arena = &darshan_core_arenas[hdr->mod_id];
+
+    pthread_mutex_lock(&arena->mutex);
+    arena->used_bytes -= hdr->size;
+    /* large allocations are simply held until the arena is released */
+    if(hdr->size_class != DARSHAN_ARENA_LARGE_CLASS)
+    {
+        *(void **)hdr = arena->free_lists[hdr->size_class];
+        arena->free_lists[hdr->size_class] = hdr;
+    }
+    pthread_mutex_unlock(&arena->mutex);
+
+    return;
+}
+
+/* create any module arenas that do not exist yet; arenas (and their locks)
+ * persist across releases, so this only does work on first initialization
+ */
+static void darshan_core_arena_create_all()
+{
+    int i;
+
+    pthread_mutex_lock(&darshan_core_arena_mutex);
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(darshan_core_arenas[i].created)
+            continue;
+        pthread_mutex_init(&darshan_core_arenas[i].mutex, NULL);
+        darshan_core_arenas[i].created = 1;
+    }
+    pthread_mutex_unlock(&darshan_core_arena_mutex);
+
+    return;
+}
+
+/* release all memory held by module arenas back to the system */
+static void darshan_core_arena_release_all()
+{
+    struct darshan_core_arena *arena;
+    struct darshan_core_arena_slab *slab, *tmp;
+    int i;
+
+    pthread_mutex_lock(&darshan_core_arena_mutex);
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        arena = &darshan_core_arenas[i];
+        if(!arena->created)
+            continue;
+        pthread_mutex_lock(&arena->mutex);
+        LL_FOREACH_SAFE(arena->slabs, slab, tmp)
+        {
+            free(slab);
+        }
+        arena->slabs = NULL;
+        arena->slab_cur = NULL;
+        arena->slab_avail = 0;
+        memset(arena->free_lists, 0, sizeof(arena->free_lists));
+        arena->reserved_bytes = 0;
+        arena->used_bytes = 0;
+        arena->peak_used_bytes = 0;
+        arena->nallocs = 0;
+        pthread_mutex_unlock(&arena->mutex);
+    }
+    pthread_mutex_unlock(&darshan_core_arena_mutex);
+
+    return;
+}
+
 void darshan_instrument_fs_data(int fs_type, darshan_record_id rec_id, int fd)
 {
 #ifdef DARSHAN_LUSTRE
@@ -17,7 +17,6 @@
 #include <time.h>
 #include <stdlib.h>
 #include <errno.h>
-#include <search.h>
 #include <assert.h>
 #include <pthread.h>
 #include <limits.h>
@@ -102,8 +101,7 @@ struct daos_object_record_ref
     double last_meta_end;
     double last_read_end;
     double last_write_end;
-    void *access_root;
-    int access_count;
+    struct darshan_common_val_table access_table;
 };
 
 struct daos_poolcont_info
@@ -120,15 +118,13 @@ struct daos_runtime
     void *rec_id_hash;
     void *oh_hash;
     int obj_rec_count;
-    darshan_record_id heatmap_id;
+    struct heatmap_record_ref *heatmap;
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
 static void daos_runtime_initialize();
 static struct daos_object_record_ref *daos_track_new_object_record(
     darshan_record_id rec_id, daos_obj_id_t oid, struct daos_poolcont_info *poolcont_info);
-static void daos_finalize_object_records(
-    void *rec_ref_p, void *user_ptr);
 #ifdef HAVE_MPI
 static void daos_record_reduction_op(
     void* inobj_v, void* inoutobj_v, int *len, MPI_Datatype *datatype);
@@ -223,7 +219,7 @@ static int my_rank = -1;
     DARSHAN_TIMER_INC_NO_OVERLAP(__rec_ref->object_rec->fcounters[DAOS_F_META_TIME], \
         __tm1, __tm2, __rec_ref->last_meta_end); \
     darshan_add_record_ref(&(daos_runtime->oh_hash), __oh_p, \
-        sizeof(daos_handle_t), __rec_ref); \
+        sizeof(daos_handle_t), __rec_ref, DARSHAN_DAOS_MOD); \
 } while(0)
 
 #define DAOS_RECORD_OBJ_READ(__oh, __counter, __sz, __is_async, __tm1, __tm2) do { \
@@ -237,13 +233,12 @@ static int my_rank = -1;
     if(__counter == DAOS_ARRAY_READS) \
         __tmp_sz *= __rec_ref->object_rec->counters[DAOS_ARRAY_CELL_SIZE];\
     /* heatmap to record traffic summary */ \
-    heatmap_update(daos_runtime->heatmap_id, HEATMAP_READ, __tmp_sz, __tm1, __tm2); \
+    heatmap_update(daos_runtime->heatmap, HEATMAP_READ, __tmp_sz, __tm1, __tm2); \
     __rec_ref->object_rec->counters[__counter] += 1; \
     if(__is_async) __rec_ref->object_rec->counters[DAOS_NB_OPS] += 1; \
     __rec_ref->object_rec->counters[DAOS_BYTES_READ] += __tmp_sz; \
     DARSHAN_BUCKET_INC(&(__rec_ref->object_rec->counters[DAOS_SIZE_READ_0_100]), __tmp_sz); \
-    __cvc = darshan_track_common_val_counters(&__rec_ref->access_root, &__tmp_sz, 1, \
-        &__rec_ref->access_count); \
+    __cvc = darshan_track_common_val_counters(&__rec_ref->access_table, &__tmp_sz, 1); \
     if(__cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(__rec_ref->object_rec->counters[DAOS_ACCESS1_ACCESS]), \
         &(__rec_ref->object_rec->counters[DAOS_ACCESS1_COUNT]), \
@@ -274,13 +269,12 @@ static int my_rank = -1;
     if(__counter == DAOS_ARRAY_WRITES) \
         __tmp_sz *= __rec_ref->object_rec->counters[DAOS_ARRAY_CELL_SIZE];\
     /* heatmap to record traffic summary */ \
-    heatmap_update(daos_runtime->heatmap_id, HEATMAP_WRITE, __tmp_sz, __tm1, __tm2); \
+    heatmap_update(daos_runtime->heatmap, HEATMAP_WRITE, __tmp_sz, __tm1, __tm2); \
     __rec_ref->object_rec->counters[__counter] += 1; \
     if(__is_async) __rec_ref->object_rec->counters[DAOS_NB_OPS] += 1; \
     __rec_ref->object_rec->counters[DAOS_BYTES_WRITTEN] += __tmp_sz; \
     DARSHAN_BUCKET_INC(&(__rec_ref->object_rec->counters[DAOS_SIZE_WRITE_0_100]), __tmp_sz); \
-    __cvc = darshan_track_common_val_counters(&__rec_ref->access_root, &__tmp_sz, 1, \
-        &__rec_ref->access_count); \
+    __cvc = darshan_track_common_val_counters(&__rec_ref->access_table, &__tmp_sz, 1); \
     if(__cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(__rec_ref->object_rec->counters[DAOS_ACCESS1_ACCESS]), \
         &(__rec_ref->object_rec->counters[DAOS_ACCESS1_COUNT]), \
@@ -1807,7 +1801,7 @@ static void daos_runtime_initialize()
     memset(daos_runtime, 0, sizeof(*daos_runtime));
 
     /* register a heatmap */
-    daos_runtime->heatmap_id = heatmap_register("heatmap:DAOS");
+    daos_runtime->heatmap = heatmap_register("heatmap:DAOS");
 
     return;
 }
@@ -1819,17 +1813,16 @@ static struct daos_object_record_ref *daos_track_new_object_record(
     struct daos_object_record_ref *rec_ref = NULL;
     int ret;
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_core_arena_alloc(DARSHAN_DAOS_MOD, sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this object record based on record id */
     ret = darshan_add_record_ref(&(daos_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+        sizeof(darshan_record_id), rec_ref, DARSHAN_DAOS_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -1847,7 +1840,7 @@ static struct daos_object_record_ref *daos_track_new_object_record(
     {
         darshan_delete_record_ref(&(daos_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -1864,15 +1857,6 @@ static struct daos_object_record_ref *daos_track_new_object_record(
     return(rec_ref);
 }
 
-static void daos_finalize_object_records(void *rec_ref_p, void *user_ptr)
-{
-    struct daos_object_record_ref *rec_ref =
-        (struct daos_object_record_ref *)rec_ref_p;
-
-    tdestroy(rec_ref->access_root, free);
-    return;
-}
-
 #ifdef HAVE_MPI
 static void daos_record_reduction_op(
     void* inobj_v, void* inoutobj_v, int *len, MPI_Datatype *datatype)
@@ -2238,8 +2222,6 @@ static void daos_cleanup()
     assert(daos_runtime);
 
     /* cleanup internal structures used for instrumenting */
-    darshan_iter_record_refs(daos_runtime->rec_id_hash,
-        &daos_finalize_object_records, NULL);
     darshan_clear_record_refs(&(daos_runtime->oh_hash), 0);
     darshan_clear_record_refs(&(daos_runtime->rec_id_hash), 1);
 
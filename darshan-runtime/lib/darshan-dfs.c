@@ -17,7 +17,6 @@
 #include <time.h>
 #include <stdlib.h>
 #include <errno.h>
-#include <search.h>
 #include <assert.h>
 #include <pthread.h>
 #include <limits.h>
@@ -86,8 +85,7 @@ struct dfs_file_record_ref
     double last_meta_end;
     double last_read_end;
     double last_write_end;
-    void *access_root;
-    int access_count;
+    struct darshan_common_val_table access_table;
 };
 
 struct dfs_mount_info
@@ -103,15 +101,13 @@ struct dfs_runtime
     void *rec_id_hash;
     void *file_obj_hash;
     int file_rec_count;
-    darshan_record_id heatmap_id;
+    struct heatmap_record_ref *heatmap;
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
 static void dfs_runtime_initialize();
 static struct dfs_file_record_ref *dfs_track_new_file_record(
     darshan_record_id rec_id, const char *path, struct dfs_mount_info *mnt_info);
-static void dfs_finalize_file_records(
-    void *rec_ref_p, void *user_ptr);
 #ifdef HAVE_MPI
 static void dfs_record_reduction_op(
     void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
@@ -238,7 +234,7 @@ static int my_rank = -1;
     __rec_ref->file_rec->fcounters[DFS_F_OPEN_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(__rec_ref->file_rec->fcounters[DFS_F_META_TIME], \
         __tm1, __tm2, __rec_ref->last_meta_end); \
-    darshan_add_record_ref(&(dfs_runtime->file_obj_hash), __obj_p, sizeof(*__obj_p), __rec_ref); \
+    darshan_add_record_ref(&(dfs_runtime->file_obj_hash), __obj_p, sizeof(*__obj_p), __rec_ref, DARSHAN_DFS_MOD); \
 } while(0)
 
 #define DFS_RECORD_READ(__obj, __read_size, __counter, __is_async, __tm1, __tm2) do { \
@@ -250,14 +246,13 @@ static int my_rank = -1;
     __rec_ref = darshan_lookup_record_ref(dfs_runtime->file_obj_hash, &__obj, sizeof(__obj)); \
     if(!__rec_ref) break; \
     /* heatmap to record traffic summary */ \
-    heatmap_update(dfs_runtime->heatmap_id, HEATMAP_READ, __sz, __tm1, __tm2); \
+    heatmap_update(dfs_runtime->heatmap, HEATMAP_READ, __sz, __tm1, __tm2); \
     __rec_ref->file_rec->counters[__counter] += 1; \
     if(__is_async) \
         __rec_ref->file_rec->counters[DFS_NB_READS] += 1; \
     __rec_ref->file_rec->counters[DFS_BYTES_READ] += __sz; \
     DARSHAN_BUCKET_INC(&(__rec_ref->file_rec->counters[DFS_SIZE_READ_0_100]), __sz); \
-    __cvc = darshan_track_common_val_counters(&__rec_ref->access_root, &__sz, 1, \
-        &__rec_ref->access_count); \
+    __cvc = darshan_track_common_val_counters(&__rec_ref->access_table, &__sz, 1); \
     if(__cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(__rec_ref->file_rec->counters[DFS_ACCESS1_ACCESS]), \
         &(__rec_ref->file_rec->counters[DFS_ACCESS1_COUNT]), \
@@ -289,14 +284,13 @@ static int my_rank = -1;
     __rec_ref = darshan_lookup_record_ref(dfs_runtime->file_obj_hash, &__obj, sizeof(__obj)); \
     if(!__rec_ref) break; \
     /* heatmap to record traffic summary */ \
-    heatmap_update(dfs_runtime->heatmap_id, HEATMAP_WRITE, __sz, __tm1, __tm2); \
+    heatmap_update(dfs_runtime->heatmap, HEATMAP_WRITE, __sz, __tm1, __tm2); \
     __rec_ref->file_rec->counters[__counter] += 1; \
     if(__is_async) \
         __rec_ref->file_rec->counters[DFS_NB_WRITES] += 1; \
     __rec_ref->file_rec->counters[DFS_BYTES_WRITTEN] += __sz; \
     DARSHAN_BUCKET_INC(&(__rec_ref->file_rec->counters[DFS_SIZE_WRITE_0_100]), __sz); \
-    __cvc = darshan_track_common_val_counters(&__rec_ref->access_root, &__sz, 1, \
-        &__rec_ref->access_count); \
+    __cvc = darshan_track_common_val_counters(&__rec_ref->access_table, &__sz, 1); \
     if(__cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(__rec_ref->file_rec->counters[DFS_ACCESS1_ACCESS]), \
         &(__rec_ref->file_rec->counters[DFS_ACCESS1_COUNT]), \
@@ -963,7 +957,7 @@ static void dfs_runtime_initialize()
     memset(dfs_runtime, 0, sizeof(*dfs_runtime));
 
     /* register a heatmap */
-    dfs_runtime->heatmap_id = heatmap_register("heatmap:DFS");
+    dfs_runtime->heatmap = heatmap_register("heatmap:DFS");
 
     return;
 }
@@ -975,17 +969,16 @@ static struct dfs_file_record_ref *dfs_track_new_file_record(
     struct dfs_file_record_ref *rec_ref = NULL;
     int ret;
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_core_arena_alloc(DARSHAN_DFS_MOD, sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this file record based on record id */
     ret = darshan_add_record_ref(&(dfs_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+        sizeof(darshan_record_id), rec_ref, DARSHAN_DFS_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -1003,7 +996,7 @@ static struct dfs_file_record_ref *dfs_track_new_file_record(
     {
         darshan_delete_record_ref(&(dfs_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -1021,15 +1014,6 @@ static struct dfs_file_record_ref *dfs_track_new_file_record(
     return(rec_ref);
 }
 
-static void dfs_finalize_file_records(void *rec_ref_p, void *user_ptr)
-{
-    struct dfs_file_record_ref *rec_ref =
-        (struct dfs_file_record_ref *)rec_ref_p;
-
-    tdestroy(rec_ref->access_root, free);
-    return;
-}
-
 #ifdef HAVE_MPI
 static void dfs_record_reduction_op(
     void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype)
@@ -1375,8 +1359,6 @@ static void dfs_cleanup()
     assert(dfs_runtime);
 
     /* cleanup internal structures used for instrumenting */
-    darshan_iter_record_refs(dfs_runtime->rec_id_hash,
-        &dfs_finalize_file_records, NULL);
     darshan_clear_record_refs(&(dfs_runtime->file_obj_hash), 0);
     darshan_clear_record_refs(&(dfs_runtime->rec_id_hash), 1);
 
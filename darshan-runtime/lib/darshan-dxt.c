@@ -54,9 +54,44 @@ typedef int64_t off64_t;
  */
 #define DXT_DEF_RECORD_SIZE 1024
 
-/* initial size of read/write trace buffer (in number of segments) */
-/* NOTE: when this size is exceeded, the buffer size is doubled */
-#define IO_TRACE_BUF_SIZE       64
+/* number of trace segments stored in each segment block */
+#define DXT_SEG_BLOCK_SIZE      64
+
+/* indices of the write and read trace block lists */
+#define DXT_WRITE_TRACE 0
+#define DXT_READ_TRACE  1
+
+/* index of a DXT module in per-module arrays */
+#define DXT_MOD_IDX(__mod_id) ((__mod_id) == DXT_POSIX_MOD ? 0 : 1)
+
+/* Trace segments are stored in fixed-size blocks drawn from a pool that is
+ * preallocated when each DXT module is initialized. A block is only ever
+ * appended to by a single thread, so the number of valid segments in it is
+ * published with release semantics once each segment is filled in. Blocks
+ * are never resized; the blocks belonging to a record are stitched together
+ * into contiguous write/read traces only when the record is serialized.
+ */
+struct dxt_seg_block
+{
+    struct dxt_seg_block *next; /* next (older) block in the record's list */
+    void *owner;                /* thread state appending to this block */
+#ifdef HAVE_STDATOMIC_H
+    atomic_int count;
+#else
+    int count;
+#endif
+    segment_info segs[DXT_SEG_BLOCK_SIZE];
+};
+
+#ifdef HAVE_STDATOMIC_H
+#define DXT_BLOCK_COUNT(__blk) \
+    atomic_load_explicit(&(__blk)->count, memory_order_acquire)
+#define DXT_BLOCK_SET_COUNT(__blk, __count) \
+    atomic_store_explicit(&(__blk)->count, __count, memory_order_release)
+#else
+#define DXT_BLOCK_COUNT(__blk) ((__blk)->count)
+#define DXT_BLOCK_SET_COUNT(__blk, __count) ((__blk)->count = (__count))
+#endif
 
 /* The dxt_file_record_ref structure maintains necessary runtime metadata
  * for the DXT file record (dxt_file_record structure, defined in
@@ -75,11 +110,10 @@ struct dxt_file_record_ref
 {
     struct dxt_file_record *file_rec;
 
-    int64_t write_available_buf;
-    int64_t read_available_buf;
-
-    segment_info *write_traces;
-    segment_info *read_traces;
+    /* write and read trace blocks, newest first */
+    struct dxt_seg_block *blocks[2];
+    int multi_thread; /* flag: blocks were appended to by multiple threads */
+    int dropped; /* flag: record was filtered out by a trace trigger */
 };
 
 /* The dxt_runtime structure maintains necessary state for storing
@@ -91,19 +125,49 @@ struct dxt_runtime
     void *rec_id_hash;
     int file_rec_count;
     size_t mem_allocated;
-    size_t mem_used;
+    struct dxt_seg_block *block_pool;
+    int block_pool_size;
+    int block_pool_next;
     char *record_buf;
     int record_buf_size;
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
+#ifdef HAVE_STDATOMIC_H
+/* The dxt_thread_stream structure tracks the blocks a thread is currently
+ * appending write and read segments to for a given record.
+ */
+struct dxt_thread_stream
+{
+    darshan_record_id rec_id;
+    struct dxt_seg_block *blocks[2];
+    UT_hash_handle hlink;
+};
+
+/* per-thread DXT state. A thread appends to its current block for a record
+ * without acquiring the DXT lock, falling back to the locked path only to
+ * obtain a new block. These structures are linked into a global list
+ * (protected by the DXT lock) and are never freed, since a thread may still
+ * reference its state via TLS after the DXT modules are cleaned up.
+ */
+struct dxt_thread_state
+{
+    atomic_int busy;
+    pid_t pid; /* process that created this state */
+    struct dxt_thread_stream *stream_hash[2]; /* POSIX, MPI-IO */
+    struct dxt_thread_state *next;
+};
+#endif
+
 /* internal helper routines */
-static void check_wr_trace_buf(
-    struct dxt_file_record_ref *rec_ref, darshan_module_id mod_id,
-    struct dxt_runtime *runtime);
-static void check_rd_trace_buf(
-    struct dxt_file_record_ref *rec_ref, darshan_module_id mod_id,
-    struct dxt_runtime *runtime);
+static void dxt_trace_segment(
+    darshan_module_id mod_id, int trace_type, darshan_record_id rec_id,
+    int64_t offset, int64_t length, double start_time, double end_time);
+static struct dxt_seg_block *dxt_get_seg_block(
+    struct dxt_runtime *runtime, darshan_module_id mod_id,
+    struct dxt_file_record_ref *rec_ref, int trace_type, void *owner);
+static void dxt_freeze(
+    struct dxt_runtime *runtime, darshan_module_id mod_id);
 static struct dxt_file_record_ref *dxt_posix_track_new_file_record(
     darshan_record_id rec_id);
 static struct dxt_file_record_ref *dxt_mpiio_track_new_file_record(
@@ -127,6 +191,11 @@ static struct dxt_runtime *dxt_posix_runtime = NULL;
 static struct dxt_runtime *dxt_mpiio_runtime = NULL;
 static pthread_mutex_t dxt_runtime_mutex =
             PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+#ifdef HAVE_STDATOMIC_H
+static struct dxt_thread_state *dxt_thread_states = NULL;
+static atomic_int dxt_trace_active[2];
+static __thread struct dxt_thread_state *dxt_tls_state = NULL;
+#endif
 
 static int dxt_my_rank = -1;
 
@@ -173,8 +242,26 @@ void dxt_posix_runtime_initialize()
         return;
     }
     memset(dxt_posix_runtime, 0, sizeof(*dxt_posix_runtime));
-    dxt_posix_runtime->mem_used = 0;
     dxt_posix_runtime->mem_allocated = dxt_psx_rec_count * DXT_DEF_RECORD_SIZE;
+
+    /* preallocate enough trace segment blocks to cover the module's memory */
+    dxt_posix_runtime->block_pool_size = dxt_posix_runtime->mem_allocated /
+        (DXT_SEG_BLOCK_SIZE * sizeof(segment_info));
+    if(dxt_posix_runtime->block_pool_size == 0)
+        dxt_posix_runtime->block_pool_size = 1;
+    dxt_posix_runtime->block_pool = malloc(dxt_posix_runtime->block_pool_size *
+        sizeof(struct dxt_seg_block));
+    if(!dxt_posix_runtime->block_pool)
+    {
+        darshan_core_unregister_module(DXT_POSIX_MOD);
+        free(dxt_posix_runtime);
+        dxt_posix_runtime = NULL;
+        DXT_UNLOCK();
+        return;
+    }
+#ifdef HAVE_STDATOMIC_H
+    atomic_store(&dxt_trace_active[DXT_MOD_IDX(DXT_POSIX_MOD)], 1);
+#endif
     DXT_UNLOCK();
 
     return;
@@ -215,8 +302,26 @@ void dxt_mpiio_runtime_initialize()
         return;
     }
     memset(dxt_mpiio_runtime, 0, sizeof(*dxt_mpiio_runtime));
-    dxt_mpiio_runtime->mem_used = 0;
     dxt_mpiio_runtime->mem_allocated = dxt_mpiio_rec_count * DXT_DEF_RECORD_SIZE;
+
+    /* preallocate enough trace segment blocks to cover the module's memory */
+    dxt_mpiio_runtime->block_pool_size = dxt_mpiio_runtime->mem_allocated /
+        (DXT_SEG_BLOCK_SIZE * sizeof(segment_info));
+    if(dxt_mpiio_runtime->block_pool_size == 0)
+        dxt_mpiio_runtime->block_pool_size = 1;
+    dxt_mpiio_runtime->block_pool = malloc(dxt_mpiio_runtime->block_pool_size *
+        sizeof(struct dxt_seg_block));
+    if(!dxt_mpiio_runtime->block_pool)
+    {
+        darshan_core_unregister_module(DXT_MPIIO_MOD);
+        free(dxt_mpiio_runtime);
+        dxt_mpiio_runtime = NULL;
+        DXT_UNLOCK();
+        return;
+    }
+#ifdef HAVE_STDATOMIC_H
+    atomic_store(&dxt_trace_active[DXT_MOD_IDX(DXT_MPIIO_MOD)], 1);
+#endif
     DXT_UNLOCK();
 
     return;
@@ -225,185 +330,29 @@ void dxt_mpiio_runtime_initialize()
 void dxt_posix_write(darshan_record_id rec_id, int64_t offset,
         int64_t length, double start_time, double end_time)
 {
-    struct dxt_file_record_ref* rec_ref = NULL;
-    struct dxt_file_record *file_rec;
-
-    DXT_LOCK();
-
-    if(!dxt_posix_runtime || dxt_posix_runtime->frozen)
-    {
-        DXT_UNLOCK();
-        return;
-    }
-
-    rec_ref = darshan_lookup_record_ref(dxt_posix_runtime->rec_id_hash,
-        &rec_id, sizeof(darshan_record_id));
-    if(!rec_ref)
-    {
-        /* track new dxt file record */
-        rec_ref = dxt_posix_track_new_file_record(rec_id);
-        if(!rec_ref)
-        {
-            DXT_UNLOCK();
-            return;
-        }
-    }
-
-    file_rec = rec_ref->file_rec;
-    check_wr_trace_buf(rec_ref, DXT_POSIX_MOD, dxt_posix_runtime);
-    if(file_rec->write_count == rec_ref->write_available_buf)
-    {
-        /* no more memory for i/o segments ... back out */
-        DXT_UNLOCK();
-        return;
-    }
-
-    rec_ref->write_traces[file_rec->write_count].offset = offset;
-    rec_ref->write_traces[file_rec->write_count].length = length;
-    rec_ref->write_traces[file_rec->write_count].start_time = start_time;
-    rec_ref->write_traces[file_rec->write_count].end_time = end_time;
-    rec_ref->write_traces[file_rec->write_count].pthread_id = (unsigned long)pthread_self();
-    file_rec->write_count += 1;
-
-    DXT_UNLOCK();
+    dxt_trace_segment(DXT_POSIX_MOD, DXT_WRITE_TRACE, rec_id, offset,
+        length, start_time, end_time);
 }
 
 void dxt_posix_read(darshan_record_id rec_id, int64_t offset,
         int64_t length, double start_time, double end_time)
 {
-    struct dxt_file_record_ref* rec_ref = NULL;
-    struct dxt_file_record *file_rec;
-
-    DXT_LOCK();
-
-    if(!dxt_posix_runtime || dxt_posix_runtime->frozen)
-    {
-        DXT_UNLOCK();
-        return;
-    }
-
-    rec_ref = darshan_lookup_record_ref(dxt_posix_runtime->rec_id_hash,
-                &rec_id, sizeof(darshan_record_id));
-    if (!rec_ref)
-    {
-        /* track new dxt file record */
-        rec_ref = dxt_posix_track_new_file_record(rec_id);
-        if(!rec_ref)
-        {
-            DXT_UNLOCK();
-            return;
-        }
-    }
-
-    file_rec = rec_ref->file_rec;
-    check_rd_trace_buf(rec_ref, DXT_POSIX_MOD, dxt_posix_runtime);
-    if(file_rec->read_count == rec_ref->read_available_buf)
-    {
-        /* no more memory for i/o segments ... back out */
-        DXT_UNLOCK();
-        return;
-    }
-
-    rec_ref->read_traces[file_rec->read_count].offset = offset;
-    rec_ref->read_traces[file_rec->read_count].length = length;
-    rec_ref->read_traces[file_rec->read_count].start_time = start_time;
-    rec_ref->read_traces[file_rec->read_count].end_time = end_time;
-    rec_ref->read_traces[file_rec->read_count].pthread_id = (unsigned long)pthread_self();
-    file_rec->read_count += 1;
-
-    DXT_UNLOCK();
+    dxt_trace_segment(DXT_POSIX_MOD, DXT_READ_TRACE, rec_id, offset,
+        length, start_time, end_time);
 }
 
 void dxt_mpiio_write(darshan_record_id rec_id, int64_t offset,
         int64_t length, double start_time, double end_time)
 {
-    struct dxt_file_record_ref* rec_ref = NULL;
-    struct dxt_file_record *file_rec;
-
-    DXT_LOCK();
-
-    if(!dxt_mpiio_runtime || dxt_mpiio_runtime->frozen)
-    {
-        DXT_UNLOCK();
-        return;
-    }
-
-    rec_ref = darshan_lookup_record_ref(dxt_mpiio_runtime->rec_id_hash,
-                &rec_id, sizeof(darshan_record_id));
-    if(!rec_ref)
-    {
-        /* track new dxt file record */
-        rec_ref = dxt_mpiio_track_new_file_record(rec_id);
-        if(!rec_ref)
-        {
-            DXT_UNLOCK();
-            return;
-        }
-    }
-
-    file_rec = rec_ref->file_rec;
-    check_wr_trace_buf(rec_ref, DXT_MPIIO_MOD, dxt_mpiio_runtime);
-    if(file_rec->write_count == rec_ref->write_available_buf)
-    {
-        /* no more memory for i/o segments ... back out */
-        DXT_UNLOCK();
-        return;
-    }
-
-    rec_ref->write_traces[file_rec->write_count].length = length;
-    rec_ref->write_traces[file_rec->write_count].offset = offset;
-    rec_ref->write_traces[file_rec->write_count].start_time = start_time;
-    rec_ref->write_traces[file_rec->write_count].end_time = end_time;
-    rec_ref->write_traces[file_rec->write_count].pthread_id = (unsigned long)pthread_self();
-    file_rec->write_count += 1;
-
-    DXT_UNLOCK();
+    dxt_trace_segment(DXT_MPIIO_MOD, DXT_WRITE_TRACE, rec_id, offset,
+        length, start_time, end_time);
 }
 
 void dxt_mpiio_read(darshan_record_id rec_id, int64_t offset,
         int64_t length, double start_time, double end_time)
 {
-    struct dxt_file_record_ref* rec_ref = NULL;
-    struct dxt_file_record *file_rec;
-
-    DXT_LOCK();
-
-    if(!dxt_mpiio_runtime || dxt_mpiio_runtime->frozen)
-    {
-        DXT_UNLOCK();
-        return;
-    }
-
-    rec_ref = darshan_lookup_record_ref(dxt_mpiio_runtime->rec_id_hash,
-                &rec_id, sizeof(darshan_record_id));
-    if(!rec_ref)
-    {
-        /* track new dxt file record */
-        rec_ref = dxt_mpiio_track_new_file_record(rec_id);
-        if(!rec_ref)
-        {
-            DXT_UNLOCK();
-            return;
-        }
-    }
-
-    file_rec = rec_ref->file_rec;
-    check_rd_trace_buf(rec_ref, DXT_MPIIO_MOD, dxt_mpiio_runtime);
-    if(file_rec->read_count == rec_ref->read_available_buf)
-    {
-        /* no more memory for i/o segments ... back out */
-        DXT_UNLOCK();
-        return;
-    }
-
-    rec_ref->read_traces[file_rec->read_count].length = length;
-    rec_ref->read_traces[file_rec->read_count].offset = offset;
-    rec_ref->read_traces[file_rec->read_count].start_time = start_time;
-    rec_ref->read_traces[file_rec->read_count].end_time = end_time;
-    rec_ref->read_traces[file_rec->read_count].pthread_id = (unsigned long)pthread_self();
-    file_rec->read_count += 1;
-
-    DXT_UNLOCK();
+    dxt_trace_segment(DXT_MPIIO_MOD, DXT_READ_TRACE, rec_id, offset,
+        length, start_time, end_time);
 }
 
 static void dxt_posix_filter_traces_iterator(void *rec_ref_p, void *user_ptr)
@@ -447,35 +396,22 @@ static void dxt_posix_filter_traces_iterator(void *rec_ref_p, void *user_ptr)
     }
 
     /* drop the record if no dynamic trace triggers occurred */
+    /* NOTE: records are only flagged here, since threads may still hold
+     * references to their trace blocks; they are skipped at serialization
+     */
     if(!should_keep)
     {
         if(dxt_mpiio_runtime && dxt_mpiio_runtime->rec_id_hash)
         {
             /* first check the MPI-IO traces to see if we should drop there */
-            mpiio_rec_ref = darshan_delete_record_ref(&dxt_mpiio_runtime->rec_id_hash,
+            mpiio_rec_ref = darshan_lookup_record_ref(dxt_mpiio_runtime->rec_id_hash,
                 &psx_file->base_rec.id, sizeof(darshan_record_id));
             if(mpiio_rec_ref)
-            {
-                free(mpiio_rec_ref->write_traces);
-                free(mpiio_rec_ref->read_traces);
-                free(mpiio_rec_ref->file_rec);
-                free(mpiio_rec_ref);
-            }
+                mpiio_rec_ref->dropped = 1;
         }
 
-        if(dxt_posix_runtime && dxt_posix_runtime->rec_id_hash)
-        {
-            /* then delete the POSIX trace records */
-            psx_rec_ref = darshan_delete_record_ref(&dxt_posix_runtime->rec_id_hash,
-                &psx_file->base_rec.id, sizeof(darshan_record_id));
-            if(psx_rec_ref)
-            {
-                free(psx_rec_ref->write_traces);
-                free(psx_rec_ref->read_traces);
-                free(psx_rec_ref->file_rec);
-                free(psx_rec_ref);
-            }
-        }
+        /* then drop the POSIX trace record */
+        psx_rec_ref->dropped = 1;
     }
 
     return;
@@ -504,120 +440,272 @@ void dxt_posix_apply_trace_filter(
  *  internal DXT helper routines   *
  ***********************************/
 
-static void check_wr_trace_buf(struct dxt_file_record_ref *rec_ref,
-    darshan_module_id mod_id, struct dxt_runtime *runtime)
+/* append a segment to the given block, returning 0 if the block is full */
+static int dxt_seg_block_append(struct dxt_seg_block *block, int64_t offset,
+    int64_t length, double start_time, double end_time)
 {
-    struct dxt_file_record *file_rec = rec_ref->file_rec;
+    int count = DXT_BLOCK_COUNT(block);
 
-    int write_count = file_rec->write_count;
-    int write_available_buf = rec_ref->write_available_buf;
+    if(count == DXT_SEG_BLOCK_SIZE)
+        return(0);
 
-    if (write_count >= write_available_buf)
-    {
-        int write_count_inc;
-        if(write_available_buf == 0)
-            write_count_inc = IO_TRACE_BUF_SIZE;
-        else
-            write_count_inc = write_available_buf;
+    block->segs[count].offset = offset;
+    block->segs[count].length = length;
+    block->segs[count].start_time = start_time;
+    block->segs[count].end_time = end_time;
+    block->segs[count].pthread_id = (unsigned long)pthread_self();
+    DXT_BLOCK_SET_COUNT(block, count + 1);
 
-        size_t mem_left = runtime->mem_allocated - runtime->mem_used;
-        size_t mem_req = write_count_inc * sizeof(segment_info);
-        if(mem_req > mem_left)
+    return(1);
+}
+
+static void dxt_trace_segment(darshan_module_id mod_id, int trace_type,
+    darshan_record_id rec_id, int64_t offset, int64_t length,
+    double start_time, double end_time)
+{
+    struct dxt_runtime *runtime;
+    struct dxt_file_record_ref *rec_ref;
+    struct dxt_seg_block **cur_block_p;
+    void *owner = NULL;
+#ifdef HAVE_STDATOMIC_H
+    struct dxt_thread_state *ts = dxt_tls_state;
+    struct dxt_thread_stream *stream;
+    int mod_idx = DXT_MOD_IDX(mod_id);
+
+    /* try to append to this thread's current block for the record without
+     * acquiring the DXT lock; the busy flag pairs with dxt_freeze()
+     */
+    if(ts)
+    {
+        atomic_store(&ts->busy, 1);
+        if(atomic_load(&dxt_trace_active[mod_idx]))
         {
-            write_count_inc = mem_left / sizeof(segment_info);
-            if(write_count_inc == 0)
+            HASH_FIND(hlink, ts->stream_hash[mod_idx], &rec_id,
+                sizeof(darshan_record_id), stream);
+            if(stream && stream->blocks[trace_type] &&
+                dxt_seg_block_append(stream->blocks[trace_type], offset,
+                    length, start_time, end_time))
             {
-                /* we need to request at least one record, even if we
-                 * know there is not enough memory left, so that Darshan
-                 * core can mark this module as having ran out of data
-                 */
-                write_count_inc = 1;
+                atomic_store_explicit(&ts->busy, 0, memory_order_release);
+                return;
             }
-            mem_req = write_count_inc * sizeof(segment_info);
         }
+        atomic_store_explicit(&ts->busy, 0, memory_order_release);
+    }
+#endif
+
+    DXT_LOCK();
+
+    runtime = (mod_id == DXT_POSIX_MOD) ? dxt_posix_runtime : dxt_mpiio_runtime;
+    if(!runtime || runtime->frozen)
+    {
+        DXT_UNLOCK();
+        return;
+    }
 
-        /* register the increased write buffer size with Darshan core */
-        /* NOTE: register_record() does not handle DXT memory allocations,
-         * it just checks that there is enough memory for the record -- if
-         * there is not enough memory, this function will return NULL
-         */
-        if(darshan_core_register_record(
-             file_rec->base_rec.id,
-             NULL, /* no name registration needed, handled in initial record alloc */
-             mod_id,
-             mem_req,
-             NULL))
+    rec_ref = darshan_lookup_record_ref(runtime->rec_id_hash,
+        &rec_id, sizeof(darshan_record_id));
+    if(!rec_ref)
+    {
+        /* track new dxt file record */
+        if(mod_id == DXT_POSIX_MOD)
+            rec_ref = dxt_posix_track_new_file_record(rec_id);
+        else
+            rec_ref = dxt_mpiio_track_new_file_record(rec_id);
+        if(!rec_ref)
         {
-            /* there is enough memory for these additional trace segments,
-             * but we have to (re)allocate them ourselves
-             */
-            write_available_buf += write_count_inc;
-            rec_ref->write_traces =
-                (segment_info *)realloc(rec_ref->write_traces,
-                        write_available_buf * sizeof(segment_info));
+            DXT_UNLOCK();
+            return;
+        }
+    }
 
-            rec_ref->write_available_buf = write_available_buf;
+#ifdef HAVE_STDATOMIC_H
+    /* each thread appends to its own blocks */
+    if(!ts)
+    {
+        ts = calloc(1, sizeof(*ts));
+        if(!ts)
+        {
+            DXT_UNLOCK();
+            return;
+        }
+        ts->pid = getpid();
+        LL_PREPEND(dxt_thread_states, ts);
+        dxt_tls_state = ts;
+    }
+    HASH_FIND(hlink, ts->stream_hash[mod_idx], &rec_id,
+        sizeof(darshan_record_id), stream);
+    if(!stream)
+    {
+        stream = calloc(1, sizeof(*stream));
+        if(!stream)
+        {
+            DXT_UNLOCK();
+            return;
         }
-        runtime->mem_used += mem_req;
+        stream->rec_id = rec_id;
+        HASH_ADD(hlink, ts->stream_hash[mod_idx], rec_id,
+            sizeof(darshan_record_id), stream);
     }
+    cur_block_p = &stream->blocks[trace_type];
+    owner = ts;
+#else
+    /* all threads share the record's newest block */
+    cur_block_p = &rec_ref->blocks[trace_type];
+#endif
+
+    if(!(*cur_block_p) || !dxt_seg_block_append(*cur_block_p, offset,
+        length, start_time, end_time))
+    {
+        *cur_block_p = dxt_get_seg_block(runtime, mod_id, rec_ref,
+            trace_type, owner);
+        if(*cur_block_p)
+            dxt_seg_block_append(*cur_block_p, offset, length, start_time,
+                end_time);
+    }
+
+    DXT_UNLOCK();
+
+    return;
 }
 
-static void check_rd_trace_buf(struct dxt_file_record_ref *rec_ref,
-    darshan_module_id mod_id, struct dxt_runtime *runtime)
+/* take a new segment block from the pool and add it to the given record's
+ * write or read trace. The DXT lock must be held.
+ */
+static struct dxt_seg_block *dxt_get_seg_block(
+    struct dxt_runtime *runtime, darshan_module_id mod_id,
+    struct dxt_file_record_ref *rec_ref, int trace_type, void *owner)
 {
-    struct dxt_file_record *file_rec = rec_ref->file_rec;
+    struct dxt_seg_block *block;
 
-    int read_count = file_rec->read_count;
-    int read_available_buf = rec_ref->read_available_buf;
+    if(runtime->block_pool_next == runtime->block_pool_size)
+        return(NULL);
 
-    if (read_count >= read_available_buf)
-    {
-        int read_count_inc;
-        if(read_available_buf == 0)
-            read_count_inc = IO_TRACE_BUF_SIZE;
-        else
-            read_count_inc = read_available_buf;
+    /* register the block's trace segments with Darshan core */
+    /* NOTE: register_record() does not handle DXT memory allocations,
+     * it just checks that there is enough memory for the record -- if
+     * there is not enough memory, this function will return NULL and
+     * Darshan core will mark this module as having ran out of data
+     */
+    if(darshan_core_register_record(
+         rec_ref->file_rec->base_rec.id,
+         NULL, /* no name registration needed, handled in initial record alloc */
+         mod_id,
+         DXT_SEG_BLOCK_SIZE * sizeof(segment_info),
+         NULL) == NULL)
+        return(NULL);
 
-        size_t mem_left = runtime->mem_allocated - runtime->mem_used;
-        size_t mem_req = read_count_inc * sizeof(segment_info);
-        if(mem_req > mem_left)
-        {
-            read_count_inc = mem_left / sizeof(segment_info);
-            if(read_count_inc == 0)
-            {
-                /* we need to request at least one record, even if we
-                 * know there is not enough memory left, so that Darshan
-                 * core can mark this module as having ran out of data
-                 */
-                read_count_inc = 1;
-            }
-            mem_req = read_count_inc * sizeof(segment_info);
-        }
+    block = &runtime->block_pool[runtime->block_pool_next++];
+    block->owner = owner;
+    DXT_BLOCK_SET_COUNT(block, 0);
+
+    if(rec_ref->blocks[trace_type] && rec_ref->blocks[trace_type]->owner != owner)
+        rec_ref->multi_thread = 1;
+    block->next = rec_ref->blocks[trace_type];
+    rec_ref->blocks[trace_type] = block;
+
+    return(block);
+}
+
+/* stop tracing for the given DXT module and wait for any appends that are
+ * in progress to complete. The DXT lock must be held.
+ */
+static void dxt_freeze(struct dxt_runtime *runtime, darshan_module_id mod_id)
+{
+#ifdef HAVE_STDATOMIC_H
+    struct dxt_thread_state *ts;
 
-        /* register the increased read buffer size with Darshan core */
-        /* NOTE: register_record() does not handle DXT memory allocations,
-         * it just checks that there is enough memory for the record -- if
-         * there is not enough memory, this function will return NULL
-         */
-        if(darshan_core_register_record(
-             file_rec->base_rec.id,
-             NULL, /* no name registration needed, handled in initial record alloc */
-             mod_id,
-             mem_req,
-             NULL))
+    if(atomic_exchange(&dxt_trace_active[DXT_MOD_IDX(mod_id)], 0))
+    {
+        LL_FOREACH(dxt_thread_states, ts)
         {
-            /* there is enough memory for these additional trace segments,
-             * but we have to (re)allocate them ourselves
+            /* states inherited across a fork belong to threads that no
+             * longer exist
              */
-            read_available_buf += read_count_inc;
-            rec_ref->read_traces =
-                (segment_info *)realloc(rec_ref->read_traces,
-                        read_available_buf * sizeof(segment_info));
+            while(ts->pid == getpid() && atomic_load(&ts->busy))
+                ;
+        }
+    }
+#endif
+    runtime->frozen = 1;
+
+    return;
+}
+
+/* free all threads' append state for the given DXT module. The module must
+ * be frozen and the DXT lock must be held.
+ */
+static void dxt_free_thread_streams(darshan_module_id mod_id)
+{
+#ifdef HAVE_STDATOMIC_H
+    struct dxt_thread_state *ts;
+    struct dxt_thread_stream *stream, *tmp;
+    int mod_idx = DXT_MOD_IDX(mod_id);
 
-            rec_ref->read_available_buf = read_available_buf;
+    LL_FOREACH(dxt_thread_states, ts)
+    {
+        HASH_ITER(hlink, ts->stream_hash[mod_idx], stream, tmp)
+        {
+            HASH_DELETE(hlink, ts->stream_hash[mod_idx], stream);
+            free(stream);
         }
-        runtime->mem_used += mem_req;
     }
+#endif
+
+    return;
+}
+
+static int dxt_seg_compare(const void *a_p, const void *b_p)
+{
+    const segment_info *a = a_p;
+    const segment_info *b = b_p;
+
+    if(a->start_time < b->start_time)
+        return(-1);
+    if(a->start_time > b->start_time)
+        return(1);
+    return(0);
+}
+
+/* count the segments in a record's write or read trace */
+static int64_t dxt_trace_count(struct dxt_file_record_ref *rec_ref,
+    int trace_type)
+{
+    struct dxt_seg_block *block;
+    int64_t count = 0;
+
+    LL_FOREACH(rec_ref->blocks[trace_type], block)
+    {
+        count += DXT_BLOCK_COUNT(block);
+    }
+
+    return(count);
+}
+
+/* copy a record's write or read trace (with 'count' segments in total) into
+ * the contiguous buffer 'segs', in the order the segments were recorded
+ */
+static void dxt_stitch_trace(struct dxt_file_record_ref *rec_ref,
+    int trace_type, segment_info *segs, int64_t count)
+{
+    struct dxt_seg_block *block;
+    int64_t pos = count;
+    int block_count;
+
+    /* blocks are ordered newest first, so fill the buffer from the end */
+    LL_FOREACH(rec_ref->blocks[trace_type], block)
+    {
+        block_count = DXT_BLOCK_COUNT(block);
+        pos -= block_count;
+        memcpy(&segs[pos], block->segs, block_count * sizeof(segment_info));
+    }
+    assert(pos == 0);
+
+    /* interleave segments recorded by different threads by start time */
+    if(rec_ref->multi_thread)
+        qsort(segs, count, sizeof(segment_info), dxt_seg_compare);
+
+    return;
 }
 
 static struct dxt_file_record_ref *dxt_posix_track_new_file_record(
@@ -629,20 +717,19 @@ static struct dxt_file_record_ref *dxt_posix_track_new_file_record(
 
     DXT_LOCK();
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_core_arena_alloc(DXT_POSIX_MOD, sizeof(*rec_ref));
     if(!rec_ref)
     {
         DXT_UNLOCK();
         return(NULL);
     }
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this file record based on record id */
     ret = darshan_add_record_ref(&(dxt_posix_runtime->rec_id_hash), &rec_id,
-            sizeof(darshan_record_id), rec_ref);
+            sizeof(darshan_record_id), rec_ref, DXT_POSIX_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         DXT_UNLOCK();
         return(NULL);
     }
@@ -661,7 +748,7 @@ static struct dxt_file_record_ref *dxt_posix_track_new_file_record(
     {
         darshan_delete_record_ref(&(dxt_posix_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         DXT_UNLOCK();
         return(NULL);
     }
@@ -672,14 +759,13 @@ static struct dxt_file_record_ref *dxt_posix_track_new_file_record(
     {
         darshan_delete_record_ref(&(dxt_posix_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         DXT_UNLOCK();
         return(NULL);
     }
     memset(file_rec, 0, sizeof(*file_rec));
 
     dxt_posix_runtime->file_rec_count++;
-    dxt_posix_runtime->mem_used += sizeof(*file_rec);
     DXT_UNLOCK();
 
     /* initialize record and record reference fields */
@@ -701,20 +787,19 @@ static struct dxt_file_record_ref *dxt_mpiio_track_new_file_record(
 
     DXT_LOCK();
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_core_arena_alloc(DXT_MPIIO_MOD, sizeof(*rec_ref));
     if(!rec_ref)
     {
         DXT_UNLOCK();
         return(NULL);
     }
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this file record based on record id */
     ret = darshan_add_record_ref(&(dxt_mpiio_runtime->rec_id_hash), &rec_id,
-            sizeof(darshan_record_id), rec_ref);
+            sizeof(darshan_record_id), rec_ref, DXT_MPIIO_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         DXT_UNLOCK();
         return(NULL);
     }
@@ -733,7 +818,7 @@ static struct dxt_file_record_ref *dxt_mpiio_track_new_file_record(
     {
         darshan_delete_record_ref(&(dxt_mpiio_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         DXT_UNLOCK();
         return(NULL);
     }
@@ -744,14 +829,13 @@ static struct dxt_file_record_ref *dxt_mpiio_track_new_file_record(
     {
         darshan_delete_record_ref(&(dxt_mpiio_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         DXT_UNLOCK();
         return(NULL);
     }
     memset(file_rec, 0, sizeof(*file_rec));
 
     dxt_mpiio_runtime->file_rec_count++;
-    dxt_mpiio_runtime->mem_used += sizeof(*file_rec);
     DXT_UNLOCK();
 
     /* initialize record and record reference fields */
@@ -768,8 +852,6 @@ static void dxt_free_record_data(void *rec_ref_p, void *user_ptr)
 {
     struct dxt_file_record_ref *dxt_rec_ref = (struct dxt_file_record_ref *)rec_ref_p;
 
-    free(dxt_rec_ref->write_traces);
-    free(dxt_rec_ref->read_traces);
     free(dxt_rec_ref->file_rec);
 }
 
@@ -777,9 +859,10 @@ static void dxt_free_record_data(void *rec_ref_p, void *user_ptr)
  *     functions exported by this module for coordinating with darshan-core     *
  ********************************************************************************/
 
-static void dxt_serialize_posix_records(void *rec_ref_p, void *user_ptr)
+static void dxt_serialize_records(void *rec_ref_p, void *user_ptr)
 {
     struct dxt_file_record_ref *rec_ref = (struct dxt_file_record_ref *)rec_ref_p;
+    struct dxt_runtime *runtime = (struct dxt_runtime *)user_ptr;
     struct dxt_file_record *file_rec;
     int64_t record_size = 0;
     int64_t record_write_count = 0;
@@ -790,10 +873,15 @@ static void dxt_serialize_posix_records(void *rec_ref_p, void *user_ptr)
     file_rec = rec_ref->file_rec;
     assert(file_rec);
 
-    record_write_count = file_rec->write_count;
-    record_read_count = file_rec->read_count;
+    if(rec_ref->dropped)
+        return;
+
+    record_write_count = dxt_trace_count(rec_ref, DXT_WRITE_TRACE);
+    record_read_count = dxt_trace_count(rec_ref, DXT_READ_TRACE);
     if (record_write_count == 0 && record_read_count == 0)
         return;
+    file_rec->write_count = record_write_count;
+    file_rec->read_count = record_read_count;
 
     /*
      * Buffer format:
@@ -802,26 +890,25 @@ static void dxt_serialize_posix_records(void *rec_ref_p, void *user_ptr)
     record_size = sizeof(struct dxt_file_record) +
             (record_write_count + record_read_count) * sizeof(segment_info);
 
-    tmp_buf_ptr = (void *)(dxt_posix_runtime->record_buf +
-        dxt_posix_runtime->record_buf_size);
+    tmp_buf_ptr = (void *)(runtime->record_buf + runtime->record_buf_size);
 
     /*Copy struct dxt_file_record */
     memcpy(tmp_buf_ptr, (void *)file_rec, sizeof(struct dxt_file_record));
     tmp_buf_ptr = (void *)(tmp_buf_ptr + sizeof(struct dxt_file_record));
 
-    /*Copy write record */
-    memcpy(tmp_buf_ptr, (void *)(rec_ref->write_traces),
-            record_write_count * sizeof(segment_info));
+    /*Stitch together write record */
+    dxt_stitch_trace(rec_ref, DXT_WRITE_TRACE, (segment_info *)tmp_buf_ptr,
+            record_write_count);
     tmp_buf_ptr = (void *)(tmp_buf_ptr +
                 record_write_count * sizeof(segment_info));
 
-    /*Copy read record */
-    memcpy(tmp_buf_ptr, (void *)(rec_ref->read_traces),
-            record_read_count * sizeof(segment_info));
+    /*Stitch together read record */
+    dxt_stitch_trace(rec_ref, DXT_READ_TRACE, (segment_info *)tmp_buf_ptr,
+            record_read_count);
     tmp_buf_ptr = (void *)(tmp_buf_ptr +
                 record_read_count * sizeof(segment_info));
 
-    dxt_posix_runtime->record_buf_size += record_size;
+    runtime->record_buf_size += record_size;
 }
 
 static void dxt_posix_output(
@@ -832,21 +919,29 @@ static void dxt_posix_output(
 
     *dxt_posix_buf_sz = 0;
 
+    DXT_LOCK();
+
+    /* stop tracing so the trace blocks can be stitched together */
+    dxt_freeze(dxt_posix_runtime, DXT_POSIX_MOD);
+
     dxt_posix_runtime->record_buf = malloc(dxt_posix_runtime->mem_allocated);
     if(!(dxt_posix_runtime->record_buf))
+    {
+        DXT_UNLOCK();
         return;
+    }
     memset(dxt_posix_runtime->record_buf, 0, dxt_posix_runtime->mem_allocated);
     dxt_posix_runtime->record_buf_size = 0;
 
     /* iterate all dxt posix records and serialize them to the output buffer */
     darshan_iter_record_refs(dxt_posix_runtime->rec_id_hash,
-        dxt_serialize_posix_records, NULL);
+        dxt_serialize_records, dxt_posix_runtime);
 
     /* set output */
     *dxt_posix_buf = dxt_posix_runtime->record_buf;
     *dxt_posix_buf_sz = dxt_posix_runtime->record_buf_size;
 
-    dxt_posix_runtime->frozen = 1;
+    DXT_UNLOCK();
 
     return;
 }
@@ -855,64 +950,25 @@ static void dxt_posix_cleanup()
 {
     assert(dxt_posix_runtime);
 
+    DXT_LOCK();
+
+    dxt_freeze(dxt_posix_runtime, DXT_POSIX_MOD);
+
     free(dxt_posix_runtime->record_buf);
 
     /* cleanup internal structures used for instrumenting */
+    dxt_free_thread_streams(DXT_POSIX_MOD);
     darshan_iter_record_refs(dxt_posix_runtime->rec_id_hash,
         dxt_free_record_data, NULL);
     darshan_clear_record_refs(&(dxt_posix_runtime->rec_id_hash), 1);
 
+    free(dxt_posix_runtime->block_pool);
     free(dxt_posix_runtime);
     dxt_posix_runtime = NULL;
 
-    return;
-}
-
-static void dxt_serialize_mpiio_records(void *rec_ref_p, void *user_ptr)
-{
-    struct dxt_file_record_ref *rec_ref = (struct dxt_file_record_ref *)rec_ref_p;
-    struct dxt_file_record *file_rec;
-    int64_t record_size = 0;
-    int64_t record_write_count = 0;
-    int64_t record_read_count = 0;
-    void *tmp_buf_ptr;
-
-    assert(rec_ref);
-    file_rec = rec_ref->file_rec;
-    assert(file_rec);
-
-    record_write_count = file_rec->write_count;
-    record_read_count = file_rec->read_count;
-    if (record_write_count == 0 && record_read_count == 0)
-        return;
-
-    /*
-     * Buffer format:
-     * dxt_file_record + write_traces + read_traces
-     */
-    record_size = sizeof(struct dxt_file_record) +
-            (record_write_count + record_read_count) * sizeof(segment_info);
-
-    tmp_buf_ptr = (void *)(dxt_mpiio_runtime->record_buf +
-        dxt_mpiio_runtime->record_buf_size);
-
-    /*Copy struct dxt_file_record */
-    memcpy(tmp_buf_ptr, (void *)file_rec, sizeof(struct dxt_file_record));
-    tmp_buf_ptr = (void *)(tmp_buf_ptr + sizeof(struct dxt_file_record));
-
-    /*Copy write record */
-    memcpy(tmp_buf_ptr, (void *)(rec_ref->write_traces),
-            record_write_count * sizeof(segment_info));
-    tmp_buf_ptr = (void *)(tmp_buf_ptr +
-                record_write_count * sizeof(segment_info));
-
-    /*Copy read record */
-    memcpy(tmp_buf_ptr, (void *)(rec_ref->read_traces),
-            record_read_count * sizeof(segment_info));
-    tmp_buf_ptr = (void *)(tmp_buf_ptr +
-                record_read_count * sizeof(segment_info));
+    DXT_UNLOCK();
 
-    dxt_mpiio_runtime->record_buf_size += record_size;
+    return;
 }
 
 static void dxt_mpiio_output(
@@ -923,21 +979,29 @@ static void dxt_mpiio_output(
 
     *dxt_mpiio_buf_sz = 0;
 
+    DXT_LOCK();
+
+    /* stop tracing so the trace blocks can be stitched together */
+    dxt_freeze(dxt_mpiio_runtime, DXT_MPIIO_MOD);
+
     dxt_mpiio_runtime->record_buf = malloc(dxt_mpiio_runtime->mem_allocated);
     if(!(dxt_mpiio_runtime->record_buf))
+    {
+        DXT_UNLOCK();
         return;
+    }
     memset(dxt_mpiio_runtime->record_buf, 0, dxt_mpiio_runtime->mem_allocated);
     dxt_mpiio_runtime->record_buf_size = 0;
 
-    /* iterate all dxt posix records and serialize them to the output buffer */
+    /* iterate all dxt mpiio records and serialize them to the output buffer */
     darshan_iter_record_refs(dxt_mpiio_runtime->rec_id_hash,
-        dxt_serialize_mpiio_records, NULL);
+        dxt_serialize_records, dxt_mpiio_runtime);
 
     /* set output */
     *dxt_mpiio_buf = dxt_mpiio_runtime->record_buf;
     *dxt_mpiio_buf_sz = dxt_mpiio_runtime->record_buf_size;
 
-    dxt_mpiio_runtime->frozen = 1;
+    DXT_UNLOCK();
 
     return;
 }
@@ -946,16 +1010,24 @@ static void dxt_mpiio_cleanup()
 {
     assert(dxt_mpiio_runtime);
 
+    DXT_LOCK();
+
+    dxt_freeze(dxt_mpiio_runtime, DXT_MPIIO_MOD);
+
     free(dxt_mpiio_runtime->record_buf);
 
     /* cleanup internal structures used for instrumenting */
+    dxt_free_thread_streams(DXT_MPIIO_MOD);
     darshan_iter_record_refs(dxt_mpiio_runtime->rec_id_hash,
         dxt_free_record_data, NULL);
     darshan_clear_record_refs(&(dxt_mpiio_runtime->rec_id_hash), 1);
 
+    free(dxt_mpiio_runtime->block_pool);
     free(dxt_mpiio_runtime);
     dxt_mpiio_runtime = NULL;
 
+    DXT_UNLOCK();
+
     return;
 }
 
@@ -20,7 +20,6 @@
 #include <time.h>
 #include <stdlib.h>
 #include <errno.h>
-#include <search.h>
 #include <assert.h>
 #include <pthread.h>
 
@@ -63,9 +62,7 @@ struct hdf5_file_record_ref
 {
     struct darshan_hdf5_file* file_rec;
     double last_meta_end;
-#ifdef HAVE_LDMS
     int64_t close_counts;
-#endif
 };
 
 /* structure that can track i/o stats for a given HDF5 dataset record at runtime */
@@ -76,11 +73,8 @@ struct hdf5_dataset_record_ref
     double last_read_end;
     double last_write_end;
     double last_meta_end;
-    void *access_root;
-    int access_count;
-#ifdef HAVE_LDMS
+    struct darshan_common_val_table access_table;
     int64_t close_counts;
-#endif
 };
 
 /* struct to encapsulate runtime state for the HDF5 module */
@@ -100,8 +94,6 @@ static struct hdf5_file_record_ref *hdf5_track_new_file_record(
     darshan_record_id rec_id, const char *rec_name);
 static struct hdf5_dataset_record_ref *hdf5_track_new_dataset_record(
     darshan_record_id rec_id, const char *rec_name);
-static void hdf5_finalize_dataset_records(
-    void *rec_ref_p, void *user_ptr);
 #ifdef HAVE_MPI
 static void hdf5_file_record_reduction_op(
     void* inrec_v, void* inoutrec_v, int *len, MPI_Datatype *datatype);
@@ -184,7 +176,7 @@ static int my_rank = -1;
     __rec_ref->file_rec->fcounters[H5F_F_OPEN_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(__rec_ref->file_rec->fcounters[H5F_F_META_TIME], \
         __tm1, __tm2, __rec_ref->last_meta_end); \
-    darshan_add_record_ref(&(hdf5_file_runtime->hid_hash), &__ret, sizeof(hid_t), __rec_ref); \
+    darshan_add_record_ref(&(hdf5_file_runtime->hid_hash), &__ret, sizeof(hid_t), __rec_ref, DARSHAN_H5F_MOD); \
     if(__newpath != __path) free(__newpath); \
     /* LDMS to publish realtime open tracing information to daemon*/ \
     if(dC.ldms_lib)\
@@ -447,13 +439,11 @@ herr_t DARSHAN_DECL(H5Fclose)(hid_t file_id)
             darshan_delete_record_ref(&(hdf5_file_runtime->hid_hash),
                 &file_id, sizeof(hid_t));
 
-#ifdef HAVE_LDMS
             rec_ref->close_counts++;
             /* publish close information for h5f */
             if(dC.ldms_lib)
                 if(dC.hdf5_enable_ldms)
                     darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->close_counts, "close", -1, -1, -1, -1, rec_ref->file_rec->counters[H5F_FLUSHES], tm1, tm2, rec_ref->file_rec->fcounters[H5F_F_META_TIME], "H5F", "MOD");
-#endif
         }
         H5F_POST_RECORD();
     }
@@ -543,7 +533,7 @@ herr_t DARSHAN_DECL(H5Fclose)(hid_t file_id)
     } \
     __rec_ref->dataset_rec->counters[H5D_DATATYPE_SIZE] = H5Tget_size(__type_id); \
     __rec_ref->dataset_rec->file_rec_id = __file_rec_id; \
-    darshan_add_record_ref(&(hdf5_dataset_runtime->hid_hash), &__ret, sizeof(hid_t), __rec_ref); \
+    darshan_add_record_ref(&(hdf5_dataset_runtime->hid_hash), &__ret, sizeof(hid_t), __rec_ref, DARSHAN_H5D_MOD); \
     /* LDMS to publish runtime h5d tracing information to daemon*/ \
     if(dC.ldms_lib)\
         if(dC.hdf5_enable_ldms)\
@@ -769,8 +759,8 @@ herr_t DARSHAN_DECL(H5Dread)(hid_t dataset_id, hid_t mem_type_id, hid_t mem_spac
             DARSHAN_BUCKET_INC(
                 &(rec_ref->dataset_rec->counters[H5D_SIZE_READ_AGG_0_100]), access_size);
             common_access_vals[0] = access_size;
-            cvc = darshan_track_common_val_counters(&rec_ref->access_root,
-                common_access_vals, H5D_MAX_NDIMS+H5D_MAX_NDIMS+1, &rec_ref->access_count);
+            cvc = darshan_track_common_val_counters(&rec_ref->access_table,
+                common_access_vals, H5D_MAX_NDIMS+H5D_MAX_NDIMS+1);
             if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS(
                 &(rec_ref->dataset_rec->counters[H5D_ACCESS1_ACCESS]),
                 &(rec_ref->dataset_rec->counters[H5D_ACCESS1_COUNT]),
@@ -799,7 +789,6 @@ herr_t DARSHAN_DECL(H5Dread)(hid_t dataset_id, hid_t mem_type_id, hid_t mem_spac
                 rec_ref->dataset_rec->fcounters[H5D_F_READ_TIME],
                 tm1, tm2, rec_ref->last_read_end);
 
-#ifdef HAVE_LDMS
             /* LDMS to publish runtime h5d tracing information to daemon*/
             if(dC.ldms_lib){
                 if(dC.hdf5_enable_ldms){
@@ -812,7 +801,6 @@ herr_t DARSHAN_DECL(H5Dread)(hid_t dataset_id, hid_t mem_type_id, hid_t mem_spac
                     darshan_ldms_connector_send(rec_ref->dataset_rec->base_rec.id, rec_ref->dataset_rec->base_rec.rank, rec_ref->dataset_rec->counters[H5D_READS], "read", -1, rec_ref->dataset_rec->counters[H5D_MAX_READ_TIME_SIZE], -1, rec_ref->dataset_rec->counters[H5D_RW_SWITCHES], rec_ref->dataset_rec->counters[H5D_FLUSHES], tm1, tm2, rec_ref->dataset_rec->fcounters[H5D_F_READ_TIME], "H5D", "MOD");
                 }
             }
-#endif
         }
         H5D_POST_RECORD();
     }
@@ -900,8 +888,8 @@ herr_t DARSHAN_DECL(H5Dwrite)(hid_t dataset_id, hid_t mem_type_id, hid_t mem_spa
             DARSHAN_BUCKET_INC(
                 &(rec_ref->dataset_rec->counters[H5D_SIZE_WRITE_AGG_0_100]), access_size);
             common_access_vals[0] = access_size;
-            cvc = darshan_track_common_val_counters(&rec_ref->access_root,
-                common_access_vals, H5D_MAX_NDIMS+H5D_MAX_NDIMS+1, &rec_ref->access_count);
+            cvc = darshan_track_common_val_counters(&rec_ref->access_table,
+                common_access_vals, H5D_MAX_NDIMS+H5D_MAX_NDIMS+1);
             if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS(
                 &(rec_ref->dataset_rec->counters[H5D_ACCESS1_ACCESS]),
                 &(rec_ref->dataset_rec->counters[H5D_ACCESS1_COUNT]),
@@ -930,7 +918,6 @@ herr_t DARSHAN_DECL(H5Dwrite)(hid_t dataset_id, hid_t mem_type_id, hid_t mem_spa
                 rec_ref->dataset_rec->fcounters[H5D_F_WRITE_TIME],
                 tm1, tm2, rec_ref->last_write_end);
 
-#ifdef HAVE_LDMS
             /* LDMS to publish runtime h5d tracing information to daemon*/
             if(dC.ldms_lib){
                 if(dC.hdf5_enable_ldms){
@@ -943,7 +930,6 @@ herr_t DARSHAN_DECL(H5Dwrite)(hid_t dataset_id, hid_t mem_type_id, hid_t mem_spa
                     darshan_ldms_connector_send(rec_ref->dataset_rec->base_rec.id, rec_ref->dataset_rec->base_rec.rank, rec_ref->dataset_rec->counters[H5D_WRITES], "write", -1, rec_ref->dataset_rec->counters[H5D_MAX_WRITE_TIME_SIZE], -1, rec_ref->dataset_rec->counters[H5D_RW_SWITCHES], rec_ref->dataset_rec->counters[H5D_FLUSHES], tm1, tm2, rec_ref->dataset_rec->fcounters[H5D_F_WRITE_TIME], "H5D", "MOD");
                 }
             }
-#endif
         }
         H5D_POST_RECORD();
     }
@@ -1012,13 +998,11 @@ herr_t DARSHAN_DECL(H5Dclose)(hid_t dataset_id)
                 tm1, tm2, rec_ref->last_meta_end);
             darshan_delete_record_ref(&(hdf5_dataset_runtime->hid_hash), &dataset_id, sizeof(hid_t));
 
-#ifdef HAVE_LDMS
             rec_ref->close_counts++;
             /* publish close information for h5d */
             if(dC.ldms_lib)
                 if(dC.hdf5_enable_ldms)
                     darshan_ldms_connector_send(rec_ref->dataset_rec->base_rec.id, rec_ref->dataset_rec->base_rec.rank, rec_ref->close_counts, "close", -1, -1, -1, -1, rec_ref->dataset_rec->counters[H5D_FLUSHES], tm1, tm2, rec_ref->dataset_rec->fcounters[H5D_F_META_TIME], "H5D", "MOD");
-#endif
         }
         H5D_POST_RECORD();
     }
@@ -1401,17 +1385,16 @@ static struct hdf5_file_record_ref *hdf5_track_new_file_record(
     struct hdf5_file_record_ref *rec_ref = NULL;
     int ret;
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_core_arena_alloc(DARSHAN_H5F_MOD, sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this file record based on record id */
     ret = darshan_add_record_ref(&(hdf5_file_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+        sizeof(darshan_record_id), rec_ref, DARSHAN_H5F_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -1429,7 +1412,7 @@ static struct hdf5_file_record_ref *hdf5_track_new_file_record(
     {
         darshan_delete_record_ref(&(hdf5_file_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -1449,17 +1432,16 @@ static struct hdf5_dataset_record_ref *hdf5_track_new_dataset_record(
     struct hdf5_dataset_record_ref *rec_ref = NULL;
     int ret;
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_core_arena_alloc(DARSHAN_H5D_MOD, sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this dataset record based on record id */
     ret = darshan_add_record_ref(&(hdf5_dataset_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+        sizeof(darshan_record_id), rec_ref, DARSHAN_H5D_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -1477,7 +1459,7 @@ static struct hdf5_dataset_record_ref *hdf5_track_new_dataset_record(
     {
         darshan_delete_record_ref(&(hdf5_dataset_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -1498,15 +1480,6 @@ static struct hdf5_dataset_record_ref *hdf5_track_new_dataset_record(
     return(rec_ref);
 }
 
-static void hdf5_finalize_dataset_records(void *rec_ref_p, void *user_ptr)
-{
-    struct hdf5_dataset_record_ref *rec_ref =
-        (struct hdf5_dataset_record_ref *)rec_ref_p;
-
-    tdestroy(rec_ref->access_root, free);
-    return;
-}
-
 #ifdef HAVE_MPI
 static void hdf5_file_record_reduction_op(void* inrec_v, void* inoutrec_v,
     int *len, MPI_Datatype *datatype)
@@ -2108,8 +2081,6 @@ static void hdf5_dataset_cleanup()
     assert(hdf5_dataset_runtime);
 
     /* cleanup internal structures used for instrumenting */
-    darshan_iter_record_refs(hdf5_dataset_runtime->rec_id_hash,
-        &hdf5_finalize_dataset_records, NULL);
     darshan_clear_record_refs(&(hdf5_dataset_runtime->hid_hash), 0);
     darshan_clear_record_refs(&(hdf5_dataset_runtime->rec_id_hash), 1);
 
@@ -22,6 +22,7 @@
 
 #include "darshan.h"
 #include "darshan-heatmap.h"
+#include "utlist.h"
 
 /* If set, this is the globally (across all ranks) agreed-upon timestamp to
  * use as the end time for normalizing and pruning heatmap bins consistently.
@@ -29,31 +30,44 @@
  */
 double g_end_timestamp = 0;
 
-/* maximum number of bins per record */
-/* TODO: make this tunable at runtime */
-/* TODO: safety check that total record size plus trailing bins doesn't
- * exceed DEF_MOD_BUF_SIZE.  If it does, the log will still be technically
- * valid but the default darshan-parser will not be able to display it.
+/* default number of bins per record (see HEATMAP_BINS config setting) */
+#define DARSHAN_DEF_HEATMAP_BINS 200
+
+/* maximum number of bins per record; this keeps the total record size
+ * within the DEF_MOD_BUF_SIZE (80 KiB) buffers that darshan-util uses to
+ * read records, so that darshan-parser is able to display it
+ */
+#define DARSHAN_MAX_HEATMAP_BINS 5000
+
+/* Bin widths are tracked as a power of two number of nanoseconds, so that
+ * finding the bin for a timestamp is a shift and widening the bins of a
+ * heatmap is a single pass over them.  This is the default initial log2
+ * width of each bin (2^27 ns, or about 0.13 seconds); a minimum width can
+ * be set with the HEATMAP_MIN_BIN_WIDTH config setting.
  */
-#define DARSHAN_MAX_HEATMAP_BINS 200
+#define DARSHAN_INITIAL_BIN_WIDTH_SHIFT 27
 
-/* initial width of each bin, as floating point seconds */
-/* TODO: make this tunable at runtime */
-#define DARSHAN_INITIAL_BIN_WIDTH_SECONDS 0.1
+/* largest log2 bin width, which keeps shifts of int64_t timestamps defined */
+#define DARSHAN_MAX_BIN_WIDTH_SHIFT 62
 
-/* maximum number of distinct heatmaps that we will track (there is a
- * heatmap per module that interacts with it, not per file, so we should not
- * need many).  If this limit is exceeded then the darshan core will mark
- * the "partial" flag for the log so that we will be able to tell that the
- * limit has been hit.
+#define HEATMAP_BIN_WIDTH_SECONDS(__shift) \
+    ((double)((int64_t)1 << (__shift)) * 1e-9)
+
+/* maximum number of distinct API heatmaps that we will track (there is a
+ * heatmap per module that interacts with it, so we should not need many).
+ * If this limit is exceeded then the darshan core will mark the "partial"
+ * flag for the log so that we will be able to tell that the limit has been
+ * hit.  Per-file heatmaps (see HEATMAP_PER_FILE config setting) are
+ * tracked in addition to these.
  */
-/* TODO: make this tunable at runtime */
 #define DARSHAN_MAX_HEATMAPS 8
 
 /* structure to track heatmaps at runtime */
 struct heatmap_record_ref
 {
     struct darshan_heatmap_record* heatmap_rec;
+    int bin_width_shift; /* log2 of the bin width in ns */
+    int thread_slot; /* index of per-thread bins, or -1 for per-file heatmaps */
 };
 
 /* The heatmap_runtime structure maintains necessary state for storing
@@ -62,16 +76,64 @@ struct heatmap_record_ref
 struct heatmap_runtime
 {
     void *rec_id_hash;
+    struct heatmap_record_ref **rec_refs; /* in record buffer order */
     int rec_count;
+    int api_rec_count;
+    int file_rec_count;
+    int file_rec_max; /* max number of per-file heatmaps */
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
+#ifdef HAVE_STDATOMIC_H
+/* bins accumulated by a single thread for a single heatmap, at a bin width
+ * that may be narrower than that of the shared heatmap record
+ */
+struct heatmap_thread_bins
+{
+    int bin_width_shift;
+    int64_t bins[]; /* write bins, followed by read bins */
+};
+
+/* Per-thread heatmap state.  Updates from a thread that has bins for a
+ * heatmap are accumulated there without taking the heatmap lock, and the
+ * bins of every thread are merged into the shared heatmap records when
+ * instrumentation is frozen.  These structures are linked into a global
+ * list (protected by the heatmap lock) and are never freed, since a thread
+ * may still reference its state via TLS after the module is cleaned up.
+ */
+struct heatmap_thread_state
+{
+    atomic_int busy;
+    pid_t pid; /* process that created this state */
+    struct heatmap_thread_bins *bins[DARSHAN_MAX_HEATMAPS];
+    struct heatmap_thread_state *next;
+};
+#endif
+
 static struct heatmap_runtime *heatmap_runtime = NULL;
 static int my_rank = -1;
+static int heatmap_nbins = DARSHAN_DEF_HEATMAP_BINS;
+static int heatmap_initial_shift = DARSHAN_INITIAL_BIN_WIDTH_SHIFT;
+
+#ifdef HAVE_STDATOMIC_H
+static struct heatmap_thread_state *heatmap_thread_states = NULL;
+static atomic_int heatmap_thread_active = 0;
+static __thread struct heatmap_thread_state *heatmap_tls_state = NULL;
+#endif
 
 static struct heatmap_record_ref *heatmap_track_new_record(
-    darshan_record_id rec_id, const char *name);
-static void collapse_heatmap(struct darshan_heatmap_record *rec);
+    darshan_record_id rec_id, const char *name, int per_file);
+static void heatmap_accumulate(int *bin_width_shift, int64_t *write_bins,
+    int64_t *read_bins, int rw_flag, int64_t size, int64_t start_ns,
+    int64_t end_ns);
+static void collapse_heatmap(int *bin_width_shift, int64_t *write_bins,
+    int64_t *read_bins, int new_shift);
+static int heatmap_shift_for_time(int bin_width_shift, int64_t end_ns);
+#ifdef HAVE_STDATOMIC_H
+static struct heatmap_thread_bins *heatmap_thread_bins_get(
+    struct heatmap_record_ref *rec_ref);
+static void heatmap_thread_flush(void);
+#endif
 #ifdef HAVE_MPI
 static void heatmap_mpi_redux(
     void *stdio_buf, MPI_Comm mod_comm,
@@ -126,9 +188,12 @@ static void heatmap_output(
 {
     struct darshan_heatmap_record* rec;
     struct darshan_heatmap_record* next_rec;
+    struct heatmap_record_ref *rec_ref;
     void* contig_buf_ptr;
     int i,j;
     double end_timestamp;
+    int64_t end_ns;
+    size_t rec_size = sizeof(*rec) + 2*heatmap_nbins*sizeof(int64_t);
     unsigned long this_size;
     int tmp_nbins;
     int empty;
@@ -147,6 +212,25 @@ static void heatmap_output(
     else
         end_timestamp = darshan_core_wtime();
 
+#ifdef HAVE_STDATOMIC_H
+    /* fold the bins accumulated by each thread into the shared records */
+    heatmap_thread_flush();
+#endif
+
+    /* Collapse records if needed until the total histogram time range
+     * extends to end of execution time.  This will ensure that all of
+     * the heatmap records have a consistent size
+     */
+    end_ns = (int64_t)(end_timestamp * 1e9);
+    for(i=0; i<heatmap_runtime->rec_count; i++)
+    {
+        rec_ref = heatmap_runtime->rec_refs[i];
+        collapse_heatmap(&rec_ref->bin_width_shift,
+            rec_ref->heatmap_rec->write_bins, rec_ref->heatmap_rec->read_bins,
+            heatmap_shift_for_time(rec_ref->bin_width_shift, end_ns));
+        rec_ref->heatmap_rec->bin_width_seconds =
+            HEATMAP_BIN_WIDTH_SECONDS(rec_ref->bin_width_shift);
+    }
 
     /* iterate through records (heatmap histograms) to drop any that contain
      * no data
@@ -154,11 +238,11 @@ static void heatmap_output(
     for(i=0; i<heatmap_runtime->rec_count; i++)
     {
         do {
-            rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + i*(sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS*2*sizeof(int64_t)));
-            next_rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + (i+1)*(sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS*2*sizeof(int64_t)));
+            rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + i*rec_size);
+            next_rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + (i+1)*rec_size);
 
             empty = 1;
-            for(j=0; j<DARSHAN_MAX_HEATMAP_BINS; j++)
+            for(j=0; j<heatmap_nbins; j++)
             {
                 if(rec->write_bins[j] > 0 || rec->read_bins[j] > 0) {
                     empty = 0;
@@ -171,19 +255,17 @@ static void heatmap_output(
                 /* if there are more heatmaps after this one, shift them all down */
                 if (i < heatmap_runtime->rec_count) {
                     memmove(rec, next_rec,
-                            (heatmap_runtime->rec_count - i) *
-                            (sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS * 2 * sizeof(int64_t)));
+                            (heatmap_runtime->rec_count - i) * rec_size);
                     /* fix pointers in any heatmaps that were compacted */
                     for (j = 0; j < heatmap_runtime->rec_count - i; j++) {
                         rec->write_bins
                             = (int64_t*)((uintptr_t)rec + sizeof(*rec));
                         rec->read_bins
                             = (int64_t*)((uintptr_t)rec + sizeof(*rec)
-                              + DARSHAN_MAX_HEATMAP_BINS * sizeof(int64_t));
+                              + heatmap_nbins * sizeof(int64_t));
                         rec = (struct
                               darshan_heatmap_record*)((uintptr_t)rec
-                              + (sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS
-                              * 2 * sizeof(int64_t)));
+                              + rec_size);
                     }
                 }
             }
@@ -197,14 +279,7 @@ static void heatmap_output(
     contig_buf_ptr = *heatmap_buf;
     for(i=0; i<heatmap_runtime->rec_count; i++)
     {
-        rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + i*(sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS*2*sizeof(int64_t)));
-
-        /* Collapse records if needed until the total histogram time range
-         * extends to end of execution time.  This will ensure that all of
-         * the heatmap records have a consistent size
-         */
-        while(end_timestamp > rec->bin_width_seconds * DARSHAN_MAX_HEATMAP_BINS)
-            collapse_heatmap(rec);
+        rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + i*rec_size);
 
         tmp_nbins= ceil(end_timestamp/rec->bin_width_seconds);
 
@@ -239,12 +314,31 @@ static void heatmap_output(
 
 static void heatmap_cleanup()
 {
+#ifdef HAVE_STDATOMIC_H
+    struct heatmap_thread_state *ts;
+    int i;
+#endif
+
     HEATMAP_LOCK();
     assert(heatmap_runtime);
 
+#ifdef HAVE_STDATOMIC_H
+    /* no thread can be updating its bins once they have been flushed */
+    heatmap_thread_flush();
+    LL_FOREACH(heatmap_thread_states, ts)
+    {
+        for(i=0; i<DARSHAN_MAX_HEATMAPS; i++)
+        {
+            free(ts->bins[i]);
+            ts->bins[i] = NULL;
+        }
+    }
+#endif
+
     /* cleanup internal structures used for instrumenting */
     darshan_clear_record_refs(&(heatmap_runtime->rec_id_hash), 1);
 
+    free(heatmap_runtime->rec_refs);
     free(heatmap_runtime);
     heatmap_runtime = NULL;
 
@@ -255,12 +349,11 @@ static void heatmap_cleanup()
 struct heatmap_runtime* heatmap_runtime_initialize(void)
 {
     struct heatmap_runtime* tmp_runtime;
+    const struct darshan_config *cfg;
+    int file_rec_max = 0;
     int ret;
-    /* NOTE: this module generates one record per module that uses it, so
-     * the memory requirements should be modest
-     */
-    size_t heatmap_buf_size = sizeof(struct darshan_heatmap_record) + 2*DARSHAN_MAX_HEATMAP_BINS*sizeof(int64_t);
-    size_t heatmap_rec_count = DARSHAN_MAX_HEATMAPS;
+    size_t heatmap_buf_size;
+    size_t heatmap_rec_count;
 
     darshan_module_funcs mod_funcs = {
 #ifdef HAVE_MPI
@@ -270,6 +363,33 @@ struct heatmap_runtime* heatmap_runtime_initialize(void)
         .mod_cleanup_func = heatmap_cleanup
     };
 
+    /* apply any user settings for heatmap resolution */
+    cfg = darshan_core_get_config();
+    if(cfg)
+    {
+        if(cfg->heatmap_nbins > 0)
+            heatmap_nbins = (cfg->heatmap_nbins < DARSHAN_MAX_HEATMAP_BINS) ?
+                cfg->heatmap_nbins : DARSHAN_MAX_HEATMAP_BINS;
+        if(cfg->heatmap_min_bin_width > 0)
+        {
+            /* round the minimum width up to a power of two ns */
+            heatmap_initial_shift = 0;
+            while(heatmap_initial_shift < DARSHAN_MAX_BIN_WIDTH_SHIFT &&
+                HEATMAP_BIN_WIDTH_SECONDS(heatmap_initial_shift) <
+                cfg->heatmap_min_bin_width)
+                heatmap_initial_shift++;
+        }
+        file_rec_max = cfg->heatmap_per_file;
+    }
+
+    /* NOTE: this module generates one record per module that uses it, so
+     * the memory requirements should be modest unless per-file heatmaps
+     * are enabled, in which case they are drawn from the same module memory
+     * budget as all other records
+     */
+    heatmap_buf_size = sizeof(struct darshan_heatmap_record) + 2*heatmap_nbins*sizeof(int64_t);
+    heatmap_rec_count = DARSHAN_MAX_HEATMAPS + file_rec_max;
+
     /* register the heatmap module with darshan core */
     /* note that we aren't holding a lock in this module at this point, but
      * the core will serialize internally and return if this module is
@@ -291,15 +411,42 @@ struct heatmap_runtime* heatmap_runtime_initialize(void)
         return(NULL);
     }
     memset(tmp_runtime, 0, sizeof(*tmp_runtime));
+    tmp_runtime->file_rec_max = file_rec_max;
+    tmp_runtime->rec_refs = calloc(DARSHAN_MAX_HEATMAPS + file_rec_max,
+        sizeof(*tmp_runtime->rec_refs));
+    if(!tmp_runtime->rec_refs)
+    {
+        darshan_core_unregister_module(DARSHAN_HEATMAP_MOD);
+        free(tmp_runtime);
+        return(NULL);
+    }
 
     return(tmp_runtime);
 }
 
-darshan_record_id heatmap_register(const char* name)
+#ifdef HAVE_STDATOMIC_H
+/* determine whether updates should be accumulated in per-thread bins, if
+ * requested.  Periodic snapshot logs need every update to reach the shared
+ * records as it happens, so per-thread bins are not used with them.
+ */
+static int heatmap_thread_bins_enabled(void)
+{
+    const struct darshan_config *cfg = darshan_core_get_config();
+
+    if(!cfg || !cfg->heatmap_thread_bins_flag || cfg->snapshot_interval > 0)
+        return(0);
+    return(1);
+}
+#endif
+
+struct heatmap_record_ref *heatmap_register(const char* name)
 {
     struct heatmap_record_ref *rec_ref;
-    darshan_record_id ret = 0;
+    darshan_record_id rec_id;
     struct heatmap_runtime* tmp_runtime;
+#ifdef HAVE_STDATOMIC_H
+    int thread_bins_flag = heatmap_thread_bins_enabled();
+#endif
 
     HEATMAP_LOCK();
 
@@ -312,9 +459,17 @@ darshan_record_id heatmap_register(const char* name)
         HEATMAP_LOCK();
         /* see if someone beat us to it */
         if(heatmap_runtime && tmp_runtime)
+        {
+            free(tmp_runtime->rec_refs);
             free(tmp_runtime);
-        else
+        }
+        else if(tmp_runtime)
+        {
             heatmap_runtime = tmp_runtime;
+#ifdef HAVE_STDATOMIC_H
+            atomic_store(&heatmap_thread_active, thread_bins_flag);
+#endif
+        }
     }
 
     /* if we exit the above logic without anyone initializing, then we
@@ -322,120 +477,233 @@ darshan_record_id heatmap_register(const char* name)
      */
     if(!heatmap_runtime) {
         HEATMAP_UNLOCK();
-        return(0);
+        return(NULL);
     }
 
     /* generate id for this heatmap */
-    ret = darshan_core_gen_record_id(name);
+    rec_id = darshan_core_gen_record_id(name);
 
     /* go ahead and instantiate a record now, rather than waiting until the
      * _update() call
      */
-    rec_ref = darshan_lookup_record_ref(heatmap_runtime->rec_id_hash, &ret, sizeof(darshan_record_id));
-    if(!rec_ref) rec_ref = heatmap_track_new_record(ret, name);
+    rec_ref = darshan_lookup_record_ref(heatmap_runtime->rec_id_hash, &rec_id, sizeof(darshan_record_id));
+    if(!rec_ref) rec_ref = heatmap_track_new_record(rec_id, name, 0);
 
     HEATMAP_UNLOCK();
 
-    return(ret);
+    return(rec_ref);
 }
 
-static void collapse_heatmap(struct darshan_heatmap_record *rec)
+struct heatmap_record_ref *heatmap_register_file(
+    struct heatmap_record_ref *api_heatmap, darshan_record_id file_id)
 {
-    int i;
+    struct heatmap_record_ref *rec_ref = NULL;
+    darshan_record_id rec_id;
+    char *api_name, *file_name, *name;
+    size_t name_len;
+
+    if(!api_heatmap)
+        return(NULL);
 
-    /* collapse write bins */
-    for(i=0; i<DARSHAN_MAX_HEATMAP_BINS; i+=2)
+    HEATMAP_LOCK();
+
+    /* the API heatmap is only valid while the module is initialized */
+    if(!heatmap_runtime || heatmap_runtime->frozen ||
+        heatmap_runtime->file_rec_count >= heatmap_runtime->file_rec_max)
     {
-        rec->write_bins[i] += rec->write_bins[i+1]; /* accumulate adjacent bins */
-        rec->write_bins[i/2] = rec->write_bins[i];  /* shift down */
+        HEATMAP_UNLOCK();
+        return(NULL);
     }
-    /* zero out second half of heatmap */
-    memset(&rec->write_bins[DARSHAN_MAX_HEATMAP_BINS/2], 0, (DARSHAN_MAX_HEATMAP_BINS/2)*sizeof(int64_t));
 
-    /* collapse read bins */
-    for(i=0; i<DARSHAN_MAX_HEATMAP_BINS; i+=2)
+    /* per-file heatmaps are named <API heatmap name>:<file name> */
+    api_name = darshan_core_lookup_record_name(
+        api_heatmap->heatmap_rec->base_rec.id);
+    file_name = darshan_core_lookup_record_name(file_id);
+    if(!api_name || !file_name)
     {
-        rec->read_bins[i] += rec->read_bins[i+1]; /* accumulate adjacent bins */
-        rec->read_bins[i/2] = rec->read_bins[i];  /* shift down */
+        HEATMAP_UNLOCK();
+        return(NULL);
     }
-    /* zero out second half of heatmap */
-    memset(&rec->read_bins[DARSHAN_MAX_HEATMAP_BINS/2], 0, (DARSHAN_MAX_HEATMAP_BINS/2)*sizeof(int64_t));
+    name_len = strlen(api_name) + strlen(file_name) + 2;
+    name = malloc(name_len);
+    if(!name)
+    {
+        HEATMAP_UNLOCK();
+        return(NULL);
+    }
+    snprintf(name, name_len, "%s:%s", api_name, file_name);
 
-    /* double bin width */
-    rec->bin_width_seconds *= 2.0;
+    rec_id = darshan_core_gen_record_id(name);
+    rec_ref = darshan_lookup_record_ref(heatmap_runtime->rec_id_hash, &rec_id, sizeof(darshan_record_id));
+    if(!rec_ref) rec_ref = heatmap_track_new_record(rec_id, name, 1);
+    free(name);
 
-    return;
+    HEATMAP_UNLOCK();
+
+    return(rec_ref);
 }
 
-void heatmap_update(darshan_record_id heatmap_id, int rw_flag,
-    int64_t size, double start_time, double end_time)
+/* find the smallest bin width (no narrower than the given one) at which
+ * the given timestamp still falls within the heatmap
+ */
+static int heatmap_shift_for_time(int bin_width_shift, int64_t end_ns)
 {
-    struct heatmap_record_ref *rec_ref;
-    int bin_index = 0;
-    double top_boundary, bottom_boundary, seconds_in_bin;
-    int64_t intermediate_bytes;
+    while(bin_width_shift < DARSHAN_MAX_BIN_WIDTH_SHIFT &&
+        (end_ns >> bin_width_shift) >= heatmap_nbins)
+        bin_width_shift++;
 
-    /* if size is zero, we have no work to do here */
-    if(size == 0) return;
+    return(bin_width_shift);
+}
 
-    HEATMAP_PRE_RECORD_VOID();
+/* widen the bins of a heatmap to 2^new_shift ns, accumulating each group
+ * of adjacent bins into one in a single pass
+ */
+static void collapse_heatmap(int *bin_width_shift, int64_t *write_bins,
+    int64_t *read_bins, int new_shift)
+{
+    int factor_shift = new_shift - *bin_width_shift;
+    int i, j;
+
+    if(factor_shift <= 0)
+        return;
 
-    rec_ref = darshan_lookup_record_ref(heatmap_runtime->rec_id_hash, &heatmap_id, sizeof(darshan_record_id));
-    /* the heatmap should have already been instantiated in the register
-     * function; something is wrong if we can't find it now
+    /* every bin i moves down to bin i >> factor_shift, which always precedes
+     * (or is) bin i and has already been emptied of its own contents
      */
-    if(!rec_ref) { HEATMAP_POST_RECORD(); return; }
+    for(i=1; i<heatmap_nbins; i++)
+    {
+        j = (factor_shift < 31) ? (i >> factor_shift) : 0;
+        write_bins[j] += write_bins[i];
+        write_bins[i] = 0;
+        read_bins[j] += read_bins[i];
+        read_bins[i] = 0;
+    }
+
+    *bin_width_shift = new_shift;
+
+    return;
+}
+
+/* add an access of the given size, spanning the given interval, to a set of
+ * write and read bins whose width is 2^(*bin_width_shift) ns
+ */
+static void heatmap_accumulate(int *bin_width_shift, int64_t *write_bins,
+    int64_t *read_bins, int rw_flag, int64_t size, int64_t start_ns,
+    int64_t end_ns)
+{
+    int64_t *bins = (rw_flag == HEATMAP_WRITE) ? write_bins : read_bins;
+    int64_t first_bin, last_bin, bin_index;
+    int64_t assigned_bytes, cumulative_bytes;
+    double bytes_per_ns;
+
+    if(start_ns < 0)
+        start_ns = 0;
+    if(end_ns < start_ns)
+        end_ns = start_ns;
 
     /* is current update out of bounds with histogram size?  if so, collapse */
-    while(end_time > rec_ref->heatmap_rec->bin_width_seconds * DARSHAN_MAX_HEATMAP_BINS)
-        collapse_heatmap(rec_ref->heatmap_rec);
+    last_bin = end_ns >> *bin_width_shift;
+    if(last_bin >= heatmap_nbins)
+    {
+        collapse_heatmap(bin_width_shift, write_bins, read_bins,
+            heatmap_shift_for_time(*bin_width_shift, end_ns));
+        last_bin = end_ns >> *bin_width_shift;
+    }
+    first_bin = start_ns >> *bin_width_shift;
 
-    /* once we fall through to this point, we know that the current heatmap
-     * granularity is sufficiently large to hold this update
+    /* fast path: most accesses are much shorter than a bin */
+    if(first_bin == last_bin)
+    {
+        bins[first_bin] += size;
+        return;
+    }
+
+    /* otherwise proportionally assign bytes to each bin the access crosses,
+     * based on the bytes attributed to the access up to the end of each bin
+     * so that the bins always add up to the full size
      */
+    bytes_per_ns = (double)size / (double)(end_ns - start_ns);
+    assigned_bytes = 0;
+    for(bin_index = first_bin; bin_index < last_bin; bin_index++)
+    {
+        cumulative_bytes = (int64_t)(bytes_per_ns *
+            (double)(((bin_index + 1) << *bin_width_shift) - start_ns));
+        bins[bin_index] += cumulative_bytes - assigned_bytes;
+        assigned_bytes = cumulative_bytes;
+    }
+    bins[last_bin] += size - assigned_bytes;
 
-    /* loop through bins to be updated (a given access may cross bin
-     * boundaries) */
-    /* note: counting on the below type conversion to round down to lower
-     * integer */
-    for(bin_index = start_time/rec_ref->heatmap_rec->bin_width_seconds; bin_index < (int)(end_time/rec_ref->heatmap_rec->bin_width_seconds + 1); bin_index++)
+    return;
+}
+
+void heatmap_update(struct heatmap_record_ref *rec_ref, int rw_flag,
+    int64_t size, double start_time, double end_time)
+{
+    int64_t start_ns, end_ns;
+    int old_shift;
+#ifdef HAVE_STDATOMIC_H
+    struct heatmap_thread_state *ts = heatmap_tls_state;
+    struct heatmap_thread_bins *tb;
+#endif
+
+    /* if size is zero, we have no work to do here */
+    if(size == 0 || !rec_ref) return;
+
+    start_ns = (int64_t)(start_time * 1e9);
+    end_ns = (int64_t)(end_time * 1e9);
+
+#ifdef HAVE_STDATOMIC_H
+    if(ts)
     {
-        /* starting assumption about how much time this update spent in
-         * current bin
+        /* announce that we are updating our bins, then make sure they were
+         * not flushed in the meantime; this pairs with the exchange on
+         * heatmap_thread_active in heatmap_thread_flush().  The heatmap
+         * (and rec_ref) may only be dereferenced after this check.
          */
-        seconds_in_bin = rec_ref->heatmap_rec->bin_width_seconds;
-        /* calculate where bin starts and stops */
-        bottom_boundary = bin_index * rec_ref->heatmap_rec->bin_width_seconds;
-        top_boundary = bottom_boundary + rec_ref->heatmap_rec->bin_width_seconds;
-        /* truncate if update started after bottom boundary */
-        if(start_time > bottom_boundary)
-            seconds_in_bin -= start_time-bottom_boundary;
-        /* truncate if update ended before top boundary */
-        if(end_time < top_boundary)
-            seconds_in_bin -= top_boundary-end_time;
-
-        if(seconds_in_bin < 0){
-            /* this should never happen; really this is an assertion
-             * condition but here we just bail out to avoid disrupting the
-             * application.
-             */
-            HEATMAP_POST_RECORD();
+        atomic_store(&ts->busy, 1);
+        if(!atomic_load(&heatmap_thread_active))
+        {
+            atomic_store_explicit(&ts->busy, 0, memory_order_release);
+            return;
+        }
+        tb = (rec_ref->thread_slot >= 0) ? ts->bins[rec_ref->thread_slot] : NULL;
+        if(tb)
+        {
+            heatmap_accumulate(&tb->bin_width_shift, tb->bins,
+                &tb->bins[heatmap_nbins], rw_flag, size, start_ns, end_ns);
+            atomic_store_explicit(&ts->busy, 0, memory_order_release);
             return;
         }
+        atomic_store_explicit(&ts->busy, 0, memory_order_release);
+    }
+#endif
+
+    HEATMAP_PRE_RECORD_VOID();
 
-        if(end_time > start_time)
-            intermediate_bytes = round(size * (seconds_in_bin/(end_time-start_time)));
-        else
-            intermediate_bytes = size;
-
-        /* proportionally assign bytes to this bin */
-        if(rw_flag == HEATMAP_WRITE)
-            rec_ref->heatmap_rec->write_bins[bin_index] +=
-                intermediate_bytes;
-        else
-            rec_ref->heatmap_rec->read_bins[bin_index] +=
-                intermediate_bytes;
+#ifdef HAVE_STDATOMIC_H
+    /* set up this thread's bins for subsequent updates to this heatmap;
+     * per-file heatmaps are always updated under the lock
+     */
+    if(rec_ref->thread_slot >= 0 && atomic_load(&heatmap_thread_active))
+    {
+        tb = heatmap_thread_bins_get(rec_ref);
+        if(tb)
+        {
+            heatmap_accumulate(&tb->bin_width_shift, tb->bins,
+                &tb->bins[heatmap_nbins], rw_flag, size, start_ns, end_ns);
+            HEATMAP_POST_RECORD();
+            return;
+        }
     }
+#endif
+
+    old_shift = rec_ref->bin_width_shift;
+    heatmap_accumulate(&rec_ref->bin_width_shift,
+        rec_ref->heatmap_rec->write_bins, rec_ref->heatmap_rec->read_bins,
+        rw_flag, size, start_ns, end_ns);
+    if(rec_ref->bin_width_shift != old_shift)
+        rec_ref->heatmap_rec->bin_width_seconds =
+            HEATMAP_BIN_WIDTH_SECONDS(rec_ref->bin_width_shift);
 
     HEATMAP_POST_RECORD();
 
@@ -443,23 +711,30 @@ void heatmap_update(darshan_record_id heatmap_id, int rw_flag,
 }
 
 static struct heatmap_record_ref *heatmap_track_new_record(
-    darshan_record_id rec_id, const char *name)
+    darshan_record_id rec_id, const char *name, int per_file)
 {
     struct darshan_heatmap_record *heatmap_rec = NULL;
     struct heatmap_record_ref *rec_ref = NULL;
     int ret;
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    /* API and per-file heatmaps have separate limits, so that files can't
+     * use up the records of API heatmaps registered later
+     */
+    if(per_file && heatmap_runtime->file_rec_count >= heatmap_runtime->file_rec_max)
+        return(NULL);
+    if(!per_file && heatmap_runtime->api_rec_count >= DARSHAN_MAX_HEATMAPS)
+        return(NULL);
+
+    rec_ref = darshan_core_arena_alloc(DARSHAN_HEATMAP_MOD, sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this record */
     ret = darshan_add_record_ref(&(heatmap_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+        sizeof(darshan_record_id), rec_ref, DARSHAN_HEATMAP_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -469,30 +744,122 @@ static struct heatmap_record_ref *heatmap_track_new_record(
         rec_id,
         name,
         DARSHAN_HEATMAP_MOD,
-        sizeof(struct darshan_heatmap_record)+(2*DARSHAN_MAX_HEATMAP_BINS*sizeof(int64_t)),
+        sizeof(struct darshan_heatmap_record)+(2*heatmap_nbins*sizeof(int64_t)),
         NULL);
 
     if(!heatmap_rec)
     {
         darshan_delete_record_ref(&(heatmap_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
     /* registering this file record was successful, so initialize some fields */
     heatmap_rec->base_rec.id = rec_id;
     heatmap_rec->base_rec.rank = my_rank;
-    heatmap_rec->bin_width_seconds = DARSHAN_INITIAL_BIN_WIDTH_SECONDS;
-    heatmap_rec->nbins = DARSHAN_MAX_HEATMAP_BINS;
+    heatmap_rec->bin_width_seconds = HEATMAP_BIN_WIDTH_SECONDS(heatmap_initial_shift);
+    heatmap_rec->nbins = heatmap_nbins;
     heatmap_rec->write_bins = (int64_t*)((uintptr_t)heatmap_rec + sizeof(*heatmap_rec));
     heatmap_rec->read_bins = (int64_t*)((uintptr_t)heatmap_rec + sizeof(*heatmap_rec) + heatmap_rec->nbins*sizeof(int64_t));
     rec_ref->heatmap_rec = heatmap_rec;
+    rec_ref->bin_width_shift = heatmap_initial_shift;
+    if(per_file)
+    {
+        rec_ref->thread_slot = -1;
+        heatmap_runtime->file_rec_count++;
+    }
+    else
+        rec_ref->thread_slot = heatmap_runtime->api_rec_count++;
+    heatmap_runtime->rec_refs[heatmap_runtime->rec_count] = rec_ref;
     heatmap_runtime->rec_count++;
 
     return(rec_ref);
 }
 
+#ifdef HAVE_STDATOMIC_H
+/* get the calling thread's bins for the given heatmap, creating the thread
+ * state and bins if necessary.  The heatmap lock must be held.
+ */
+static struct heatmap_thread_bins *heatmap_thread_bins_get(
+    struct heatmap_record_ref *rec_ref)
+{
+    struct heatmap_thread_state *ts = heatmap_tls_state;
+
+    if(!ts)
+    {
+        ts = calloc(1, sizeof(*ts));
+        if(!ts)
+            return(NULL);
+        ts->pid = getpid();
+        LL_PREPEND(heatmap_thread_states, ts);
+        heatmap_tls_state = ts;
+    }
+
+    if(!ts->bins[rec_ref->thread_slot])
+    {
+        ts->bins[rec_ref->thread_slot] = calloc(1,
+            sizeof(struct heatmap_thread_bins) + 2*heatmap_nbins*sizeof(int64_t));
+        if(!ts->bins[rec_ref->thread_slot])
+            return(NULL);
+        ts->bins[rec_ref->thread_slot]->bin_width_shift = heatmap_initial_shift;
+    }
+
+    return(ts->bins[rec_ref->thread_slot]);
+}
+
+/* permanently disable per-thread bins and merge the bins of every thread
+ * into the shared heatmap records.  The heatmap lock must be held.  Safe to
+ * call more than once.
+ */
+static void heatmap_thread_flush()
+{
+    struct heatmap_thread_state *ts;
+    struct heatmap_thread_bins *tb;
+    struct heatmap_record_ref *rec_ref;
+    int factor_shift;
+    int i, j, k;
+
+    if(!atomic_exchange(&heatmap_thread_active, 0))
+        return;
+
+    LL_FOREACH(heatmap_thread_states, ts)
+    {
+        /* wait for any in-flight update by this thread to complete; states
+         * inherited across a fork belong to threads that no longer exist
+         */
+        while(ts->pid == getpid() && atomic_load(&ts->busy))
+            ;
+        for(i=0; i<heatmap_runtime->rec_count; i++)
+        {
+            rec_ref = heatmap_runtime->rec_refs[i];
+            if(rec_ref->thread_slot < 0 || !ts->bins[rec_ref->thread_slot])
+                continue;
+            tb = ts->bins[rec_ref->thread_slot];
+
+            /* bring the shared record and the thread's bins to the same
+             * width, then add the thread's bins into the shared record
+             */
+            if(tb->bin_width_shift > rec_ref->bin_width_shift)
+                collapse_heatmap(&rec_ref->bin_width_shift,
+                    rec_ref->heatmap_rec->write_bins,
+                    rec_ref->heatmap_rec->read_bins, tb->bin_width_shift);
+            factor_shift = rec_ref->bin_width_shift - tb->bin_width_shift;
+            for(j=0; j<heatmap_nbins; j++)
+            {
+                k = (factor_shift < 31) ? (j >> factor_shift) : 0;
+                rec_ref->heatmap_rec->write_bins[k] += tb->bins[j];
+                rec_ref->heatmap_rec->read_bins[k] += tb->bins[heatmap_nbins + j];
+            }
+            rec_ref->heatmap_rec->bin_width_seconds =
+                HEATMAP_BIN_WIDTH_SECONDS(rec_ref->bin_width_shift);
+        }
+    }
+
+    return;
+}
+#endif
+
 #ifdef HAVE_MPI
 static void heatmap_mpi_redux(
     void *stdio_buf, MPI_Comm mod_comm,
@@ -507,6 +874,9 @@ static void heatmap_mpi_redux(
     HEATMAP_LOCK();
     assert(heatmap_runtime);
     heatmap_runtime->frozen = 1;
+#ifdef HAVE_STDATOMIC_H
+    heatmap_thread_flush();
+#endif
     HEATMAP_UNLOCK();
 
     /* check time locally */
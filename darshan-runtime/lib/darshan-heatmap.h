@@ -9,25 +9,55 @@
 
 #include <stdint.h>
 
+#include "darshan-log-format.h"
+
 #define HEATMAP_READ 1
 #define HEATMAP_WRITE 2
 
+/* opaque handle to a registered heatmap */
+struct heatmap_record_ref;
+
 #ifdef DARSHAN_HEATMAP
 
 /* heatmap_register()
  *
- * registers a heatmap with specified name.  Returns record id to use for
- * subsequent updates
+ * registers a heatmap with specified name.  Returns a handle to use for
+ * subsequent updates, or NULL if the heatmap could not be registered
  */
-darshan_record_id heatmap_register(const char* name);
+struct heatmap_record_ref *heatmap_register(const char* name);
 
-/* heatmap_read()
+/* heatmap_update()
  *
- * functions to record read and write traffic
+ * function to record read and write traffic
  */
-void heatmap_update(darshan_record_id heatmap_id, int rw_flag,
+void heatmap_update(struct heatmap_record_ref *heatmap, int rw_flag,
     int64_t size, double start_time, double end_time);
 
+/* heatmap_register_file()
+ *
+ * registers a per-file heatmap for the given file record, named after the
+ * given API heatmap and the file's path.  Returns NULL if per-file heatmaps
+ * are disabled or their limit (see HEATMAP_PER_FILE) has been reached.
+ */
+struct heatmap_record_ref *heatmap_register_file(
+    struct heatmap_record_ref *api_heatmap, darshan_record_id file_id);
+
+/* HEATMAP_UPDATE_FILE()
+ *
+ * records traffic in the per-file heatmap of a module's file record
+ * reference, which must have 'heatmap' and 'heatmap_registered' fields.
+ * The heatmap is registered on the first non-empty access to the file, so
+ * that only files that are actually read or written count against the limit.
+ */
+#define HEATMAP_UPDATE_FILE(__api_heatmap, __rec_ref, __rw_flag, __size, __tm1, __tm2) do { \
+    if(!(__rec_ref)->heatmap_registered && (__size) > 0) { \
+        (__rec_ref)->heatmap = heatmap_register_file(__api_heatmap, \
+            (__rec_ref)->file_rec->base_rec.id); \
+        (__rec_ref)->heatmap_registered = 1; \
+    } \
+    heatmap_update((__rec_ref)->heatmap, __rw_flag, __size, __tm1, __tm2); \
+} while(0)
+
 #else
 
 /* The heatmap API functions are often invoked from within large macros in
@@ -36,11 +66,19 @@ void heatmap_update(darshan_record_id heatmap_id, int rw_flag,
  * is disabled so that other modules do not need preprocessor modifications.
  */
 
-static inline darshan_record_id heatmap_register(const char* name) {
-    return(0);
+static inline struct heatmap_record_ref *heatmap_register(const char* name) {
+    return(NULL);
+}
+
+static inline struct heatmap_record_ref *heatmap_register_file(
+    struct heatmap_record_ref *api_heatmap, darshan_record_id file_id) {
+    return(NULL);
 }
 
-#define heatmap_update(heatmap_id, rw_flag, size, start_time, end_time) \
+#define heatmap_update(heatmap, rw_flag, size, start_time, end_time) \
+do {} while(0)
+
+#define HEATMAP_UPDATE_FILE(__api_heatmap, __rec_ref, __rw_flag, __size, __tm1, __tm2) \
 do {} while(0)
 
 #endif
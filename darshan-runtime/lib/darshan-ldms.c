@@ -14,18 +14,219 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#ifdef HAVE_STDATOMIC_H
+#include <stdatomic.h>
+#endif
 #include "darshan-ldms.h"
 #include "darshan.h"
 
-/* Check for LDMS libraries if Darshan is built --with-ldms */
-#ifdef HAVE_LDMS
+/* number of events buffered per thread (must be a power of 2) */
+#define DARSHAN_LDMS_RING_SIZE 1024
+/* encoded events are batched in a buffer of this size before publishing */
+#define DARSHAN_LDMS_BATCH_SIZE (64*1024)
+#define DARSHAN_LDMS_MSG_MAX 1024
+/* how long the publisher sleeps when it finds no events to publish */
+#define DARSHAN_LDMS_IDLE_NSEC (10*1000*1000)
+
+/* compact event recorded by an instrumented thread; strings are the string
+ * literals passed in by the modules, so they do not need to be copied
+ */
+struct darshan_ldms_event
+{
+    uint64_t record_id;
+    int64_t rank;
+    int64_t record_count;
+    int64_t offset;
+    int64_t length;
+    int64_t max_byte;
+    int64_t rw_switch;
+    int64_t flushes;
+    int64_t hdf5_data[5];
+    double start_time;
+    double end_time;
+    double total_time;
+    const char *op;
+    const char *mod_name;
+    const char *data_type;
+};
+
+#ifdef HAVE_STDATOMIC_H
+typedef atomic_uint_fast64_t darshan_ldms_idx;
+#define LDMS_IDX_LOAD(__p) atomic_load_explicit(__p, memory_order_acquire)
+#define LDMS_IDX_STORE(__p, __v) atomic_store_explicit(__p, __v, memory_order_release)
+#define LDMS_RING_LOCK()
+#define LDMS_RING_UNLOCK()
+#else
+typedef uint64_t darshan_ldms_idx;
+#define LDMS_IDX_LOAD(__p) (*(__p))
+#define LDMS_IDX_STORE(__p, __v) (*(__p) = (__v))
+#define LDMS_RING_LOCK() pthread_mutex_lock(&ldms_pub.ring_mutex)
+#define LDMS_RING_UNLOCK() pthread_mutex_unlock(&ldms_pub.ring_mutex)
+#endif
+
+/* single-producer, single-consumer ring of events. 'head' is only advanced
+ * by the thread owning the ring and 'tail' only by the publisher thread.
+ * Rings are linked into a global list and are never freed, since a thread
+ * may still reference its ring via TLS after the connector shuts down.
+ */
+struct darshan_ldms_ring
+{
+    darshan_ldms_idx head;
+    darshan_ldms_idx tail;
+    darshan_ldms_idx dropped; /* events dropped because the ring was full */
+    uint64_t generation;      /* connector initialization that created this ring */
+    struct darshan_ldms_ring *next;
+    struct darshan_ldms_event events[DARSHAN_LDMS_RING_SIZE];
+};
+
+/* destination of the encoded events; 'publish' is given a batch of
+ * newline-terminated JSON messages
+ */
+struct darshan_ldms_sink
+{
+    const char *name;
+    int (*open)(const char *arg);
+    int (*publish)(char *batch, size_t len);
+    void (*close)(void);
+};
+
+/* state of the background publisher */
+static struct
+{
+    darshan_ldms_idx running;
+    darshan_ldms_idx stop;
+    int block; /* wait for room in a full ring rather than dropping events */
+    int verbose;
+    pid_t pid;
+    pthread_t thread;
+    uint64_t generation;
+    struct darshan_ldms_ring *rings;
+    pthread_mutex_t rings_mutex;
+#ifndef HAVE_STDATOMIC_H
+    pthread_mutex_t ring_mutex;
+#endif
+    const struct darshan_ldms_sink *sink;
+    char *batch;
+    size_t batch_len;
+    uint64_t publish_errors;
+    int64_t jobid;
+    int64_t uid;
+    char exe[DARSHAN_EXE_LEN+1];
+    char hname[HOST_NAME_MAX];
+} ldms_pub = {
+    .rings_mutex = PTHREAD_MUTEX_INITIALIZER,
+#ifndef HAVE_STDATOMIC_H
+    .ring_mutex = PTHREAD_MUTEX_INITIALIZER,
+#endif
+};
+
+static __thread struct darshan_ldms_ring *ldms_tls_ring = NULL;
 
 struct darshanConnector dC = {
-     .ldms_darsh = NULL,
-     .ldms_lib = 1,
-     .jobid = 0,
+     .ldms_lib = 0,
      };
 
+/* writes all of a buffer to the given descriptor.  The sinks call into the
+ * kernel directly, so that their I/O is not instrumented by Darshan.
+ */
+static int darshan_ldms_write_all(int fd, const char *buf, size_t len, int is_sock)
+{
+    ssize_t ret;
+
+    while(len > 0)
+    {
+        if(is_sock)
+            ret = send(fd, buf, len, MSG_NOSIGNAL);
+        else
+            ret = syscall(SYS_write, fd, buf, len);
+        if(ret < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            return(-1);
+        }
+        buf += ret;
+        len -= ret;
+    }
+
+    return(0);
+}
+
+static int ldms_sink_fd = -1;
+
+static int darshan_ldms_file_open(const char *path)
+{
+    ldms_sink_fd = syscall(SYS_openat, AT_FDCWD, path,
+        O_WRONLY | O_CREAT | O_APPEND, 0644);
+    return(ldms_sink_fd < 0 ? -1 : 0);
+}
+
+static int darshan_ldms_file_publish(char *batch, size_t len)
+{
+    return(darshan_ldms_write_all(ldms_sink_fd, batch, len, 0));
+}
+
+static int darshan_ldms_unix_open(const char *path)
+{
+    struct sockaddr_un addr;
+
+    if(strlen(path) >= sizeof(addr.sun_path))
+        return(-1);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    ldms_sink_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(ldms_sink_fd < 0)
+        return(-1);
+    if(connect(ldms_sink_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        syscall(SYS_close, ldms_sink_fd);
+        ldms_sink_fd = -1;
+        return(-1);
+    }
+
+    return(0);
+}
+
+static int darshan_ldms_unix_publish(char *batch, size_t len)
+{
+    return(darshan_ldms_write_all(ldms_sink_fd, batch, len, 1));
+}
+
+static void darshan_ldms_fd_close(void)
+{
+    if(ldms_sink_fd >= 0)
+        syscall(SYS_close, ldms_sink_fd);
+    ldms_sink_fd = -1;
+}
+
+static const struct darshan_ldms_sink darshan_ldms_file_sink = {
+    .name = "file",
+    .open = darshan_ldms_file_open,
+    .publish = darshan_ldms_file_publish,
+    .close = darshan_ldms_fd_close,
+};
+
+static const struct darshan_ldms_sink darshan_ldms_unix_sink = {
+    .name = "unix",
+    .open = darshan_ldms_unix_open,
+    .publish = darshan_ldms_unix_publish,
+    .close = darshan_ldms_fd_close,
+};
+
+/* Check for LDMS libraries if Darshan is built --with-ldms */
+#ifdef HAVE_LDMS
+
 static void event_cb(ldms_t x, ldms_xprt_event_t e, void *cb_arg)
 {
 	switch (e->type) {
@@ -100,64 +301,8 @@ ldms_t setup_connection(const char *xprt, const char *host,
 	return dC.ldms_g;
 }
 
-void darshan_ldms_connector_initialize(struct darshan_core_runtime *init_core)
+static int darshan_ldms_stream_open(const char *arg)
 {
-     /*TODO: Create environment variable to re-connect to ldms every x seconds
-	if(getenv("DARSHAN_LDMS_REINIT"))
-	    dC.env_ldms_reinit = getenv("DARSHAN_LDMS_REINIT");
-	else
-	    dC.env_ldms_reinit = "1";*/
-
-    (void)gethostname(dC.hname, sizeof(dC.hname));
-
-    dC.uid = init_core->log_job_p->uid;
-
-    if (getenv("SLURM_JOB_ID"))
-	dC.jobid = atoi(getenv("SLURM_JOB_ID"));
-    else if (getenv("LSB_JOBID"))
-	dC.jobid = atoi(getenv("LSB_JOBID"));
-    else if (getenv("JOB_ID"))
-	dC.jobid = atoi(getenv("JOB_ID"));
-    else if (getenv("LOAD_STEP_ID"))
-	dC.jobid = atoi(getenv("LOAD_STEP_ID"));
-    else
-        /* grab jobid from darshan_core_runtime if slurm, lsf, sge or loadleveler do not exist*/
-        dC.jobid = init_core->log_job_p->jobid;
-
-    /* grab exe path from darshan_core_runtime. Save with a tmp that will be used later*/
-    dC.exepath = strtok(init_core->log_exemnt_p, " ");
-    dC.exe_tmp = dC.exepath;
-
-    /* Set flags for various LDMS environment variables */
-    if (getenv("DARSHAN_LDMS_ENABLE_ALL")){
-	dC.posix_enable_ldms = 1;
-	dC.mpiio_enable_ldms = 1;
-	dC.stdio_enable_ldms = 1;
-	dC.hdf5_enable_ldms = 1;
-	}
-
-    else {
-	if (getenv("DARSHAN_LDMS_ENABLE_POSIX"))
-		dC.posix_enable_ldms = 1;
-	else
-		dC.posix_enable_ldms = 0;
-
-	if (getenv("DARSHAN_LDMS_ENABLE_MPIIO"))
-		dC.mpiio_enable_ldms = 1;
-	else
-		dC.mpiio_enable_ldms = 0;
-
-	if (getenv("DARSHAN_LDMS_ENABLE_STDIO"))
-		dC.stdio_enable_ldms = 1;
-	else
-		dC.stdio_enable_ldms = 0;
-
-	if (getenv("DARSHAN_LDMS_ENABLE_HDF5"))
-		dC.hdf5_enable_ldms = 1;
-	else
-		dC.hdf5_enable_ldms = 0;
-	}
-
     const char* env_ldms_xprt	 = getenv("DARSHAN_LDMS_XPRT");
     const char* env_ldms_host	 = getenv("DARSHAN_LDMS_HOST");
     const char* env_ldms_port	 = getenv("DARSHAN_LDMS_PORT");
@@ -192,91 +337,437 @@ void darshan_ldms_connector_initialize(struct darshan_core_runtime *init_core)
 
     if (dC.ldms_darsh == NULL){
         pthread_mutex_unlock(&dC.ln_lock);
-        return;
+        return(-1);
     }
     else if (dC.ldms_darsh->disconnected){
         darshan_core_fprintf(stderr, "LDMS library: darshanConnector - disconnected from LDMS streams daemon -- exiting.\n");
+        dC.ldms_darsh = NULL;
         pthread_mutex_unlock(&dC.ln_lock);
-        return;
+        return(-1);
     }
     pthread_mutex_unlock(&dC.ln_lock);
-    return;
+    return(0);
 }
 
-void darshan_ldms_connector_send(uint64_t record_id, int64_t rank, int64_t record_count, char *rwo, int64_t offset, int64_t length, int64_t max_byte, int64_t rw_switch, int64_t flushes,  double start_time, double end_time, double total_time, char *mod_name, char *data_type)
+static int darshan_ldms_stream_publish(char *batch, size_t len)
 {
-    char jb11[1024];
-    int rc, ret, i, size, exists, found;
-    struct timespec tspec_start, tspec_end;
-    uint64_t micro_s;
+    char *msg, *end;
+    int rc, ret = 0;
 
-    pthread_mutex_lock(&dC.ln_lock);
-    if (dC.ldms_darsh != NULL)
-	exists = 1;
-    else
-	exists = 0;
-    pthread_mutex_unlock(&dC.ln_lock);
-
-    if (!exists){
-	return;
+    /* the streams daemon expects one JSON message per publish */
+    for(msg = batch; msg < batch + len; msg = end + 1)
+    {
+        end = memchr(msg, '\n', batch + len - msg);
+        *end = '\0';
+        rc = ldmsd_stream_publish(dC.ldms_darsh, dC.env_ldms_stream, LDMSD_STREAM_JSON, msg, end - msg + 1);
+        if (rc)
+        {
+            darshan_core_fprintf(stderr, "LDMS library: darshanConnector - error %d publishing stream data.\n", rc);
+            ret = -1;
+        }
     }
 
-    /* Current schema name used to query darshan data stored in DSOS.
-    * If not storing to DSOS, then this can be ignored.*/
-    dC.schema = "darshan_data";
+    return(ret);
+}
+
+static void darshan_ldms_stream_close(void)
+{
+    return;
+}
+
+static const struct darshan_ldms_sink darshan_ldms_stream_sink = {
+    .name = "ldms",
+    .open = darshan_ldms_stream_open,
+    .publish = darshan_ldms_stream_publish,
+    .close = darshan_ldms_stream_close,
+};
 
-    /* get the full file path from record ID */
-    dC.filepath = darshan_core_lookup_record_name(record_id);
+#endif
+
+static const struct darshan_ldms_sink *darshan_ldms_sinks[] = {
+#ifdef HAVE_LDMS
+    &darshan_ldms_stream_sink,
+#endif
+    &darshan_ldms_file_sink,
+    &darshan_ldms_unix_sink,
+    NULL
+};
+
+/* encodes an event as a newline-terminated JSON message at the end of the
+ * publisher's batch buffer
+ */
+static void darshan_ldms_encode(struct darshan_ldms_event *ev)
+{
+    const char *schema = "darshan_data";
+    const char *exepath = ldms_pub.exe;
+    const char *filepath;
+    char *msg = ldms_pub.batch + ldms_pub.batch_len;
+    int64_t no_hdf5_data[5] = {-1, -1, -1, -1, -1};
+    int64_t *hdf5_data = ev->hdf5_data;
+    struct timespec tspec_end;
+    uint64_t micro_s;
+    int len;
 
     /* set all hdf5 related fields to -1 for all other modules*/
-    if (strcmp(mod_name, "H5D") != 0){
-	size = sizeof(dC.hdf5_data)/sizeof(dC.hdf5_data[0]);
-	for (i=0; i < size; i++)
-	    dC.hdf5_data[i] = -1;
-    }
+    if (strcmp(ev->mod_name, "H5D") != 0)
+        hdf5_data = no_hdf5_data;
 
     /* set following fields for module data to N/A to reduce message size */
-    if (strcmp(data_type, "MOD") == 0)
+    if (strcmp(ev->data_type, "MOD") == 0)
     {
-	dC.filepath = "N/A";
-	dC.exepath = "N/A";
-	dC.schema = "N/A";
+        filepath = "N/A";
+        exepath = "N/A";
+        schema = "N/A";
     }
     else
-	dC.exepath = dC.exe_tmp;
+    {
+        /* get the full file path from record ID */
+        filepath = darshan_core_lookup_record_name(ev->record_id);
+        if (!filepath)
+            filepath = "N/A";
+    }
 
-    /* convert the start and end times to timespecs and report absolute timestamps */
-    tspec_start = darshan_core_abs_timespec_from_wtime(start_time);
-    tspec_end = darshan_core_abs_timespec_from_wtime(end_time);
+    /* convert the end time to a timespec and report an absolute timestamp */
+    tspec_end = darshan_core_abs_timespec_from_wtime(ev->end_time);
     micro_s = tspec_end.tv_nsec/1.0e3;
 
-    sprintf(jb11,"{\"schema\":\"%s\", \"uid\":%ld, \"exe\":\"%s\",\"job_id\":%ld,\"rank\":%ld,\"ProducerName\":\"%s\",\"file\":\"%s\",\"record_id\":%"PRIu64",\"module\":\"%s\",\"type\":\"%s\",\"max_byte\":%ld,\"switches\":%ld,\"flushes\":%ld,\"cnt\":%ld,\"op\":\"%s\",\"seg\":[{\"pt_sel\":%ld,\"irreg_hslab\":%ld,\"reg_hslab\":%ld,\"ndims\":%ld,\"npoints\":%ld,\"off\":%ld,\"len\":%ld,\"start\":%0.6f,\"dur\":%0.6f,\"total\":%0.6f,\"timestamp\":%lu.%.6lu}]}", dC.schema, dC.uid, dC.exepath, dC.jobid, rank, dC.hname, dC.filepath, record_id, mod_name, data_type, max_byte, rw_switch, flushes, record_count, rwo, dC.hdf5_data[0], dC.hdf5_data[1], dC.hdf5_data[2], dC.hdf5_data[3], dC.hdf5_data[4], offset, length, start_time, end_time-start_time, total_time, tspec_end.tv_sec, micro_s);
+    len = snprintf(msg, DARSHAN_LDMS_MSG_MAX, "{\"schema\":\"%s\", \"uid\":%ld, \"exe\":\"%s\",\"job_id\":%ld,\"rank\":%ld,\"ProducerName\":\"%s\",\"file\":\"%s\",\"record_id\":%"PRIu64",\"module\":\"%s\",\"type\":\"%s\",\"max_byte\":%ld,\"switches\":%ld,\"flushes\":%ld,\"cnt\":%ld,\"op\":\"%s\",\"seg\":[{\"pt_sel\":%ld,\"irreg_hslab\":%ld,\"reg_hslab\":%ld,\"ndims\":%ld,\"npoints\":%ld,\"off\":%ld,\"len\":%ld,\"start\":%0.6f,\"dur\":%0.6f,\"total\":%0.6f,\"timestamp\":%lu.%.6lu}]}", schema, ldms_pub.uid, exepath, ldms_pub.jobid, ev->rank, ldms_pub.hname, filepath, ev->record_id, ev->mod_name, ev->data_type, ev->max_byte, ev->rw_switch, ev->flushes, ev->record_count, ev->op, hdf5_data[0], hdf5_data[1], hdf5_data[2], hdf5_data[3], hdf5_data[4], ev->offset, ev->length, ev->start_time, ev->end_time-ev->start_time, ev->total_time, tspec_end.tv_sec, micro_s);
+    if (len < 0 || len >= DARSHAN_LDMS_MSG_MAX)
+        return; /* drop messages that do not fit, e.g. with very long paths */
 
-    if (getenv("DARSHAN_LDMS_VERBOSE"))
-       darshan_core_fprintf(stderr, "JSON Message: %s\n", jb11);
+    if (ldms_pub.verbose)
+        darshan_core_fprintf(stderr, "JSON Message: %s\n", msg);
 
-    rc = ldmsd_stream_publish(dC.ldms_darsh, dC.env_ldms_stream, LDMSD_STREAM_JSON, jb11, strlen(jb11) + 1);
-    if (rc)
-       darshan_core_fprintf(stderr, "LDMS library: darshanConnector - error %d publishing stream data.\n", rc);
+    msg[len] = '\n';
+    ldms_pub.batch_len += len + 1;
+}
+
+static void darshan_ldms_flush(void)
+{
+    if (ldms_pub.batch_len == 0)
+        return;
 
-    out_1:
-	 return;
+    if (ldms_pub.sink->publish(ldms_pub.batch, ldms_pub.batch_len) < 0)
+    {
+        if (ldms_pub.publish_errors++ == 0)
+            darshan_core_fprintf(stderr, "darshan library warning: "\
+                "unable to publish LDMS connector data to %s sink\n",
+                ldms_pub.sink->name);
+    }
+    ldms_pub.batch_len = 0;
 }
 
-#else
+/* encodes and publishes all events currently buffered in the rings;
+ * returns the number of events drained
+ */
+static uint64_t darshan_ldms_drain(void)
+{
+    struct darshan_ldms_ring *ring;
+    uint64_t head, tail;
+    uint64_t count = 0;
 
-struct darshanConnector dC = {
- .ldms_lib = 0
- };
+    /* rings are only ever added to the front of the list */
+    pthread_mutex_lock(&ldms_pub.rings_mutex);
+    ring = ldms_pub.rings;
+    pthread_mutex_unlock(&ldms_pub.rings_mutex);
+
+    for (; ring; ring = ring->next)
+    {
+        LDMS_RING_LOCK();
+        head = LDMS_IDX_LOAD(&ring->head);
+        LDMS_RING_UNLOCK();
+        for (tail = LDMS_IDX_LOAD(&ring->tail); tail != head; tail++)
+        {
+            if (ldms_pub.batch_len + DARSHAN_LDMS_MSG_MAX > DARSHAN_LDMS_BATCH_SIZE)
+                darshan_ldms_flush();
+            darshan_ldms_encode(&ring->events[tail & (DARSHAN_LDMS_RING_SIZE - 1)]);
+            count++;
+        }
+        LDMS_RING_LOCK();
+        LDMS_IDX_STORE(&ring->tail, head);
+        LDMS_RING_UNLOCK();
+    }
+    darshan_ldms_flush();
+
+    return(count);
+}
+
+static void *darshan_ldms_publisher(void *arg)
+{
+    struct timespec idle = {0, DARSHAN_LDMS_IDLE_NSEC};
+    uint64_t stop;
+
+    while (1)
+    {
+        /* drain once more after being stopped, so no events are left */
+        stop = LDMS_IDX_LOAD(&ldms_pub.stop);
+        if (darshan_ldms_drain() == 0 && !stop)
+            nanosleep(&idle, NULL);
+        if (stop)
+            break;
+    }
+
+    return(NULL);
+}
+
+static struct darshan_ldms_ring *darshan_ldms_ring_create(void)
+{
+    struct darshan_ldms_ring *ring;
+
+    ring = malloc(sizeof(*ring));
+    if (!ring)
+        return(NULL);
+    memset(ring, 0, sizeof(*ring));
+    ring->generation = ldms_pub.generation;
+
+    pthread_mutex_lock(&ldms_pub.rings_mutex);
+    ring->next = ldms_pub.rings;
+    ldms_pub.rings = ring;
+    pthread_mutex_unlock(&ldms_pub.rings_mutex);
+
+    ldms_tls_ring = ring;
+    return(ring);
+}
 
 void darshan_ldms_connector_initialize(struct darshan_core_runtime *init_core)
 {
+    const struct darshan_ldms_sink *sink = NULL;
+    const char *sink_str;
+    const char *sink_arg = NULL;
+    size_t name_len;
+    sigset_t all_sigs, old_sigs;
+    char *tmp;
+    int i, ret;
+
+     /*TODO: Create environment variable to re-connect to ldms every x seconds
+	if(getenv("DARSHAN_LDMS_REINIT"))
+	    dC.env_ldms_reinit = getenv("DARSHAN_LDMS_REINIT");
+	else
+	    dC.env_ldms_reinit = "1";*/
+
+    if (LDMS_IDX_LOAD(&ldms_pub.running))
+    {
+        if (ldms_pub.pid == getpid())
+            return;
+        /* forked child: the publisher thread was not inherited, so release
+         * the parent's sink and start a new one
+         */
+        LDMS_IDX_STORE(&ldms_pub.running, 0);
+        ldms_pub.sink->close();
+        free(ldms_pub.batch);
+        ldms_pub.batch = NULL;
+    }
+
+    (void)gethostname(ldms_pub.hname, sizeof(ldms_pub.hname));
+
+    ldms_pub.uid = init_core->log_job_p->uid;
+
+    if (getenv("SLURM_JOB_ID"))
+	ldms_pub.jobid = atoi(getenv("SLURM_JOB_ID"));
+    else if (getenv("LSB_JOBID"))
+	ldms_pub.jobid = atoi(getenv("LSB_JOBID"));
+    else if (getenv("JOB_ID"))
+	ldms_pub.jobid = atoi(getenv("JOB_ID"));
+    else if (getenv("LOAD_STEP_ID"))
+	ldms_pub.jobid = atoi(getenv("LOAD_STEP_ID"));
+    else
+        /* grab jobid from darshan_core_runtime if slurm, lsf, sge or loadleveler do not exist*/
+        ldms_pub.jobid = init_core->log_job_p->jobid;
+
+    /* copy the exe path (without arguments) from darshan_core_runtime */
+    strncpy(ldms_pub.exe, init_core->log_exemnt_p, DARSHAN_EXE_LEN);
+    tmp = strchr(ldms_pub.exe, ' ');
+    if (tmp)
+        *tmp = '\0';
+
+    /* Set flags for various LDMS environment variables */
+    if (getenv("DARSHAN_LDMS_ENABLE_ALL")){
+	dC.posix_enable_ldms = 1;
+	dC.mpiio_enable_ldms = 1;
+	dC.stdio_enable_ldms = 1;
+	dC.hdf5_enable_ldms = 1;
+	}
+
+    else {
+	if (getenv("DARSHAN_LDMS_ENABLE_POSIX"))
+		dC.posix_enable_ldms = 1;
+	else
+		dC.posix_enable_ldms = 0;
+
+	if (getenv("DARSHAN_LDMS_ENABLE_MPIIO"))
+		dC.mpiio_enable_ldms = 1;
+	else
+		dC.mpiio_enable_ldms = 0;
+
+	if (getenv("DARSHAN_LDMS_ENABLE_STDIO"))
+		dC.stdio_enable_ldms = 1;
+	else
+		dC.stdio_enable_ldms = 0;
+
+	if (getenv("DARSHAN_LDMS_ENABLE_HDF5"))
+		dC.hdf5_enable_ldms = 1;
+	else
+		dC.hdf5_enable_ldms = 0;
+	}
+
+    ldms_pub.verbose = (getenv("DARSHAN_LDMS_VERBOSE") != NULL);
+    tmp = getenv("DARSHAN_LDMS_BACKPRESSURE");
+    ldms_pub.block = (tmp && strcmp(tmp, "block") == 0);
+
+    /* select the sink events are published to */
+    sink_str = getenv("DARSHAN_LDMS_SINK");
+    if (!sink_str || *sink_str == '\0')
+        sink_str = "ldms";
+    tmp = strchr(sink_str, ':');
+    name_len = tmp ? (size_t)(tmp - sink_str) : strlen(sink_str);
+    if (tmp)
+        sink_arg = tmp + 1;
+    for (i = 0; darshan_ldms_sinks[i]; i++)
+    {
+        if (strlen(darshan_ldms_sinks[i]->name) == name_len &&
+            strncmp(darshan_ldms_sinks[i]->name, sink_str, name_len) == 0)
+            sink = darshan_ldms_sinks[i];
+    }
+    if (!sink || (sink != darshan_ldms_sinks[0] && (!sink_arg || *sink_arg == '\0')))
+    {
+        darshan_core_fprintf(stderr, "darshan library warning: "\
+            "unsupported DARSHAN_LDMS_SINK \"%s\" (expected "
+#ifdef HAVE_LDMS
+            "\"ldms\", "
+#endif
+            "\"file:<path>\" or \"unix:<path>\")\n", sink_str);
+        return;
+    }
+    if (sink->open(sink_arg) < 0)
+    {
+        darshan_core_fprintf(stderr, "darshan library warning: "\
+            "unable to open LDMS connector %s sink\n", sink->name);
+        return;
+    }
+    ldms_pub.sink = sink;
+
+    ldms_pub.batch = malloc(DARSHAN_LDMS_BATCH_SIZE);
+    if (!ldms_pub.batch)
+    {
+        sink->close();
+        return;
+    }
+    ldms_pub.batch_len = 0;
+    ldms_pub.publish_errors = 0;
+
+    /* rings inherited from a parent process are stale */
+    if (ldms_pub.pid != getpid())
+    {
+        ldms_pub.rings = NULL;
+        ldms_pub.generation++;
+        ldms_pub.pid = getpid();
+    }
+
+    LDMS_IDX_STORE(&ldms_pub.stop, 0);
+    LDMS_IDX_STORE(&ldms_pub.running, 1);
+
+    /* keep application signals from being delivered to the publisher */
+    sigfillset(&all_sigs);
+    pthread_sigmask(SIG_SETMASK, &all_sigs, &old_sigs);
+    ret = pthread_create(&ldms_pub.thread, NULL, darshan_ldms_publisher, NULL);
+    pthread_sigmask(SIG_SETMASK, &old_sigs, NULL);
+    if (ret != 0)
+    {
+        LDMS_IDX_STORE(&ldms_pub.running, 0);
+        free(ldms_pub.batch);
+        ldms_pub.batch = NULL;
+        sink->close();
+        return;
+    }
+
+    dC.ldms_lib = 1;
     return;
 }
 
 void darshan_ldms_connector_send(uint64_t record_id, int64_t rank, int64_t record_count, char *rwo, int64_t offset, int64_t length, int64_t max_byte, int64_t rw_switch, int64_t flushes,  double start_time, double end_time, double total_time, char *mod_name, char *data_type)
 {
+    struct darshan_ldms_ring *ring = ldms_tls_ring;
+    struct darshan_ldms_event *ev;
+    uint64_t head;
+
+    if (!LDMS_IDX_LOAD(&ldms_pub.running))
+        return;
+
+    if (!ring || ring->generation != ldms_pub.generation)
+    {
+        ring = darshan_ldms_ring_create();
+        if (!ring)
+            return;
+    }
+
+    LDMS_RING_LOCK();
+    head = LDMS_IDX_LOAD(&ring->head);
+    while (head - LDMS_IDX_LOAD(&ring->tail) >= DARSHAN_LDMS_RING_SIZE)
+    {
+        /* ring is full: drop the event or wait for the publisher */
+        if (!ldms_pub.block || !LDMS_IDX_LOAD(&ldms_pub.running))
+        {
+            LDMS_IDX_STORE(&ring->dropped, LDMS_IDX_LOAD(&ring->dropped) + 1);
+            LDMS_RING_UNLOCK();
+            return;
+        }
+        LDMS_RING_UNLOCK();
+        sched_yield();
+        LDMS_RING_LOCK();
+    }
+
+    ev = &ring->events[head & (DARSHAN_LDMS_RING_SIZE - 1)];
+    ev->record_id = record_id;
+    ev->rank = rank;
+    ev->record_count = record_count;
+    ev->offset = offset;
+    ev->length = length;
+    ev->max_byte = max_byte;
+    ev->rw_switch = rw_switch;
+    ev->flushes = flushes;
+    memcpy(ev->hdf5_data, dC.hdf5_data, sizeof(ev->hdf5_data));
+    ev->start_time = start_time;
+    ev->end_time = end_time;
+    ev->total_time = total_time;
+    ev->op = rwo;
+    ev->mod_name = mod_name;
+    ev->data_type = data_type;
+
+    LDMS_IDX_STORE(&ring->head, head + 1);
+    LDMS_RING_UNLOCK();
+
     return;
 }
-#endif
 
+void darshan_ldms_connector_shutdown(void)
+{
+    struct darshan_ldms_ring *ring;
+    uint64_t dropped = 0;
+
+    if (!LDMS_IDX_LOAD(&ldms_pub.running))
+        return;
+
+    dC.ldms_lib = 0;
+    LDMS_IDX_STORE(&ldms_pub.running, 0);
+
+    /* the publisher thread does not exist in a forked child process */
+    if (ldms_pub.pid == getpid())
+    {
+        LDMS_IDX_STORE(&ldms_pub.stop, 1);
+        pthread_join(ldms_pub.thread, NULL);
+    }
+    ldms_pub.sink->close();
+    free(ldms_pub.batch);
+    ldms_pub.batch = NULL;
+
+    pthread_mutex_lock(&ldms_pub.rings_mutex);
+    for (ring = ldms_pub.rings; ring; ring = ring->next)
+        dropped += LDMS_IDX_LOAD(&ring->dropped);
+    pthread_mutex_unlock(&ldms_pub.rings_mutex);
+    if (dropped)
+        darshan_core_fprintf(stderr, "darshan library warning: "\
+            "LDMS connector dropped %" PRIu64 " events that arrived faster "\
+            "than they could be published\n", dropped);
+
+    return;
+}
@@ -258,7 +258,7 @@ void darshan_instrument_lustre_file(darshan_record_id rec_id, int fd)
         rec_size = LUSTRE_RECORD_SIZE(num_comps, num_stripes);
 
         /* allocate and add a new record reference */
-        rec_ref = malloc(sizeof(*rec_ref));
+        rec_ref = darshan_core_arena_alloc(DARSHAN_LUSTRE_MOD, sizeof(*rec_ref));
         if(!rec_ref)
         {
             llapi_layout_free(lustre_layout);
@@ -267,10 +267,10 @@ void darshan_instrument_lustre_file(darshan_record_id rec_id, int fd)
         }
     
         ret = darshan_add_record_ref(&(lustre_runtime->record_id_hash),
-            &rec_id, sizeof(darshan_record_id), rec_ref);
+            &rec_id, sizeof(darshan_record_id), rec_ref, DARSHAN_LUSTRE_MOD);
         if(ret == 0)
         {
-            free(rec_ref);
+            darshan_core_arena_free(rec_ref);
             llapi_layout_free(lustre_layout);
             LUSTRE_UNLOCK();
             return;
@@ -288,7 +288,7 @@ void darshan_instrument_lustre_file(darshan_record_id rec_id, int fd)
             /* if NULL, darshan has no more memory for instrumenting */
             darshan_delete_record_ref(&(lustre_runtime->record_id_hash),
                 &rec_id, sizeof(darshan_record_id));
-            free(rec_ref);
+            darshan_core_arena_free(rec_ref);
             llapi_layout_free(lustre_layout);
             LUSTRE_UNLOCK();
             return;
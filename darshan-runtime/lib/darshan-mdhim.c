@@ -367,7 +367,7 @@ static struct mdhim_record_ref *mdhim_track_new_record(
     int ret;
     size_t rec_size;
 
-    rec_ref = calloc(1, sizeof(*rec_ref));
+    rec_ref = darshan_core_arena_alloc(DARSHAN_MDHIM_MOD, sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
 
@@ -375,10 +375,10 @@ static struct mdhim_record_ref *mdhim_track_new_record(
      * table, using the Darshan record identifier as the handle
      */
     ret = darshan_add_record_ref(&(mdhim_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+        sizeof(darshan_record_id), rec_ref, DARSHAN_MDHIM_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -398,7 +398,7 @@ static struct mdhim_record_ref *mdhim_track_new_record(
         /* if registration fails, delete record reference and return */
         darshan_delete_record_ref(&(mdhim_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
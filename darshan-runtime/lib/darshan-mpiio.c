@@ -21,7 +21,6 @@
 #include <time.h>
 #include <stdlib.h>
 #include <errno.h>
-#include <search.h>
 #include <assert.h>
 #include <pthread.h>
 
@@ -151,11 +150,10 @@ struct mpiio_file_record_ref
     double last_meta_end;
     double last_read_end;
     double last_write_end;
-    void *access_root;
-    int access_count;
-#ifdef HAVE_LDMS
+    struct darshan_common_val_table access_table;
     int64_t close_counts;
-#endif
+    struct heatmap_record_ref *heatmap; /* per-file heatmap, if any */
+    int heatmap_registered; /* per-file heatmap registration attempted */
 };
 
 /* The mpiio_runtime structure maintains necessary state for storing
@@ -167,7 +165,7 @@ struct mpiio_runtime
     void *rec_id_hash;
     void *fh_hash;
     int file_rec_count;
-    darshan_record_id heatmap_id;
+    struct heatmap_record_ref *heatmap;
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
@@ -175,17 +173,20 @@ static void mpiio_runtime_initialize(
     void);
 static struct mpiio_file_record_ref *mpiio_track_new_file_record(
     darshan_record_id rec_id, const char *path);
-static void mpiio_finalize_file_records(
-    void *rec_ref_p, void *user_ptr);
 #ifdef HAVE_MPI
 static void mpiio_record_reduction_op(
     void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
 static void mpiio_shared_record_variance(
     MPI_Comm mod_comm, struct darshan_mpiio_file *inrec_array,
     struct darshan_mpiio_file *outrec_array, int shared_rec_count);
+static void mpiio_shared_record_init(
+    struct darshan_mpiio_file *rec);
 static void mpiio_mpi_redux(
     void *mpiio_buf, MPI_Comm mod_comm,
     darshan_record_id *shared_recs, int shared_rec_count);
+static void mpiio_mpi_partial_redux(
+    void *mpiio_buf, MPI_Comm mod_comm,
+    struct darshan_partial_shared_rec *partial_recs, int partial_rec_count);
 #endif
 static void mpiio_output(
     void **mpiio_buf, int *mpiio_buf_sz);
@@ -252,7 +253,7 @@ static int my_rank = -1;
     rec_ref->file_rec->fcounters[MPIIO_F_OPEN_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(rec_ref->file_rec->fcounters[MPIIO_F_META_TIME], \
         __tm1, __tm2, rec_ref->last_meta_end); \
-    darshan_add_record_ref(&(mpiio_runtime->fh_hash), &__fh, sizeof(MPI_File), rec_ref); \
+    darshan_add_record_ref(&(mpiio_runtime->fh_hash), &__fh, sizeof(MPI_File), rec_ref, DARSHAN_MPIIO_MOD); \
     if(newpath != __path) free(newpath); \
     /* LDMS to publish realtime open tracing information to daemon*/ \
     if(dC.ldms_lib)\
@@ -288,11 +289,11 @@ static int get_byte_offset = 0;
     /* DXT to record detailed read tracing information */ \
     dxt_mpiio_read(rec_ref->file_rec->base_rec.id, displacement, size, __tm1, __tm2); \
     /* heatmap to record traffic summary */ \
-    heatmap_update(mpiio_runtime->heatmap_id, HEATMAP_READ, size, __tm1, __tm2); \
+    heatmap_update(mpiio_runtime->heatmap, HEATMAP_READ, size, __tm1, __tm2); \
+    HEATMAP_UPDATE_FILE(mpiio_runtime->heatmap, rec_ref, HEATMAP_READ, size, __tm1, __tm2); \
     DARSHAN_BUCKET_INC(&(rec_ref->file_rec->counters[MPIIO_SIZE_READ_AGG_0_100]), size); \
     size_ll = size; \
-    cvc = darshan_track_common_val_counters(&rec_ref->access_root, &size_ll, 1, \
-        &rec_ref->access_count); \
+    cvc = darshan_track_common_val_counters(&rec_ref->access_table, &size_ll, 1); \
     if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[MPIIO_ACCESS1_ACCESS]), \
         &(rec_ref->file_rec->counters[MPIIO_ACCESS1_COUNT]), \
@@ -335,11 +336,11 @@ static int get_byte_offset = 0;
     /* DXT to record detailed write tracing information */ \
     dxt_mpiio_write(rec_ref->file_rec->base_rec.id, displacement, size, __tm1, __tm2); \
     /* heatmap to record traffic summary */ \
-    heatmap_update(mpiio_runtime->heatmap_id, HEATMAP_WRITE, size, __tm1, __tm2); \
+    heatmap_update(mpiio_runtime->heatmap, HEATMAP_WRITE, size, __tm1, __tm2); \
+    HEATMAP_UPDATE_FILE(mpiio_runtime->heatmap, rec_ref, HEATMAP_WRITE, size, __tm1, __tm2); \
     DARSHAN_BUCKET_INC(&(rec_ref->file_rec->counters[MPIIO_SIZE_WRITE_AGG_0_100]), size); \
     size_ll = size; \
-    cvc = darshan_track_common_val_counters(&rec_ref->access_root, &size_ll, 1, \
-        &rec_ref->access_count); \
+    cvc = darshan_track_common_val_counters(&rec_ref->access_table, &size_ll, 1); \
     if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[MPIIO_ACCESS1_ACCESS]), \
         &(rec_ref->file_rec->counters[MPIIO_ACCESS1_COUNT]), \
@@ -1306,13 +1307,11 @@ int DARSHAN_DECL(MPI_File_close)(MPI_File *fh)
         darshan_delete_record_ref(&(mpiio_runtime->fh_hash),
             &tmp_fh, sizeof(MPI_File));
 
-#ifdef HAVE_LDMS
         rec_ref->close_counts++;
         /* publish close information for mpiio */
         if(dC.ldms_lib)
             if(dC.mpiio_enable_ldms)
                 darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->close_counts, "close", -1, -1, -1, -1, -1, tm1, tm2, rec_ref->file_rec->fcounters[MPIIO_F_META_TIME], "MPIIO", "MOD");
-#endif
     }
     MPIIO_POST_RECORD();
 
@@ -1332,6 +1331,7 @@ static void mpiio_runtime_initialize()
     darshan_module_funcs mod_funcs = {
 #ifdef HAVE_MPI
     .mod_redux_func = &mpiio_mpi_redux,
+    .mod_partial_redux_func = &mpiio_mpi_partial_redux,
 #endif
     .mod_output_func = &mpiio_output,
     .mod_cleanup_func = &mpiio_cleanup
@@ -1366,7 +1366,7 @@ static void mpiio_runtime_initialize()
     dxt_mpiio_runtime_initialize();
 
     /* register a heatmap */
-    mpiio_runtime->heatmap_id = heatmap_register("heatmap:MPIIO");
+    mpiio_runtime->heatmap = heatmap_register("heatmap:MPIIO");
 
     return;
 }
@@ -1378,17 +1378,16 @@ static struct mpiio_file_record_ref *mpiio_track_new_file_record(
     struct mpiio_file_record_ref *rec_ref = NULL;
     int ret;
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_core_arena_alloc(DARSHAN_MPIIO_MOD, sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this file record based on record id */
     ret = darshan_add_record_ref(&(mpiio_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+        sizeof(darshan_record_id), rec_ref, DARSHAN_MPIIO_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -1406,7 +1405,7 @@ static struct mpiio_file_record_ref *mpiio_track_new_file_record(
     {
         darshan_delete_record_ref(&(mpiio_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -1419,15 +1418,6 @@ static struct mpiio_file_record_ref *mpiio_track_new_file_record(
     return(rec_ref);
 }
 
-static void mpiio_finalize_file_records(void *rec_ref_p, void *user_ptr)
-{
-    struct mpiio_file_record_ref *rec_ref =
-        (struct mpiio_file_record_ref *)rec_ref_p;
-
-    tdestroy(rec_ref->access_root, free);
-    return;
-}
-
 #ifdef HAVE_MPI
 static void mpiio_record_reduction_op(void* infile_v, void* inoutfile_v,
     int *len, MPI_Datatype *datatype)
@@ -1781,6 +1771,33 @@ void darshan_mpiio_shutdown_bench_setup(int test_case)
  ********************************************************************************/
 
 #ifdef HAVE_MPI
+/* initialize fastest/slowest info of a shared record prior to reduction */
+static void mpiio_shared_record_init(struct darshan_mpiio_file *rec)
+{
+    double mpiio_time =
+        rec->fcounters[MPIIO_F_READ_TIME] +
+        rec->fcounters[MPIIO_F_WRITE_TIME] +
+        rec->fcounters[MPIIO_F_META_TIME];
+
+    rec->counters[MPIIO_FASTEST_RANK] = rec->base_rec.rank;
+    rec->counters[MPIIO_FASTEST_RANK_BYTES] =
+        rec->counters[MPIIO_BYTES_READ] +
+        rec->counters[MPIIO_BYTES_WRITTEN];
+    rec->fcounters[MPIIO_F_FASTEST_RANK_TIME] = mpiio_time;
+
+    /* until reduction occurs, we assume that this rank is both
+     * the fastest and slowest. It is up to the reduction operator
+     * to find the true min and max.
+     */
+    rec->counters[MPIIO_SLOWEST_RANK] = rec->counters[MPIIO_FASTEST_RANK];
+    rec->counters[MPIIO_SLOWEST_RANK_BYTES] =
+        rec->counters[MPIIO_FASTEST_RANK_BYTES];
+    rec->fcounters[MPIIO_F_SLOWEST_RANK_TIME] =
+        rec->fcounters[MPIIO_F_FASTEST_RANK_TIME];
+
+    return;
+}
+
 static void mpiio_mpi_redux(
     void *mpiio_buf,
     MPI_Comm mod_comm,
@@ -1790,7 +1807,6 @@ static void mpiio_mpi_redux(
     int mpiio_rec_count;
     struct mpiio_file_record_ref *rec_ref;
     struct darshan_mpiio_file *mpiio_rec_buf = (struct darshan_mpiio_file *)mpiio_buf;
-    double mpiio_time;
     struct darshan_mpiio_file *red_send_buf = NULL;
     struct darshan_mpiio_file *red_recv_buf = NULL;
     MPI_Datatype red_type;
@@ -1809,32 +1825,8 @@ static void mpiio_mpi_redux(
             &shared_recs[i], sizeof(darshan_record_id));
         assert(rec_ref);
 
-        mpiio_time =
-                rec_ref->file_rec->fcounters[MPIIO_F_READ_TIME] +
-                rec_ref->file_rec->fcounters[MPIIO_F_WRITE_TIME] +
-                rec_ref->file_rec->fcounters[MPIIO_F_META_TIME];
-
-        /* initialize fastest/slowest info prior to the reduction */
-        rec_ref->file_rec->counters[MPIIO_FASTEST_RANK] =
-            rec_ref->file_rec->base_rec.rank;
-        rec_ref->file_rec->counters[MPIIO_FASTEST_RANK_BYTES] =
-            rec_ref->file_rec->counters[MPIIO_BYTES_READ] +
-            rec_ref->file_rec->counters[MPIIO_BYTES_WRITTEN];
-        rec_ref->file_rec->fcounters[MPIIO_F_FASTEST_RANK_TIME] =
-            mpiio_time;
-
-            /* until reduction occurs, we assume that this rank is both
-             * the fastest and slowest. It is up to the reduction operator
-             * to find the true min and max.
-             */
-            rec_ref->file_rec->counters[MPIIO_SLOWEST_RANK] =
-                rec_ref->file_rec->counters[MPIIO_FASTEST_RANK];
-            rec_ref->file_rec->counters[MPIIO_SLOWEST_RANK_BYTES] =
-                rec_ref->file_rec->counters[MPIIO_FASTEST_RANK_BYTES];
-            rec_ref->file_rec->fcounters[MPIIO_F_SLOWEST_RANK_TIME] =
-                rec_ref->file_rec->fcounters[MPIIO_F_FASTEST_RANK_TIME];
-
-            rec_ref->file_rec->base_rec.rank = -1;
+        mpiio_shared_record_init(rec_ref->file_rec);
+        rec_ref->file_rec->base_rec.rank = -1;
     }
 
     /* sort the array of records so we get all of the shared records
@@ -1896,6 +1888,106 @@ static void mpiio_mpi_redux(
     MPIIO_UNLOCK();
     return;
 }
+
+static void mpiio_mpi_partial_redux(
+    void *mpiio_buf,
+    MPI_Comm mod_comm,
+    struct darshan_partial_shared_rec *partial_recs,
+    int partial_rec_count)
+{
+    struct darshan_mpiio_file *mpiio_rec_buf = (struct darshan_mpiio_file *)mpiio_buf;
+    struct darshan_mpiio_file *recv_recs = NULL;
+    struct darshan_mpiio_file *rec;
+    struct darshan_partial_shared_rec *partial_rec;
+    struct darshan_variance_dt time_var, bytes_var, tmp_var;
+    int recv_rec_count;
+    int one = 1;
+    int ret;
+    int i, j;
+
+    MPIIO_LOCK();
+    assert(mpiio_runtime);
+
+    /* necessary initialization of partially shared records */
+    for(i = 0; i < mpiio_runtime->file_rec_count; i++)
+    {
+        rec = &mpiio_rec_buf[i];
+        if(rec->base_rec.rank >= 0 && darshan_partial_record_lookup(
+            partial_recs, partial_rec_count, rec->base_rec.id))
+        {
+            mpiio_shared_record_init(rec);
+        }
+    }
+
+    /* move each partially shared record to the lowest rank that opened it */
+    ret = darshan_partial_record_exchange(mod_comm, DARSHAN_MPIIO_MOD, mpiio_buf,
+        &mpiio_runtime->file_rec_count, sizeof(struct darshan_mpiio_file),
+        partial_recs, partial_rec_count, (void **)&recv_recs, &recv_rec_count);
+    if(ret < 0)
+    {
+        /* leave the records we would have reduced rank-local */
+        MPIIO_UNLOCK();
+        return;
+    }
+
+    /* reduce the received records into our own, both sorted by id; records
+     * that could not be sent to the process reducing them are still here
+     */
+    for(i = 0, j = 0; i < mpiio_runtime->file_rec_count; i++)
+    {
+        rec = &mpiio_rec_buf[i];
+        if(rec->base_rec.rank < 0)
+            continue;
+        partial_rec = darshan_partial_record_lookup(partial_recs,
+            partial_rec_count, rec->base_rec.id);
+        if(!partial_rec || partial_rec->root != my_rank)
+            continue;
+
+        time_var.n = 1;
+        time_var.S = 0;
+        time_var.T = rec->fcounters[MPIIO_F_READ_TIME] +
+                     rec->fcounters[MPIIO_F_WRITE_TIME] +
+                     rec->fcounters[MPIIO_F_META_TIME];
+        bytes_var.n = 1;
+        bytes_var.S = 0;
+        bytes_var.T = (double)
+                      rec->counters[MPIIO_BYTES_READ] +
+                      rec->counters[MPIIO_BYTES_WRITTEN];
+
+        while(j < recv_rec_count && recv_recs[j].base_rec.id < rec->base_rec.id)
+            j++;
+        for(; j < recv_rec_count && recv_recs[j].base_rec.id == rec->base_rec.id; j++)
+        {
+            tmp_var.n = 1;
+            tmp_var.S = 0;
+            tmp_var.T = recv_recs[j].fcounters[MPIIO_F_READ_TIME] +
+                        recv_recs[j].fcounters[MPIIO_F_WRITE_TIME] +
+                        recv_recs[j].fcounters[MPIIO_F_META_TIME];
+            darshan_variance_reduce(&tmp_var, &time_var, &one, NULL);
+            tmp_var.n = 1;
+            tmp_var.S = 0;
+            tmp_var.T = (double)
+                        recv_recs[j].counters[MPIIO_BYTES_READ] +
+                        recv_recs[j].counters[MPIIO_BYTES_WRITTEN];
+            darshan_variance_reduce(&tmp_var, &bytes_var, &one, NULL);
+
+            mpiio_record_reduction_op(&recv_recs[j], rec, &one, NULL);
+        }
+
+        rec->fcounters[MPIIO_F_VARIANCE_RANK_TIME] = time_var.S / time_var.n;
+        rec->fcounters[MPIIO_F_VARIANCE_RANK_BYTES] = bytes_var.S / bytes_var.n;
+
+        /* the rank field of a partially shared record holds the negated
+         * number of processes that opened it
+         */
+        rec->base_rec.rank = -partial_rec->rank_count;
+    }
+
+    free(recv_recs);
+
+    MPIIO_UNLOCK();
+    return;
+}
 #endif
 
 static void mpiio_output(
@@ -1923,8 +2015,6 @@ static void mpiio_cleanup()
     assert(mpiio_runtime);
 
     /* cleanup internal structures used for instrumenting */
-    darshan_iter_record_refs(mpiio_runtime->rec_id_hash,
-        &mpiio_finalize_file_records, NULL);
     darshan_clear_record_refs(&(mpiio_runtime->fh_hash), 0);
     darshan_clear_record_refs(&(mpiio_runtime->rec_id_hash), 1);
 
@@ -263,19 +263,18 @@ static struct null_record_ref *null_track_new_record(
     struct null_record_ref *rec_ref = NULL;
     int ret;
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_core_arena_alloc(DARSHAN_NULL_MOD, sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* allocate a new NULL record reference and add it to the hash
      * table, using the Darshan record identifier as the handle
      */
     ret = darshan_add_record_ref(&(null_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+        sizeof(darshan_record_id), rec_ref, DARSHAN_NULL_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -294,7 +293,7 @@ static struct null_record_ref *null_track_new_record(
         /* if registration fails, delete record reference and return */
         darshan_delete_record_ref(&(null_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
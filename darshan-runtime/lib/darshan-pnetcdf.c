@@ -20,7 +20,6 @@
 #include <time.h>
 #include <stdlib.h>
 #include <errno.h>
-#include <search.h>
 #include <assert.h>
 #include <pthread.h>
 
@@ -45,8 +44,6 @@ struct pnetcdf_var_record_ref
     double last_read_end;
     double last_write_end;
     double last_meta_end;
-    void *access_root;
-    int access_count;
     int unlimdimid;
 };
 
@@ -74,8 +71,6 @@ static struct pnetcdf_file_record_ref *pnetcdf_file_track_new_record(
     darshan_record_id rec_id, const char *path);
 static struct pnetcdf_var_record_ref *pnetcdf_var_track_new_record(
     darshan_record_id rec_id, const char *path);
-static void pnetcdf_var_finalize_records(
-    void *rec_ref_p, void *user_ptr);
 static void pnetcdf_file_record_reduction_op(
     void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
 static void pnetcdf_var_record_reduction_op(
@@ -244,16 +239,16 @@ static struct pnetcdf_file_record_ref *pnetcdf_file_track_new_record(
     struct pnetcdf_file_record_ref *rec_ref = NULL;
     int ret;
 
-    rec_ref = (struct pnetcdf_file_record_ref*) calloc(1, sizeof(struct pnetcdf_file_record_ref));
+    rec_ref = darshan_core_arena_alloc(DARSHAN_PNETCDF_FILE_MOD, sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
 
     /* add a reference to this file record based on record id */
     ret = darshan_add_record_ref(&(pnetcdf_file_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+        sizeof(darshan_record_id), rec_ref, DARSHAN_PNETCDF_FILE_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -271,7 +266,7 @@ static struct pnetcdf_file_record_ref *pnetcdf_file_track_new_record(
     {
         darshan_delete_record_ref(&(pnetcdf_file_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -291,16 +286,16 @@ static struct pnetcdf_var_record_ref *pnetcdf_var_track_new_record(
     struct pnetcdf_var_record_ref *rec_ref = NULL;
     int ret;
 
-    rec_ref = (struct pnetcdf_var_record_ref*) calloc(1, sizeof(struct pnetcdf_var_record_ref));
+    rec_ref = darshan_core_arena_alloc(DARSHAN_PNETCDF_VAR_MOD, sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
 
     /* add a reference to this variable record based on record id */
     ret = darshan_add_record_ref(&(pnetcdf_var_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+        sizeof(darshan_record_id), rec_ref, DARSHAN_PNETCDF_VAR_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -318,7 +313,7 @@ static struct pnetcdf_var_record_ref *pnetcdf_var_track_new_record(
     {
         darshan_delete_record_ref(&(pnetcdf_var_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -331,15 +326,6 @@ static struct pnetcdf_var_record_ref *pnetcdf_var_track_new_record(
     return(rec_ref);
 }
 
-static void pnetcdf_var_finalize_records(void *rec_ref_p, void *user_ptr)
-{
-    struct pnetcdf_var_record_ref *rec_ref =
-        (struct pnetcdf_var_record_ref *)rec_ref_p;
-
-    tdestroy(rec_ref->access_root, free);
-    return;
-}
-
 static void pnetcdf_file_record_reduction_op(void* infile_v, void* inoutfile_v,
     int *len, MPI_Datatype *datatype)
 {
@@ -929,12 +915,6 @@ static void pnetcdf_var_cleanup(void)
     PNETCDF_LOCK();
     assert(pnetcdf_var_runtime);
 
-    /* perform any final transformations on PnetCDF file records before
-     * writing them out to log file
-     */
-    darshan_iter_record_refs(pnetcdf_var_runtime->rec_id_hash,
-        &pnetcdf_var_finalize_records, NULL);
-
     /* cleanup internal structures used for instrumenting */
     darshan_clear_record_refs(&(pnetcdf_var_runtime->varid_hash), 0);
     darshan_clear_record_refs(&(pnetcdf_var_runtime->rec_id_hash), 1);
@@ -23,7 +23,6 @@
 #include <errno.h>
 #include <sys/uio.h>
 #include <sys/mman.h>
-#include <search.h>
 #include <assert.h>
 #include <libgen.h>
 #include <aio.h>
@@ -143,15 +142,13 @@ struct posix_file_record_ref
     double last_meta_end;
     double last_read_end;
     double last_write_end;
-    void *access_root;
-    int access_count;
-    void *stride_root;
-    int stride_count;
+    struct darshan_common_val_table access_table;
+    struct darshan_common_val_table stride_table;
     struct posix_aio_tracker* aio_list;
     int fs_type; /* same as darshan_fs_info->fs_type */
-#ifdef HAVE_LDMS
     int64_t close_counts;
-#endif
+    struct heatmap_record_ref *heatmap; /* per-file heatmap, if any */
+    int heatmap_registered; /* per-file heatmap registration attempted */
 };
 
 /* The posix_runtime structure maintains necessary state for storing
@@ -163,7 +160,7 @@ struct posix_runtime
     void *rec_id_hash;
     void *fd_hash;
     int file_rec_count;
-    darshan_record_id heatmap_id;
+    struct heatmap_record_ref *heatmap;
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
@@ -175,6 +172,80 @@ struct posix_aio_tracker
     struct posix_aio_tracker *next;
 };
 
+#ifdef HAVE_STDATOMIC_H
+/* number of entries in each thread's direct-mapped fd cache (power of 2) */
+#define POSIX_THREAD_FD_CACHE_SIZE 64
+
+/* number of read (or write) busy intervals a thread can accumulate for a
+ * file before they must be merged into the shared record
+ */
+#define POSIX_THREAD_MAX_INTERVALS 64
+
+/* interval during which a thread was reading or writing a file */
+struct posix_thread_interval
+{
+    double start;
+    double end;
+};
+
+/* The posix_thread_delta structure accumulates counter updates made by a
+ * single thread to a single file record when the POSIX thread cache is
+ * enabled. Positional read/write operations that hit in the calling thread's
+ * fd cache update these deltas without acquiring the POSIX module lock; the
+ * deltas are folded back into the shared file record (under the lock) when
+ * the file is closed or when the module is shut down. Each delta has its own
+ * spin lock, held by the owning thread while updating it and by whichever
+ * thread merges it.
+ *
+ * NOTE: sequential/consecutive access and read/write switch counters are
+ * tracked relative to the calling thread's own access stream while cached.
+ * Read and write times are kept as lists of busy intervals rather than sums;
+ * the intervals of all threads accessing a file are merged together, so that
+ * time during which several threads were accessing the file at once is only
+ * counted once.
+ */
+struct posix_thread_delta
+{
+    darshan_record_id rec_id;
+    struct posix_file_record_ref *rec_ref;
+    atomic_flag lock;
+    int64_t file_alignment;
+    int64_t last_byte_read;
+    int64_t last_byte_written;
+    enum darshan_io_type last_io_type;
+    struct posix_thread_interval read_busy[POSIX_THREAD_MAX_INTERVALS];
+    struct posix_thread_interval write_busy[POSIX_THREAD_MAX_INTERVALS];
+    int read_busy_count;
+    int write_busy_count;
+    int64_t counters[POSIX_NUM_INDICES];
+    double fcounters[POSIX_F_NUM_INDICES];
+    struct darshan_common_val_table access_table;
+    struct darshan_common_val_table stride_table;
+    int dirty;
+    UT_hash_handle hlink;
+};
+
+struct posix_thread_fd_slot
+{
+    int fd;
+    unsigned long epoch;
+    struct posix_thread_delta *delta;
+};
+
+/* per-thread state for the POSIX thread cache. These structures are linked
+ * into a global list (protected by the POSIX module lock) so that their
+ * deltas can be flushed at shutdown. They are never freed, since a thread
+ * may still reference its state via TLS after the module is cleaned up.
+ */
+struct posix_thread_state
+{
+    pid_t pid; /* process that created this state */
+    struct posix_thread_fd_slot fd_cache[POSIX_THREAD_FD_CACHE_SIZE];
+    struct posix_thread_delta *delta_hash;
+    struct posix_thread_state *next;
+};
+#endif
+
 static void posix_runtime_initialize(
     void);
 static struct posix_file_record_ref *posix_track_new_file_record(
@@ -183,22 +254,40 @@ static void posix_aio_tracker_add(
     int fd, void *aiocbp);
 static struct posix_aio_tracker* posix_aio_tracker_del(
     int fd, void *aiocbp);
-static void posix_finalize_file_records(
-    void *rec_ref_p, void *user_ptr);
 #ifdef HAVE_MPI
 static void posix_record_reduction_op(
     void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
 static void posix_shared_record_variance(
     MPI_Comm mod_comm, struct darshan_posix_file *inrec_array,
     struct darshan_posix_file *outrec_array, int shared_rec_count);
+static void posix_shared_record_init(
+    struct darshan_posix_file *rec);
 static void posix_mpi_redux(
     void *posix_buf, MPI_Comm mod_comm,
     darshan_record_id *shared_recs, int shared_rec_count);
+static void posix_mpi_partial_redux(
+    void *posix_buf, MPI_Comm mod_comm,
+    struct darshan_partial_shared_rec *partial_recs, int partial_rec_count);
 #endif
 static void posix_output(
     void **posix_buf, int *posix_buf_sz);
 static void posix_cleanup(
     void);
+#ifdef HAVE_STDATOMIC_H
+static int posix_thread_cache_record_io(
+    int fd, enum darshan_io_type io_type, int64_t ret, int64_t offset,
+    int aligned, double tm1, double tm2);
+static void posix_thread_cache_fill(
+    int fd, struct posix_file_record_ref *rec_ref);
+static void posix_thread_cache_invalidate(
+    void);
+static void posix_thread_cache_merge_record(
+    struct posix_file_record_ref *rec_ref);
+static void posix_thread_cache_flush(
+    void);
+static void posix_thread_cache_cleanup(
+    void);
+#endif
 
 /* extern function def for querying record name from a STDIO stream */
 extern char *darshan_stdio_lookup_record_name(FILE *stream);
@@ -209,6 +298,13 @@ static int posix_runtime_init_attempted = 0;
 static int my_rank = -1;
 static int darshan_mem_alignment = 1;
 
+#ifdef HAVE_STDATOMIC_H
+static struct posix_thread_state *posix_thread_states = NULL;
+static atomic_int posix_thread_cache_active = 0;
+static atomic_ulong posix_fd_epoch = 1;
+static __thread struct posix_thread_state *posix_tls_state = NULL;
+#endif
+
 #define POSIX_LOCK() pthread_mutex_lock(&posix_runtime_mutex)
 #define POSIX_UNLOCK() pthread_mutex_unlock(&posix_runtime_mutex)
 
@@ -235,6 +331,24 @@ static int darshan_mem_alignment = 1;
     POSIX_UNLOCK(); \
 } while(0)
 
+#ifdef HAVE_STDATOMIC_H
+/* positional reads/writes are first offered to the calling thread's record
+ * cache, which avoids the POSIX module lock entirely on a cache hit; on a
+ * miss the wrapper falls through to the locked path, which refills the cache
+ */
+#define POSIX_RECORD_PIO_FAST(__ret, __fd, __io_type, __offset, __aligned, __tm1, __tm2) do { \
+    if(!__darshan_disabled && __ret >= 0 && \
+        posix_thread_cache_record_io(__fd, __io_type, __ret, __offset, __aligned, __tm1, __tm2)) \
+        return(__ret); \
+} while(0)
+#define POSIX_THREAD_CACHE_FILL(__fd, __rec_ref) posix_thread_cache_fill(__fd, __rec_ref)
+#define POSIX_THREAD_CACHE_INVALIDATE() posix_thread_cache_invalidate()
+#else
+#define POSIX_RECORD_PIO_FAST(__ret, __fd, __io_type, __offset, __aligned, __tm1, __tm2)
+#define POSIX_THREAD_CACHE_FILL(__fd, __rec_ref)
+#define POSIX_THREAD_CACHE_INVALIDATE()
+#endif
+
 #define POSIX_RECORD_OPEN(__ret, __path, __mode, __tm1, __tm2) do { \
     darshan_record_id __rec_id; \
     struct posix_file_record_ref *__rec_ref; \
@@ -277,7 +391,8 @@ static int darshan_mem_alignment = 1;
     __rec_ref->file_rec->fcounters[POSIX_F_OPEN_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(__rec_ref->file_rec->fcounters[POSIX_F_META_TIME], \
         __tm1, __tm2, __rec_ref->last_meta_end); \
-    darshan_add_record_ref(&(posix_runtime->fd_hash), &__ret, sizeof(int), __rec_ref); \
+    darshan_add_record_ref(&(posix_runtime->fd_hash), &__ret, sizeof(int), __rec_ref, DARSHAN_POSIX_MOD); \
+    POSIX_THREAD_CACHE_INVALIDATE(); \
 } while(0)
 
 #define POSIX_RECORD_READ(__ret, __fd, __pread_flag, __pread_offset, __aligned, __tm1, __tm2) do { \
@@ -297,7 +412,8 @@ static int darshan_mem_alignment = 1;
     /* DXT to record detailed read tracing information */ \
     dxt_posix_read(rec_ref->file_rec->base_rec.id, this_offset, __ret, __tm1, __tm2); \
     /* heatmap to record traffic summary */ \
-    heatmap_update(posix_runtime->heatmap_id, HEATMAP_READ, __ret, __tm1, __tm2); \
+    heatmap_update(posix_runtime->heatmap, HEATMAP_READ, __ret, __tm1, __tm2); \
+    HEATMAP_UPDATE_FILE(posix_runtime->heatmap, rec_ref, HEATMAP_READ, __ret, __tm1, __tm2); \
     if(this_offset > rec_ref->last_byte_read) \
         rec_ref->file_rec->counters[POSIX_SEQ_READS] += 1;  \
     if(this_offset == (rec_ref->last_byte_read + 1)) \
@@ -314,14 +430,12 @@ static int darshan_mem_alignment = 1;
     rec_ref->file_rec->counters[POSIX_BYTES_READ] += __ret; \
     rec_ref->file_rec->counters[POSIX_READS] += 1; \
     DARSHAN_BUCKET_INC(&(rec_ref->file_rec->counters[POSIX_SIZE_READ_0_100]), __ret); \
-    cvc = darshan_track_common_val_counters(&rec_ref->access_root, &__ret, 1, \
-        &rec_ref->access_count); \
+    cvc = darshan_track_common_val_counters(&rec_ref->access_table, &__ret, 1); \
     if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[POSIX_ACCESS1_ACCESS]), \
         &(rec_ref->file_rec->counters[POSIX_ACCESS1_COUNT]), \
         cvc->vals, 1, cvc->freq, 0); \
-    cvc = darshan_track_common_val_counters(&rec_ref->stride_root, &stride, 1, \
-        &rec_ref->stride_count); \
+    cvc = darshan_track_common_val_counters(&rec_ref->stride_table, &stride, 1); \
     if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[POSIX_STRIDE1_STRIDE]), \
         &(rec_ref->file_rec->counters[POSIX_STRIDE1_COUNT]), \
@@ -347,6 +461,8 @@ static int darshan_mem_alignment = 1;
     if(dC.ldms_lib)\
         if(dC.posix_enable_ldms)\
             darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[POSIX_READS], "read", this_offset, __ret, rec_ref->file_rec->counters[POSIX_MAX_BYTE_READ],rec_ref->file_rec->counters[POSIX_RW_SWITCHES], -1,  __tm1, __tm2, rec_ref->file_rec->fcounters[POSIX_F_READ_TIME], "POSIX", "MOD");\
+    if(__pread_flag) \
+        POSIX_THREAD_CACHE_FILL(__fd, rec_ref); \
 } while(0)
 
 #define POSIX_RECORD_WRITE(__ret, __fd, __pwrite_flag, __pwrite_offset, __aligned, __tm1, __tm2) do { \
@@ -366,7 +482,8 @@ static int darshan_mem_alignment = 1;
     /* DXT to record detailed write tracing information */ \
     dxt_posix_write(rec_ref->file_rec->base_rec.id, this_offset, __ret, __tm1, __tm2); \
     /* heatmap to record traffic summary */ \
-    heatmap_update(posix_runtime->heatmap_id, HEATMAP_WRITE, __ret, __tm1, __tm2); \
+    heatmap_update(posix_runtime->heatmap, HEATMAP_WRITE, __ret, __tm1, __tm2); \
+    HEATMAP_UPDATE_FILE(posix_runtime->heatmap, rec_ref, HEATMAP_WRITE, __ret, __tm1, __tm2); \
     if(this_offset > rec_ref->last_byte_written) \
         rec_ref->file_rec->counters[POSIX_SEQ_WRITES] += 1; \
     if(this_offset == (rec_ref->last_byte_written + 1)) \
@@ -383,14 +500,12 @@ static int darshan_mem_alignment = 1;
     rec_ref->file_rec->counters[POSIX_BYTES_WRITTEN] += __ret; \
     rec_ref->file_rec->counters[POSIX_WRITES] += 1; \
     DARSHAN_BUCKET_INC(&(rec_ref->file_rec->counters[POSIX_SIZE_WRITE_0_100]), __ret); \
-    cvc = darshan_track_common_val_counters(&rec_ref->access_root, &__ret, 1, \
-        &rec_ref->access_count); \
+    cvc = darshan_track_common_val_counters(&rec_ref->access_table, &__ret, 1); \
     if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[POSIX_ACCESS1_ACCESS]), \
         &(rec_ref->file_rec->counters[POSIX_ACCESS1_COUNT]), \
         cvc->vals, 1, cvc->freq, 0); \
-    cvc = darshan_track_common_val_counters(&rec_ref->stride_root, &stride, 1, \
-        &rec_ref->stride_count); \
+    cvc = darshan_track_common_val_counters(&rec_ref->stride_table, &stride, 1); \
     if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[POSIX_STRIDE1_STRIDE]), \
         &(rec_ref->file_rec->counters[POSIX_STRIDE1_COUNT]), \
@@ -416,6 +531,8 @@ static int darshan_mem_alignment = 1;
     if(dC.ldms_lib)\
         if(dC.posix_enable_ldms)\
             darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[POSIX_WRITES], "write", this_offset, __ret, rec_ref->file_rec->counters[POSIX_MAX_BYTE_WRITTEN], rec_ref->file_rec->counters[POSIX_RW_SWITCHES], -1, __tm1, __tm2, rec_ref->file_rec->fcounters[POSIX_F_WRITE_TIME], "POSIX", "MOD");\
+    if(__pwrite_flag) \
+        POSIX_THREAD_CACHE_FILL(__fd, rec_ref); \
 } while(0)
 
 #define POSIX_LOOKUP_RECORD_STAT(__path, __statbuf, __tm1, __tm2) do { \
@@ -1032,6 +1149,7 @@ ssize_t DARSHAN_DECL(pread)(int fd, void *buf, size_t count, off_t offset)
     ret = __real_pread(fd, buf, count, offset);
     tm2 = POSIX_WTIME();
 
+    POSIX_RECORD_PIO_FAST(ret, fd, DARSHAN_IO_READ, offset, aligned_flag, tm1, tm2);
     POSIX_PRE_RECORD();
     POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2);
     POSIX_POST_RECORD();
@@ -1054,6 +1172,7 @@ ssize_t DARSHAN_DECL(pwrite)(int fd, const void *buf, size_t count, off_t offset
     ret = __real_pwrite(fd, buf, count, offset);
     tm2 = POSIX_WTIME();
 
+    POSIX_RECORD_PIO_FAST(ret, fd, DARSHAN_IO_WRITE, offset, aligned_flag, tm1, tm2);
     POSIX_PRE_RECORD();
     POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2);
     POSIX_POST_RECORD();
@@ -1076,6 +1195,7 @@ ssize_t DARSHAN_DECL(pread64)(int fd, void *buf, size_t count, off64_t offset)
     ret = __real_pread64(fd, buf, count, offset);
     tm2 = POSIX_WTIME();
 
+    POSIX_RECORD_PIO_FAST(ret, fd, DARSHAN_IO_READ, offset, aligned_flag, tm1, tm2);
     POSIX_PRE_RECORD();
     POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2);
     POSIX_POST_RECORD();
@@ -1098,6 +1218,7 @@ ssize_t DARSHAN_DECL(pwrite64)(int fd, const void *buf, size_t count, off64_t of
     ret = __real_pwrite64(fd, buf, count, offset);
     tm2 = POSIX_WTIME();
 
+    POSIX_RECORD_PIO_FAST(ret, fd, DARSHAN_IO_WRITE, offset, aligned_flag, tm1, tm2);
     POSIX_PRE_RECORD();
     POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2);
     POSIX_POST_RECORD();
@@ -1153,6 +1274,7 @@ ssize_t DARSHAN_DECL(preadv)(int fd, const struct iovec *iov, int iovcnt, off_t
     ret = __real_preadv(fd, iov, iovcnt, offset);
     tm2 = POSIX_WTIME();
 
+    POSIX_RECORD_PIO_FAST(ret, fd, DARSHAN_IO_READ, offset, aligned_flag, tm1, tm2);
     POSIX_PRE_RECORD();
     POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2);
     POSIX_POST_RECORD();
@@ -1180,6 +1302,7 @@ ssize_t DARSHAN_DECL(preadv64)(int fd, const struct iovec *iov, int iovcnt, off6
     ret = __real_preadv64(fd, iov, iovcnt, offset);
     tm2 = POSIX_WTIME();
 
+    POSIX_RECORD_PIO_FAST(ret, fd, DARSHAN_IO_READ, offset, aligned_flag, tm1, tm2);
     POSIX_PRE_RECORD();
     POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2);
     POSIX_POST_RECORD();
@@ -1210,6 +1333,7 @@ ssize_t DARSHAN_DECL(preadv2)(int fd, const struct iovec *iov, int iovcnt, off_t
     ret = __real_preadv2(fd, iov, iovcnt, offset, flags);
     tm2 = POSIX_WTIME();
 
+    POSIX_RECORD_PIO_FAST(ret, fd, DARSHAN_IO_READ, offset, aligned_flag, tm1, tm2);
     POSIX_PRE_RECORD();
     POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2);
     POSIX_POST_RECORD();
@@ -1237,6 +1361,7 @@ ssize_t DARSHAN_DECL(preadv64v2)(int fd, const struct iovec *iov, int iovcnt, of
     ret = __real_preadv64v2(fd, iov, iovcnt, offset, flags);
     tm2 = POSIX_WTIME();
 
+    POSIX_RECORD_PIO_FAST(ret, fd, DARSHAN_IO_READ, offset, aligned_flag, tm1, tm2);
     POSIX_PRE_RECORD();
     POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2);
     POSIX_POST_RECORD();
@@ -1293,6 +1418,7 @@ ssize_t DARSHAN_DECL(pwritev)(int fd, const struct iovec *iov, int iovcnt, off_t
     ret = __real_pwritev(fd, iov, iovcnt, offset);
     tm2 = POSIX_WTIME();
 
+    POSIX_RECORD_PIO_FAST(ret, fd, DARSHAN_IO_WRITE, offset, aligned_flag, tm1, tm2);
     POSIX_PRE_RECORD();
     POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2);
     POSIX_POST_RECORD();
@@ -1320,6 +1446,7 @@ ssize_t DARSHAN_DECL(pwritev64)(int fd, const struct iovec *iov, int iovcnt, off
     ret = __real_pwritev64(fd, iov, iovcnt, offset);
     tm2 = POSIX_WTIME();
 
+    POSIX_RECORD_PIO_FAST(ret, fd, DARSHAN_IO_WRITE, offset, aligned_flag, tm1, tm2);
     POSIX_PRE_RECORD();
     POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2);
     POSIX_POST_RECORD();
@@ -1349,6 +1476,7 @@ ssize_t DARSHAN_DECL(pwritev2)(int fd, const struct iovec *iov, int iovcnt, off_
     ret = __real_pwritev2(fd, iov, iovcnt, offset, flags);
     tm2 = POSIX_WTIME();
 
+    POSIX_RECORD_PIO_FAST(ret, fd, DARSHAN_IO_WRITE, offset, aligned_flag, tm1, tm2);
     POSIX_PRE_RECORD();
     POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2);
     POSIX_POST_RECORD();
@@ -1376,6 +1504,7 @@ ssize_t DARSHAN_DECL(pwritev64v2)(int fd, const struct iovec *iov, int iovcnt, o
     ret = __real_pwritev64v2(fd, iov, iovcnt, offset, flags);
     tm2 = POSIX_WTIME();
 
+    POSIX_RECORD_PIO_FAST(ret, fd, DARSHAN_IO_WRITE, offset, aligned_flag, tm1, tm2);
     POSIX_PRE_RECORD();
     POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2);
     POSIX_POST_RECORD();
@@ -1752,14 +1881,16 @@ int DARSHAN_DECL(close)(int fd)
             rec_ref->file_rec->fcounters[POSIX_F_META_TIME],
             tm1, tm2, rec_ref->last_meta_end);
         darshan_delete_record_ref(&(posix_runtime->fd_hash), &fd, sizeof(int));
+        POSIX_THREAD_CACHE_INVALIDATE();
+#ifdef HAVE_STDATOMIC_H
+        posix_thread_cache_merge_record(rec_ref);
+#endif
 
-#ifdef HAVE_LDMS
         rec_ref->close_counts++;
         /* publish close information for posix */
         if(dC.ldms_lib)
             if(dC.posix_enable_ldms)
                 darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->close_counts, "close", -1, -1, -1, -1, -1, tm1, tm2, rec_ref->file_rec->fcounters[POSIX_F_META_TIME], "POSIX", "MOD");
-#endif
     }
     POSIX_POST_RECORD();
 
@@ -2031,9 +2162,13 @@ static void posix_runtime_initialize()
 {
     int ret;
     size_t psx_rec_count;
+#ifdef HAVE_STDATOMIC_H
+    const struct darshan_config *cfg;
+#endif
     darshan_module_funcs mod_funcs = {
 #ifdef HAVE_MPI
         .mod_redux_func = &posix_mpi_redux,
+        .mod_partial_redux_func = &posix_mpi_partial_redux,
 #endif
         .mod_output_func = &posix_output,
         .mod_cleanup_func = &posix_cleanup
@@ -2068,7 +2203,19 @@ static void posix_runtime_initialize()
     dxt_posix_runtime_initialize();
 
     /* register a heatmap */
-    posix_runtime->heatmap_id = heatmap_register("heatmap:POSIX");
+    posix_runtime->heatmap = heatmap_register("heatmap:POSIX");
+
+#ifdef HAVE_STDATOMIC_H
+    /* enable per-thread record caching, if requested; the thread cache is
+     * bypassed if LDMS needs to publish each POSIX operation, and if periodic
+     * snapshot logs need every update to reach the shared records as it
+     * happens
+     */
+    cfg = darshan_core_get_config();
+    if(cfg && cfg->posix_thread_cache_flag && cfg->snapshot_interval == 0 &&
+        !(dC.ldms_lib && dC.posix_enable_ldms))
+        atomic_store(&posix_thread_cache_active, 1);
+#endif
 
     return;
 }
@@ -2081,17 +2228,16 @@ static struct posix_file_record_ref *posix_track_new_file_record(
     struct darshan_fs_info fs_info;
     int ret;
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_core_arena_alloc(DARSHAN_POSIX_MOD, sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this file record based on record id */
     ret = darshan_add_record_ref(&(posix_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+        sizeof(darshan_record_id), rec_ref, DARSHAN_POSIX_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -2109,7 +2255,7 @@ static struct posix_file_record_ref *posix_track_new_file_record(
     {
         darshan_delete_record_ref(&(posix_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -2177,16 +2323,538 @@ static void posix_aio_tracker_add(int fd, void *aiocbp)
     return;
 }
 
-static void posix_finalize_file_records(void *rec_ref_p, void *user_ptr)
+#ifdef HAVE_STDATOMIC_H
+static void posix_thread_delta_lock(
+    struct posix_thread_delta *delta)
+{
+    while(atomic_flag_test_and_set_explicit(&delta->lock, memory_order_acquire))
+        ;
+    return;
+}
+
+static void posix_thread_delta_unlock(
+    struct posix_thread_delta *delta)
+{
+    atomic_flag_clear_explicit(&delta->lock, memory_order_release);
+    return;
+}
+
+/* append a busy interval to a thread's list, extending the last interval
+ * instead if the two overlap. The caller must make sure there is room.
+ */
+static void posix_thread_interval_add(
+    struct posix_thread_interval *busy, int *count, double tm1, double tm2)
+{
+    if(tm1 == 0.0 || tm2 == 0.0)
+        return;
+
+    if(*count > 0 && tm1 <= busy[*count - 1].end)
+    {
+        if(tm2 > busy[*count - 1].end)
+            busy[*count - 1].end = tm2;
+        return;
+    }
+    busy[*count].start = tm1;
+    busy[*count].end = tm2;
+    (*count)++;
+
+    return;
+}
+
+static int posix_thread_interval_cmp(const void *a, const void *b)
+{
+    const struct posix_thread_interval *ia = a;
+    const struct posix_thread_interval *ib = b;
+
+    if(ia->start < ib->start)
+        return(-1);
+    if(ia->start > ib->start)
+        return(1);
+    return(0);
+}
+
+/* add the union of a set of busy intervals (possibly gathered from several
+ * threads) to a file record's read or write time, skipping any time already
+ * accounted for up to the record's last end time (in the same way as the
+ * locked path), then reset the list.
+ *
+ * NOTE: operations recorded on the locked path advance the record's last end
+ * time immediately, so cached intervals that end before a later locked
+ * operation are not counted.
+ */
+static void posix_thread_interval_merge(
+    struct posix_thread_interval *busy, int *count, double *timer,
+    double *last_end)
+{
+    double start, end;
+    int i, j;
+
+    qsort(busy, *count, sizeof(*busy), posix_thread_interval_cmp);
+    for(i = 0; i < *count; i = j)
+    {
+        start = busy[i].start;
+        end = busy[i].end;
+        for(j = i + 1; j < *count && busy[j].start <= end; j++)
+        {
+            if(busy[j].end > end)
+                end = busy[j].end;
+        }
+        if(end <= *last_end)
+            continue;
+        DARSHAN_TIMER_INC_NO_OVERLAP(*timer, start, end, *last_end);
+    }
+    *count = 0;
+
+    return;
+}
+
+/* apply a single read or write operation to a thread's record delta,
+ * mirroring the counter updates made by POSIX_RECORD_READ/WRITE
+ */
+static void posix_thread_delta_update(
+    struct posix_thread_delta *delta, enum darshan_io_type io_type,
+    int64_t ret, int64_t offset, int aligned, double tm1, double tm2)
+{
+    int64_t *counters = delta->counters;
+    double *fcounters = delta->fcounters;
+    int64_t *last_byte;
+    int64_t stride;
+    double elapsed = tm2 - tm1;
+    int is_read = (io_type == DARSHAN_IO_READ);
+
+    last_byte = is_read ? &delta->last_byte_read : &delta->last_byte_written;
+    if(offset > *last_byte)
+        counters[is_read ? POSIX_SEQ_READS : POSIX_SEQ_WRITES] += 1;
+    if(offset == (*last_byte + 1))
+        counters[is_read ? POSIX_CONSEC_READS : POSIX_CONSEC_WRITES] += 1;
+    if(offset > 0 && offset > *last_byte && *last_byte != 0)
+        stride = offset - *last_byte - 1;
+    else
+        stride = 0;
+    *last_byte = offset + ret - 1;
+    if(is_read)
+    {
+        if(counters[POSIX_MAX_BYTE_READ] < (offset + ret - 1))
+            counters[POSIX_MAX_BYTE_READ] = offset + ret - 1;
+        counters[POSIX_BYTES_READ] += ret;
+        counters[POSIX_READS] += 1;
+        DARSHAN_BUCKET_INC(&(counters[POSIX_SIZE_READ_0_100]), ret);
+    }
+    else
+    {
+        if(counters[POSIX_MAX_BYTE_WRITTEN] < (offset + ret - 1))
+            counters[POSIX_MAX_BYTE_WRITTEN] = offset + ret - 1;
+        counters[POSIX_BYTES_WRITTEN] += ret;
+        counters[POSIX_WRITES] += 1;
+        DARSHAN_BUCKET_INC(&(counters[POSIX_SIZE_WRITE_0_100]), ret);
+    }
+    darshan_track_common_val_counters(&delta->access_table, &ret, 1);
+    darshan_track_common_val_counters(&delta->stride_table, &stride, 1);
+    if(!aligned)
+        counters[POSIX_MEM_NOT_ALIGNED] += 1;
+    if(delta->file_alignment > 0 && (offset % delta->file_alignment) != 0)
+        counters[POSIX_FILE_NOT_ALIGNED] += 1;
+    if(delta->last_io_type == (is_read ? DARSHAN_IO_WRITE : DARSHAN_IO_READ))
+        counters[POSIX_RW_SWITCHES] += 1;
+    delta->last_io_type = io_type;
+    if(is_read)
+    {
+        if(fcounters[POSIX_F_READ_START_TIMESTAMP] == 0 ||
+         fcounters[POSIX_F_READ_START_TIMESTAMP] > tm1)
+            fcounters[POSIX_F_READ_START_TIMESTAMP] = tm1;
+        fcounters[POSIX_F_READ_END_TIMESTAMP] = tm2;
+        if(fcounters[POSIX_F_MAX_READ_TIME] < elapsed)
+        {
+            fcounters[POSIX_F_MAX_READ_TIME] = elapsed;
+            counters[POSIX_MAX_READ_TIME_SIZE] = ret;
+        }
+        posix_thread_interval_add(delta->read_busy, &delta->read_busy_count,
+            tm1, tm2);
+    }
+    else
+    {
+        if(fcounters[POSIX_F_WRITE_START_TIMESTAMP] == 0 ||
+         fcounters[POSIX_F_WRITE_START_TIMESTAMP] > tm1)
+            fcounters[POSIX_F_WRITE_START_TIMESTAMP] = tm1;
+        fcounters[POSIX_F_WRITE_END_TIMESTAMP] = tm2;
+        if(fcounters[POSIX_F_MAX_WRITE_TIME] < elapsed)
+        {
+            fcounters[POSIX_F_MAX_WRITE_TIME] = elapsed;
+            counters[POSIX_MAX_WRITE_TIME_SIZE] = ret;
+        }
+        posix_thread_interval_add(delta->write_busy, &delta->write_busy_count,
+            tm1, tm2);
+    }
+    delta->dirty = 1;
+
+    return;
+}
+
+/* fold a thread's accumulated deltas into the shared file record, then reset
+ * them. Busy intervals still in the delta are merged on their own; callers
+ * should move them to a list shared with other threads' deltas for the same
+ * record first (see posix_thread_cache_merge_record()). The POSIX module lock
+ * and the delta's lock must be held.
+ */
+static void posix_thread_delta_merge(
+    struct posix_thread_delta *delta)
+{
+    struct posix_file_record_ref *rec_ref = delta->rec_ref;
+    struct darshan_posix_file *file_rec = rec_ref->file_rec;
+    struct darshan_common_val_counter *cvc, *tcvc;
+    int64_t *counters = delta->counters;
+    double *fcounters = delta->fcounters;
+    int i;
+
+    if(!delta->dirty)
+        return;
+
+    file_rec->counters[POSIX_READS] += counters[POSIX_READS];
+    file_rec->counters[POSIX_WRITES] += counters[POSIX_WRITES];
+    file_rec->counters[POSIX_BYTES_READ] += counters[POSIX_BYTES_READ];
+    file_rec->counters[POSIX_BYTES_WRITTEN] += counters[POSIX_BYTES_WRITTEN];
+    file_rec->counters[POSIX_CONSEC_READS] += counters[POSIX_CONSEC_READS];
+    file_rec->counters[POSIX_CONSEC_WRITES] += counters[POSIX_CONSEC_WRITES];
+    file_rec->counters[POSIX_SEQ_READS] += counters[POSIX_SEQ_READS];
+    file_rec->counters[POSIX_SEQ_WRITES] += counters[POSIX_SEQ_WRITES];
+    file_rec->counters[POSIX_RW_SWITCHES] += counters[POSIX_RW_SWITCHES];
+    file_rec->counters[POSIX_MEM_NOT_ALIGNED] += counters[POSIX_MEM_NOT_ALIGNED];
+    file_rec->counters[POSIX_FILE_NOT_ALIGNED] += counters[POSIX_FILE_NOT_ALIGNED];
+    for(i = POSIX_SIZE_READ_0_100; i <= POSIX_SIZE_WRITE_1G_PLUS; i++)
+        file_rec->counters[i] += counters[i];
+    if(file_rec->counters[POSIX_MAX_BYTE_READ] < counters[POSIX_MAX_BYTE_READ])
+        file_rec->counters[POSIX_MAX_BYTE_READ] = counters[POSIX_MAX_BYTE_READ];
+    if(file_rec->counters[POSIX_MAX_BYTE_WRITTEN] < counters[POSIX_MAX_BYTE_WRITTEN])
+        file_rec->counters[POSIX_MAX_BYTE_WRITTEN] = counters[POSIX_MAX_BYTE_WRITTEN];
+
+    if(fcounters[POSIX_F_READ_START_TIMESTAMP] > 0 &&
+        (file_rec->fcounters[POSIX_F_READ_START_TIMESTAMP] == 0 ||
+         file_rec->fcounters[POSIX_F_READ_START_TIMESTAMP] >
+         fcounters[POSIX_F_READ_START_TIMESTAMP]))
+        file_rec->fcounters[POSIX_F_READ_START_TIMESTAMP] =
+            fcounters[POSIX_F_READ_START_TIMESTAMP];
+    if(fcounters[POSIX_F_WRITE_START_TIMESTAMP] > 0 &&
+        (file_rec->fcounters[POSIX_F_WRITE_START_TIMESTAMP] == 0 ||
+         file_rec->fcounters[POSIX_F_WRITE_START_TIMESTAMP] >
+         fcounters[POSIX_F_WRITE_START_TIMESTAMP]))
+        file_rec->fcounters[POSIX_F_WRITE_START_TIMESTAMP] =
+            fcounters[POSIX_F_WRITE_START_TIMESTAMP];
+    if(file_rec->fcounters[POSIX_F_READ_END_TIMESTAMP] <
+        fcounters[POSIX_F_READ_END_TIMESTAMP])
+        file_rec->fcounters[POSIX_F_READ_END_TIMESTAMP] =
+            fcounters[POSIX_F_READ_END_TIMESTAMP];
+    if(file_rec->fcounters[POSIX_F_WRITE_END_TIMESTAMP] <
+        fcounters[POSIX_F_WRITE_END_TIMESTAMP])
+        file_rec->fcounters[POSIX_F_WRITE_END_TIMESTAMP] =
+            fcounters[POSIX_F_WRITE_END_TIMESTAMP];
+    if(file_rec->fcounters[POSIX_F_MAX_READ_TIME] < fcounters[POSIX_F_MAX_READ_TIME])
+    {
+        file_rec->fcounters[POSIX_F_MAX_READ_TIME] = fcounters[POSIX_F_MAX_READ_TIME];
+        file_rec->counters[POSIX_MAX_READ_TIME_SIZE] = counters[POSIX_MAX_READ_TIME_SIZE];
+    }
+    if(file_rec->fcounters[POSIX_F_MAX_WRITE_TIME] < fcounters[POSIX_F_MAX_WRITE_TIME])
+    {
+        file_rec->fcounters[POSIX_F_MAX_WRITE_TIME] = fcounters[POSIX_F_MAX_WRITE_TIME];
+        file_rec->counters[POSIX_MAX_WRITE_TIME_SIZE] = counters[POSIX_MAX_WRITE_TIME_SIZE];
+    }
+    posix_thread_interval_merge(delta->read_busy, &delta->read_busy_count,
+        &file_rec->fcounters[POSIX_F_READ_TIME], &rec_ref->last_read_end);
+    posix_thread_interval_merge(delta->write_busy, &delta->write_busy_count,
+        &file_rec->fcounters[POSIX_F_WRITE_TIME], &rec_ref->last_write_end);
+
+    /* fold this thread's common values into the record's common value tables */
+    for(i = 0; i < delta->access_table.count; i++)
+    {
+        tcvc = &delta->access_table.counters[i];
+        cvc = darshan_track_common_val_counters(&rec_ref->access_table,
+            tcvc->vals, 1);
+        if(!cvc) continue;
+        cvc->freq += tcvc->freq - 1;
+        DARSHAN_UPDATE_COMMON_VAL_COUNTERS(
+            &(file_rec->counters[POSIX_ACCESS1_ACCESS]),
+            &(file_rec->counters[POSIX_ACCESS1_COUNT]),
+            cvc->vals, 1, cvc->freq, 0);
+    }
+    for(i = 0; i < delta->stride_table.count; i++)
+    {
+        tcvc = &delta->stride_table.counters[i];
+        cvc = darshan_track_common_val_counters(&rec_ref->stride_table,
+            tcvc->vals, 1);
+        if(!cvc) continue;
+        cvc->freq += tcvc->freq - 1;
+        DARSHAN_UPDATE_COMMON_VAL_COUNTERS(
+            &(file_rec->counters[POSIX_STRIDE1_STRIDE]),
+            &(file_rec->counters[POSIX_STRIDE1_COUNT]),
+            cvc->vals, 1, cvc->freq, 0);
+    }
+
+    memset(delta->counters, 0, sizeof(delta->counters));
+    memset(delta->fcounters, 0, sizeof(delta->fcounters));
+    memset(&delta->access_table, 0, sizeof(delta->access_table));
+    memset(&delta->stride_table, 0, sizeof(delta->stride_table));
+    delta->dirty = 0;
+
+    return;
+}
+
+/* try to record a positional read/write using the calling thread's record
+ * cache, without acquiring the POSIX module lock. Returns 1 if the operation
+ * was recorded, 0 if the caller must fall back to the locked path.
+ */
+static int posix_thread_cache_record_io(
+    int fd, enum darshan_io_type io_type, int64_t ret, int64_t offset,
+    int aligned, double tm1, double tm2)
+{
+    struct posix_thread_state *ts = posix_tls_state;
+    struct posix_thread_fd_slot *slot;
+    struct posix_thread_delta *delta;
+    struct heatmap_record_ref *heatmap, *file_heatmap;
+    unsigned long epoch;
+
+    if(!ts || fd < 0 ||
+        !atomic_load_explicit(&posix_thread_cache_active, memory_order_relaxed))
+        return(0);
+
+    slot = &ts->fd_cache[fd & (POSIX_THREAD_FD_CACHE_SIZE - 1)];
+    epoch = atomic_load_explicit(&posix_fd_epoch, memory_order_acquire);
+    if(slot->fd != fd || slot->epoch != epoch)
+        return(0);
+
+    /* lock our delta, then make sure the cache was not shut down (or the fd
+     * table modified) in the meantime; this pairs with the exchange on
+     * posix_thread_cache_active in posix_thread_cache_flush()
+     */
+    delta = slot->delta;
+    posix_thread_delta_lock(delta);
+    if(!atomic_load(&posix_thread_cache_active) ||
+        slot->epoch != atomic_load(&posix_fd_epoch))
+    {
+        posix_thread_delta_unlock(delta);
+        return(0);
+    }
+    if((io_type == DARSHAN_IO_READ ? delta->read_busy_count :
+        delta->write_busy_count) == POSIX_THREAD_MAX_INTERVALS)
+    {
+        /* no room for another busy interval; merge all threads' deltas for
+         * this record under the lock and let the locked path record this
+         * operation
+         */
+        posix_thread_delta_unlock(delta);
+        POSIX_LOCK();
+        if(atomic_load(&posix_thread_cache_active))
+            posix_thread_cache_merge_record(delta->rec_ref);
+        POSIX_UNLOCK();
+        return(0);
+    }
+    heatmap = posix_runtime->heatmap;
+    file_heatmap = delta->rec_ref->heatmap;
+    posix_thread_delta_update(delta, io_type, ret, offset, aligned, tm1, tm2);
+    posix_thread_delta_unlock(delta);
+
+    /* DXT and heatmap maintain their own locking */
+    if(io_type == DARSHAN_IO_READ)
+    {
+        dxt_posix_read(delta->rec_id, offset, ret, tm1, tm2);
+        heatmap_update(heatmap, HEATMAP_READ, ret, tm1, tm2);
+        heatmap_update(file_heatmap, HEATMAP_READ, ret, tm1, tm2);
+    }
+    else
+    {
+        dxt_posix_write(delta->rec_id, offset, ret, tm1, tm2);
+        heatmap_update(heatmap, HEATMAP_WRITE, ret, tm1, tm2);
+        heatmap_update(file_heatmap, HEATMAP_WRITE, ret, tm1, tm2);
+    }
+
+    return(1);
+}
+
+/* cache the mapping from the given fd to the calling thread's delta for
+ * the given record, creating the thread state and delta if necessary.
+ * The POSIX module lock must be held.
+ */
+static void posix_thread_cache_fill(
+    int fd, struct posix_file_record_ref *rec_ref)
+{
+    struct posix_thread_state *ts = posix_tls_state;
+    struct posix_thread_fd_slot *slot;
+    struct posix_thread_delta *delta;
+    darshan_record_id rec_id = rec_ref->file_rec->base_rec.id;
+
+    if(fd < 0 || !atomic_load(&posix_thread_cache_active))
+        return;
+
+    /* a state inherited across a fork is not reused, so that only states
+     * created by this process are ever locked by it
+     */
+    if(!ts || ts->pid != getpid())
+    {
+        ts = calloc(1, sizeof(*ts));
+        if(!ts)
+            return;
+        ts->pid = getpid();
+        LL_PREPEND(posix_thread_states, ts);
+        posix_tls_state = ts;
+    }
+
+    HASH_FIND(hlink, ts->delta_hash, &rec_id, sizeof(darshan_record_id), delta);
+    if(!delta)
+    {
+        delta = calloc(1, sizeof(*delta));
+        if(!delta)
+            return;
+        delta->rec_id = rec_id;
+        delta->rec_ref = rec_ref;
+        atomic_flag_clear(&delta->lock);
+        delta->file_alignment = rec_ref->file_rec->counters[POSIX_FILE_ALIGNMENT];
+        delta->last_byte_read = rec_ref->last_byte_read;
+        delta->last_byte_written = rec_ref->last_byte_written;
+        delta->last_io_type = rec_ref->last_io_type;
+        HASH_ADD(hlink, ts->delta_hash, rec_id, sizeof(darshan_record_id), delta);
+    }
+
+    slot = &ts->fd_cache[fd & (POSIX_THREAD_FD_CACHE_SIZE - 1)];
+    slot->fd = fd;
+    slot->delta = delta;
+    slot->epoch = atomic_load(&posix_fd_epoch);
+
+    return;
+}
+
+/* invalidate all threads' fd caches after the fd table is modified */
+static void posix_thread_cache_invalidate()
+{
+    atomic_fetch_add(&posix_fd_epoch, 1);
+    return;
+}
+
+/* merge every thread's deltas for the given record into the shared record.
+ * Busy intervals from all threads are gathered into a single list before
+ * being added to the record's read and write times, so that time spent by
+ * one thread is not hidden by a later interval from another thread. The
+ * POSIX module lock must be held.
+ */
+static void posix_thread_cache_merge_record(
+    struct posix_file_record_ref *rec_ref)
+{
+    darshan_record_id rec_id = rec_ref->file_rec->base_rec.id;
+    struct posix_thread_state *ts;
+    struct posix_thread_delta *delta;
+    struct posix_thread_interval *read_busy = NULL;
+    struct posix_thread_interval *write_busy = NULL;
+    int read_count = 0;
+    int write_count = 0;
+    int nstates = 0;
+
+    LL_FOREACH(posix_thread_states, ts)
+        nstates++;
+    if(nstates > 1)
+    {
+        read_busy = malloc(nstates * POSIX_THREAD_MAX_INTERVALS *
+            sizeof(*read_busy));
+        write_busy = malloc(nstates * POSIX_THREAD_MAX_INTERVALS *
+            sizeof(*write_busy));
+        /* if either allocation fails, fall back to merging each thread's
+         * intervals separately
+         */
+        if(!read_busy || !write_busy)
+        {
+            free(read_busy);
+            free(write_busy);
+            read_busy = write_busy = NULL;
+        }
+    }
+
+    LL_FOREACH(posix_thread_states, ts)
+    {
+        HASH_FIND(hlink, ts->delta_hash, &rec_id, sizeof(darshan_record_id),
+            delta);
+        if(!delta)
+            continue;
+
+        /* states inherited across a fork belong to threads that no longer
+         * exist, and their deltas may have been left locked
+         */
+        if(ts->pid == getpid())
+            posix_thread_delta_lock(delta);
+        if(read_busy)
+        {
+            memcpy(&read_busy[read_count], delta->read_busy,
+                delta->read_busy_count * sizeof(*read_busy));
+            read_count += delta->read_busy_count;
+            delta->read_busy_count = 0;
+            memcpy(&write_busy[write_count], delta->write_busy,
+                delta->write_busy_count * sizeof(*write_busy));
+            write_count += delta->write_busy_count;
+            delta->write_busy_count = 0;
+        }
+        posix_thread_delta_merge(delta);
+        if(ts->pid == getpid())
+            posix_thread_delta_unlock(delta);
+    }
+
+    if(read_busy)
+    {
+        posix_thread_interval_merge(read_busy, &read_count,
+            &rec_ref->file_rec->fcounters[POSIX_F_READ_TIME],
+            &rec_ref->last_read_end);
+        posix_thread_interval_merge(write_busy, &write_count,
+            &rec_ref->file_rec->fcounters[POSIX_F_WRITE_TIME],
+            &rec_ref->last_write_end);
+        free(read_busy);
+        free(write_busy);
+    }
+
+    return;
+}
+
+/* permanently disable the thread cache and merge all outstanding deltas
+ * from every thread into the shared records. The POSIX module lock must
+ * be held. Safe to call more than once.
+ */
+static void posix_thread_cache_flush()
 {
-    struct posix_file_record_ref *rec_ref =
-        (struct posix_file_record_ref *)rec_ref_p;
+    struct posix_thread_state *ts;
+    struct posix_thread_delta *delta, *tmp;
+
+    if(!atomic_exchange(&posix_thread_cache_active, 0))
+        return;
+
+    /* merging a record also merges the other threads' deltas for it, and
+     * waits for any in-flight update to them to complete
+     */
+    LL_FOREACH(posix_thread_states, ts)
+    {
+        HASH_ITER(hlink, ts->delta_hash, delta, tmp)
+        {
+            posix_thread_cache_merge_record(delta->rec_ref);
+        }
+    }
 
-    tdestroy(rec_ref->access_root, free);
-    tdestroy(rec_ref->stride_root, free);
     return;
 }
 
+/* free all thread deltas. The POSIX module lock must be held. */
+static void posix_thread_cache_cleanup()
+{
+    struct posix_thread_state *ts;
+    struct posix_thread_delta *delta, *tmp;
+
+    posix_thread_cache_flush();
+    posix_thread_cache_invalidate();
+
+    LL_FOREACH(posix_thread_states, ts)
+    {
+        HASH_ITER(hlink, ts->delta_hash, delta, tmp)
+        {
+            HASH_DELETE(hlink, ts->delta_hash, delta);
+            free(delta);
+        }
+    }
+
+    return;
+}
+#endif
+
 #ifdef HAVE_MPI
 static void posix_record_reduction_op(void* infile_v, void* inoutfile_v,
     int *len, MPI_Datatype *datatype)
@@ -2614,6 +3282,33 @@ void darshan_posix_shutdown_bench_setup(int test_case)
  *********************************************************************************/
 
 #ifdef HAVE_MPI
+/* initialize fastest/slowest info of a shared record prior to reduction */
+static void posix_shared_record_init(struct darshan_posix_file *rec)
+{
+    double posix_time =
+        rec->fcounters[POSIX_F_READ_TIME] +
+        rec->fcounters[POSIX_F_WRITE_TIME] +
+        rec->fcounters[POSIX_F_META_TIME];
+
+    rec->counters[POSIX_FASTEST_RANK] = rec->base_rec.rank;
+    rec->counters[POSIX_FASTEST_RANK_BYTES] =
+        rec->counters[POSIX_BYTES_READ] +
+        rec->counters[POSIX_BYTES_WRITTEN];
+    rec->fcounters[POSIX_F_FASTEST_RANK_TIME] = posix_time;
+
+    /* until reduction occurs, we assume that this rank is both
+     * the fastest and slowest. It is up to the reduction operator
+     * to find the true min and max.
+     */
+    rec->counters[POSIX_SLOWEST_RANK] = rec->counters[POSIX_FASTEST_RANK];
+    rec->counters[POSIX_SLOWEST_RANK_BYTES] =
+        rec->counters[POSIX_FASTEST_RANK_BYTES];
+    rec->fcounters[POSIX_F_SLOWEST_RANK_TIME] =
+        rec->fcounters[POSIX_F_FASTEST_RANK_TIME];
+
+    return;
+}
+
 static void posix_mpi_redux(
     void *posix_buf,
     MPI_Comm mod_comm,
@@ -2623,7 +3318,6 @@ static void posix_mpi_redux(
     int posix_rec_count;
     struct posix_file_record_ref *rec_ref;
     struct darshan_posix_file *posix_rec_buf = (struct darshan_posix_file *)posix_buf;
-    double posix_time;
     struct darshan_posix_file *red_send_buf = NULL;
     struct darshan_posix_file *red_recv_buf = NULL;
     MPI_Datatype red_type;
@@ -2633,6 +3327,10 @@ static void posix_mpi_redux(
     POSIX_LOCK();
     assert(posix_runtime);
 
+#ifdef HAVE_STDATOMIC_H
+    posix_thread_cache_flush();
+#endif
+
     posix_rec_count = posix_runtime->file_rec_count;
 
     /* necessary initialization of shared records */
@@ -2642,31 +3340,7 @@ static void posix_mpi_redux(
             &shared_recs[i], sizeof(darshan_record_id));
         assert(rec_ref);
 
-        posix_time =
-            rec_ref->file_rec->fcounters[POSIX_F_READ_TIME] +
-            rec_ref->file_rec->fcounters[POSIX_F_WRITE_TIME] +
-            rec_ref->file_rec->fcounters[POSIX_F_META_TIME];
-
-        /* initialize fastest/slowest info prior to the reduction */
-        rec_ref->file_rec->counters[POSIX_FASTEST_RANK] =
-            rec_ref->file_rec->base_rec.rank;
-        rec_ref->file_rec->counters[POSIX_FASTEST_RANK_BYTES] =
-            rec_ref->file_rec->counters[POSIX_BYTES_READ] +
-            rec_ref->file_rec->counters[POSIX_BYTES_WRITTEN];
-        rec_ref->file_rec->fcounters[POSIX_F_FASTEST_RANK_TIME] =
-            posix_time;
-
-        /* until reduction occurs, we assume that this rank is both
-         * the fastest and slowest. It is up to the reduction operator
-         * to find the true min and max.
-         */
-        rec_ref->file_rec->counters[POSIX_SLOWEST_RANK] =
-            rec_ref->file_rec->counters[POSIX_FASTEST_RANK];
-        rec_ref->file_rec->counters[POSIX_SLOWEST_RANK_BYTES] =
-            rec_ref->file_rec->counters[POSIX_FASTEST_RANK_BYTES];
-        rec_ref->file_rec->fcounters[POSIX_F_SLOWEST_RANK_TIME] =
-            rec_ref->file_rec->fcounters[POSIX_F_FASTEST_RANK_TIME];
-
+        posix_shared_record_init(rec_ref->file_rec);
         rec_ref->file_rec->base_rec.rank = -1;
     }
 
@@ -2729,6 +3403,110 @@ static void posix_mpi_redux(
     POSIX_UNLOCK();
     return;
 }
+
+static void posix_mpi_partial_redux(
+    void *posix_buf,
+    MPI_Comm mod_comm,
+    struct darshan_partial_shared_rec *partial_recs,
+    int partial_rec_count)
+{
+    struct darshan_posix_file *posix_rec_buf = (struct darshan_posix_file *)posix_buf;
+    struct darshan_posix_file *recv_recs = NULL;
+    struct darshan_posix_file *rec;
+    struct darshan_partial_shared_rec *partial_rec;
+    struct darshan_variance_dt time_var, bytes_var, tmp_var;
+    int recv_rec_count;
+    int one = 1;
+    int ret;
+    int i, j;
+
+    POSIX_LOCK();
+    assert(posix_runtime);
+
+#ifdef HAVE_STDATOMIC_H
+    posix_thread_cache_flush();
+#endif
+
+    /* necessary initialization of partially shared records */
+    for(i = 0; i < posix_runtime->file_rec_count; i++)
+    {
+        rec = &posix_rec_buf[i];
+        if(rec->base_rec.rank >= 0 && darshan_partial_record_lookup(
+            partial_recs, partial_rec_count, rec->base_rec.id))
+        {
+            posix_shared_record_init(rec);
+        }
+    }
+
+    /* move each partially shared record to the lowest rank that opened it */
+    ret = darshan_partial_record_exchange(mod_comm, DARSHAN_POSIX_MOD, posix_buf,
+        &posix_runtime->file_rec_count, sizeof(struct darshan_posix_file),
+        partial_recs, partial_rec_count, (void **)&recv_recs, &recv_rec_count);
+    if(ret < 0)
+    {
+        /* leave the records we would have reduced rank-local */
+        POSIX_UNLOCK();
+        return;
+    }
+
+    /* reduce the received records into our own, both sorted by id; records
+     * that could not be sent to the process reducing them are still here
+     */
+    for(i = 0, j = 0; i < posix_runtime->file_rec_count; i++)
+    {
+        rec = &posix_rec_buf[i];
+        if(rec->base_rec.rank < 0)
+            continue;
+        partial_rec = darshan_partial_record_lookup(partial_recs,
+            partial_rec_count, rec->base_rec.id);
+        if(!partial_rec || partial_rec->root != my_rank)
+            continue;
+
+        time_var.n = 1;
+        time_var.S = 0;
+        time_var.T = rec->fcounters[POSIX_F_READ_TIME] +
+                     rec->fcounters[POSIX_F_WRITE_TIME] +
+                     rec->fcounters[POSIX_F_META_TIME];
+        bytes_var.n = 1;
+        bytes_var.S = 0;
+        bytes_var.T = (double)
+                      rec->counters[POSIX_BYTES_READ] +
+                      rec->counters[POSIX_BYTES_WRITTEN];
+
+        while(j < recv_rec_count && recv_recs[j].base_rec.id < rec->base_rec.id)
+            j++;
+        for(; j < recv_rec_count && recv_recs[j].base_rec.id == rec->base_rec.id; j++)
+        {
+            tmp_var.n = 1;
+            tmp_var.S = 0;
+            tmp_var.T = recv_recs[j].fcounters[POSIX_F_READ_TIME] +
+                        recv_recs[j].fcounters[POSIX_F_WRITE_TIME] +
+                        recv_recs[j].fcounters[POSIX_F_META_TIME];
+            darshan_variance_reduce(&tmp_var, &time_var, &one, NULL);
+            tmp_var.n = 1;
+            tmp_var.S = 0;
+            tmp_var.T = (double)
+                        recv_recs[j].counters[POSIX_BYTES_READ] +
+                        recv_recs[j].counters[POSIX_BYTES_WRITTEN];
+            darshan_variance_reduce(&tmp_var, &bytes_var, &one, NULL);
+
+            posix_record_reduction_op(&recv_recs[j], rec, &one, NULL);
+        }
+
+        rec->fcounters[POSIX_F_VARIANCE_RANK_TIME] = time_var.S / time_var.n;
+        rec->fcounters[POSIX_F_VARIANCE_RANK_BYTES] = bytes_var.S / bytes_var.n;
+
+        /* the rank field of a partially shared record holds the negated
+         * number of processes that opened it
+         */
+        rec->base_rec.rank = -partial_rec->rank_count;
+    }
+
+    free(recv_recs);
+
+    POSIX_UNLOCK();
+    return;
+}
 #endif
 
 static void posix_output(
@@ -2740,6 +3518,10 @@ static void posix_output(
     POSIX_LOCK();
     assert(posix_runtime);
 
+#ifdef HAVE_STDATOMIC_H
+    posix_thread_cache_flush();
+#endif
+
     /* just pass back our updated total buffer size -- no need to update buffer */
     posix_rec_count = posix_runtime->file_rec_count;
     *posix_buf_sz = posix_rec_count * sizeof(struct darshan_posix_file);
@@ -2755,9 +3537,11 @@ static void posix_cleanup()
     POSIX_LOCK();
     assert(posix_runtime);
 
+#ifdef HAVE_STDATOMIC_H
+    posix_thread_cache_cleanup();
+#endif
+
     /* cleanup internal structures used for instrumenting */
-    darshan_iter_record_refs(posix_runtime->rec_id_hash,
-        &posix_finalize_file_records, NULL);
     darshan_clear_record_refs(&(posix_runtime->fd_hash), 0);
     darshan_clear_record_refs(&(posix_runtime->rec_id_hash), 1);
 
@@ -136,9 +136,9 @@ struct stdio_file_record_ref
     double last_read_end;
     double last_write_end;
     int fs_type;
-#ifdef HAVE_LDMS
     int64_t close_counts;
-#endif
+    struct heatmap_record_ref *heatmap; /* per-file heatmap, if any */
+    int heatmap_registered; /* per-file heatmap registration attempted */
 };
 
 /* The stdio_runtime structure maintains necessary state for storing
@@ -150,7 +150,7 @@ struct stdio_runtime
     void *rec_id_hash;
     void *stream_hash;
     int file_rec_count;
-    darshan_record_id heatmap_id;
+    struct heatmap_record_ref *heatmap;
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
@@ -257,7 +257,7 @@ extern int __real_fileno(FILE *stream);
         __rec_ref->file_rec->fcounters[STDIO_F_OPEN_START_TIMESTAMP] = __tm1; \
     __rec_ref->file_rec->fcounters[STDIO_F_OPEN_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(__rec_ref->file_rec->fcounters[STDIO_F_META_TIME], __tm1, __tm2, __rec_ref->last_meta_end); \
-    darshan_add_record_ref(&(stdio_runtime->stream_hash), &(__ret), sizeof(__ret), __rec_ref); \
+    darshan_add_record_ref(&(stdio_runtime->stream_hash), &(__ret), sizeof(__ret), __rec_ref, DARSHAN_STDIO_MOD); \
 } while(0)
 
 
@@ -269,7 +269,8 @@ extern int __real_fileno(FILE *stream);
     this_offset = rec_ref->offset; \
     rec_ref->offset = this_offset + __bytes; \
     /* heatmap to record traffic summary */ \
-    heatmap_update(stdio_runtime->heatmap_id, HEATMAP_READ, __bytes, __tm1, __tm2); \
+    heatmap_update(stdio_runtime->heatmap, HEATMAP_READ, __bytes, __tm1, __tm2); \
+    HEATMAP_UPDATE_FILE(stdio_runtime->heatmap, rec_ref, HEATMAP_READ, __bytes, __tm1, __tm2); \
     if(rec_ref->file_rec->counters[STDIO_MAX_BYTE_READ] < (this_offset + __bytes - 1)) \
         rec_ref->file_rec->counters[STDIO_MAX_BYTE_READ] = (this_offset + __bytes - 1); \
     rec_ref->file_rec->counters[STDIO_BYTES_READ] += __bytes; \
@@ -293,7 +294,8 @@ extern int __real_fileno(FILE *stream);
     this_offset = rec_ref->offset; \
     rec_ref->offset = this_offset + __bytes; \
     /* heatmap to record traffic summary */ \
-    heatmap_update(stdio_runtime->heatmap_id, HEATMAP_WRITE, __bytes, __tm1, __tm2); \
+    heatmap_update(stdio_runtime->heatmap, HEATMAP_WRITE, __bytes, __tm1, __tm2); \
+    HEATMAP_UPDATE_FILE(stdio_runtime->heatmap, rec_ref, HEATMAP_WRITE, __bytes, __tm1, __tm2); \
     if(rec_ref->file_rec->counters[STDIO_MAX_BYTE_WRITTEN] < (this_offset + __bytes - 1)) \
         rec_ref->file_rec->counters[STDIO_MAX_BYTE_WRITTEN] = (this_offset + __bytes - 1); \
     rec_ref->file_rec->counters[STDIO_BYTES_WRITTEN] += __bytes; \
@@ -487,13 +489,11 @@ int DARSHAN_DECL(fclose)(FILE *fp)
             tm1, tm2, rec_ref->last_meta_end);
         darshan_delete_record_ref(&(stdio_runtime->stream_hash), &fp, sizeof(fp));
 
-#ifdef HAVE_LDMS
         rec_ref->close_counts++;
         /* publish close information for stdio */
         if(dC.ldms_lib)
             if(dC.stdio_enable_ldms)
                 darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->close_counts, "close", -1, -1, -1, -1, rec_ref->file_rec->counters[STDIO_FLUSHES], tm1, tm2, rec_ref->file_rec->fcounters[STDIO_F_META_TIME], "STDIO", "MOD");
-#endif
     }
     STDIO_POST_RECORD();
 
@@ -1130,7 +1130,7 @@ static void stdio_runtime_initialize()
     STDIO_RECORD_OPEN(stderr, "<STDERR>", 0, 0);
 
     /* register a heatmap */
-    stdio_runtime->heatmap_id = heatmap_register("heatmap:STDIO");
+    stdio_runtime->heatmap = heatmap_register("heatmap:STDIO");
 
     return;
 }
@@ -1143,17 +1143,16 @@ static struct stdio_file_record_ref *stdio_track_new_file_record(
     struct darshan_fs_info fs_info;
     int ret;
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_core_arena_alloc(DARSHAN_STDIO_MOD, sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this file record based on record id */
     ret = darshan_add_record_ref(&(stdio_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+        sizeof(darshan_record_id), rec_ref, DARSHAN_STDIO_MOD);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
@@ -1171,7 +1170,7 @@ static struct stdio_file_record_ref *stdio_track_new_file_record(
     {
         darshan_delete_record_ref(&(stdio_runtime->rec_id_hash),
             &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_core_arena_free(rec_ref);
         return(NULL);
     }
 
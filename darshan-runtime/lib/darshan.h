@@ -60,6 +60,12 @@
 #define DARSHAN_DEF_MMAP_LOG_PATH "/tmp"
 #endif
 
+/* Environment variable to override default snapshot log path */
+#define DARSHAN_SNAPSHOT_PATH_OVERRIDE "DARSHAN_SNAPSHOT_PATH"
+
+/* default path for storing snapshot logs is '/tmp' */
+#define DARSHAN_DEF_SNAPSHOT_PATH "/tmp"
+
 /* Maximum runtime memory consumption per process (in MiB) across
  * all instrumentation modules
  */
@@ -78,6 +84,29 @@
 #define DARSHAN_NAME_MEM_MAX (1 * 1024 * 1024)
 #endif
 
+/* default compression level for log data (-1 selects the default level of
+ * the compression library in use), and the largest level accepted, which
+ * is clamped to 9 for zlib
+ */
+#define DARSHAN_DEF_COMP_LEVEL (-1)
+#define DARSHAN_MAX_COMP_LEVEL 19
+
+/* size of the chunks that log buffers are split into when they are
+ * compressed by multiple threads (i.e., DARSHAN_COMP_THREADS > 1)
+ */
+#define DARSHAN_COMP_CHUNK_SIZE (256 * 1024)
+
+/* size of the chunks that log buffers are split into for periodic snapshot
+ * logs (i.e., DARSHAN_SNAPSHOT_INTERVAL > 0), so that only chunks that
+ * changed since the last snapshot need to be compressed again
+ */
+#define DARSHAN_SNAPSHOT_CHUNK_SIZE (32 * 1024)
+
+/* number of log regions (job record, name records, and modules) staged for
+ * aggregated log writes (i.e., DARSHAN_LOG_AGGREGATORS > 0)
+ */
+#define DARSHAN_AGG_REGION_COUNT (DARSHAN_KNOWN_MODULE_COUNT + 2)
+
 /* maximum buffer size for full paths, for internal use only */
 #define __DARSHAN_PATH_MAX 4096
 
@@ -113,6 +142,9 @@ struct darshan_core_name_record_ref
     struct darshan_name_record *name_record;
     uint64_t mod_flags;
     uint64_t global_mod_flags;
+    int shared_rank_count; /* number of processes that opened the record */
+    uint64_t partial_mod_flags; /* modules to reduce over a subset of processes */
+    int min_rank; /* lowest rank that opened the record */
     UT_hash_handle hlink;
 };
 
@@ -122,6 +154,7 @@ struct darshan_core_regex
     regex_t regex;
     char *regex_str;
     uint64_t mod_flags;
+    size_t prefix_len; /* length of the literal prefix after a leading '^' */
     struct darshan_core_regex *next;
 };
 
@@ -142,11 +175,27 @@ struct darshan_core_runtime
     struct darshan_core_name_record_ref *name_hash;
     size_t name_mem_used;
     char *comp_buf;
+    struct darshan_log_chunk *chunk_index; /* local compressed chunk index */
+    int chunk_count;
+    int chunk_index_size;
+    struct darshan_log_rec_index *rec_index; /* local record index */
+    int rec_index_count;
+    int rec_index_size;
+    struct darshan_path_trie *path_trie; /* mount points and path exclusions */
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
     char mmap_log_name[__DARSHAN_PATH_MAX];
 #endif
 #ifdef HAVE_MPI
     MPI_Comm mpi_comm;
+    /* compressed log regions staged for an aggregated log write, and the
+     * length of each region in the staging buffer (job record, name
+     * records, then each module)
+     */
+    char *agg_buf;
+    size_t agg_buf_size;
+    size_t agg_buf_used;
+    uint64_t agg_region_len[DARSHAN_AGG_REGION_COUNT];
+    int agg_err;
 #endif
     int pid;
 };
@@ -245,6 +294,30 @@ typedef void (*darshan_module_redux)(
     darshan_record_id *shared_recs, /* list of shared data record ids */
     int shared_rec_count /* count of shared data records */
 );
+
+/* description of a record shared by a subset of processes */
+struct darshan_partial_shared_rec
+{
+    darshan_record_id id;
+    int root; /* lowest rank that opened the record, which reduces it */
+    int rank_count; /* number of processes that opened the record */
+};
+
+/*
+ * module developers _may_ define a 'darshan_module_partial_redux' function
+ * to reduce records shared by a subset of processes (given in the
+ * 'partial_recs' array, sorted by record id) into a single data record
+ * on each record's root process. Unlike 'darshan_module_redux', this
+ * function is only called on processes that opened at least one of these
+ * records, so it must not use collectives on 'mod_comm'. Set to NULL to
+ * avoid any reduction steps.
+ */
+typedef void (*darshan_module_partial_redux)(
+    void *mod_buf, /* input parameter indicating module's buffer address */
+    MPI_Comm mod_comm,  /* MPI communicator to communicate with */
+    struct darshan_partial_shared_rec *partial_recs, /* partially shared records */
+    int partial_rec_count /* count of partially shared records */
+);
 #endif
 /*
  * module developers _must_ define a 'darshan_module_output' function
@@ -265,6 +338,7 @@ typedef struct darshan_module_funcs
 {
 #ifdef HAVE_MPI
     darshan_module_redux mod_redux_func;
+    darshan_module_partial_redux mod_partial_redux_func;
 #endif
     darshan_module_output mod_output_func;
     darshan_module_cleanup mod_cleanup_func;
@@ -363,6 +437,36 @@ void *darshan_core_register_record(
 char *darshan_core_lookup_record_name(
     darshan_record_id rec_id);
 
+/* darshan_core_arena_alloc()
+ *
+ * Allocates 'size' bytes of zero-initialized memory from the arena that
+ * darshan-core maintains for the module identified by 'mod_id'. Modules
+ * should use this for runtime structures they allocate per record or per
+ * handle (e.g., record references). Arena memory is carved out of large
+ * slabs, recycled by size class, and released in bulk when Darshan shuts
+ * down. Returns NULL on failure.
+ */
+void *darshan_core_arena_alloc(
+    darshan_module_id mod_id,
+    size_t size);
+
+/* darshan_core_arena_free()
+ *
+ * Returns memory obtained from darshan_core_arena_alloc() to its arena
+ * so that it can be reused by subsequent allocations.
+ */
+void darshan_core_arena_free(
+    void *ptr);
+
+/* darshan_core_get_config()
+ *
+ * Returns a pointer to Darshan's runtime configuration, or NULL if Darshan
+ * is not currently active. Modules should only use this to query their
+ * settings at initialization time and must not modify the configuration.
+ */
+const struct darshan_config *darshan_core_get_config(
+    void);
+
 /* darshan_core_disabled_instrumentation
  *
  * Returns true (1) if Darshan has currently disabled instrumentation,
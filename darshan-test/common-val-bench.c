@@ -0,0 +1,147 @@
+/*
+ *  (C) 2026 by Argonne National Laboratory.
+ *      See COPYRIGHT in top-level directory.
+ */
+
+/* Times darshan_track_common_val_counters(), which every module calls to
+ * record access sizes and strides, when the values seen are drawn from 1,
+ * 4, 16 or 64 distinct sizes.  A tsearch() tree (what the modules used
+ * before the fixed-size table) is timed on the same values as a reference.
+ * Include the runtime's darshan-runtime-config.h and lib/ headers and link
+ * with libdarshan to build it.
+ *
+ * Arguments: [number of operations per test]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <search.h>
+#include <assert.h>
+#include <time.h>
+
+#include "darshan.h"
+
+/* tsearch() reference */
+static int tree_vals_compare(const void *a_p, const void *b_p)
+{
+    const struct darshan_common_val_counter* a = a_p;
+    const struct darshan_common_val_counter* b = b_p;
+
+    return(memcmp(a->vals, b->vals, sizeof(*(a->vals)) * a->nvals));
+}
+
+static struct darshan_common_val_counter *tree_track_common_val_counters(
+    void **common_val_root, int64_t *vals, int nvals, int *common_val_count)
+{
+    struct darshan_common_val_counter* counter;
+    struct darshan_common_val_counter* found = NULL;
+    struct darshan_common_val_counter tmp_counter;
+    void* tmp;
+
+    memcpy(tmp_counter.vals, vals, sizeof(*vals) * nvals);
+    tmp_counter.nvals = nvals;
+    tmp_counter.freq = 1;
+    tmp = tfind(&tmp_counter, common_val_root, tree_vals_compare);
+    if(tmp)
+    {
+        found = *(struct darshan_common_val_counter**)tmp;
+        found->freq++;
+    }
+    else if(*common_val_count < DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT)
+    {
+        counter = malloc(sizeof(*counter));
+        if(!counter)
+            return(NULL);
+        memcpy(counter->vals, vals, sizeof(*vals) * nvals);
+        counter->nvals = nvals;
+        counter->freq = 1;
+        tmp = tsearch(counter, common_val_root, tree_vals_compare);
+        found = *(struct darshan_common_val_counter**)tmp;
+        (*common_val_count)++;
+    }
+
+    return(found);
+}
+
+static double now_ns(void)
+{
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return(tp.tv_sec * 1e9 + tp.tv_nsec);
+}
+
+int main(int argc, char **argv)
+{
+    long nops = 10000000;
+    int ndistinct[] = {1, 4, 16, 64};
+    int64_t *vals;
+    int64_t counters[8];
+    struct darshan_common_val_counter *cvc;
+    struct darshan_common_val_table *table;
+    void *root;
+    int count;
+    double start, tree_ns, table_ns;
+    long i;
+    int t;
+
+    if(argc > 2)
+    {
+        fprintf(stderr, "Usage: %s [nops]\n", argv[0]);
+        return(-1);
+    }
+    if(argc == 2)
+        nops = atol(argv[1]);
+    if(nops < 1)
+        nops = 1;
+
+    vals = malloc(nops * sizeof(*vals));
+    table = malloc(sizeof(*table));
+    if(!vals || !table)
+    {
+        fprintf(stderr, "Error: unable to allocate benchmark buffers\n");
+        return(-1);
+    }
+
+    printf("# distinct\tops\ttree ns/op\ttable ns/op\n");
+    for(t = 0; t < (int)(sizeof(ndistinct)/sizeof(ndistinct[0])); t++)
+    {
+        /* pseudo-random sequence of access sizes from a fixed set */
+        srand(t + 1);
+        for(i = 0; i < nops; i++)
+            vals[i] = 4096 * (1 + rand() % ndistinct[t]);
+
+        root = NULL;
+        count = 0;
+        memset(counters, 0, sizeof(counters));
+        start = now_ns();
+        for(i = 0; i < nops; i++)
+        {
+            cvc = tree_track_common_val_counters(&root, &vals[i], 1, &count);
+            if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS(&counters[0],
+                &counters[4], cvc->vals, 1, cvc->freq, 0);
+        }
+        tree_ns = (now_ns() - start) / nops;
+        tdestroy(root, free);
+
+        memset(table, 0, sizeof(*table));
+        memset(counters, 0, sizeof(counters));
+        start = now_ns();
+        for(i = 0; i < nops; i++)
+        {
+            cvc = darshan_track_common_val_counters(table, &vals[i], 1);
+            if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS(&counters[0],
+                &counters[4], cvc->vals, 1, cvc->freq, 0);
+        }
+        table_ns = (now_ns() - start) / nops;
+
+        printf("%d\t%ld\t%.2f\t%.2f\n", ndistinct[t], nops, tree_ns, table_ns);
+    }
+
+    free(vals);
+    free(table);
+    return(0);
+}
@@ -0,0 +1,156 @@
+/*
+ *  (C) 2026 by Argonne National Laboratory.
+ *      See COPYRIGHT in top-level directory.
+ */
+
+/* Drives heatmap_update() on a single registered heatmap with three access
+ * patterns: 1 us accesses that stay within one bin, 0.5 s accesses that
+ * cross bin boundaries, and accesses at ever later times that keep forcing
+ * the bins to be widened.  The first pattern is repeated with 1, 2, 4, ...
+ * threads; run with and without DARSHAN_HEATMAP_THREAD_BINS=1 to see the
+ * per-thread bins against the shared locked ones.  Compile with
+ * -DDARSHAN_HEATMAP against darshan-runtime's lib/ headers and link with
+ * libdarshan.
+ *
+ * Arguments: [number of operations per test] [max threads]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <mpi.h>
+
+#include "darshan.h"
+#include "darshan-heatmap.h"
+
+/* access patterns */
+#define PATTERN_SHORT 0   /* 1 us accesses, always within one bin */
+#define PATTERN_SPAN 1    /* 0.5 s accesses, crossing bin boundaries */
+#define PATTERN_GROWING 2 /* short accesses at ever later times */
+
+struct bench_args
+{
+    struct heatmap_record_ref *heatmap;
+    int pattern;
+    long nops;
+};
+
+static double now_ns(void)
+{
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return(tp.tv_sec * 1e9 + tp.tv_nsec);
+}
+
+static void *bench_thread(void *arg)
+{
+    struct bench_args *a = (struct bench_args *)arg;
+    double start, end;
+    int rw_flag;
+    long i;
+
+    for(i = 0; i < a->nops; i++)
+    {
+        switch(a->pattern)
+        {
+            case PATTERN_SHORT:
+                start = 1.0 + (i % 1000) * 1e-3;
+                end = start + 1e-6;
+                break;
+            case PATTERN_SPAN:
+                start = 1.0 + (i % 1000) * 1e-3;
+                end = start + 0.5;
+                break;
+            default:
+                /* reaches roughly 27 hours by the end of the run */
+                start = 1e5 * (double)i / a->nops;
+                end = start + 1e-6;
+                break;
+        }
+        rw_flag = (i & 1) ? HEATMAP_READ : HEATMAP_WRITE;
+        heatmap_update(a->heatmap, rw_flag, 4096, start, end);
+    }
+
+    return(NULL);
+}
+
+static double run_bench(struct heatmap_record_ref *heatmap, int pattern,
+    long nops, int nthreads)
+{
+    pthread_t *threads;
+    struct bench_args a;
+    double start;
+    int i;
+
+    a.heatmap = heatmap;
+    a.pattern = pattern;
+    a.nops = nops;
+
+    threads = malloc(nthreads * sizeof(*threads));
+    if(!threads)
+        return(-1);
+
+    start = now_ns();
+    for(i = 0; i < nthreads; i++)
+        pthread_create(&threads[i], NULL, bench_thread, &a);
+    for(i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+
+    free(threads);
+    return((now_ns() - start) / nops);
+}
+
+int main(int argc, char **argv)
+{
+    long nops = 10000000;
+    int max_threads = 8;
+    const char *pattern_names[] = {"short", "span", "growing"};
+    struct heatmap_record_ref *heatmap;
+    double heatmap_ns;
+    int pattern, nthreads;
+
+    MPI_Init(&argc, &argv);
+
+    if(argc > 3)
+    {
+        fprintf(stderr, "Usage: %s [nops] [max_threads]\n", argv[0]);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if(argc > 1)
+        nops = atol(argv[1]);
+    if(argc > 2)
+        max_threads = atoi(argv[2]);
+    if(nops < 1)
+        nops = 1;
+    if(max_threads < 1)
+        max_threads = 1;
+
+    heatmap = heatmap_register("heatmap:BENCH");
+    if(!heatmap)
+    {
+        fprintf(stderr, "Error: unable to register heatmap (is Darshan enabled?)\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    printf("# pattern\tthreads\tops/thread\tns/op\n");
+    for(pattern = PATTERN_SHORT; pattern <= PATTERN_GROWING; pattern++)
+    {
+        for(nthreads = 1; nthreads <= max_threads; nthreads *= 2)
+        {
+            /* only time concurrent updates for the common case */
+            if(pattern != PATTERN_SHORT && nthreads > 1)
+                break;
+            heatmap_ns = run_bench(heatmap, pattern, nops, nthreads);
+            printf("%s\t%d\t%ld\t%.2f\n", pattern_names[pattern],
+                nthreads, nops, heatmap_ns);
+        }
+    }
+
+    MPI_Finalize();
+    return(0);
+}
@@ -0,0 +1,218 @@
+/*
+ *  (C) 2026 by Argonne National Laboratory.
+ *      See COPYRIGHT in top-level directory.
+ */
+
+/* Classifies a set of synthetic record paths the way darshan-core does when
+ * a record is registered (excluded or not, and on which mount point), once
+ * with a linear scan over every exclusion, regex and mount and once with
+ * the darshan_path_trie_*() functions plus literal prefix checks in front
+ * of the regexes.  The two must agree on every path; the time per path of
+ * each is reported.  Needs darshan-runtime's lib/darshan.h and libdarshan.
+ *
+ * Arguments: [number of paths]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <regex.h>
+#include <time.h>
+
+#include "darshan.h"
+
+#define NMNTS 64
+#define PATH_EXCLUDED 1
+#define PATH_INCLUDED 2
+
+/* default darshan-runtime path exclusions and inclusions */
+static char *exclude_dirs[] = {"/etc/", "/dev/", "/usr/", "/bin/", "/boot/",
+    "/lib/", "/opt/", "/sbin/", "/sys/", "/proc/", "/var/", NULL};
+static char *include_dirs[] = {"/var/opt/cray/dws/mounts/", NULL};
+
+/* NAME_EXCLUDE regexes, along with the length of their literal prefix */
+static struct
+{
+    char *str;
+    size_t prefix_len;
+    regex_t regex;
+} regexes[] = {
+    {"^/scratch/[^/]*/tmp/", 9, {0}},
+    {"^/home/[a-z]+/\\.cache/", 6, {0}},
+    {"^/proj/p07/ckpt_[0-9]+$", 16, {0}},
+    {"\\.lock$", 0, {0}},
+};
+#define NREGEXES (int)(sizeof(regexes)/sizeof(regexes[0]))
+
+static char mnt_paths[NMNTS][64];
+static int nmnts;
+
+static int mnt_path_cmp(const void *a, const void *b)
+{
+    return((int)strlen((const char *)b) - (int)strlen((const char *)a));
+}
+
+/* straightforward scan, used to check the trie's answers */
+static int linear_match(const char *path, int *excluded)
+{
+    int i;
+
+    *excluded = 0;
+    for(i = 0; exclude_dirs[i]; i++)
+    {
+        if(!strncmp(exclude_dirs[i], path, strlen(exclude_dirs[i])))
+        {
+            *excluded = 1;
+            break;
+        }
+    }
+    for(i = 0; !*excluded && i < NREGEXES; i++)
+    {
+        if(regexec(&regexes[i].regex, path, 0, NULL, 0) == 0)
+            *excluded = 1;
+    }
+    if(*excluded)
+    {
+        for(i = 0; include_dirs[i]; i++)
+        {
+            if(!strncmp(include_dirs[i], path, strlen(include_dirs[i])))
+                *excluded = 0;
+        }
+    }
+    for(i = 0; i < nmnts; i++)
+    {
+        if(!strncmp(mnt_paths[i], path, strlen(mnt_paths[i])))
+            return(i);
+    }
+
+    return(-1);
+}
+
+static int trie_match(struct darshan_path_trie *trie, const char *path,
+    int *excluded)
+{
+    int mnt_idx;
+    int flags;
+    int i;
+
+    mnt_idx = darshan_path_trie_match(trie, path, &flags);
+    *excluded = (flags & PATH_EXCLUDED) != 0;
+    for(i = 0; !*excluded && i < NREGEXES; i++)
+    {
+        if(regexes[i].prefix_len &&
+            strncmp(path, regexes[i].str + 1, regexes[i].prefix_len))
+            continue;
+        if(regexec(&regexes[i].regex, path, 0, NULL, 0) == 0)
+            *excluded = 1;
+    }
+    if(*excluded && (flags & PATH_INCLUDED))
+        *excluded = 0;
+
+    return(mnt_idx);
+}
+
+static double now_ns(void)
+{
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return(tp.tv_sec * 1e9 + tp.tv_nsec);
+}
+
+int main(int argc, char **argv)
+{
+    char *roots[] = {"/scratch/u%d/tmp/", "/scratch/u%d/run/", "/home/user%d/",
+        "/home/user%d/.cache/", "/proj/p%02d/", "/proj/p07/ckpt_%d",
+        "/usr/lib/x%d/", "/var/opt/cray/dws/mounts/j%d/", "/tmp/%d/"};
+    int nroots = sizeof(roots)/sizeof(roots[0]);
+    long npaths = 1000000;
+    char (*paths)[128];
+    struct darshan_path_trie *trie = NULL;
+    int *linear_res, *trie_res;
+    long nexcluded = 0;
+    double start, linear_ns, trie_ns;
+    int excluded;
+    long i;
+    int n;
+
+    if(argc > 2)
+    {
+        fprintf(stderr, "Usage: %s [npaths]\n", argv[0]);
+        return(-1);
+    }
+    if(argc == 2)
+        npaths = atol(argv[1]);
+    if(npaths < 1)
+        npaths = 1;
+
+    paths = malloc(npaths * sizeof(*paths));
+    linear_res = malloc(npaths * sizeof(*linear_res));
+    trie_res = malloc(npaths * sizeof(*trie_res));
+    if(!paths || !linear_res || !trie_res)
+    {
+        fprintf(stderr, "Error: unable to allocate benchmark buffers\n");
+        return(-1);
+    }
+
+    /* synthetic mount table, sorted from longest to shortest path */
+    strcpy(mnt_paths[nmnts++], "/");
+    strcpy(mnt_paths[nmnts++], "/home");
+    strcpy(mnt_paths[nmnts++], "/scratch");
+    strcpy(mnt_paths[nmnts++], "/tmp");
+    while(nmnts < NMNTS)
+    {
+        sprintf(mnt_paths[nmnts], "/proj/p%02d", nmnts);
+        nmnts++;
+    }
+    qsort(mnt_paths, nmnts, sizeof(mnt_paths[0]), mnt_path_cmp);
+
+    for(n = 0; n < nmnts; n++)
+        darshan_path_trie_insert(&trie, mnt_paths[n], 0, n);
+    for(n = 0; include_dirs[n]; n++)
+        darshan_path_trie_insert(&trie, include_dirs[n], PATH_INCLUDED, -1);
+    for(n = 0; exclude_dirs[n]; n++)
+        darshan_path_trie_insert(&trie, exclude_dirs[n], PATH_EXCLUDED, -1);
+    for(n = 0; n < NREGEXES; n++)
+        regcomp(&regexes[n].regex, regexes[n].str, REG_EXTENDED);
+
+    srand(1);
+    for(i = 0; i < npaths; i++)
+    {
+        n = sprintf(paths[i], roots[rand() % nroots], rand() % 100);
+        sprintf(&paths[i][n], "dir%d/file%ld%s", rand() % 1000, i,
+            (rand() % 50) ? "" : ".lock");
+    }
+
+    start = now_ns();
+    for(i = 0; i < npaths; i++)
+        linear_res[i] = linear_match(paths[i], &excluded) * 2 + excluded;
+    linear_ns = (now_ns() - start) / npaths;
+
+    start = now_ns();
+    for(i = 0; i < npaths; i++)
+        trie_res[i] = trie_match(trie, paths[i], &excluded) * 2 + excluded;
+    trie_ns = (now_ns() - start) / npaths;
+
+    for(i = 0; i < npaths; i++)
+    {
+        if(linear_res[i] != trie_res[i])
+        {
+            fprintf(stderr, "Error: mismatched results for %s\n", paths[i]);
+            return(-1);
+        }
+        nexcluded += linear_res[i] & 1;
+    }
+
+    printf("# paths\texcluded\tlinear ns/path\ttrie ns/path\n");
+    printf("%ld\t%ld\t%.2f\t%.2f\n", npaths, nexcluded, linear_ns, trie_ns);
+
+    darshan_path_trie_destroy(trie);
+    for(n = 0; n < NREGEXES; n++)
+        regfree(&regexes[n].regex);
+    free(paths);
+    free(linear_res);
+    free(trie_res);
+    return(0);
+}
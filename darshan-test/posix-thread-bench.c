@@ -0,0 +1,182 @@
+/*
+ *  (C) 2025 by Argonne National Laboratory.
+ *      See COPYRIGHT in top-level directory.
+ */
+
+/* Benchmark for the scalability of Darshan's POSIX instrumentation when
+ * many threads issue small positional I/O operations to the same file.
+ *
+ * For each thread count from 1 to the given maximum (doubling each time),
+ * every thread issues a fixed number of pwrite()s followed by a fixed number
+ * of pread()s to disjoint regions of a shared file, and the aggregate
+ * operation rate is reported.  Run it with Darshan preloaded, both with and
+ * without DARSHAN_POSIX_THREAD_CACHE=1 set, to compare the locked and
+ * per-thread cached instrumentation paths.
+ *
+ * Arguments: [-t max_threads] [-n ops_per_thread] [-s io_size] filename
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include <mpi.h>
+
+struct thread_args
+{
+    int fd;
+    int tid;
+    int nops;
+    size_t io_size;
+    int err;
+};
+
+static void *thread_func(void *arg)
+{
+    struct thread_args *a = (struct thread_args *)arg;
+    char *buf;
+    off_t base;
+    int i;
+
+    buf = malloc(a->io_size);
+    if(!buf)
+    {
+        a->err = 1;
+        return(NULL);
+    }
+    memset(buf, 'a' + a->tid % 26, a->io_size);
+
+    base = (off_t)a->tid * a->nops * a->io_size;
+    for(i = 0; i < a->nops; i++)
+    {
+        if(pwrite(a->fd, buf, a->io_size, base + (off_t)i * a->io_size) !=
+            (ssize_t)a->io_size)
+        {
+            a->err = 1;
+            break;
+        }
+    }
+    for(i = 0; i < a->nops && !a->err; i++)
+    {
+        if(pread(a->fd, buf, a->io_size, base + (off_t)i * a->io_size) !=
+            (ssize_t)a->io_size)
+        {
+            a->err = 1;
+            break;
+        }
+    }
+
+    free(buf);
+    return(NULL);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-t max_threads] [-n ops_per_thread] "
+        "[-s io_size] filename\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    int max_threads = 16;
+    int nops = 100000;
+    size_t io_size = 16;
+    int nthreads, i, c, fd, rank;
+    int nerrs = 0;
+    pthread_t *threads;
+    struct thread_args *args;
+    double start, elapsed;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    while((c = getopt(argc, argv, "t:n:s:")) != -1)
+    {
+        switch(c)
+        {
+            case 't':
+                max_threads = atoi(optarg);
+                break;
+            case 'n':
+                nops = atoi(optarg);
+                break;
+            case 's':
+                io_size = (size_t)atol(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                MPI_Finalize();
+                return(-1);
+        }
+    }
+    if(optind != argc - 1 || max_threads < 1 || nops < 1 || io_size < 1)
+    {
+        usage(argv[0]);
+        MPI_Finalize();
+        return(-1);
+    }
+
+    /* only one rank is needed to measure intra-process scaling */
+    if(rank != 0)
+    {
+        MPI_Finalize();
+        return(0);
+    }
+
+    threads = malloc(max_threads * sizeof(*threads));
+    args = malloc(max_threads * sizeof(*args));
+    if(!threads || !args)
+    {
+        fprintf(stderr, "Error: unable to allocate thread state\n");
+        MPI_Finalize();
+        return(-1);
+    }
+
+    fd = open(argv[optind], O_CREAT | O_RDWR, 0644);
+    if(fd < 0)
+    {
+        perror("open");
+        MPI_Finalize();
+        return(-1);
+    }
+
+    printf("# threads\tops\tseconds\tops/sec\n");
+    for(nthreads = 1; nthreads <= max_threads; nthreads *= 2)
+    {
+        start = MPI_Wtime();
+        for(i = 0; i < nthreads; i++)
+        {
+            args[i].fd = fd;
+            args[i].tid = i;
+            args[i].nops = nops;
+            args[i].io_size = io_size;
+            args[i].err = 0;
+            pthread_create(&threads[i], NULL, thread_func, &args[i]);
+        }
+        for(i = 0; i < nthreads; i++)
+        {
+            pthread_join(threads[i], NULL);
+            nerrs += args[i].err;
+        }
+        elapsed = MPI_Wtime() - start;
+
+        printf("%d\t%ld\t%f\t%f\n", nthreads, 2L * nthreads * nops, elapsed,
+            (2.0 * nthreads * nops) / elapsed);
+    }
+
+    close(fd);
+    unlink(argv[optind]);
+    free(threads);
+    free(args);
+
+    if(nerrs)
+        fprintf(stderr, "Error: %d threads failed to complete their I/O\n", nerrs);
+
+    MPI_Finalize();
+    return(nerrs ? -1 : 0);
+}
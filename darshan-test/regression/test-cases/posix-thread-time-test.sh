@@ -0,0 +1,57 @@
+#!/bin/bash
+
+PROG=posix-thread-time-test
+
+# compile
+$DARSHAN_CC $DARSHAN_TESTDIR/test-cases/src/${PROG}.c -o $DARSHAN_TMP/${PROG} -lpthread
+if [ $? -ne 0 ]; then
+    echo "Error: failed to compile ${PROG}" 1>&2
+    exit 1
+fi
+
+# run once using the locked path and once using the POSIX thread cache; in
+# both cases the write time reported for each file must account for the
+# time that the two threads spent (taking turns) in pwrite()
+for THREAD_CACHE in 0 1; do
+    # set log file path; remove previous log if present
+    export DARSHAN_LOGFILE=$DARSHAN_TMP/${PROG}.${THREAD_CACHE}.darshan
+    rm -f ${DARSHAN_LOGFILE}
+    rm -f $DARSHAN_TMP/${PROG}.tmp.dat.*
+
+    # execute
+    if [ $THREAD_CACHE -eq 1 ]; then
+        export DARSHAN_POSIX_THREAD_CACHE=1
+    else
+        unset DARSHAN_POSIX_THREAD_CACHE
+    fi
+    $DARSHAN_RUNJOB $DARSHAN_TMP/${PROG} -f $DARSHAN_TMP/${PROG}.tmp.dat
+    if [ $? -ne 0 ]; then
+        echo "Error: failed to execute ${PROG}" 1>&2
+        exit 1
+    fi
+    unset DARSHAN_POSIX_THREAD_CACHE
+
+    # parse log
+    $DARSHAN_UTIL_PATH/bin/darshan-parser $DARSHAN_LOGFILE > $DARSHAN_TMP/${PROG}.${THREAD_CACHE}.darshan.txt
+    if [ $? -ne 0 ]; then
+        echo "Error: failed to parse ${DARSHAN_LOGFILE}" 1>&2
+        exit 1
+    fi
+
+    # check results
+    for TIME_FILE in $DARSHAN_TMP/${PROG}.tmp.dat.*.time; do
+        DATA_FILE=${TIME_FILE%.time}
+        MEASURED_TIME=`cat $TIME_FILE`
+        WRITE_TIME=`grep POSIX_F_WRITE_TIME $DARSHAN_TMP/${PROG}.${THREAD_CACHE}.darshan.txt | grep -vE "^#" | grep -E "[[:space:]]${DATA_FILE}[[:space:]]" | cut -f 5`
+        if [ -z "$WRITE_TIME" ]; then
+            echo "Error: no POSIX record for $DATA_FILE, thread cache $THREAD_CACHE" 1>&2
+            exit 1
+        fi
+        if [ $(echo "$WRITE_TIME < 0.9 * $MEASURED_TIME" | bc -l) -eq 1 ]; then
+            echo "Error: POSIX_F_WRITE_TIME $WRITE_TIME is less than the measured write time $MEASURED_TIME for $DATA_FILE, thread cache $THREAD_CACHE" 1>&2
+            exit 1
+        fi
+    done
+done
+
+exit 0
@@ -0,0 +1,130 @@
+/*
+ *  (C) 2026 by Argonne National Laboratory.
+ *      See COPYRIGHT in top-level directory.
+ */
+
+/* Two threads take turns issuing large pwrite()s to the same file, so
+ * that their writes interleave in time without overlapping.  Each process
+ * writes its own file (<file>.<rank>) and stores the total time spent in
+ * pwrite() in <file>.<rank>.time, to be compared against the
+ * POSIX_F_WRITE_TIME that Darshan reports for the file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <mpi.h>
+
+#define NTHREADS 2
+#define NWRITES 16
+#define WRITE_SIZE (8*1024*1024)
+
+static int fd;
+static int turn = 0;
+static double busy_time = 0;
+static pthread_mutex_t turn_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t turn_cond = PTHREAD_COND_INITIALIZER;
+
+static double wtime(void)
+{
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return(tp.tv_sec + tp.tv_nsec * 1e-9);
+}
+
+static void *writer(void *arg)
+{
+    int tid = (int)(long)arg;
+    char *buf;
+    double tm1, tm2;
+    int i;
+
+    buf = malloc(WRITE_SIZE);
+    if(!buf)
+        return((void *)1);
+    memset(buf, 'a' + tid, WRITE_SIZE);
+
+    for(i = tid; i < NTHREADS * NWRITES; i += NTHREADS)
+    {
+        pthread_mutex_lock(&turn_mutex);
+        while(turn != i)
+            pthread_cond_wait(&turn_cond, &turn_mutex);
+        pthread_mutex_unlock(&turn_mutex);
+
+        tm1 = wtime();
+        if(pwrite(fd, buf, WRITE_SIZE, (off_t)i * WRITE_SIZE) != WRITE_SIZE)
+        {
+            perror("pwrite");
+            free(buf);
+            return((void *)1);
+        }
+        tm2 = wtime();
+
+        pthread_mutex_lock(&turn_mutex);
+        busy_time += tm2 - tm1;
+        turn++;
+        pthread_cond_broadcast(&turn_cond);
+        pthread_mutex_unlock(&turn_mutex);
+    }
+
+    free(buf);
+    return(NULL);
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t threads[NTHREADS];
+    char path[256];
+    void *thread_ret;
+    FILE *time_fp;
+    int rank;
+    int err = 0;
+    long i;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if(argc != 3 || strcmp(argv[1], "-f"))
+    {
+        fprintf(stderr, "Usage: %s -f <file>\n", argv[0]);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    snprintf(path, sizeof(path), "%s.%d", argv[2], rank);
+    fd = open(path, O_CREAT|O_TRUNC|O_WRONLY, S_IRUSR|S_IWUSR);
+    if(fd < 0)
+    {
+        perror("open");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    for(i = 0; i < NTHREADS; i++)
+        pthread_create(&threads[i], NULL, writer, (void *)i);
+    for(i = 0; i < NTHREADS; i++)
+    {
+        pthread_join(threads[i], &thread_ret);
+        if(thread_ret)
+            err = 1;
+    }
+    close(fd);
+    unlink(path);
+
+    snprintf(path, sizeof(path), "%s.%d.time", argv[2], rank);
+    time_fp = fopen(path, "w");
+    if(!time_fp)
+    {
+        perror("fopen");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    fprintf(time_fp, "%lf\n", busy_time);
+    fclose(time_fp);
+
+    MPI_Finalize();
+    return(err);
+}
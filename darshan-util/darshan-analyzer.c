@@ -14,14 +14,22 @@
 #include <assert.h>
 #include <ftw.h>
 #include <zlib.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "darshan-logutils.h"
+#include "uthash-1.9.2/src/uthash.h"
 
 #define BUCKET1 0.20
 #define BUCKET2 0.40
 #define BUCKET3 0.60
 #define BUCKET4 0.80
 
+/* number of POSIX records read from a log at a time */
+#define PSX_BATCH_RECS 256
+
 int total_shared = 0;
 int total_fpp    = 0;
 int total_mpio   = 0;
@@ -35,25 +43,60 @@ int bucket3 = 0;
 int bucket4 = 0;
 int bucket5 = 0;
 
+/* logs processed (rather than restored from a checkpoint) in this run */
+int run_count = 0;
+
+/* paths of logs already recorded in the checkpoint file */
+struct checkpoint_entry
+{
+    char *path;
+    UT_hash_handle hlink;
+};
+
+struct checkpoint_entry *checkpoint_hash = NULL;
+FILE *checkpoint_file = NULL;
+
+/* bounded queue of log paths handed from the directory walk to the worker
+ * threads, so that logs are processed while the tree is still being walked
+ */
+struct analyzer_queue
+{
+    char **paths;
+    int size;
+    int head;
+    int count;
+    int done;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+int njobs = 1;
+struct analyzer_queue queue;
+
 int process_log(const char *fname, double *io_ratio, int *used_mpio, int *used_pnet, int *used_hdf5, int *used_shared, int *used_fpp)
 {
     int ret;
     darshan_fd file;
     struct darshan_job job;
-    struct darshan_mod_logutil_funcs *psx_mod = mod_logutils[DARSHAN_POSIX_MOD];
-    struct darshan_posix_file psx_rec;
-    void *psx_rec_p = &psx_rec;
+    struct darshan_posix_file *psx_recs;
+    int nrecs;
     int f_count;
+    int i;
     double total_io_time;
     double total_job_time;
 
-    assert(psx_mod);
-    memset(psx_rec_p, 0, sizeof(struct darshan_posix_file));
+    /* only the header, the job record and the POSIX module data are read
+     * from each log; the other module checks only need the header
+     */
+    psx_recs = malloc(PSX_BATCH_RECS * sizeof(*psx_recs));
+    if (psx_recs == NULL)
+        return -1;
 
     file = darshan_log_open(fname);
     if (file == NULL)
     {
         fprintf(stderr, "darshan_log_open() failed to open %s.\n", fname);
+        free(psx_recs);
         return -1;
     }
 
@@ -62,27 +105,35 @@ int process_log(const char *fname, double *io_ratio, int *used_mpio, int *used_p
     {
         fprintf(stderr, "darshan_log_get_job() failed on file %s.\n", fname);
         darshan_log_close(file);
+        free(psx_recs);
         return -1;
     }
 
     f_count = 0;
     total_io_time = 0.0;
 
-    while((ret = psx_mod->log_get_record(file, &psx_rec_p)) == 1)
+    do
     {
-        f_count   += 1;
-
-        if (psx_rec.base_rec.rank == -1)
-            *used_shared = 1;
-        else
-            *used_fpp = 1;
-
-        total_io_time += (psx_rec.fcounters[POSIX_F_READ_TIME] +
-                         psx_rec.fcounters[POSIX_F_WRITE_TIME] +
-                         psx_rec.fcounters[POSIX_F_META_TIME]);
-
-        memset(psx_rec_p, 0, sizeof(struct darshan_posix_file));
-    }
+        ret = darshan_log_get_records(file, DARSHAN_POSIX_MOD, psx_recs,
+            PSX_BATCH_RECS, &nrecs);
+        if (ret < 0)
+            break;
+
+        for (i = 0; i < nrecs; i++)
+        {
+            f_count   += 1;
+
+            if (psx_recs[i].base_rec.rank < 0)
+                *used_shared = 1;
+            else
+                *used_fpp = 1;
+
+            total_io_time += (psx_recs[i].fcounters[POSIX_F_READ_TIME] +
+                             psx_recs[i].fcounters[POSIX_F_WRITE_TIME] +
+                             psx_recs[i].fcounters[POSIX_F_META_TIME]);
+        }
+    } while (nrecs == PSX_BATCH_RECS);
+    free(psx_recs);
     if (ret < 0)
     {
         fprintf(stderr, "Error: unable to read posix file record in log file %s.\n", fname);
@@ -113,19 +164,12 @@ int process_log(const char *fname, double *io_ratio, int *used_mpio, int *used_p
     return 0;
 }
 
-int tree_walk (const char *fpath, const struct stat *sb, int typeflag)
+/* add the results of one log to the totals (and to the checkpoint file,
+ * unless they were just read back from it)
+ */
+void record_result(const char *fpath, double io_ratio, int used_mpio, int used_pnet,
+    int used_hdf5, int used_shared, int used_fpp, int checkpoint)
 {
-    double io_ratio = 0.0;
-    int used_mpio = 0;
-    int used_pnet = 0;
-    int used_hdf5 = 0;
-    int used_shared = 0;
-    int used_fpp = 0;
-
-    if (typeflag != FTW_F) return 0;
-
-    process_log(fpath,&io_ratio,&used_mpio,&used_pnet,&used_hdf5,&used_shared,&used_fpp);
-
     total_count++;
 
     if (used_mpio > 0) total_mpio++;
@@ -145,28 +189,322 @@ int tree_walk (const char *fpath, const struct stat *sb, int typeflag)
     else if (io_ratio > BUCKET4)
         bucket5++;
 
+    if (checkpoint && checkpoint_file)
+    {
+        /* one line per log, flushed so an interrupted run can resume */
+        fprintf(checkpoint_file, "%.17g\t%d\t%d\t%d\t%d\t%d\t%s\n", io_ratio,
+            used_mpio, used_pnet, used_hdf5, used_shared, used_fpp, fpath);
+        fflush(checkpoint_file);
+    }
+}
+
+void analyze_log(const char *fpath)
+{
+    double io_ratio = 0.0;
+    int used_mpio = 0;
+    int used_pnet = 0;
+    int used_hdf5 = 0;
+    int used_shared = 0;
+    int used_fpp = 0;
+
+    process_log(fpath,&io_ratio,&used_mpio,&used_pnet,&used_hdf5,&used_shared,&used_fpp);
+
+    if (njobs > 1)
+        pthread_mutex_lock(&queue.mutex);
+    run_count++;
+    record_result(fpath, io_ratio, used_mpio, used_pnet, used_hdf5, used_shared,
+        used_fpp, 1);
+    if (njobs > 1)
+        pthread_mutex_unlock(&queue.mutex);
+}
+
+void *analyze_thread(void *arg)
+{
+    char *fpath;
+
+    while (1)
+    {
+        pthread_mutex_lock(&queue.mutex);
+        while (queue.count == 0 && !queue.done)
+            pthread_cond_wait(&queue.cond, &queue.mutex);
+        if (queue.count == 0)
+        {
+            pthread_mutex_unlock(&queue.mutex);
+            break;
+        }
+        fpath = queue.paths[queue.head];
+        queue.head = (queue.head + 1) % queue.size;
+        queue.count--;
+        pthread_cond_broadcast(&queue.cond);
+        pthread_mutex_unlock(&queue.mutex);
+
+        analyze_log(fpath);
+        free(fpath);
+    }
+
+    return NULL;
+}
+
+/* restore the results recorded in a previous run's checkpoint file */
+int load_checkpoint(const char *checkpoint_path)
+{
+    FILE *f;
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t len;
+    off_t valid_len = 0;
+    struct checkpoint_entry *entry;
+    double io_ratio;
+    int used_mpio, used_pnet, used_hdf5, used_shared, used_fpp;
+    int path_off;
+
+    f = fopen(checkpoint_path, "r");
+    if (f == NULL)
+        return 0; /* nothing to resume */
+
+    while ((len = getline(&line, &line_size, f)) > 0)
+    {
+        /* drop a partially written last line, so that new results are
+         * appended after the last complete one
+         */
+        if (line[len-1] != '\n')
+        {
+            if (truncate(checkpoint_path, valid_len) < 0)
+            {
+                fprintf(stderr, "Error: unable to truncate checkpoint file %s.\n", checkpoint_path);
+                free(line);
+                fclose(f);
+                return -1;
+            }
+            break;
+        }
+        valid_len += len;
+        line[len-1] = '\0';
+
+        path_off = 0;
+        if (sscanf(line, "%lf\t%d\t%d\t%d\t%d\t%d\t%n", &io_ratio, &used_mpio,
+            &used_pnet, &used_hdf5, &used_shared, &used_fpp, &path_off) != 6 ||
+            path_off == 0)
+        {
+            fprintf(stderr, "Error: invalid line in checkpoint file %s.\n", checkpoint_path);
+            free(line);
+            fclose(f);
+            return -1;
+        }
+
+        HASH_FIND(hlink, checkpoint_hash, line + path_off, strlen(line + path_off), entry);
+        if (entry)
+            continue;
+        entry = malloc(sizeof(*entry));
+        if (entry)
+            entry->path = strdup(line + path_off);
+        if (!entry || !entry->path)
+        {
+            fprintf(stderr, "Error: unable to allocate checkpoint state.\n");
+            free(entry);
+            free(line);
+            fclose(f);
+            return -1;
+        }
+        HASH_ADD_KEYPTR(hlink, checkpoint_hash, entry->path, strlen(entry->path), entry);
+
+        record_result(entry->path, io_ratio, used_mpio, used_pnet, used_hdf5,
+            used_shared, used_fpp, 0);
+    }
+
+    free(line);
+    fclose(f);
+    return 0;
+}
+
+int tree_walk (const char *fpath, const struct stat *sb, int typeflag)
+{
+    struct checkpoint_entry *entry;
+    char *path;
+
+    if (typeflag != FTW_F) return 0;
+
+    if (checkpoint_hash)
+    {
+        HASH_FIND(hlink, checkpoint_hash, fpath, strlen(fpath), entry);
+        if (entry)
+            return 0;
+    }
+
+    if (njobs == 1)
+    {
+        analyze_log(fpath);
+        return 0;
+    }
+
+    path = strdup(fpath);
+    if (path == NULL)
+        return -1;
+
+    pthread_mutex_lock(&queue.mutex);
+    while (queue.count == queue.size)
+        pthread_cond_wait(&queue.cond, &queue.mutex);
+    queue.paths[(queue.head + queue.count) % queue.size] = path;
+    queue.count++;
+    pthread_cond_broadcast(&queue.cond);
+    pthread_mutex_unlock(&queue.mutex);
+
     return 0;
 }
 
+void usage(char *exename)
+{
+    fprintf(stderr, "Usage: %s [options] <directory>\n", exename);
+    fprintf(stderr, "       Summarizes the access methods used by all Darshan logs in a directory tree.\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "\t--help \t\tprints this help message and exits\n");
+    fprintf(stderr, "\t--version \tprints Darshan version number and exits\n");
+    fprintf(stderr, "\t-j, --jobs\tNumber of logs to process in parallel (default: 1).\n");
+    fprintf(stderr, "\t--checkpoint\tFile recording the results of each log, used to resume an\n");
+    fprintf(stderr, "\t\t\tinterrupted run (logs already in the file are skipped).\n");
+
+    exit(1);
+}
+
+void parse_args(int argc, char **argv, char **base, char **checkpoint_path)
+{
+    int index;
+    char *check;
+    static struct option long_opts[] =
+    {
+        {"jobs", required_argument, NULL, 'j'},
+        {"checkpoint", required_argument, NULL, 'c'},
+        {"version",  0, NULL, 'v'},
+        {"help",  0, NULL, 0},
+        {0, 0, 0, 0}
+    };
+
+    *checkpoint_path = NULL;
+
+    while(1)
+    {
+        int c = getopt_long(argc, argv, "j:", long_opts, &index);
+
+        if(c == -1) break;
+
+        switch(c)
+        {
+            case 'j':
+                njobs = strtol(optarg, &check, 10);
+                if(optarg == check || njobs < 1)
+                {
+                    fprintf(stderr, "Error: invalid number of jobs.\n");
+                    exit(1);
+                }
+                break;
+            case 'c':
+                *checkpoint_path = optarg;
+                break;
+            case 'v':
+                printf("%s\n", PACKAGE_VERSION);
+                exit(0);
+            case '?':
+            default:
+                usage(argv[0]);
+                break;
+        }
+    }
+
+    if(optind + 1 == argc)
+    {
+        *base = argv[optind];
+    }
+    else
+    {
+        usage(argv[0]);
+    }
+
+    return;
+}
+
+static double wtime(void)
+{
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return(tp.tv_sec + tp.tv_nsec / 1e9);
+}
+
 int main(int argc, char **argv)
 {
     char * base = NULL;
+    char *checkpoint_path = NULL;
+    pthread_t *threads = NULL;
+    struct checkpoint_entry *entry, *tmp;
+    double start, elapsed;
     int ret = 0;
+    int i;
+
+    parse_args(argc, argv, &base, &checkpoint_path);
 
-    if(argc != 2)
+    if (checkpoint_path)
     {
-        fprintf(stderr, "Usage: darshan-analyzer --version | <directory>\n");
-        fprintf(stderr, "       '--version' or directory of Darshan logs required as argument.\n");
-        return(-1);
+        if (load_checkpoint(checkpoint_path) < 0)
+            return(-1);
+        checkpoint_file = fopen(checkpoint_path, "a");
+        if (checkpoint_file == NULL)
+        {
+            fprintf(stderr, "Error: unable to open checkpoint file %s.\n", checkpoint_path);
+            return(-1);
+        }
     }
 
-    base = argv[1];
-    if (!strcmp(base, "--version")) {
-        printf("%s\n",PACKAGE_VERSION);
-        exit(0);
+    start = wtime();
+
+    if (njobs > 1)
+    {
+        queue.size = 4 * njobs;
+        queue.paths = malloc(queue.size * sizeof(*queue.paths));
+        threads = malloc(njobs * sizeof(*threads));
+        if (!queue.paths || !threads)
+        {
+            fprintf(stderr, "Error: unable to allocate worker state.\n");
+            return(-1);
+        }
+        pthread_mutex_init(&queue.mutex, NULL);
+        pthread_cond_init(&queue.cond, NULL);
+        for (i = 0; i < njobs; i++)
+        {
+            if (pthread_create(&threads[i], NULL, analyze_thread, NULL) != 0)
+            {
+                fprintf(stderr, "Error: unable to create worker thread.\n");
+                return(-1);
+            }
+        }
     }
 
     ret = ftw(base, tree_walk, 512);
+
+    if (njobs > 1)
+    {
+        pthread_mutex_lock(&queue.mutex);
+        queue.done = 1;
+        pthread_cond_broadcast(&queue.cond);
+        pthread_mutex_unlock(&queue.mutex);
+        for (i = 0; i < njobs; i++)
+            pthread_join(threads[i], NULL);
+        pthread_mutex_destroy(&queue.mutex);
+        pthread_cond_destroy(&queue.cond);
+        free(queue.paths);
+        free(threads);
+    }
+
+    elapsed = wtime() - start;
+
+    if (checkpoint_file)
+        fclose(checkpoint_file);
+    HASH_ITER(hlink, checkpoint_hash, entry, tmp)
+    {
+        HASH_DELETE(hlink, checkpoint_hash, entry);
+        free(entry->path);
+        free(entry);
+    }
+
     if(ret != 0)
     {
         fprintf(stderr, "Error: failed to walk path: %s\n", base);
@@ -186,6 +524,8 @@ int main(int argc, char **argv)
     printf ("%.2lf-%.2lf: %d\n", (double)BUCKET2, (double)BUCKET3, bucket3);
     printf ("%.2lf-%.2lf: %d\n", (double)BUCKET3, (double)BUCKET4, bucket4);
     printf ("%.2lf-%.2lf: %d\n", (double)BUCKET4, (double)1.0,   bucket5);
+    printf("\nprocessed %d logs in %.2lf seconds: %.2lf logs/sec\n", run_count,
+        elapsed, elapsed > 0 ? run_count / elapsed : 0.0);
     return 0;
 }
 
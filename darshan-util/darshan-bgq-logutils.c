@@ -45,6 +45,7 @@ static void darshan_log_print_bgq_description(int ver);
 static void darshan_log_print_bgq_rec_diff(void *file_rec1, char *file_name1,
     void *file_rec2, char *file_name2);
 static void darshan_log_agg_bgq_recs(void *rec, void *agg_rec, int init_flag);
+static int darshan_log_sizeof_bgq_rec(void* bgq_buf_p);
 
 struct darshan_mod_logutil_funcs bgq_logutils =
 {
@@ -53,9 +54,16 @@ struct darshan_mod_logutil_funcs bgq_logutils =
     .log_print_record = &darshan_log_print_bgq_rec,
     .log_print_description = &darshan_log_print_bgq_description,
     .log_print_diff = &darshan_log_print_bgq_rec_diff,
-    .log_agg_records = &darshan_log_agg_bgq_recs
+    .log_agg_records = &darshan_log_agg_bgq_recs,
+    .log_sizeof_record = &darshan_log_sizeof_bgq_rec
 };
 
+static int darshan_log_sizeof_bgq_rec(void* bgq_buf_p)
+{
+    /* BG/Q records have a fixed size */
+    return(sizeof(struct darshan_bgq_record));
+}
+
 static int darshan_log_get_bgq_rec(darshan_fd fd, void** bgq_buf_p)
 {
     struct darshan_bgq_record *rec = *((struct darshan_bgq_record **)bgq_buf_p);
@@ -29,9 +29,13 @@ int usage (char *exename)
     fprintf(stderr, "Usage: %s [options] <infile> <outfile>\n", exename);
     fprintf(stderr, "       Converts darshan log from infile to outfile.\n");
     fprintf(stderr, "       rewrites the log file into the newest format.\n");
+    fprintf(stderr, "       --format <arrow|parquet> Export the log's name records and module\n");
+    fprintf(stderr, "                records as columnar tables named <outfile>.<table>.<format>.\n");
     fprintf(stderr, "       --help prints this help message and exits\n");
     fprintf(stderr, "       --version prints Darshan version number and exits\n");
     fprintf(stderr, "       --bzip2 Use bzip2 compression instead of zlib.\n");
+    fprintf(stderr, "       --zstd Use zstd compression instead of zlib.\n");
+    fprintf(stderr, "       --nocomp Write the log uncompressed, for faster reads.\n");
     fprintf(stderr, "       --obfuscate Obfuscate all items in the log.\n");
     fprintf(stderr, "       --obfuscate_jobid Obfuscate job ID in the log.\n");
     fprintf(stderr, "       --obfuscate_uid Obfuscate uid in the log.\n");
@@ -45,7 +49,8 @@ int usage (char *exename)
     exit(1);
 }
 
-void parse_args (int argc, char **argv, char **infile, char **outfile, int *bzip2,
+void parse_args (int argc, char **argv, char **infile, char **outfile,
+		 enum darshan_comp_type *comp_type, int *columnar_format,
 		 int *obfuscate_jobid, int *obfuscate_uid, int *obfuscate_exe, int *obfuscate_names,
 		 int *reset_md, int *key, char **annotate, uint64_t* hash)
 {
@@ -55,6 +60,9 @@ void parse_args (int argc, char **argv, char **infile, char **outfile, int *bzip
     static struct option long_opts[] =
     {
         {"bzip2", 0, NULL, 'b'},
+        {"zstd", 0, NULL, 'z'},
+        {"nocomp", 0, NULL, 'c'},
+        {"format", 1, NULL, 'F'},
         {"annotate", 1, NULL, 'a'},
         {"obfuscate", 0, NULL, 'o'},
         {"obfuscate_jobid", 0, NULL, 'j'},
@@ -69,7 +77,8 @@ void parse_args (int argc, char **argv, char **infile, char **outfile, int *bzip
         { 0, 0, 0, 0 }
     };
 
-    *bzip2 = 0;
+    *comp_type = DARSHAN_ZLIB_COMP;
+    *columnar_format = -1;
     *obfuscate_jobid = 0;
     *obfuscate_uid = 0;
     *obfuscate_exe = 0;
@@ -87,7 +96,21 @@ void parse_args (int argc, char **argv, char **infile, char **outfile, int *bzip
         switch(c)
         {
             case 'b':
-                *bzip2 = 1;
+                *comp_type = DARSHAN_BZIP2_COMP;
+                break;
+            case 'z':
+                *comp_type = DARSHAN_ZSTD_COMP;
+                break;
+            case 'c':
+                *comp_type = DARSHAN_NO_COMP;
+                break;
+            case 'F':
+                if(strcmp(optarg, "arrow") == 0)
+                    *columnar_format = DARSHAN_COLUMNAR_ARROW;
+                else if(strcmp(optarg, "parquet") == 0)
+                    *columnar_format = DARSHAN_COLUMNAR_PARQUET;
+                else
+                    usage(argv[0]);
                 break;
             case 'a':
                 *annotate = optarg;
@@ -301,6 +324,65 @@ static void remove_hash_recs(struct darshan_name_record_ref **name_hash,
     return;
 }
 
+/* export the log as a set of columnar tables instead of converting it */
+static int export_columnar(char *infile_name, char *prefix, int format)
+{
+    darshan_fd infile;
+    char path[4096];
+    char mod_name[64];
+    const char *ext = (format == DARSHAN_COLUMNAR_ARROW) ? "arrow" : "parquet";
+    int i, j;
+    int ret;
+
+    infile = darshan_log_open(infile_name);
+    if(!infile)
+        return(-1);
+
+    snprintf(path, sizeof(path), "%s.names.%s", prefix, ext);
+    ret = darshan_log_export_names(infile, format, path);
+    if(ret < 0)
+    {
+        darshan_log_close(infile);
+        return(-1);
+    }
+
+    for(i=0; i<DARSHAN_MAX_MODS; i++)
+    {
+        if(infile->mod_map[i].len == 0)
+            continue;
+        else if(i >= DARSHAN_KNOWN_MODULE_COUNT || !mod_logutils[i])
+        {
+            fprintf(stderr, "# Warning: module id %d can't be parsed, SKIPPING.\n", i);
+            continue;
+        }
+
+        /* module names like "BG/Q" are not valid file names as is */
+        snprintf(mod_name, sizeof(mod_name), "%s", darshan_module_names[i]);
+        for(j=0; mod_name[j]; j++)
+        {
+            if(mod_name[j] == '/')
+                mod_name[j] = '_';
+        }
+
+        snprintf(path, sizeof(path), "%s.%s.%s", prefix, mod_name, ext);
+        ret = darshan_log_export_module(infile, i, format, path);
+        if(ret < 0)
+        {
+            darshan_log_close(infile);
+            return(-1);
+        }
+        else if(ret == 1)
+        {
+            fprintf(stderr, "# Warning: no columnar layout defined "
+                "for module %s, SKIPPING.\n", darshan_module_names[i]);
+        }
+    }
+
+    darshan_log_close(infile);
+
+    return(0);
+}
+
 int main(int argc, char **argv)
 {
     int ret;
@@ -317,22 +399,24 @@ int main(int argc, char **argv)
     struct darshan_name_record_ref *ref, *tmp;
     char *mod_buf, *tmp_mod_buf;
     enum darshan_comp_type comp_type;
-    int bzip2;
+    int columnar_format;
     int obfuscate_jobid, obfuscate_uid, obfuscate_exe, obfuscate_names;
     int key;
     char *annotation = NULL;
     darshan_record_id hash;
     int reset_md;
 
-    parse_args(argc, argv, &infile_name, &outfile_name, &bzip2,
+    parse_args(argc, argv, &infile_name, &outfile_name, &comp_type, &columnar_format,
                &obfuscate_jobid, &obfuscate_uid, &obfuscate_exe, &obfuscate_names,
                &reset_md, &key, &annotation, &hash);
 
+    if(columnar_format >= 0)
+        return(export_columnar(infile_name, outfile_name, columnar_format));
+
     infile = darshan_log_open(infile_name);
     if(!infile)
         return(-1);
  
-    comp_type = bzip2 ? DARSHAN_BZIP2_COMP : DARSHAN_ZLIB_COMP;
     outfile = darshan_log_create(outfile_name, comp_type, infile->partial_flag);
     if(!outfile)
     {
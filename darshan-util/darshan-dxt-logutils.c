@@ -35,6 +35,7 @@ static void dxt_log_print_mpiio_file_darshan(void *file_rec,
 
 static void dxt_swap_file_record(struct dxt_file_record *file_rec);
 static void dxt_swap_file_record(struct dxt_file_record *file_rec);
+static int dxt_log_sizeof_file(void* dxt_buf_p);
 
 struct darshan_mod_logutil_funcs dxt_posix_logutils =
 {
@@ -44,8 +45,18 @@ struct darshan_mod_logutil_funcs dxt_posix_logutils =
     .log_print_description = NULL,
     .log_print_diff = NULL,
     .log_agg_records = NULL,
+    .log_sizeof_record = &dxt_log_sizeof_file,
 };
 
+static int dxt_log_sizeof_file(void* dxt_buf_p)
+{
+    struct dxt_file_record *file_rec = (struct dxt_file_record *)dxt_buf_p;
+
+    /* the trace segments trail the fixed-size portion of the record */
+    return(sizeof(struct dxt_file_record) + (sizeof(segment_info) *
+        (file_rec->write_count + file_rec->read_count)));
+}
+
 struct darshan_mod_logutil_funcs dxt_mpiio_logutils =
 {
     .log_get_record = &dxt_log_get_mpiio_file,
@@ -54,6 +65,7 @@ struct darshan_mod_logutil_funcs dxt_mpiio_logutils =
     .log_print_description = NULL,
     .log_print_diff = NULL,
     .log_agg_records = NULL,
+    .log_sizeof_record = &dxt_log_sizeof_file,
 };
 
 static void dxt_swap_file_record(struct dxt_file_record *file_rec)
@@ -25,13 +25,15 @@
 
 #define OPTION_SHOW_INCOMPLETE  (1 << 7)  /* show what we have, even if log is incomplete */
 #define OPTION_VERSION          (1 << 4)  /* print Darshan version number */
+#define OPTION_THREADS          (1 << 8)  /* decompress log data with multiple threads */
 
 static int usage (char *exename);
-static int parse_args (int argc, char **argv, char **filename);
+static int parse_args (int argc, char **argv, char **filename, int *nthreads);
 
 int main(int argc, char **argv)
 {
     int mask;
+    int nthreads;
     int ret;
     int i, j;
     char *filename;
@@ -52,12 +54,18 @@ int main(int argc, char **argv)
     struct lustre_record_ref *lustre_rec_hash = NULL;
     char *mod_buf = NULL;
 
-    mask = parse_args(argc, argv, &filename);
+    mask = parse_args(argc, argv, &filename, &nthreads);
 
     fd = darshan_log_open(filename);
     if (!fd)
         return(-1);
 
+    if (nthreads > 1 && darshan_log_set_threads(fd, nthreads) < 0)
+    {
+        darshan_log_close(fd);
+        return(-1);
+    }
+
     /* read darshan job info */
     ret = darshan_log_get_job(fd, &job);
     if (ret < 0)
@@ -99,6 +107,8 @@ int main(int argc, char **argv)
         comp_str = "BZIP2";
     else if (fd->comp_type == DARSHAN_NO_COMP)
         comp_str = "NONE";
+    else if (fd->comp_type == DARSHAN_ZSTD_COMP)
+        comp_str = "ZSTD";
     else
         comp_str = "UNKNOWN";
 
@@ -358,7 +368,7 @@ cleanup:
     return(ret);
 }
 
-static int parse_args (int argc, char **argv, char **filename)
+static int parse_args (int argc, char **argv, char **filename, int *nthreads)
 {
     int index;
     int mask;
@@ -366,11 +376,13 @@ static int parse_args (int argc, char **argv, char **filename)
     {
         {"show-incomplete", 0, NULL, OPTION_SHOW_INCOMPLETE},
         {"version",  0, NULL, OPTION_VERSION},
+        {"threads", 1, NULL, OPTION_THREADS},
         {"help",  0, NULL, 0},
         {0, 0, 0, 0}
     };
 
     mask = 0;
+    *nthreads = 1;
 
     while(1)
     {
@@ -383,6 +395,11 @@ static int parse_args (int argc, char **argv, char **filename)
             case OPTION_SHOW_INCOMPLETE:
                 mask |= c;
                 break;
+            case OPTION_THREADS:
+                *nthreads = atoi(optarg);
+                if (*nthreads < 1)
+                    usage(argv[0]);
+                break;
             case OPTION_VERSION:
                 printf("%s\n",PACKAGE_VERSION);
                 exit(0);
@@ -412,6 +429,7 @@ static int usage (char *exename)
     fprintf(stderr, "    --help prints this help message and exits\n");
     fprintf(stderr, "    --version prints Darshan version number and exits\n");
     fprintf(stderr, "    --show-incomplete : display results even if log is incomplete\n");
+    fprintf(stderr, "    --threads <N> : decompress log data using N threads\n");
 
     exit(1);
 }
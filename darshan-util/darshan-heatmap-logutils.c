@@ -28,6 +28,7 @@ static int darshan_log_put_heatmap_record(darshan_fd fd, void* heatmap_buf);
 static void darshan_log_print_heatmap_record(void *file_rec,
     char *file_name, char *mnt_pt, char *fs_type);
 static void darshan_log_print_heatmap_description(int ver);
+static int darshan_log_sizeof_heatmap_record(void* heatmap_buf_p);
 
 /* structure storing each function needed for implementing the darshan
  * logutil interface. these functions are used for reading, writing, and
@@ -46,9 +47,18 @@ struct darshan_mod_logutil_funcs heatmap_logutils =
     /* _agg is deliberately not implemented; there are no shared records in
      * the heatmap; it is always reported per process
      */
-    .log_agg_records = NULL
+    .log_agg_records = NULL,
+    .log_sizeof_record = &darshan_log_sizeof_heatmap_record
 };
 
+static int darshan_log_sizeof_heatmap_record(void* heatmap_buf_p)
+{
+    struct darshan_heatmap_record *rec = (struct darshan_heatmap_record *)heatmap_buf_p;
+
+    /* the write and read bins trail the fixed-size portion of the record */
+    return(sizeof(struct darshan_heatmap_record) + rec->nbins*2*sizeof(int64_t));
+}
+
 /* retrieve a heatmap record from log file descriptor 'fd', storing the
  * data in the buffer address pointed to by 'heatmap_buf_p'. Return 1 on
  * successful record read, 0 on no more data, and -1 on error.
@@ -236,6 +246,8 @@ static void darshan_log_print_heatmap_description(int ver)
     printf("\n# description of heatmap counters:\n");
     printf("#   HEATMAP_F_BIN_WIDTH_SECONDS: time duration of each heatmap bin\n");
     printf("#   HEATMAP_{READ|WRITE}_BIN_{*}: number of bytes read or written within specified heatmap bin\n");
+    printf("#   heatmaps are named heatmap:<API>, or heatmap:<API>:<file name> for\n");
+    printf("#     per-file heatmaps (enabled with the HEATMAP_PER_FILE runtime setting)\n");
 
     return;
 }
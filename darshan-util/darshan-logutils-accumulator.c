@@ -39,6 +39,10 @@ struct darshan_accumulator_st {
      * shared files observed
      */
     double shared_io_total_time_by_slowest;
+    /* slowest rank time in any single partially shared file that was
+     * reduced over a subset of ranks
+     */
+    double part_shared_io_total_time_by_slowest;
     /* how many total bytes were read or written? */
     int64_t total_bytes;
     /* for non-shared files, how long did each rank spend in IO? */
@@ -134,10 +138,19 @@ int darshan_accumulator_inject(darshan_accumulator acc,
         /* total bytes moved */
         acc->total_bytes += (r_bytes + w_bytes);
 
-        if(rank < 0) {
+        if(rank == -1) {
             /* sum the slowest I/O time across all shared files */
             acc->shared_io_total_time_by_slowest += io_total_time;
         }
+        else if(rank < -1) {
+            /* record reduced over -rank processes; different partially
+             * shared files are assumed to be accessed concurrently by
+             * disjoint groups of ranks, so track the slowest one rather
+             * than adding them up serially
+             */
+            if(io_total_time > acc->part_shared_io_total_time_by_slowest)
+                acc->part_shared_io_total_time_by_slowest = io_total_time;
+        }
         else {
             /* sum per-rank I/O times (including meta and rw breakdown) for
              * each rank separately
@@ -262,6 +275,8 @@ int darshan_accumulator_emit(darshan_accumulator             acc,
     metrics->total_bytes = acc->total_bytes;
     metrics->shared_io_total_time_by_slowest
         = acc->shared_io_total_time_by_slowest;
+    metrics->part_shared_io_total_time_by_slowest
+        = acc->part_shared_io_total_time_by_slowest;
     /* determine which rank had the slowest path through unique files */
     for (i = 0; i < acc->job_nprocs; i++) {
         if (acc->rank_cumul_io_total_time[i]
@@ -277,10 +292,11 @@ int darshan_accumulator_emit(darshan_accumulator             acc,
     }
 
     /* aggregate io time is estimated as the time consumed by the slowest
-     * rank in unique files plus the time consumed by the slowest rank in in
-     * each shared file
+     * rank in unique files, plus the slowest partially shared file, plus
+     * the time consumed by the slowest rank in in each shared file
      */
     metrics->agg_time_by_slowest = metrics->unique_io_total_time_by_slowest +
+        metrics->part_shared_io_total_time_by_slowest +
         metrics->shared_io_total_time_by_slowest;
     /* aggregate rate is total bytes deviced by above; guard against divide
      * by zero calculation, though
@@ -0,0 +1,1221 @@
+/*
+ * Copyright (C) 2026 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+/* This file implements the columnar export API (darshan_log_export_*)
+ * functions in darshan-logutils.h.  Module records are written as tables
+ * with one column per counter, in either the Arrow IPC file format or the
+ * Parquet format.  Both writers are self-contained (no Arrow or Parquet
+ * libraries are needed) and only produce the small subset of each format
+ * that is needed here: non-nullable 64-bit integer, double, and UTF-8
+ * string columns, written uncompressed.  Records are streamed through a
+ * fixed number of rows at a time (one record batch or row group each), so
+ * memory use does not depend on the size of the log.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "darshan-logutils.h"
+#include "uthash-1.9.2/src/uthash.h"
+
+/* number of rows buffered before they are written as a record batch (Arrow)
+ * or row group (Parquet)
+ */
+#define COLUMNAR_BATCH_ROWS 32768
+
+enum columnar_type
+{
+    COLUMNAR_UINT64,
+    COLUMNAR_INT64,
+    COLUMNAR_DOUBLE,
+    COLUMNAR_UTF8
+};
+
+/* growable byte buffer, used for column data and encoded metadata */
+struct columnar_buf
+{
+    unsigned char *buf;
+    size_t len;
+    size_t cap;
+    int err;
+};
+
+struct columnar_col
+{
+    char *name;
+    enum columnar_type type;
+    /* fixed-width values, or concatenated strings for UTF8 columns */
+    struct columnar_buf data;
+    /* UTF8 columns only: nrows+1 offsets into data */
+    int32_t *offsets;
+};
+
+/* offset and sizes of a written Arrow record batch, or of a column chunk of
+ * a Parquet row group
+ */
+struct columnar_block
+{
+    int64_t offset;
+    int64_t meta_len;
+    int64_t body_len;
+};
+
+struct columnar_table
+{
+    enum darshan_columnar_format format;
+    FILE *fp;
+    const char *path;
+    int64_t file_off;
+    int ncols;
+    struct columnar_col *cols;
+    int64_t nrows;
+    int64_t total_rows;
+    /* Arrow: one block per record batch.  Parquet: ncols blocks per row
+     * group, with the row counts of the row groups in group_rows
+     */
+    struct columnar_block *blocks;
+    int nblocks;
+    int64_t *group_rows;
+    int ngroups;
+    int err;
+};
+
+/* layout of modules whose records are a fixed set of counters */
+struct columnar_counter_layout
+{
+    darshan_module_id mod_id;
+    char **counter_names;
+    int ncounters;
+    size_t counters_off;
+    char **fcounter_names;
+    int nfcounters;
+    size_t fcounters_off;
+    /* offset of the parent file record id, or 0 if none */
+    size_t file_rec_id_off;
+};
+
+#define COUNTER_LAYOUT(__id, __type, __prefix, __PREFIX, __file_rec_id_off) \
+    { __id, __prefix ## _counter_names, __PREFIX ## _NUM_INDICES, \
+      offsetof(struct __type, counters), __prefix ## _f_counter_names, \
+      __PREFIX ## _F_NUM_INDICES, offsetof(struct __type, fcounters), \
+      __file_rec_id_off }
+
+static struct columnar_counter_layout counter_layouts[] =
+{
+    COUNTER_LAYOUT(DARSHAN_POSIX_MOD, darshan_posix_file, posix, POSIX, 0),
+    COUNTER_LAYOUT(DARSHAN_MPIIO_MOD, darshan_mpiio_file, mpiio, MPIIO, 0),
+    COUNTER_LAYOUT(DARSHAN_H5F_MOD, darshan_hdf5_file, h5f, H5F, 0),
+    COUNTER_LAYOUT(DARSHAN_H5D_MOD, darshan_hdf5_dataset, h5d, H5D,
+        offsetof(struct darshan_hdf5_dataset, file_rec_id)),
+    COUNTER_LAYOUT(DARSHAN_PNETCDF_FILE_MOD, darshan_pnetcdf_file,
+        pnetcdf_file, PNETCDF_FILE, 0),
+    COUNTER_LAYOUT(DARSHAN_PNETCDF_VAR_MOD, darshan_pnetcdf_var,
+        pnetcdf_var, PNETCDF_VAR,
+        offsetof(struct darshan_pnetcdf_var, file_rec_id)),
+    COUNTER_LAYOUT(DARSHAN_BGQ_MOD, darshan_bgq_record, bgq, BGQ, 0),
+    COUNTER_LAYOUT(DARSHAN_STDIO_MOD, darshan_stdio_file, stdio, STDIO, 0),
+    COUNTER_LAYOUT(DARSHAN_MDHIM_MOD, darshan_mdhim_record, mdhim, MDHIM, 0),
+    COUNTER_LAYOUT(DARSHAN_DFS_MOD, darshan_dfs_file, dfs, DFS, 0),
+    COUNTER_LAYOUT(DARSHAN_DAOS_MOD, darshan_daos_object, daos, DAOS, 0),
+};
+
+static int columnar_little_endian(void)
+{
+    uint16_t x = 1;
+
+    return(*(unsigned char *)&x == 1);
+}
+
+/*********************************************************
+ *               byte buffer helpers                     *
+ *********************************************************/
+
+static size_t buf_reserve(struct columnar_buf *b, size_t align, size_t size)
+{
+    size_t pos = b->len;
+    size_t new_cap;
+    unsigned char *tmp;
+
+    if(align > 1 && pos % align)
+        pos += align - (pos % align);
+
+    if(pos + size > b->cap)
+    {
+        new_cap = b->cap ? b->cap : 1024;
+        while(new_cap < pos + size)
+            new_cap *= 2;
+        tmp = realloc(b->buf, new_cap);
+        if(!tmp)
+        {
+            b->err = -1;
+            return(0);
+        }
+        b->buf = tmp;
+        b->cap = new_cap;
+    }
+
+    memset(b->buf + b->len, 0, pos + size - b->len);
+    b->len = pos + size;
+
+    return(pos);
+}
+
+static void buf_append(struct columnar_buf *b, const void *data, size_t size)
+{
+    size_t pos = buf_reserve(b, 1, size);
+
+    if(!b->err)
+        memcpy(b->buf + pos, data, size);
+    return;
+}
+
+static void put_le(struct columnar_buf *b, size_t pos, uint64_t v, int nbytes)
+{
+    int i;
+
+    if(b->err)
+        return;
+    for(i = 0; i < nbytes; i++)
+        b->buf[pos + i] = (v >> (8 * i)) & 0xff;
+    return;
+}
+
+/*********************************************************
+ *               flatbuffer builder (Arrow)              *
+ *********************************************************/
+
+/* Flatbuffers are built front to back here: each table is written before
+ * its children, and the offsets to the children are patched in once they
+ * have been written, so that all offsets point forward as required.
+ */
+
+/* write a table with the given field sizes (0 for absent fields), storing
+ * the position of each field in pos. returns the position of the table
+ */
+static size_t fb_table(struct columnar_buf *b, int nfields, const int *sizes,
+    size_t *pos)
+{
+    size_t vt, t, end;
+    int i;
+
+    vt = buf_reserve(b, 2, 4 + 2 * nfields);
+    t = buf_reserve(b, 8, 4);
+    for(i = 0; i < nfields; i++)
+        pos[i] = sizes[i] ? buf_reserve(b, sizes[i], sizes[i]) : 0;
+    end = b->len;
+
+    put_le(b, vt, 4 + 2 * nfields, 2);
+    put_le(b, vt + 2, end - t, 2);
+    for(i = 0; i < nfields; i++)
+        put_le(b, vt + 4 + 2 * i, sizes[i] ? pos[i] - t : 0, 2);
+    /* the vtable precedes the table */
+    put_le(b, t, (uint32_t)(t - vt), 4);
+
+    return(t);
+}
+
+static void fb_link(struct columnar_buf *b, size_t slot, size_t target)
+{
+    put_le(b, slot, (uint32_t)(target - slot), 4);
+    return;
+}
+
+/* write a vector header and count elements, aligning the elements to
+ * align bytes. returns the position of the first element
+ */
+static size_t fb_vector(struct columnar_buf *b, int count, int elem_size,
+    int align)
+{
+    size_t pos;
+
+    while((b->len + 4) % align)
+        buf_reserve(b, 1, 1);
+    pos = buf_reserve(b, 4, 4 + (size_t)count * elem_size);
+    put_le(b, pos, count, 4);
+
+    return(pos + 4);
+}
+
+static size_t fb_string(struct columnar_buf *b, const char *str)
+{
+    size_t len = strlen(str);
+    size_t pos;
+
+    pos = buf_reserve(b, 4, 4 + len + 1);
+    put_le(b, pos, len, 4);
+    if(!b->err)
+        memcpy(b->buf + pos + 4, str, len);
+
+    return(pos);
+}
+
+/* Arrow flatbuffer enum values */
+#define ARROW_METADATA_V5 4
+#define ARROW_HEADER_SCHEMA 1
+#define ARROW_HEADER_RECORD_BATCH 3
+#define ARROW_TYPE_INT 2
+#define ARROW_TYPE_FLOATING_POINT 3
+#define ARROW_TYPE_UTF8 5
+#define ARROW_PRECISION_DOUBLE 2
+
+static size_t fb_schema(struct columnar_buf *b, struct columnar_table *tbl)
+{
+    int schema_sizes[2] = {2, 4};
+    int field_sizes[6] = {4, 1, 1, 4, 0, 4};
+    int int_sizes[2] = {4, 1};
+    int fp_sizes[1] = {2};
+    size_t schema_pos[2], field_pos[6], type_pos[2];
+    size_t schema, fields, field, type, children;
+    int i;
+
+    schema = fb_table(b, 2, schema_sizes, schema_pos);
+    put_le(b, schema_pos[0], columnar_little_endian() ? 0 : 1, 2);
+    fields = fb_vector(b, tbl->ncols, 4, 4);
+    fb_link(b, schema_pos[1], fields - 4);
+
+    for(i = 0; i < tbl->ncols; i++)
+    {
+        field = fb_table(b, 6, field_sizes, field_pos);
+        fb_link(b, fields + 4 * i, field);
+
+        fb_link(b, field_pos[0], fb_string(b, tbl->cols[i].name));
+        put_le(b, field_pos[1], 0, 1); /* not nullable */
+        switch(tbl->cols[i].type)
+        {
+            case COLUMNAR_UINT64:
+            case COLUMNAR_INT64:
+                put_le(b, field_pos[2], ARROW_TYPE_INT, 1);
+                type = fb_table(b, 2, int_sizes, type_pos);
+                put_le(b, type_pos[0], 64, 4);
+                put_le(b, type_pos[1],
+                    tbl->cols[i].type == COLUMNAR_INT64, 1);
+                break;
+            case COLUMNAR_DOUBLE:
+                put_le(b, field_pos[2], ARROW_TYPE_FLOATING_POINT, 1);
+                type = fb_table(b, 1, fp_sizes, type_pos);
+                put_le(b, type_pos[0], ARROW_PRECISION_DOUBLE, 2);
+                break;
+            case COLUMNAR_UTF8:
+            default:
+                put_le(b, field_pos[2], ARROW_TYPE_UTF8, 1);
+                type = fb_table(b, 0, NULL, type_pos);
+                break;
+        }
+        fb_link(b, field_pos[3], type);
+
+        /* readers expect a (possibly empty) list of children */
+        children = fb_vector(b, 0, 4, 4);
+        fb_link(b, field_pos[5], children - 4);
+    }
+
+    return(schema);
+}
+
+/* build an encapsulated Arrow IPC message with the given header type. for
+ * record batches, the buffer layout of the body is described as well
+ */
+static int arrow_message(struct columnar_table *tbl, struct columnar_buf *b,
+    int header_type, int64_t body_len)
+{
+    int msg_sizes[4] = {2, 1, 4, 8};
+    int rb_sizes[3] = {8, 4, 4};
+    size_t msg_pos[4], rb_pos[3];
+    size_t msg, rb, nodes, bufs;
+    int64_t off = 0, len;
+    int nbufs = 0;
+    int i, j;
+
+    /* continuation marker and metadata length, then the flatbuffer */
+    buf_reserve(b, 1, 8);
+    put_le(b, 0, 0xffffffff, 4);
+    buf_reserve(b, 1, 4); /* root offset */
+
+    msg = fb_table(b, 4, msg_sizes, msg_pos);
+    fb_link(b, 8, msg);
+    put_le(b, msg_pos[0], ARROW_METADATA_V5, 2);
+    put_le(b, msg_pos[1], header_type, 1);
+    put_le(b, msg_pos[3], body_len, 8);
+
+    if(header_type == ARROW_HEADER_SCHEMA)
+    {
+        fb_link(b, msg_pos[2], fb_schema(b, tbl));
+    }
+    else
+    {
+        rb = fb_table(b, 3, rb_sizes, rb_pos);
+        fb_link(b, msg_pos[2], rb);
+        put_le(b, rb_pos[0], tbl->nrows, 8);
+
+        nodes = fb_vector(b, tbl->ncols, 16, 8);
+        fb_link(b, rb_pos[1], nodes - 4);
+        for(i = 0; i < tbl->ncols; i++)
+        {
+            put_le(b, nodes + 16 * i, tbl->nrows, 8);
+            put_le(b, nodes + 16 * i + 8, 0, 8);
+            nbufs += (tbl->cols[i].type == COLUMNAR_UTF8) ? 3 : 2;
+        }
+
+        bufs = fb_vector(b, nbufs, 16, 8);
+        fb_link(b, rb_pos[2], bufs - 4);
+        for(i = 0, j = 0; i < tbl->ncols; i++)
+        {
+            /* empty validity bitmap */
+            put_le(b, bufs + 16 * j, off, 8);
+            put_le(b, bufs + 16 * j + 8, 0, 8);
+            j++;
+            if(tbl->cols[i].type == COLUMNAR_UTF8)
+            {
+                len = (tbl->nrows + 1) * sizeof(int32_t);
+                put_le(b, bufs + 16 * j, off, 8);
+                put_le(b, bufs + 16 * j + 8, len, 8);
+                off += (len + 7) & ~7;
+                j++;
+            }
+            len = tbl->cols[i].data.len;
+            put_le(b, bufs + 16 * j, off, 8);
+            put_le(b, bufs + 16 * j + 8, len, 8);
+            off += (len + 7) & ~7;
+            j++;
+        }
+    }
+
+    /* pad the metadata so the body starts 8-byte aligned */
+    buf_reserve(b, 8, 0);
+    put_le(b, 4, b->len - 8, 4);
+
+    return(b->err);
+}
+
+/*********************************************************
+ *            thrift compact protocol (Parquet)          *
+ *********************************************************/
+
+#define TC_I32 5
+#define TC_I64 6
+#define TC_BINARY 8
+#define TC_LIST 9
+#define TC_STRUCT 12
+
+static void tc_varint(struct columnar_buf *b, uint64_t v)
+{
+    unsigned char byte;
+
+    do
+    {
+        byte = v & 0x7f;
+        v >>= 7;
+        if(v)
+            byte |= 0x80;
+        buf_append(b, &byte, 1);
+    } while(v);
+
+    return;
+}
+
+static void tc_field(struct columnar_buf *b, int *last_id, int id, int type)
+{
+    unsigned char byte;
+
+    if(id > *last_id && id - *last_id <= 15)
+    {
+        byte = ((id - *last_id) << 4) | type;
+        buf_append(b, &byte, 1);
+    }
+    else
+    {
+        byte = type;
+        buf_append(b, &byte, 1);
+        tc_varint(b, ((uint64_t)id << 1) ^ (id >> 15));
+    }
+    *last_id = id;
+
+    return;
+}
+
+static void tc_i32(struct columnar_buf *b, int *last_id, int id, int32_t v)
+{
+    tc_field(b, last_id, id, TC_I32);
+    tc_varint(b, (uint32_t)((v << 1) ^ (v >> 31)));
+    return;
+}
+
+static void tc_i64(struct columnar_buf *b, int *last_id, int id, int64_t v)
+{
+    tc_field(b, last_id, id, TC_I64);
+    tc_varint(b, (uint64_t)((v << 1) ^ (v >> 63)));
+    return;
+}
+
+static void tc_binary(struct columnar_buf *b, int *last_id, int id,
+    const char *str)
+{
+    size_t len = strlen(str);
+
+    tc_field(b, last_id, id, TC_BINARY);
+    tc_varint(b, len);
+    buf_append(b, str, len);
+    return;
+}
+
+static void tc_list(struct columnar_buf *b, int *last_id, int id,
+    int elem_type, int count)
+{
+    unsigned char byte;
+
+    tc_field(b, last_id, id, TC_LIST);
+    if(count < 15)
+    {
+        byte = (count << 4) | elem_type;
+        buf_append(b, &byte, 1);
+    }
+    else
+    {
+        byte = 0xf0 | elem_type;
+        buf_append(b, &byte, 1);
+        tc_varint(b, count);
+    }
+    return;
+}
+
+static void tc_stop(struct columnar_buf *b)
+{
+    unsigned char byte = 0;
+
+    buf_append(b, &byte, 1);
+    return;
+}
+
+/* Parquet enum values */
+#define PQ_TYPE_INT64 2
+#define PQ_TYPE_DOUBLE 5
+#define PQ_TYPE_BYTE_ARRAY 6
+#define PQ_REQUIRED 0
+#define PQ_CONVERTED_UTF8 0
+#define PQ_CONVERTED_UINT_64 14
+#define PQ_ENCODING_PLAIN 0
+#define PQ_ENCODING_RLE 3
+#define PQ_PAGE_DATA 0
+
+static int pq_type(enum columnar_type type)
+{
+    switch(type)
+    {
+        case COLUMNAR_UINT64:
+        case COLUMNAR_INT64:
+            return(PQ_TYPE_INT64);
+        case COLUMNAR_DOUBLE:
+            return(PQ_TYPE_DOUBLE);
+        case COLUMNAR_UTF8:
+        default:
+            return(PQ_TYPE_BYTE_ARRAY);
+    }
+}
+
+/*********************************************************
+ *                  table writer                         *
+ *********************************************************/
+
+static int table_write(struct columnar_table *tbl, const void *data, size_t len)
+{
+    static const char zeros[8] = {0};
+
+    if(tbl->err)
+        return(-1);
+
+    if(!data)
+        data = zeros;
+    if(len && fwrite(data, 1, len, tbl->fp) != len)
+    {
+        fprintf(stderr, "Error: failed to write to %s.\n", tbl->path);
+        tbl->err = -1;
+        return(-1);
+    }
+    tbl->file_off += len;
+
+    return(0);
+}
+
+static int table_add_block(struct columnar_table *tbl, int64_t offset,
+    int64_t meta_len, int64_t body_len)
+{
+    struct columnar_block *tmp;
+
+    tmp = realloc(tbl->blocks, (tbl->nblocks + 1) * sizeof(*tmp));
+    if(!tmp)
+    {
+        tbl->err = -1;
+        return(-1);
+    }
+    tbl->blocks = tmp;
+    tbl->blocks[tbl->nblocks].offset = offset;
+    tbl->blocks[tbl->nblocks].meta_len = meta_len;
+    tbl->blocks[tbl->nblocks].body_len = body_len;
+    tbl->nblocks++;
+
+    return(0);
+}
+
+/* byte swap fixed-width column values on big-endian hosts, as Parquet data
+ * is always little-endian
+ */
+static void table_swap_col(struct columnar_col *col)
+{
+    size_t i;
+
+    if(col->type == COLUMNAR_UTF8 || columnar_little_endian())
+        return;
+    for(i = 0; i < col->data.len; i += sizeof(int64_t))
+        DARSHAN_BSWAP64(col->data.buf + i);
+    return;
+}
+
+static int table_flush_arrow(struct columnar_table *tbl)
+{
+    struct columnar_buf msg = {0};
+    int64_t body_len = 0, offset;
+    int64_t len;
+    int i;
+
+    for(i = 0; i < tbl->ncols; i++)
+    {
+        if(tbl->cols[i].type == COLUMNAR_UTF8)
+            body_len += ((tbl->nrows + 1) * sizeof(int32_t) + 7) & ~7;
+        body_len += (tbl->cols[i].data.len + 7) & ~7;
+    }
+
+    if(arrow_message(tbl, &msg, ARROW_HEADER_RECORD_BATCH, body_len) < 0)
+    {
+        free(msg.buf);
+        tbl->err = -1;
+        return(-1);
+    }
+
+    offset = tbl->file_off;
+    table_write(tbl, msg.buf, msg.len);
+    for(i = 0; i < tbl->ncols; i++)
+    {
+        if(tbl->cols[i].type == COLUMNAR_UTF8)
+        {
+            len = (tbl->nrows + 1) * sizeof(int32_t);
+            table_write(tbl, tbl->cols[i].offsets, len);
+            table_write(tbl, NULL, ((len + 7) & ~7) - len);
+        }
+        len = tbl->cols[i].data.len;
+        table_write(tbl, tbl->cols[i].data.buf, len);
+        table_write(tbl, NULL, ((len + 7) & ~7) - len);
+    }
+    table_add_block(tbl, offset, msg.len, body_len);
+    free(msg.buf);
+
+    return(tbl->err);
+}
+
+static int table_flush_parquet(struct columnar_table *tbl)
+{
+    struct columnar_buf hdr = {0};
+    struct columnar_buf strs = {0};
+    struct columnar_col *col;
+    unsigned char *page;
+    int64_t page_len, *tmp_rows;
+    int last_id, dp_last_id;
+    int64_t offset;
+    int64_t i;
+    int c;
+
+    for(c = 0; c < tbl->ncols; c++)
+    {
+        col = &tbl->cols[c];
+
+        /* PLAIN encoded strings are each prefixed with their length */
+        if(col->type == COLUMNAR_UTF8)
+        {
+            strs.len = 0;
+            for(i = 0; i < tbl->nrows; i++)
+            {
+                size_t pos = buf_reserve(&strs, 1, 4);
+                int32_t len = col->offsets[i+1] - col->offsets[i];
+
+                put_le(&strs, pos, len, 4);
+                buf_append(&strs, col->data.buf + col->offsets[i], len);
+            }
+            page = strs.buf;
+            page_len = strs.len;
+        }
+        else
+        {
+            table_swap_col(col);
+            page = col->data.buf;
+            page_len = col->data.len;
+        }
+
+        /* a single uncompressed data page per column chunk; required
+         * columns carry no repetition or definition levels
+         */
+        hdr.len = 0;
+        last_id = 0;
+        tc_i32(&hdr, &last_id, 1, PQ_PAGE_DATA);
+        tc_i32(&hdr, &last_id, 2, page_len);
+        tc_i32(&hdr, &last_id, 3, page_len);
+        tc_field(&hdr, &last_id, 5, TC_STRUCT);
+        dp_last_id = 0;
+        tc_i32(&hdr, &dp_last_id, 1, tbl->nrows);
+        tc_i32(&hdr, &dp_last_id, 2, PQ_ENCODING_PLAIN);
+        tc_i32(&hdr, &dp_last_id, 3, PQ_ENCODING_RLE);
+        tc_i32(&hdr, &dp_last_id, 4, PQ_ENCODING_RLE);
+        tc_stop(&hdr);
+        tc_stop(&hdr);
+        if(hdr.err || strs.err)
+            tbl->err = -1;
+
+        offset = tbl->file_off;
+        table_write(tbl, hdr.buf, hdr.len);
+        table_write(tbl, page, page_len);
+        table_add_block(tbl, offset, hdr.len, page_len);
+    }
+    free(hdr.buf);
+    free(strs.buf);
+
+    tmp_rows = realloc(tbl->group_rows, (tbl->ngroups + 1) * sizeof(*tmp_rows));
+    if(!tmp_rows)
+    {
+        tbl->err = -1;
+        return(-1);
+    }
+    tbl->group_rows = tmp_rows;
+    tbl->group_rows[tbl->ngroups++] = tbl->nrows;
+
+    return(tbl->err);
+}
+
+/* write out the rows buffered in the table */
+static int table_flush(struct columnar_table *tbl)
+{
+    int i;
+
+    if(tbl->err)
+        return(-1);
+    if(tbl->nrows == 0)
+        return(0);
+
+    if(tbl->format == DARSHAN_COLUMNAR_ARROW)
+        table_flush_arrow(tbl);
+    else
+        table_flush_parquet(tbl);
+
+    tbl->total_rows += tbl->nrows;
+    tbl->nrows = 0;
+    for(i = 0; i < tbl->ncols; i++)
+        tbl->cols[i].data.len = 0;
+
+    return(tbl->err);
+}
+
+static void table_destroy(struct columnar_table *tbl)
+{
+    int i;
+
+    for(i = 0; i < tbl->ncols; i++)
+    {
+        free(tbl->cols[i].name);
+        free(tbl->cols[i].data.buf);
+        free(tbl->cols[i].offsets);
+    }
+    free(tbl->cols);
+    free(tbl->blocks);
+    free(tbl->group_rows);
+    if(tbl->fp)
+        fclose(tbl->fp);
+    free(tbl);
+
+    return;
+}
+
+/* create a table with room for ncols columns, which are defined with
+ * table_add_col() before the first row is added
+ */
+static struct columnar_table *table_create(enum darshan_columnar_format format,
+    const char *path, int ncols)
+{
+    struct columnar_table *tbl;
+
+    if(format != DARSHAN_COLUMNAR_ARROW && format != DARSHAN_COLUMNAR_PARQUET)
+    {
+        fprintf(stderr, "Error: invalid columnar export format.\n");
+        return(NULL);
+    }
+
+    tbl = calloc(1, sizeof(*tbl));
+    if(!tbl)
+        return(NULL);
+    tbl->cols = calloc(ncols, sizeof(*tbl->cols));
+    if(!tbl->cols)
+    {
+        free(tbl);
+        return(NULL);
+    }
+    tbl->format = format;
+    tbl->path = path;
+
+    tbl->fp = fopen(path, "w");
+    if(!tbl->fp)
+    {
+        fprintf(stderr, "Error: unable to create %s.\n", path);
+        table_destroy(tbl);
+        return(NULL);
+    }
+
+    return(tbl);
+}
+
+static int table_add_col(struct columnar_table *tbl, const char *name,
+    enum columnar_type type)
+{
+    struct columnar_col *col = &tbl->cols[tbl->ncols];
+
+    col->name = strdup(name);
+    col->type = type;
+    if(type == COLUMNAR_UTF8)
+    {
+        col->offsets = malloc((COLUMNAR_BATCH_ROWS + 1) * sizeof(int32_t));
+        if(col->offsets)
+            col->offsets[0] = 0;
+    }
+    else
+    {
+        /* fixed-width columns never grow beyond a batch of values */
+        buf_reserve(&col->data, 8, COLUMNAR_BATCH_ROWS * sizeof(int64_t));
+        col->data.len = 0;
+    }
+    tbl->ncols++;
+
+    if(!col->name || col->data.err || (type == COLUMNAR_UTF8 && !col->offsets))
+    {
+        tbl->err = -1;
+        return(-1);
+    }
+
+    return(0);
+}
+
+/* write the file header (and Arrow schema) once all columns are defined */
+static int table_begin(struct columnar_table *tbl)
+{
+    struct columnar_buf msg = {0};
+    static const char arrow_magic[8] = "ARROW1\0\0";
+
+    if(tbl->err)
+        return(-1);
+
+    if(tbl->format == DARSHAN_COLUMNAR_ARROW)
+    {
+        table_write(tbl, arrow_magic, 8);
+        if(arrow_message(tbl, &msg, ARROW_HEADER_SCHEMA, 0) < 0)
+            tbl->err = -1;
+        table_write(tbl, msg.buf, msg.len);
+        free(msg.buf);
+    }
+    else
+        table_write(tbl, "PAR1", 4);
+
+    return(tbl->err);
+}
+
+static inline void table_put_fixed(struct columnar_table *tbl, int col,
+    const void *val)
+{
+    struct columnar_col *c = &tbl->cols[col];
+
+    memcpy(c->data.buf + c->data.len, val, sizeof(int64_t));
+    c->data.len += sizeof(int64_t);
+    return;
+}
+
+static void table_put_str(struct columnar_table *tbl, int col, const char *str)
+{
+    struct columnar_col *c = &tbl->cols[col];
+
+    buf_append(&c->data, str, strlen(str));
+    c->offsets[tbl->nrows+1] = c->data.len;
+    if(c->data.err || c->data.len > INT32_MAX)
+        tbl->err = -1;
+    return;
+}
+
+/* finish a row, writing out the batch once it is full */
+static int table_end_row(struct columnar_table *tbl)
+{
+    tbl->nrows++;
+    if(tbl->nrows == COLUMNAR_BATCH_ROWS)
+        return(table_flush(tbl));
+    return(tbl->err);
+}
+
+static int table_finish_arrow(struct columnar_table *tbl)
+{
+    struct columnar_buf b = {0};
+    int footer_sizes[4] = {2, 4, 4, 4};
+    size_t footer_pos[4];
+    size_t footer, blocks;
+    uint32_t eos[2] = {0xffffffff, 0};
+    unsigned char footer_len[4];
+    int i;
+
+    table_write(tbl, eos, sizeof(eos));
+
+    buf_reserve(&b, 1, 4);
+    footer = fb_table(&b, 4, footer_sizes, footer_pos);
+    fb_link(&b, 0, footer);
+    put_le(&b, footer_pos[0], ARROW_METADATA_V5, 2);
+    fb_link(&b, footer_pos[1], fb_schema(&b, tbl));
+    fb_link(&b, footer_pos[2], fb_vector(&b, 0, 24, 8) - 4);
+    blocks = fb_vector(&b, tbl->nblocks, 24, 8);
+    fb_link(&b, footer_pos[3], blocks - 4);
+    for(i = 0; i < tbl->nblocks; i++)
+    {
+        put_le(&b, blocks + 24 * i, tbl->blocks[i].offset, 8);
+        put_le(&b, blocks + 24 * i + 8, tbl->blocks[i].meta_len, 4);
+        put_le(&b, blocks + 24 * i + 16, tbl->blocks[i].body_len, 8);
+    }
+    buf_reserve(&b, 8, 0);
+    if(b.err)
+        tbl->err = -1;
+
+    footer_len[0] = b.len & 0xff;
+    footer_len[1] = (b.len >> 8) & 0xff;
+    footer_len[2] = (b.len >> 16) & 0xff;
+    footer_len[3] = (b.len >> 24) & 0xff;
+    table_write(tbl, b.buf, b.len);
+    table_write(tbl, footer_len, 4);
+    table_write(tbl, "ARROW1", 6);
+    free(b.buf);
+
+    return(tbl->err);
+}
+
+static int table_finish_parquet(struct columnar_table *tbl)
+{
+    struct columnar_buf b = {0};
+    struct columnar_block *blk;
+    struct columnar_col *col;
+    unsigned char meta_len[4];
+    int last_id, el_id, rg_id, cc_id, cm_id;
+    int64_t rg_bytes;
+    char created_by[64];
+    int g, c;
+
+    last_id = 0;
+    tc_i32(&b, &last_id, 1, 1);
+
+    /* a root schema element followed by one leaf per column */
+    tc_list(&b, &last_id, 2, TC_STRUCT, tbl->ncols + 1);
+    el_id = 0;
+    tc_binary(&b, &el_id, 4, "schema");
+    tc_i32(&b, &el_id, 5, tbl->ncols);
+    tc_stop(&b);
+    for(c = 0; c < tbl->ncols; c++)
+    {
+        col = &tbl->cols[c];
+        el_id = 0;
+        tc_i32(&b, &el_id, 1, pq_type(col->type));
+        tc_i32(&b, &el_id, 3, PQ_REQUIRED);
+        tc_binary(&b, &el_id, 4, col->name);
+        if(col->type == COLUMNAR_UTF8)
+            tc_i32(&b, &el_id, 6, PQ_CONVERTED_UTF8);
+        else if(col->type == COLUMNAR_UINT64)
+            tc_i32(&b, &el_id, 6, PQ_CONVERTED_UINT_64);
+        tc_stop(&b);
+    }
+
+    tc_i64(&b, &last_id, 3, tbl->total_rows);
+
+    tc_list(&b, &last_id, 4, TC_STRUCT, tbl->ngroups);
+    for(g = 0; g < tbl->ngroups; g++)
+    {
+        rg_id = 0;
+        rg_bytes = 0;
+        tc_list(&b, &rg_id, 1, TC_STRUCT, tbl->ncols);
+        for(c = 0; c < tbl->ncols; c++)
+        {
+            col = &tbl->cols[c];
+            blk = &tbl->blocks[g * tbl->ncols + c];
+            rg_bytes += blk->meta_len + blk->body_len;
+
+            cc_id = 0;
+            tc_i64(&b, &cc_id, 2, blk->offset);
+            tc_field(&b, &cc_id, 3, TC_STRUCT);
+            cm_id = 0;
+            tc_i32(&b, &cm_id, 1, pq_type(col->type));
+            tc_list(&b, &cm_id, 2, TC_I32, 2);
+            tc_varint(&b, PQ_ENCODING_PLAIN << 1);
+            tc_varint(&b, PQ_ENCODING_RLE << 1);
+            tc_list(&b, &cm_id, 3, TC_BINARY, 1);
+            tc_varint(&b, strlen(col->name));
+            buf_append(&b, col->name, strlen(col->name));
+            tc_i32(&b, &cm_id, 4, 0); /* uncompressed */
+            tc_i64(&b, &cm_id, 5, tbl->group_rows[g]);
+            tc_i64(&b, &cm_id, 6, blk->meta_len + blk->body_len);
+            tc_i64(&b, &cm_id, 7, blk->meta_len + blk->body_len);
+            tc_i64(&b, &cm_id, 9, blk->offset);
+            tc_stop(&b);
+            tc_stop(&b);
+        }
+        tc_i64(&b, &rg_id, 2, rg_bytes);
+        tc_i64(&b, &rg_id, 3, tbl->group_rows[g]);
+        tc_stop(&b);
+    }
+
+    snprintf(created_by, sizeof(created_by), "darshan-util version %s",
+        darshan_log_get_lib_version());
+    tc_binary(&b, &last_id, 6, created_by);
+    tc_stop(&b);
+    if(b.err)
+        tbl->err = -1;
+
+    meta_len[0] = b.len & 0xff;
+    meta_len[1] = (b.len >> 8) & 0xff;
+    meta_len[2] = (b.len >> 16) & 0xff;
+    meta_len[3] = (b.len >> 24) & 0xff;
+    table_write(tbl, b.buf, b.len);
+    table_write(tbl, meta_len, 4);
+    table_write(tbl, "PAR1", 4);
+    free(b.buf);
+
+    return(tbl->err);
+}
+
+/* flush remaining rows, write the file footer and close the table. the
+ * output file is removed if anything failed
+ */
+static int table_finish(struct columnar_table *tbl)
+{
+    int ret;
+
+    table_flush(tbl);
+    if(!tbl->err)
+    {
+        if(tbl->format == DARSHAN_COLUMNAR_ARROW)
+            table_finish_arrow(tbl);
+        else
+            table_finish_parquet(tbl);
+    }
+
+    if(fclose(tbl->fp) != 0)
+        tbl->err = -1;
+    tbl->fp = NULL;
+    if(tbl->err)
+        remove(tbl->path);
+
+    ret = tbl->err;
+    table_destroy(tbl);
+
+    return(ret);
+}
+
+/*********************************************************
+ *                  module exporters                     *
+ *********************************************************/
+
+static int export_counters(darshan_fd fd, struct columnar_counter_layout *l,
+    struct columnar_table *tbl)
+{
+    struct darshan_base_record *base_rec;
+    int64_t rank;
+    void *rec;
+    int ret;
+    int i, c;
+
+    table_add_col(tbl, "id", COLUMNAR_UINT64);
+    table_add_col(tbl, "rank", COLUMNAR_INT64);
+    if(l->file_rec_id_off)
+        table_add_col(tbl, "file_rec_id", COLUMNAR_UINT64);
+    for(i = 0; i < l->ncounters; i++)
+        table_add_col(tbl, l->counter_names[i], COLUMNAR_INT64);
+    for(i = 0; i < l->nfcounters; i++)
+        table_add_col(tbl, l->fcounter_names[i], COLUMNAR_DOUBLE);
+    if(table_begin(tbl) < 0)
+        return(-1);
+
+    while((ret = darshan_log_get_record_ref(fd, l->mod_id, &rec)) == 1)
+    {
+        base_rec = (struct darshan_base_record *)rec;
+        rank = base_rec->rank;
+
+        c = 0;
+        table_put_fixed(tbl, c++, &base_rec->id);
+        table_put_fixed(tbl, c++, &rank);
+        if(l->file_rec_id_off)
+            table_put_fixed(tbl, c++, (char *)rec + l->file_rec_id_off);
+        for(i = 0; i < l->ncounters; i++)
+            table_put_fixed(tbl, c++,
+                (char *)rec + l->counters_off + i * sizeof(int64_t));
+        for(i = 0; i < l->nfcounters; i++)
+            table_put_fixed(tbl, c++,
+                (char *)rec + l->fcounters_off + i * sizeof(double));
+
+        if(table_end_row(tbl) < 0)
+            return(-1);
+    }
+
+    return(ret);
+}
+
+/* DXT records are exported as one row per traced I/O segment */
+static int export_dxt(darshan_fd fd, darshan_module_id mod_id,
+    struct columnar_table *tbl)
+{
+    struct dxt_file_record *file_rec;
+    segment_info *seg;
+    char hostname[HOSTNAME_SIZE+1];
+    int64_t rank;
+    uint64_t pthread_id;
+    void *rec;
+    int64_t i;
+    int ret;
+
+    table_add_col(tbl, "id", COLUMNAR_UINT64);
+    table_add_col(tbl, "rank", COLUMNAR_INT64);
+    table_add_col(tbl, "hostname", COLUMNAR_UTF8);
+    table_add_col(tbl, "operation", COLUMNAR_UTF8);
+    table_add_col(tbl, "offset", COLUMNAR_INT64);
+    table_add_col(tbl, "length", COLUMNAR_INT64);
+    table_add_col(tbl, "start_time", COLUMNAR_DOUBLE);
+    table_add_col(tbl, "end_time", COLUMNAR_DOUBLE);
+    table_add_col(tbl, "pthread_id", COLUMNAR_UINT64);
+    if(table_begin(tbl) < 0)
+        return(-1);
+
+    while((ret = darshan_log_get_record_ref(fd, mod_id, &rec)) == 1)
+    {
+        file_rec = (struct dxt_file_record *)rec;
+        seg = (segment_info *)(file_rec + 1);
+        rank = file_rec->base_rec.rank;
+        memcpy(hostname, file_rec->hostname, HOSTNAME_SIZE);
+        hostname[HOSTNAME_SIZE] = '\0';
+
+        /* write segments precede read segments */
+        for(i = 0; i < file_rec->write_count + file_rec->read_count; i++)
+        {
+            pthread_id = seg[i].pthread_id;
+            table_put_fixed(tbl, 0, &file_rec->base_rec.id);
+            table_put_fixed(tbl, 1, &rank);
+            table_put_str(tbl, 2, hostname);
+            table_put_str(tbl, 3, (i < file_rec->write_count) ? "write" : "read");
+            table_put_fixed(tbl, 4, &seg[i].offset);
+            table_put_fixed(tbl, 5, &seg[i].length);
+            table_put_fixed(tbl, 6, &seg[i].start_time);
+            table_put_fixed(tbl, 7, &seg[i].end_time);
+            table_put_fixed(tbl, 8, &pthread_id);
+
+            if(table_end_row(tbl) < 0)
+                return(-1);
+        }
+    }
+
+    return(ret);
+}
+
+int darshan_log_export_names(darshan_fd fd,
+    enum darshan_columnar_format format, const char *path)
+{
+    struct darshan_name_record_ref *name_hash = NULL;
+    struct darshan_name_record_ref *ref, *tmp;
+    struct columnar_table *tbl;
+    int ret;
+
+    ret = darshan_log_get_namehash(fd, &name_hash);
+    if(ret < 0)
+        return(-1);
+
+    tbl = table_create(format, path, 2);
+    if(tbl)
+    {
+        table_add_col(tbl, "id", COLUMNAR_UINT64);
+        table_add_col(tbl, "name", COLUMNAR_UTF8);
+        table_begin(tbl);
+    }
+
+    HASH_ITER(hlink, name_hash, ref, tmp)
+    {
+        if(tbl && !tbl->err)
+        {
+            table_put_fixed(tbl, 0, &ref->name_record->id);
+            table_put_str(tbl, 1, ref->name_record->name);
+            table_end_row(tbl);
+        }
+        HASH_DELETE(hlink, name_hash, ref);
+        free(ref->name_record);
+        free(ref);
+    }
+
+    if(!tbl)
+        return(-1);
+    return(table_finish(tbl));
+}
+
+int darshan_log_export_module(darshan_fd fd, darshan_module_id mod_id,
+    enum darshan_columnar_format format, const char *path)
+{
+    struct columnar_counter_layout *layout = NULL;
+    struct columnar_table *tbl;
+    int ncols;
+    int i;
+    int ret;
+
+    if(mod_id < 0 || mod_id >= DARSHAN_KNOWN_MODULE_COUNT ||
+        !mod_logutils[mod_id])
+    {
+        fprintf(stderr, "Error: invalid Darshan module id.\n");
+        return(-1);
+    }
+
+    for(i = 0; i < (int)(sizeof(counter_layouts) / sizeof(counter_layouts[0])); i++)
+    {
+        if(counter_layouts[i].mod_id == mod_id)
+        {
+            layout = &counter_layouts[i];
+            break;
+        }
+    }
+    if(layout)
+        ncols = 3 + layout->ncounters + layout->nfcounters;
+    else if(mod_id == DXT_POSIX_MOD || mod_id == DXT_MPIIO_MOD)
+        ncols = 9;
+    else
+        return(1); /* no columnar layout for this module */
+
+    tbl = table_create(format, path, ncols);
+    if(!tbl)
+        return(-1);
+
+    if(layout)
+        ret = export_counters(fd, layout, tbl);
+    else
+        ret = export_dxt(fd, mod_id, tbl);
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: failed to export %s module records.\n",
+            darshan_module_names[mod_id]);
+        tbl->err = -1;
+    }
+
+    return(table_finish(tbl));
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -0,0 +1,387 @@
+/*
+ * Copyright (C) 2026 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+/* This file implements the summary sidecar API (darshan_log_summary_*)
+ * functions in darshan-logutils.h.  A sidecar holds the log's header and
+ * job data, along with the derived metrics and aggregate record of each
+ * module that supports the accumulator API, so that job-level summaries
+ * can be reported without decompressing any records.  Sidecars are written
+ * in the byte order of the host that created them and record the size and
+ * modification time of their log; a sidecar that does not match its log
+ * (or this library) is treated as missing.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "darshan-logutils.h"
+
+#define SUMMARY_MAGIC "DSUMMARY"
+#define SUMMARY_FORMAT_VER 2
+#define SUMMARY_BYTE_ORDER 0x01020304
+
+struct summary_file_header
+{
+    char magic[8];
+    uint32_t format_ver;
+    uint32_t byte_order;
+    /* sizes of the structs stored in the file, as a check that the reader
+     * was built with the same definitions as the writer
+     */
+    uint32_t job_size;
+    uint32_t metrics_size;
+    /* size and modification time (in ns) of the log when the sidecar was
+     * created
+     */
+    int64_t log_size;
+    int64_t log_mtime_ns;
+    char version[8];
+    uint32_t comp_type;
+    uint64_t partial_flag;
+    uint32_t mod_ver[DARSHAN_MAX_MODS];
+    uint64_t mod_len[DARSHAN_MAX_MODS];
+    struct darshan_job job;
+    uint32_t exe_len;
+    uint32_t nmods;
+};
+
+struct summary_file_module
+{
+    uint32_t mod_id;
+    uint32_t agg_record_size;
+    int64_t record_count;
+    struct darshan_derived_metrics metrics;
+};
+
+static int64_t summary_mtime_ns(const struct stat *st)
+{
+    return((int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec);
+}
+
+static char *summary_default_path(const char *log_path, const char *summary_path)
+{
+    char *path;
+
+    if(summary_path)
+        return(strdup(summary_path));
+
+    path = malloc(strlen(log_path) + strlen(DARSHAN_SUMMARY_SUFFIX) + 1);
+    if(path)
+        sprintf(path, "%s%s", log_path, DARSHAN_SUMMARY_SUFFIX);
+    return(path);
+}
+
+/* accumulate all records of a module; returns 1 if the module has a
+ * summary, 0 if it doesn't support the accumulator API, -1 on failure
+ */
+static int summary_accumulate_module(darshan_fd fd, int mod_idx,
+    int64_t nprocs, struct darshan_summary_module *mod_sum, void *agg_buf)
+{
+    darshan_accumulator acc;
+    void *rec;
+    int ret;
+
+    mod_sum->agg_record_size = 0;
+    if(darshan_accumulator_create(mod_idx, nprocs, &acc) < 0)
+        return(0);
+
+    mod_sum->record_count = 0;
+    while((ret = darshan_log_get_record_ref(fd, mod_idx, &rec)) == 1)
+    {
+        if(darshan_accumulator_inject(acc, rec, 1) < 0)
+        {
+            ret = -1;
+            break;
+        }
+        mod_sum->record_count++;
+    }
+    if(ret == 0)
+    {
+        memset(agg_buf, 0, DEF_MOD_BUF_SIZE);
+        ret = darshan_accumulator_emit(acc, &mod_sum->metrics, agg_buf);
+    }
+    darshan_accumulator_destroy(acc);
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: failed to summarize %s module records.\n",
+            darshan_module_names[mod_idx]);
+        return(-1);
+    }
+
+    mod_sum->agg_record_size = mod_logutils[mod_idx]->log_sizeof_record(agg_buf);
+    mod_sum->agg_record = agg_buf;
+    return(1);
+}
+
+int darshan_log_summary_create(const char *log_path, const char *summary_path)
+{
+    struct summary_file_header hdr;
+    struct summary_file_module fmod;
+    struct darshan_summary_module mod_sum;
+    struct stat st;
+    darshan_fd fd;
+    char *path = NULL;
+    char *tmp_path = NULL;
+    char *exe = NULL;
+    char *agg_buf = NULL;
+    long nmods_off;
+    FILE *f = NULL;
+    int tmp_fd;
+    int i;
+    int ret = -1;
+
+    if(stat(log_path, &st) < 0)
+    {
+        fprintf(stderr, "Error: unable to stat darshan log file %s.\n", log_path);
+        return(-1);
+    }
+
+    fd = darshan_log_open(log_path);
+    if(!fd)
+        return(-1);
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SUMMARY_MAGIC, sizeof(hdr.magic));
+    hdr.format_ver = SUMMARY_FORMAT_VER;
+    hdr.byte_order = SUMMARY_BYTE_ORDER;
+    hdr.job_size = sizeof(struct darshan_job);
+    hdr.metrics_size = sizeof(struct darshan_derived_metrics);
+    hdr.log_size = st.st_size;
+    hdr.log_mtime_ns = summary_mtime_ns(&st);
+    memcpy(hdr.version, fd->version, sizeof(hdr.version));
+    hdr.comp_type = fd->comp_type;
+    hdr.partial_flag = fd->partial_flag;
+    for(i = 0; i < DARSHAN_MAX_MODS; i++)
+    {
+        hdr.mod_ver[i] = fd->mod_ver[i];
+        hdr.mod_len[i] = fd->mod_map[i].len;
+    }
+
+    exe = malloc(DARSHAN_EXE_LEN + 1);
+    agg_buf = malloc(DEF_MOD_BUF_SIZE);
+    path = summary_default_path(log_path, summary_path);
+    if(!exe || !agg_buf || !path)
+        goto out;
+    tmp_path = malloc(strlen(path) + 8);
+    if(!tmp_path)
+        goto out;
+    tmp_path[0] = '\0';
+
+    if(darshan_log_get_job(fd, &hdr.job) < 0 || darshan_log_get_exe(fd, exe) < 0)
+        goto out;
+    hdr.exe_len = strlen(exe);
+
+    /* write to a temporary file that replaces the sidecar once complete,
+     * so readers never see a partial sidecar
+     */
+    sprintf(tmp_path, "%s.XXXXXX", path);
+    tmp_fd = mkstemp(tmp_path);
+    if(tmp_fd < 0)
+    {
+        fprintf(stderr, "Error: unable to create summary file %s.\n", tmp_path);
+        tmp_path[0] = '\0';
+        goto out;
+    }
+    /* the sidecar is as accessible as its log */
+    fchmod(tmp_fd, st.st_mode & 0666);
+    f = fdopen(tmp_fd, "w");
+    if(!f)
+    {
+        close(tmp_fd);
+        goto out;
+    }
+
+    nmods_off = offsetof(struct summary_file_header, nmods);
+    if(fwrite(&hdr, sizeof(hdr), 1, f) != 1 ||
+        fwrite(exe, 1, hdr.exe_len, f) != hdr.exe_len)
+        goto out;
+
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(fd->mod_map[i].len == 0 || !mod_logutils[i])
+            continue;
+
+        ret = summary_accumulate_module(fd, i, hdr.job.nprocs, &mod_sum, agg_buf);
+        if(ret < 0)
+            goto out;
+        ret = -1;
+        if(mod_sum.agg_record_size <= 0)
+            continue;
+
+        memset(&fmod, 0, sizeof(fmod));
+        fmod.mod_id = i;
+        fmod.agg_record_size = mod_sum.agg_record_size;
+        fmod.record_count = mod_sum.record_count;
+        fmod.metrics = mod_sum.metrics;
+        if(fwrite(&fmod, sizeof(fmod), 1, f) != 1 ||
+            fwrite(agg_buf, fmod.agg_record_size, 1, f) != 1)
+            goto out;
+        hdr.nmods++;
+    }
+
+    /* fill in the number of modules now that it is known */
+    if(fseek(f, nmods_off, SEEK_SET) < 0 ||
+        fwrite(&hdr.nmods, sizeof(hdr.nmods), 1, f) != 1)
+        goto out;
+
+    ret = fclose(f);
+    f = NULL;
+    if(ret == 0)
+        ret = rename(tmp_path, path);
+    if(ret < 0)
+        fprintf(stderr, "Error: unable to write summary file %s.\n", path);
+
+out:
+    if(f)
+    {
+        fclose(f);
+        ret = -1;
+    }
+    if(ret < 0 && tmp_path && tmp_path[0])
+        unlink(tmp_path);
+    free(tmp_path);
+    free(path);
+    free(exe);
+    free(agg_buf);
+    darshan_log_close(fd);
+    return(ret);
+}
+
+int darshan_log_summary_read(const char *log_path, const char *summary_path,
+    struct darshan_log_summary **summary)
+{
+    struct summary_file_header hdr;
+    struct summary_file_module fmod;
+    struct darshan_log_summary *sum;
+    struct darshan_summary_module *mod_sum;
+    struct stat st;
+    char *path;
+    FILE *f;
+    uint32_t i;
+    int ret = 1;
+
+    *summary = NULL;
+
+    path = summary_default_path(log_path, summary_path);
+    if(!path)
+        return(-1);
+    f = fopen(path, "r");
+    free(path);
+    if(!f)
+        return(1); /* no sidecar */
+
+    if(stat(log_path, &st) < 0 || fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+        memcmp(hdr.magic, SUMMARY_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.format_ver != SUMMARY_FORMAT_VER ||
+        hdr.byte_order != SUMMARY_BYTE_ORDER ||
+        hdr.job_size != sizeof(struct darshan_job) ||
+        hdr.metrics_size != sizeof(struct darshan_derived_metrics) ||
+        hdr.log_size != st.st_size ||
+        hdr.log_mtime_ns != summary_mtime_ns(&st) ||
+        hdr.exe_len > DARSHAN_EXE_LEN)
+    {
+        /* unusable or stale sidecar */
+        fclose(f);
+        return(1);
+    }
+
+    sum = calloc(1, sizeof(*sum));
+    if(!sum)
+        goto out;
+    memcpy(sum->version, hdr.version, sizeof(sum->version));
+    sum->version[sizeof(sum->version)-1] = '\0';
+    sum->comp_type = hdr.comp_type;
+    sum->partial_flag = hdr.partial_flag;
+    memcpy(sum->mod_ver, hdr.mod_ver, sizeof(sum->mod_ver));
+    memcpy(sum->mod_len, hdr.mod_len, sizeof(sum->mod_len));
+    sum->job = hdr.job;
+    sum->exe = calloc(1, hdr.exe_len + 1);
+    if(!sum->exe)
+    {
+        ret = -1;
+        goto out;
+    }
+    if(fread(sum->exe, 1, hdr.exe_len, f) != hdr.exe_len)
+        goto out;
+
+    for(i = 0; i < hdr.nmods; i++)
+    {
+        if(fread(&fmod, sizeof(fmod), 1, f) != 1 ||
+            fmod.mod_id >= DARSHAN_KNOWN_MODULE_COUNT ||
+            fmod.agg_record_size == 0 || fmod.agg_record_size > DEF_MOD_BUF_SIZE ||
+            sum->mods[fmod.mod_id])
+            goto out;
+
+        mod_sum = calloc(1, sizeof(*mod_sum));
+        if(!mod_sum)
+        {
+            ret = -1;
+            goto out;
+        }
+        sum->mods[fmod.mod_id] = mod_sum;
+        mod_sum->record_count = fmod.record_count;
+        mod_sum->metrics = fmod.metrics;
+        mod_sum->agg_record_size = fmod.agg_record_size;
+        mod_sum->agg_record = malloc(fmod.agg_record_size);
+        if(!mod_sum->agg_record)
+        {
+            ret = -1;
+            goto out;
+        }
+        if(fread(mod_sum->agg_record, fmod.agg_record_size, 1, f) != 1)
+            goto out;
+    }
+
+    fclose(f);
+    *summary = sum;
+    return(0);
+
+out:
+    /* a truncated or corrupt sidecar is treated like a missing one */
+    if(!sum)
+        ret = -1;
+    fclose(f);
+    darshan_log_summary_free(sum);
+    return(ret);
+}
+
+void darshan_log_summary_free(struct darshan_log_summary *summary)
+{
+    int i;
+
+    if(!summary)
+        return;
+
+    for(i = 0; i < DARSHAN_MAX_MODS; i++)
+    {
+        if(summary->mods[i])
+        {
+            free(summary->mods[i]->agg_record);
+            free(summary->mods[i]);
+        }
+    }
+    free(summary->exe);
+    free(summary);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
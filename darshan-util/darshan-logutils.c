@@ -12,16 +12,23 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <inttypes.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <limits.h>
+#include <pthread.h>
 #ifdef HAVE_LIBBZ2
 #include <bzlib.h>
 #endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
 
 #include "darshan-logutils.h"
 
@@ -36,6 +43,18 @@
 #define DARSHAN_JOB_REGION_ID       (-2)
 #define DARSHAN_NAME_MAP_REGION_ID  (-1)
 
+#ifdef HAVE_LIBZSTD
+/* zstd streaming state: a compression or decompression context, plus
+ * the position within the staged input (zstd does not track it for us)
+ */
+struct darshan_zstd_state
+{
+    ZSTD_CCtx *cctx;
+    ZSTD_DCtx *dctx;
+    ZSTD_inBuffer in;
+};
+#endif
+
 struct darshan_dz_state
 {
     /* pointer to arbitrary data structure used for managing
@@ -51,6 +70,15 @@ struct darshan_dz_state
     int eor;
     /* the region id we last tried reading/writing */
     int prev_reg_id;
+    /* for reading logs, flag indicating reads of the current region are
+     * limited to the data of a single process, located by 'strm_map'
+     */
+    int strm_limit_flag;
+    struct darshan_log_map strm_map;
+    /* for reading mapped uncompressed logs, the mapped log data used in
+     * place of the staging buffer
+     */
+    char *map_data;
 };
 
 /* internal fd data structure */
@@ -72,10 +100,59 @@ struct darshan_fd_int_state
      * data from the log file
      */
     int (*get_namerecs)(void *, int, int, struct darshan_name_record_ref **,
-                        darshan_record_id *, int);
+                        darshan_record_id *, int, char *);
 
     /* compression/decompression stream read/write state */
     struct darshan_dz_state dz;
+    /* location of the compressed chunk index (if any) */
+    struct darshan_log_map chunk_map;
+    /* location of the record index (if any), and the index once read */
+    struct darshan_log_map rec_index_map;
+    struct darshan_log_rec_index *rec_index;
+    int rec_index_count;
+    /* the chunk index, once read */
+    struct darshan_log_chunk *chunk_index;
+    int chunk_index_count;
+    /* number of threads used to decompress log regions */
+    int nthreads;
+    /* a log region decompressed in parallel, which reads of the region
+     * are served from (if 'pz_buf' is set)
+     */
+    int pz_reg_id;
+    char *pz_buf;
+    uint64_t pz_size;
+    uint64_t pz_pos;
+    /* the log file mapped into memory (uncompressed logs only) */
+    char *mmap_buf;
+    uint64_t mmap_len;
+    /* buffer holding the last record returned by
+     * darshan_log_get_record_ref(), when it isn't read in place
+     */
+    void *ref_buf;
+    int ref_buf_size;
+};
+
+/* one independently compressed stream of a log region being decompressed
+ * in parallel. 'dst_len' is 0 if the decompressed length isn't known in
+ * advance, in which case 'dst' is allocated by the decompressing thread.
+ */
+struct darshan_pz_stream
+{
+    unsigned char *src;
+    uint64_t src_len;
+    char *dst;
+    uint64_t dst_len;
+};
+
+/* shared state for threads decompressing the streams of a log region */
+struct darshan_pz_state
+{
+    struct darshan_pz_stream *streams;
+    int nstreams;
+    int comp_type;
+    int next_stream;
+    int err;
+    pthread_mutex_t mutex;
 };
 
 /* each module's implementation of the darshan logutil functions */
@@ -90,7 +167,8 @@ struct darshan_mod_logutil_funcs *mod_logutils[DARSHAN_KNOWN_MODULE_COUNT] =
 static int darshan_mnt_info_cmp(const void *a, const void *b);
 static int darshan_log_get_namerecs(void *name_rec_buf, int buf_len,
     int swap_flag, struct darshan_name_record_ref **hash,
-    darshan_record_id *whitelist, int whitelist_count);
+    darshan_record_id *whitelist, int whitelist_count, char *prev_name);
+static int darshan_name_record_cmp(const void *a, const void *b);
 static int darshan_log_get_format_version(char *ver_str, int *maj_num, int *min_num);
 static int darshan_log_get_header(darshan_fd fd);
 static int darshan_log_put_header(darshan_fd fd);
@@ -113,15 +191,41 @@ static int darshan_log_bzip2_write(darshan_fd fd, struct darshan_log_map *map_p,
     void *buf, int len, int flush_strm_flag);
 static int darshan_log_bzip2_flush(darshan_fd fd, int region_id);
 #endif
+#ifdef HAVE_LIBZSTD
+static int darshan_log_zstd_read(darshan_fd fd, struct darshan_log_map map,
+    void *buf, int len, int reset_strm_flag);
+static int darshan_log_zstd_write(darshan_fd fd, struct darshan_log_map *map_p,
+    void *buf, int len, int flush_strm_flag);
+static int darshan_log_zstd_flush(darshan_fd fd, int region_id);
+#endif
 static int darshan_log_dzload(darshan_fd fd, struct darshan_log_map map);
 static int darshan_log_dzunload(darshan_fd fd, struct darshan_log_map *map_p);
 static int darshan_log_noz_read(darshan_fd fd, struct darshan_log_map map,
     void *buf, int len, int reset_strm_flag);
+static int darshan_log_noz_write(darshan_fd fd, struct darshan_log_map *map_p,
+    void *buf, int len, int flush_strm_flag);
+static int darshan_log_noz_flush(darshan_fd fd, int region_id);
+static int darshan_log_noz_unload(darshan_fd fd, struct darshan_log_map *map_p);
+static int darshan_log_noz_mapload(darshan_fd fd, struct darshan_log_map map);
+static int darshan_log_noz_ref(darshan_fd fd, int region_id, void **ptr,
+    int len);
+static void darshan_log_mmap(darshan_fd fd);
+static void darshan_log_dzreset(darshan_fd fd);
+static void darshan_log_pzload(darshan_fd fd, int region_id);
+static int darshan_log_pzread(darshan_fd fd, void *buf, int len);
+static void darshan_log_pzfree(darshan_fd fd);
+static int darshan_log_get_index(darshan_fd fd, struct darshan_log_map map,
+    int entry_size, void **entries, int *count);
+static int darshan_log_load_rec_index(darshan_fd fd);
+static int darshan_log_load_chunk_index(darshan_fd fd);
 
 /* backwards compatibility functions */
 static int darshan_log_get_namerecs_3_00(void *name_rec_buf, int buf_len,
     int swap_flag, struct darshan_name_record_ref **hash,
-    darshan_record_id *whitelist, int whitelist_count);
+    darshan_record_id *whitelist, int whitelist_count, char *prev_name);
+static int darshan_log_get_namerecs_3_41(void *name_rec_buf, int buf_len,
+    int swap_flag, struct darshan_name_record_ref **hash,
+    darshan_record_id *whitelist, int whitelist_count, char *prev_name);
 
 static char *darshan_util_lib_ver = PACKAGE_VERSION;
 
@@ -189,6 +293,10 @@ darshan_fd darshan_log_open(const char *name)
         return(NULL);
     }
 
+    /* uncompressed logs are read directly from a mapping of the file */
+    if(tmp_fd->comp_type == DARSHAN_NO_COMP)
+        darshan_log_mmap(tmp_fd);
+
     return(tmp_fd);
 }
 
@@ -633,6 +741,7 @@ int darshan_log_get_filtered_namehash(darshan_fd fd,
     struct darshan_fd_int_state *state;
     char *name_rec_buf;
     int name_rec_buf_sz;
+    char *prev_name;
     int read;
     int read_req_sz;
     int buf_len = 0;
@@ -660,6 +769,15 @@ int darshan_log_get_filtered_namehash(darshan_fd fd,
         return(-1);
     memset(name_rec_buf, 0, name_rec_buf_sz);
 
+    /* front coded names are decoded relative to the previous name */
+    prev_name = malloc(__DARSHAN_PATH_MAX + 1);
+    if(!prev_name)
+    {
+        free(name_rec_buf);
+        return(-1);
+    }
+    prev_name[0] = '\0';
+
     do
     {
         /* read chunks of the darshan record id -> name mapping from log file,
@@ -672,13 +790,20 @@ int darshan_log_get_filtered_namehash(darshan_fd fd,
         {
             fprintf(stderr, "Error: failed to read name hash from darshan log file.\n");
             free(name_rec_buf);
+            free(prev_name);
             return(-1);
         }
         buf_len += read;
 
         /* extract any name records in the buffer */
         buf_processed = state->get_namerecs(name_rec_buf, buf_len, fd->swap_flag, hash,
-            whitelist, whitelist_count);
+            whitelist, whitelist_count, prev_name);
+        if(buf_processed < 0)
+        {
+            free(name_rec_buf);
+            free(prev_name);
+            return(-1);
+        }
 
         /* copy any leftover data to beginning of buffer to parse next */
         memcpy(name_rec_buf, name_rec_buf + buf_processed, buf_len - buf_processed);
@@ -691,6 +816,7 @@ int darshan_log_get_filtered_namehash(darshan_fd fd,
     assert(buf_len == 0);
 
     free(name_rec_buf);
+    free(prev_name);
     return(0);
 }
 
@@ -707,9 +833,15 @@ int darshan_log_put_namehash(darshan_fd fd, struct darshan_name_record_ref *hash
 {
     struct darshan_fd_int_state *state;
     struct darshan_name_record_ref *ref, *tmp;
-    struct darshan_name_record *name_rec;
-    int name_rec_len;
+    struct darshan_name_record **name_recs;
+    const char *prev_name = "";
+    const char *name;
+    char *enc_rec, *enc_p;
+    int name_rec_cnt = 0;
+    int prefix_len, suffix_len;
+    int enc_len;
     int wrote;
+    int i;
 
     if(!fd)
     {
@@ -719,31 +851,62 @@ int darshan_log_put_namehash(darshan_fd fd, struct darshan_name_record_ref *hash
     state = fd->state;
     assert(state);
 
-    /* allocate memory for largest possible hash record */
-    name_rec = malloc(sizeof(darshan_record_id) + __DARSHAN_PATH_MAX + 1);
-    if(!name_rec)
+    /* allocate memory for largest possible encoded name record */
+    enc_rec = malloc(sizeof(darshan_record_id) + 2 + __DARSHAN_PATH_MAX + 1);
+    name_recs = malloc((HASH_CNT(hlink, hash) + 1) * sizeof(*name_recs));
+    if(!enc_rec || !name_recs)
+    {
+        free(enc_rec);
+        free(name_recs);
         return(-1);
-    memset(name_rec, 0, sizeof(darshan_record_id) + __DARSHAN_PATH_MAX + 1);
+    }
 
-    /* individually serialize each hash record and write to log file */
+    /* sort name records by name so they can be front coded */
     HASH_ITER(hlink, hash, ref, tmp)
     {
-        name_rec_len = sizeof(darshan_record_id) + strlen(ref->name_record->name) + 1;
-        memcpy(name_rec, ref->name_record, name_rec_len);
+        name_recs[name_rec_cnt++] = ref->name_record;
+    }
+    qsort(name_recs, name_rec_cnt, sizeof(*name_recs), darshan_name_record_cmp);
+
+    /* individually encode each name record and write to log file */
+    for(i = 0; i < name_rec_cnt; i++)
+    {
+        name = name_recs[i]->name;
+        for(prefix_len = 0; (prefix_len < DARSHAN_NAME_PREFIX_MAX) &&
+            prev_name[prefix_len] &&
+            (prev_name[prefix_len] == name[prefix_len]); prefix_len++);
+        suffix_len = strlen(name + prefix_len) + 1;
+
+        enc_p = enc_rec;
+        memcpy(enc_p, &name_recs[i]->id, sizeof(darshan_record_id));
+        enc_p += sizeof(darshan_record_id);
+        if(prefix_len < 0x80)
+            *enc_p++ = prefix_len;
+        else
+        {
+            *enc_p++ = 0x80 | (prefix_len >> 8);
+            *enc_p++ = prefix_len & 0xFF;
+        }
+        memcpy(enc_p, name + prefix_len, suffix_len);
+        enc_len = (enc_p - enc_rec) + suffix_len;
 
         /* write this hash entry to log file */
         wrote = darshan_log_dzwrite(fd, DARSHAN_NAME_MAP_REGION_ID,
-            name_rec, name_rec_len);
-        if(wrote != name_rec_len)
+            enc_rec, enc_len);
+        if(wrote != enc_len)
         {
             state->err = -1;
             fprintf(stderr, "Error: failed to write name hash to darshan log file.\n");
-            free(name_rec);
+            free(enc_rec);
+            free(name_recs);
             return(-1);
         }
+
+        prev_name = name;
     }
 
-    free(name_rec);
+    free(enc_rec);
+    free(name_recs);
     return(0);
 }
 
@@ -850,6 +1013,266 @@ int darshan_log_put_mod(darshan_fd fd, darshan_module_id mod_id,
     return(0);
 }
 
+/* darshan_log_get_chunk_index()
+ *
+ * read the index of independently compressed chunks of log data, if the
+ * log includes one. On success, '*chunks' is set to an array (which must
+ * be freed by the caller) of '*chunk_count' chunk descriptors, sorted by
+ * region and offset. '*chunk_count' is set to 0 if there is no index.
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_get_chunk_index(darshan_fd fd, struct darshan_log_chunk **chunks,
+    int *chunk_count)
+{
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+    assert(fd->state);
+
+    return(darshan_log_get_index(fd, fd->state->chunk_map,
+        sizeof(struct darshan_log_chunk), (void **)chunks, chunk_count));
+}
+
+/* darshan_log_get_record_index()
+ *
+ * read the index describing where each process's module data is stored
+ * in the log, if the log includes one. On success, '*index' is set to an
+ * array (which must be freed by the caller) of '*index_count' entries,
+ * sorted by module and offset. '*index_count' is set to 0 if there is
+ * no index.
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_get_record_index(darshan_fd fd, struct darshan_log_rec_index **index,
+    int *index_count)
+{
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+    assert(fd->state);
+
+    return(darshan_log_get_index(fd, fd->state->rec_index_map,
+        sizeof(struct darshan_log_rec_index), (void **)index, index_count));
+}
+
+/* darshan_log_seek_rank()
+ *
+ * position the given module's log data so that the next record read from
+ * it (e.g., with darshan_log_get_record()) is the first record stored by
+ * the process with the given rank, or by the next higher rank that stored
+ * any records. Records of shared files are stored by rank 0. Requires the
+ * log to include a record index.
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_seek_rank(darshan_fd fd, darshan_module_id mod_id, int64_t rank)
+{
+    struct darshan_fd_int_state *state;
+    struct darshan_log_rec_index *entry = NULL;
+    int i;
+
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+    state = fd->state;
+    assert(state);
+
+    if(mod_id < 0 || mod_id >= DARSHAN_KNOWN_MODULE_COUNT)
+    {
+        fprintf(stderr, "Error: invalid Darshan module id.\n");
+        return(-1);
+    }
+
+    if(darshan_log_load_rec_index(fd) < 0)
+        return(-1);
+    if(state->rec_index_map.len == 0)
+    {
+        fprintf(stderr, "Error: darshan log file has no record index.\n");
+        return(-1);
+    }
+
+    for(i = 0; i < state->rec_index_count; i++)
+    {
+        if(state->rec_index[i].region_id == mod_id &&
+            state->rec_index[i].rank >= rank)
+        {
+            entry = &state->rec_index[i];
+            break;
+        }
+    }
+
+    darshan_log_dzreset(fd);
+    state->dz.prev_reg_id = mod_id;
+    state->dz.strm_limit_flag = 0;
+    if(!entry)
+    {
+        /* no more records in this region: flag the end of the region, and
+         * move out of it so that later reads restart at its beginning
+         */
+        state->dz.eor = 1;
+        return(darshan_log_seek(fd, 0));
+    }
+
+    /* reads continue from this process's data to the end of the region */
+    return(darshan_log_seek(fd, entry->off));
+}
+
+/* darshan_log_get_record_by_id()
+ *
+ * retrieve the record with the given id from a module's log data. If the
+ * log includes a record index, only the data of processes that may have
+ * stored the record is decompressed; otherwise all of the module's data is
+ * searched. Any ongoing traversal of the module's records (e.g., with
+ * darshan_log_get_record()) restarts at the beginning of the module's data
+ * afterwards. '*buf' must be NULL on input, and is set to a newly allocated
+ * record (which must be freed by the caller) if one is found. If several
+ * processes stored a record with this id, the one stored by the lowest
+ * rank is returned.
+ *
+ * returns 1 if the record was found, 0 if not, -1 on failure
+ */
+int darshan_log_get_record_by_id(darshan_fd fd, darshan_module_id mod_id,
+    darshan_record_id rec_id, void **buf)
+{
+    struct darshan_fd_int_state *state;
+    struct darshan_log_rec_index *entry;
+    struct darshan_log_rec_index whole_region;
+    struct darshan_base_record *base_rec;
+    void *rec;
+    int count;
+    int found = 0;
+    int ret = 0;
+    int i;
+
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+    state = fd->state;
+    assert(state);
+
+    if(mod_id < 0 || mod_id >= DARSHAN_KNOWN_MODULE_COUNT)
+    {
+        fprintf(stderr, "Error: invalid Darshan module id.\n");
+        return(-1);
+    }
+    if(!mod_logutils[mod_id] || fd->mod_map[mod_id].len == 0)
+        return(0);
+
+    if(darshan_log_load_rec_index(fd) < 0)
+        return(-1);
+
+    /* without an index, the whole region is a single candidate */
+    entry = state->rec_index;
+    count = state->rec_index_count;
+    if(state->rec_index_map.len == 0)
+    {
+        memset(&whole_region, 0, sizeof(whole_region));
+        whole_region.region_id = mod_id;
+        whole_region.off = fd->mod_map[mod_id].off;
+        whole_region.len = fd->mod_map[mod_id].len;
+        entry = &whole_region;
+        count = 1;
+    }
+
+    for(i = 0; i < count && !found && ret == 0; i++)
+    {
+        if(entry[i].region_id != mod_id)
+            continue;
+        if(entry != &whole_region &&
+            (rec_id < entry[i].min_id || rec_id > entry[i].max_id ||
+             !DARSHAN_REC_INDEX_FILTER_TEST(entry[i].id_filter, rec_id)))
+            continue;
+
+        /* read records from just this process's data */
+        darshan_log_dzreset(fd);
+        state->dz.prev_reg_id = mod_id;
+        state->dz.strm_limit_flag = 1;
+        state->dz.strm_map.off = entry[i].off;
+        state->dz.strm_map.len = entry[i].len;
+        if(darshan_log_seek(fd, entry[i].off) < 0)
+        {
+            ret = -1;
+            break;
+        }
+
+        while(1)
+        {
+            rec = NULL;
+            ret = mod_logutils[mod_id]->log_get_record(fd, &rec);
+            if(ret < 1)
+                break;
+
+            base_rec = (struct darshan_base_record *)rec;
+            if(base_rec->id == rec_id)
+            {
+                *buf = rec;
+                found = 1;
+                break;
+            }
+            free(rec);
+        }
+        if(ret > 0)
+            ret = 0;
+    }
+
+    /* restart any later reads of this region at its beginning */
+    darshan_log_dzreset(fd);
+    state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+    state->dz.strm_limit_flag = 0;
+    if(darshan_log_seek(fd, 0) < 0)
+        ret = -1;
+
+    if(ret < 0)
+    {
+        if(found)
+        {
+            free(*buf);
+            *buf = NULL;
+        }
+        return(-1);
+    }
+    return(found);
+}
+
+/* darshan_log_set_threads()
+ *
+ * set the number of threads used to decompress each region of the given
+ * log. With more than one thread, a region is decompressed all at once
+ * when reading of it starts, if the independently compressed streams it is
+ * made of can be located (using the log's chunk index or record index, or
+ * by scanning zstd frames); otherwise it is decompressed as it is read,
+ * as usual.
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_set_threads(darshan_fd fd, int nthreads)
+{
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+    assert(fd->state);
+
+    if(nthreads < 1)
+    {
+        fprintf(stderr, "Error: invalid number of threads.\n");
+        return(-1);
+    }
+
+    fd->state->nthreads = nthreads;
+    return(0);
+}
+
 /* darshan_log_close()
  *
  * close an open darshan file descriptor, freeing any resources
@@ -884,6 +1307,16 @@ void darshan_log_close(darshan_fd fd)
                 if(ret == 0)
                     break;
 #endif 
+#ifdef HAVE_LIBZSTD
+            case DARSHAN_ZSTD_COMP:
+                ret = darshan_log_zstd_flush(fd, state->dz.prev_reg_id);
+                if(ret == 0)
+                    break;
+#endif
+            case DARSHAN_NO_COMP:
+                ret = darshan_log_noz_flush(fd, state->dz.prev_reg_id);
+                if(ret == 0)
+                    break;
             default:
                 /* if flush fails, remove the output log file */
                 state->err = -1;
@@ -913,6 +1346,12 @@ void darshan_log_close(darshan_fd fd)
     darshan_log_dzdestroy(fd);
     if(state->exe_mnt_data)
         free(state->exe_mnt_data);
+    free(state->rec_index);
+    free(state->chunk_index);
+    darshan_log_pzfree(fd);
+    if(state->mmap_buf)
+        munmap(state->mmap_buf, state->mmap_len);
+    free(state->ref_buf);
     free(state);
     free(fd);
 
@@ -963,6 +1402,14 @@ int darshan_log_get_job_runtime(darshan_fd fd, struct darshan_job job, double *r
  *             internal helper functions                *
  ********************************************************/
 
+static int darshan_name_record_cmp(const void *a, const void *b)
+{
+    const struct darshan_name_record *rec_a = *(struct darshan_name_record * const *)a;
+    const struct darshan_name_record *rec_b = *(struct darshan_name_record * const *)b;
+
+    return(strcmp(rec_a->name, rec_b->name));
+}
+
 static int darshan_mnt_info_cmp(const void *a, const void *b)
 {
     struct darshan_mnt_info *m_a = (struct darshan_mnt_info *)a;
@@ -995,75 +1442,93 @@ int whitelist_filter(darshan_record_id val, darshan_record_id *whitelist, int wh
 
 static int darshan_log_get_namerecs(void *name_rec_buf, int buf_len,
     int swap_flag, struct darshan_name_record_ref **hash,
-    darshan_record_id *whitelist, int whitelist_count)
+    darshan_record_id *whitelist, int whitelist_count, char *prev_name)
 {
     struct darshan_name_record_ref *ref;
-    struct darshan_name_record *name_rec;
-    char *tmp_p;
-    int buf_processed = 0;
+    darshan_record_id rec_id;
+    char *buf_ptr;
+    char *suffix;
+    int prefix_len, prefix_bytes;
+    int suffix_len, name_len;
     int rec_len;
+    int buf_processed = 0;
 
-    /* work through the name record buffer -- deserialize the record data
-     * and add to the output hash table
-     * NOTE: these mapping pairs are variable in length, so we have to be able
-     * to handle incomplete mappings temporarily here
+    /* work through the name record buffer -- decode each front coded name
+     * using the previous name, and add the record to the output hash table
+     * NOTE: these records are variable in length, so we have to be able
+     * to handle incomplete records temporarily here
      */
-    name_rec = (struct darshan_name_record *)name_rec_buf;
-    while(buf_len >= sizeof(darshan_record_id) + 1)
+    buf_ptr = name_rec_buf;
+    while(buf_len > (int)sizeof(darshan_record_id) + 1)
     {
-        if(strnlen(name_rec->name, buf_len - sizeof(darshan_record_id)) ==
-            (buf_len - sizeof(darshan_record_id)))
+        /* get the length of the prefix shared with the previous name */
+        prefix_len = (unsigned char)buf_ptr[sizeof(darshan_record_id)];
+        prefix_bytes = 1;
+        if(prefix_len & 0x80)
         {
-            /* if this record name's terminating null character is not
-             * present, we need to read more of the buffer before continuing
-             */
+            prefix_len = ((prefix_len & 0x7F) << 8) |
+                (unsigned char)buf_ptr[sizeof(darshan_record_id) + 1];
+            prefix_bytes = 2;
+        }
+        rec_len = sizeof(darshan_record_id) + prefix_bytes;
+        if(buf_len <= rec_len)
+            break;
+
+        /* if the suffix's terminating null character is not present, we
+         * need to read more of the buffer before continuing
+         */
+        suffix = buf_ptr + rec_len;
+        suffix_len = strnlen(suffix, buf_len - rec_len);
+        if(suffix_len == buf_len - rec_len)
             break;
+        rec_len += suffix_len + 1;
+
+        name_len = prefix_len + suffix_len;
+        if((prefix_len > (int)strlen(prev_name)) || (name_len > __DARSHAN_PATH_MAX))
+        {
+            fprintf(stderr, "Error: invalid name record in darshan log file.\n");
+            return(-1);
         }
-        rec_len = sizeof(darshan_record_id) + strlen(name_rec->name) + 1;
+        memcpy(prev_name + prefix_len, suffix, suffix_len + 1);
 
+        memcpy(&rec_id, buf_ptr, sizeof(darshan_record_id));
         if(swap_flag)
         {
             /* we need to sort out endianness issues before deserializing */
-            DARSHAN_BSWAP64(&(name_rec->id));
+            DARSHAN_BSWAP64(&rec_id);
         }
 
-        HASH_FIND(hlink, *hash, &(name_rec->id), sizeof(darshan_record_id), ref);
+        HASH_FIND(hlink, *hash, &rec_id, sizeof(darshan_record_id), ref);
         if(!ref && (!whitelist ||
-            whitelist_filter(name_rec->id, whitelist, whitelist_count)))
+            whitelist_filter(rec_id, whitelist, whitelist_count)))
         {
             ref = malloc(sizeof(*ref));
             if(!ref)
                 return(-1);
 
-            ref->name_record = malloc(rec_len);
+            ref->name_record = malloc(sizeof(darshan_record_id) + name_len + 1);
             if(!ref->name_record)
             {
                 free(ref);
                 return(-1);
             }
-
-            /* copy the name record over from the hash buffer */
-            memcpy(ref->name_record, name_rec, rec_len);
+            ref->name_record->id = rec_id;
+            memcpy(ref->name_record->name, prev_name, name_len + 1);
 
             /* add this record to the hash */
             HASH_ADD(hlink, *hash, name_record->id, sizeof(darshan_record_id), ref);
         }
-        else if(ref && !strlen(ref->name_record->name) && strlen(name_rec->name) > 0)
+        else if(ref && !strlen(ref->name_record->name) && name_len > 0)
         {
             free(ref->name_record);
-            ref->name_record = malloc(rec_len);
+            ref->name_record = malloc(sizeof(darshan_record_id) + name_len + 1);
             if(!ref->name_record)
-            {
-                free(ref);
                 return(-1);
-            }
-
-            /* copy the name record over from the hash buffer */
-            memcpy(ref->name_record, name_rec, rec_len);
+            ref->name_record->id = rec_id;
+            memcpy(ref->name_record->name, prev_name, name_len + 1);
         }
 
-        tmp_p = (char *)name_rec + rec_len;
-        name_rec = (struct darshan_name_record *)tmp_p;
+        buf_ptr += rec_len;
         buf_len -= rec_len;
         buf_processed += rec_len;
     }
@@ -1135,7 +1600,12 @@ static int darshan_log_get_header(darshan_fd fd)
                  (log_ver_min == 21) ||
                  (log_ver_min == 41)))
     {
-        fd->state->get_namerecs = darshan_log_get_namerecs;
+        fd->state->get_namerecs = darshan_log_get_namerecs_3_41;
+    }
+    else if((log_ver_maj == 3) && (log_ver_min == 42))
+    {
+        /* set below, according to the name record encoding in the header */
+        fd->state->get_namerecs = NULL;
     }
     else
     {
@@ -1155,7 +1625,7 @@ static int darshan_log_get_header(darshan_fd fd)
 
     /* read uncompressed header from log file */
     /* NOTE: header bumped from 16 to 64 modules at log ver 3.41 */
-    if(((log_ver_maj == 3) && (log_ver_min >= 41)) || (log_ver_maj > 3))
+    if(((log_ver_maj == 3) && (log_ver_min >= 42)) || (log_ver_maj > 3))
     {
         ret = darshan_log_read(fd, &header, sizeof(header));
         if(ret != (int)sizeof(header))
@@ -1166,6 +1636,21 @@ static int darshan_log_get_header(darshan_fd fd)
 
         fd->job_map.off = sizeof(struct darshan_header);
     }
+    else if((log_ver_maj == 3) && (log_ver_min == 41))
+    {
+        /* the chunk index map, name record encoding, and record index map
+         * were appended to the header at log ver 3.42
+         */
+        memset(&header, 0, sizeof(header));
+        ret = darshan_log_read(fd, &header, offsetof(struct darshan_header, chunk_map));
+        if(ret != (int)offsetof(struct darshan_header, chunk_map))
+        {
+            fprintf(stderr, "Error: failed to read darshan log file header.\n");
+            return(-1);
+        }
+
+        fd->job_map.off = offsetof(struct darshan_header, chunk_map);
+    }
     else
     {
         /* backwards compatibility with 3.00 version of Darshan header */
@@ -1225,6 +1710,11 @@ static int darshan_log_get_header(darshan_fd fd)
                 DARSHAN_BSWAP64(&(header.mod_map[i].len));
                 DARSHAN_BSWAP32(&(header.mod_ver[i]));
             }
+            DARSHAN_BSWAP64(&(header.chunk_map.off));
+            DARSHAN_BSWAP64(&(header.chunk_map.len));
+            DARSHAN_BSWAP64(&(header.name_enc));
+            DARSHAN_BSWAP64(&(header.rec_index_map.off));
+            DARSHAN_BSWAP64(&(header.rec_index_map.len));
         }
         else
         {
@@ -1239,9 +1729,26 @@ static int darshan_log_get_header(darshan_fd fd)
     fd->partial_flag = header.partial_flag;
     memcpy(fd->mod_ver, header.mod_ver, DARSHAN_MAX_MODS * sizeof(uint32_t));
 
+    if(!fd->state->get_namerecs)
+    {
+        if(header.name_enc == DARSHAN_NAME_ENC_FRONT_CODED)
+            fd->state->get_namerecs = darshan_log_get_namerecs;
+        else if(header.name_enc == DARSHAN_NAME_ENC_PLAIN)
+            fd->state->get_namerecs = darshan_log_get_namerecs_3_41;
+        else
+        {
+            fprintf(stderr, "Error: unknown name record encoding (%" PRIu64 ").\n",
+                header.name_enc);
+            return(-1);
+        }
+    }
+
     /* save the mapping of data within log file to this file descriptor */
     memcpy(&fd->name_map, &(header.name_map), sizeof(struct darshan_log_map));
     memcpy(&fd->mod_map, &(header.mod_map), DARSHAN_MAX_MODS * sizeof(struct darshan_log_map));
+    memcpy(&fd->state->chunk_map, &(header.chunk_map), sizeof(struct darshan_log_map));
+    memcpy(&fd->state->rec_index_map, &(header.rec_index_map),
+        sizeof(struct darshan_log_map));
 
     if((log_ver_maj == 3) && (log_ver_min < 20))
     {
@@ -1338,6 +1845,7 @@ static int darshan_log_put_header(darshan_fd fd)
     header.magic_nr = DARSHAN_MAGIC_NR;
     header.comp_type = fd->comp_type;
     header.partial_flag = fd->partial_flag;
+    header.name_enc = DARSHAN_NAME_ENC_FRONT_CODED;
     memcpy(&header.name_map, &fd->name_map, sizeof(struct darshan_log_map));
     memcpy(header.mod_map, fd->mod_map, DARSHAN_MAX_MODS * sizeof(struct darshan_log_map));
     memcpy(header.mod_ver, fd->mod_ver, DARSHAN_MAX_MODS * sizeof(uint32_t));
@@ -1506,14 +2014,47 @@ static int darshan_log_dzinit(darshan_fd fd)
             break;
         }
 #endif
-        case DARSHAN_NO_COMP:
+#ifdef HAVE_LIBZSTD
+        case DARSHAN_ZSTD_COMP:
         {
-            /* we just track an offset into the staging buffers for no_comp */
-            int *buf_off = malloc(sizeof(int));
-            *buf_off = 0;
-            state->dz.comp_dat = buf_off;
-            break;
-        }
+            struct darshan_zstd_state *tmp_zs = calloc(1, sizeof(*tmp_zs));
+            if(!tmp_zs)
+            {
+                free(state->dz.buf);
+                return(-1);
+            }
+
+            if(!(state->creat_flag))
+            {
+                /* read only file, init decompression context */
+                tmp_zs->dctx = ZSTD_createDCtx();
+            }
+            else
+            {
+                /* write only file, init compression context */
+                tmp_zs->cctx = ZSTD_createCCtx();
+                if(tmp_zs->cctx)
+                    ZSTD_CCtx_setParameter(tmp_zs->cctx,
+                        ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+            }
+            if(!tmp_zs->dctx && !tmp_zs->cctx)
+            {
+                free(tmp_zs);
+                free(state->dz.buf);
+                return(-1);
+            }
+            state->dz.comp_dat = tmp_zs;
+            break;
+        }
+#endif
+        case DARSHAN_NO_COMP:
+        {
+            /* we just track an offset into the staging buffers for no_comp */
+            int *buf_off = malloc(sizeof(int));
+            *buf_off = 0;
+            state->dz.comp_dat = buf_off;
+            break;
+        }
         default:
             fprintf(stderr, "Error: invalid compression type.\n");
             return(-1);
@@ -1541,6 +2082,15 @@ static void darshan_log_dzdestroy(darshan_fd fd)
             else
                 BZ2_bzCompressEnd((bz_stream *)state->dz.comp_dat);
             break;
+#endif
+#ifdef HAVE_LIBZSTD
+        case DARSHAN_ZSTD_COMP:
+        {
+            struct darshan_zstd_state *zs = state->dz.comp_dat;
+            ZSTD_freeDCtx(zs->dctx);
+            ZSTD_freeCCtx(zs->cctx);
+            break;
+        }
 #endif
         case DARSHAN_NO_COMP:
             /* do nothing */
@@ -1566,13 +2116,26 @@ static int darshan_log_dzread(darshan_fd fd, int region_id, void *buf, int len)
     {
         state->dz.eor = 0;
         state->dz.size = 0;
-        reset_strm_flag = 1; /* reset libz/bzip2 streams */
+        state->dz.strm_limit_flag = 0;
+        reset_strm_flag = 1; /* reset libz/bzip2/zstd streams */
+
+        if(state->nthreads > 1 && region_id != DARSHAN_JOB_REGION_ID)
+            darshan_log_pzload(fd, region_id);
+    }
+
+    /* serve reads from the region's data if it was decompressed in parallel */
+    if(state->pz_buf && state->pz_reg_id == region_id)
+    {
+        state->dz.prev_reg_id = region_id;
+        return(darshan_log_pzread(fd, buf, len));
     }
 
     if(region_id == DARSHAN_JOB_REGION_ID)
         map = fd->job_map;
     else if(region_id == DARSHAN_NAME_MAP_REGION_ID)
         map = fd->name_map;
+    else if(state->dz.strm_limit_flag)
+        map = state->dz.strm_map;
     else
         map = fd->mod_map[region_id];
 
@@ -1585,6 +2148,11 @@ static int darshan_log_dzread(darshan_fd fd, int region_id, void *buf, int len)
         case DARSHAN_BZIP2_COMP:
             ret = darshan_log_bzip2_read(fd, map, buf, len, reset_strm_flag);
             break;
+#endif
+#ifdef HAVE_LIBZSTD
+        case DARSHAN_ZSTD_COMP:
+            ret = darshan_log_zstd_read(fd, map, buf, len, reset_strm_flag);
+            break;
 #endif
         case DARSHAN_NO_COMP:
             ret = darshan_log_noz_read(fd, map, buf, len, reset_strm_flag);
@@ -1649,11 +2217,15 @@ static int darshan_log_dzwrite(darshan_fd fd, int region_id, void *buf, int len)
         case DARSHAN_BZIP2_COMP:
             ret = darshan_log_bzip2_write(fd, map_p, buf, len, flush_strm_flag);
             break;
+#endif
+#ifdef HAVE_LIBZSTD
+        case DARSHAN_ZSTD_COMP:
+            ret = darshan_log_zstd_write(fd, map_p, buf, len, flush_strm_flag);
+            break;
 #endif
         case DARSHAN_NO_COMP:
-            fprintf(stderr,
-                "Error: uncompressed writing of log files is not supported.\n");
-            return(-1);
+            ret = darshan_log_noz_write(fd, map_p, buf, len, flush_strm_flag);
+            break;
         default:
             fprintf(stderr, "Error: invalid compression type.\n");
             return(-1);
@@ -1991,6 +2563,163 @@ static int darshan_log_bzip2_flush(darshan_fd fd, int region_id)
 }
 #endif
 
+#ifdef HAVE_LIBZSTD
+static int darshan_log_zstd_read(darshan_fd fd, struct darshan_log_map map,
+    void *buf, int len, int reset_strm_flag)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_zstd_state *zs = (struct darshan_zstd_state *)state->dz.comp_dat;
+    ZSTD_outBuffer out;
+    size_t zret;
+    int ret;
+
+    assert(zs && zs->dctx);
+
+    if(reset_strm_flag)
+    {
+        zs->in.size = zs->in.pos = 0;
+        ZSTD_DCtx_reset(zs->dctx, ZSTD_reset_session_only);
+    }
+
+    out.dst = buf;
+    out.size = len;
+    out.pos = 0;
+
+    /* we just decompress until the output buffer is full, assuming there
+     * is enough compressed data in file to satisfy the request size.
+     * NOTE: regions may hold several concatenated zstd frames, which
+     * the decompression context moves across on its own.
+     */
+    while(out.pos < out.size)
+    {
+        /* check if we need more compressed data */
+        if(zs->in.pos == zs->in.size)
+        {
+            /* if the eor flag is set, clear it and return -- future
+             * reads of this log region will restart at the beginning
+             */
+            if(state->dz.eor)
+            {
+                state->dz.eor = 0;
+                break;
+            }
+
+            /* read more data from input file */
+            ret = darshan_log_dzload(fd, map);
+            if(ret < 0)
+                return(-1);
+            assert(state->dz.size > 0);
+
+            zs->in.src = state->dz.buf;
+            zs->in.size = state->dz.size;
+            zs->in.pos = 0;
+        }
+
+        zret = ZSTD_decompressStream(zs->dctx, &out, &(zs->in));
+        if(ZSTD_isError(zret))
+        {
+            fprintf(stderr, "Error: unable to decompress darshan log data.\n");
+            return(-1);
+        }
+    }
+
+    return((int)out.pos);
+}
+
+static int darshan_log_zstd_write(darshan_fd fd, struct darshan_log_map *map_p,
+    void *buf, int len, int flush_strm_flag)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_zstd_state *zs = (struct darshan_zstd_state *)state->dz.comp_dat;
+    ZSTD_inBuffer in;
+    ZSTD_outBuffer out;
+    size_t zret;
+    int ret;
+
+    assert(zs && zs->cctx);
+
+    /* flush compressed output buffer if we are moving to a new log region */
+    if(flush_strm_flag)
+    {
+        ret = darshan_log_zstd_flush(fd, state->dz.prev_reg_id);
+        if(ret < 0)
+            return(-1);
+    }
+
+    in.src = buf;
+    in.size = len;
+    in.pos = 0;
+
+    /* compress input data until none left */
+    while(in.pos < in.size)
+    {
+        /* if we are out of output, flush to log file */
+        if(state->dz.size == DARSHAN_DEF_COMP_BUF_SZ)
+        {
+            ret = darshan_log_dzunload(fd, map_p);
+            if(ret < 0)
+                return(-1);
+        }
+
+        out.dst = state->dz.buf;
+        out.size = DARSHAN_DEF_COMP_BUF_SZ;
+        out.pos = state->dz.size;
+        zret = ZSTD_compressStream2(zs->cctx, &out, &in, ZSTD_e_continue);
+        if(ZSTD_isError(zret))
+        {
+            fprintf(stderr, "Error: unable to compress darshan log data.\n");
+            return(-1);
+        }
+        state->dz.size = out.pos;
+    }
+
+    return((int)in.pos);
+}
+
+static int darshan_log_zstd_flush(darshan_fd fd, int region_id)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_zstd_state *zs = (struct darshan_zstd_state *)state->dz.comp_dat;
+    struct darshan_log_map *map_p;
+    ZSTD_inBuffer in = {NULL, 0, 0};
+    ZSTD_outBuffer out;
+    size_t zret;
+
+    assert(zs && zs->cctx);
+
+    if(region_id == DARSHAN_JOB_REGION_ID)
+        map_p = &(fd->job_map);
+    else if(region_id == DARSHAN_NAME_MAP_REGION_ID)
+        map_p = &(fd->name_map);
+    else
+        map_p = &(fd->mod_map[region_id]);
+
+    /* make sure the compressor finishes this frame */
+    do
+    {
+        out.dst = state->dz.buf;
+        out.size = DARSHAN_DEF_COMP_BUF_SZ;
+        out.pos = state->dz.size;
+        zret = ZSTD_compressStream2(zs->cctx, &out, &in, ZSTD_e_end);
+        if(ZSTD_isError(zret))
+        {
+            fprintf(stderr, "Error: unable to compress darshan log data.\n");
+            return(-1);
+        }
+        state->dz.size = out.pos;
+
+        if(state->dz.size)
+        {
+            /* flush to file */
+            if(darshan_log_dzunload(fd, map_p) < 0)
+                return(-1);
+        }
+    } while(zret != 0);
+
+    return(0);
+}
+#endif
+
 static int darshan_log_noz_read(darshan_fd fd, struct darshan_log_map map,
     void *buf, int len, int reset_strm_flag)
 {
@@ -2021,15 +2750,20 @@ static int darshan_log_noz_read(darshan_fd fd, struct darshan_log_map map,
             }
 
             /* read more data from input file */
-            ret = darshan_log_dzload(fd, map);
+            if(state->mmap_buf)
+                ret = darshan_log_noz_mapload(fd, map);
+            else
+                ret = darshan_log_dzload(fd, map);
             if(ret < 0)
                 return(-1);
             assert(state->dz.size > 0);
+            *buf_off = 0;
         }
 
-        cp_size = (len > (state->dz.size - *buf_off)) ?
-            state->dz.size - *buf_off : len;
-        memcpy(buf, state->dz.buf + *buf_off, cp_size);
+        cp_size = ((len - total_bytes) > (state->dz.size - *buf_off)) ?
+            state->dz.size - *buf_off : (len - total_bytes);
+        memcpy((char *)buf + total_bytes, (state->mmap_buf ?
+            state->dz.map_data : (char *)state->dz.buf) + *buf_off, cp_size);
         total_bytes += cp_size;
         *buf_off += cp_size;
     }
@@ -2037,115 +2771,871 @@ static int darshan_log_noz_read(darshan_fd fd, struct darshan_log_map map,
     return(total_bytes);
 }
 
-static int darshan_log_dzload(darshan_fd fd, struct darshan_log_map map)
+static int darshan_log_noz_write(darshan_fd fd, struct darshan_log_map *map_p,
+    void *buf, int len, int flush_strm_flag)
 {
     struct darshan_fd_int_state *state = fd->state;
     int ret;
-    unsigned int remaining;
-    unsigned int read_size;
+    int total_bytes = 0;
+    int cp_size;
 
-    /* seek to the appropriate portion of the log file, if out of range */
-    if((state->pos < map.off) || (state->pos >= (map.off + map.len)))
+    /* flush output buffer if we are moving to a new log region */
+    if(flush_strm_flag)
     {
-        ret = darshan_log_seek(fd, map.off);
+        ret = darshan_log_noz_flush(fd, state->dz.prev_reg_id);
         if(ret < 0)
-        {
-            fprintf(stderr, "Error: unable to seek in darshan log file.\n");
             return(-1);
-        }
     }
 
-    /* read more compressed data from file to staging buffer */
-    remaining = (map.off + map.len) - state->pos;
-    read_size = (remaining > DARSHAN_DEF_COMP_BUF_SZ) ?
-        DARSHAN_DEF_COMP_BUF_SZ : remaining;
-
-    ret = darshan_log_read(fd, state->dz.buf, read_size);
-    if(ret < (int)read_size)
+    /* copy input data to the staging buffer, writing it out when full */
+    while(total_bytes < len)
     {
-        fprintf(stderr, "Error: unable to read compressed data from file.\n");
-        return(-1);
-    }
+        if(state->dz.size == DARSHAN_DEF_COMP_BUF_SZ)
+        {
+            ret = darshan_log_noz_unload(fd, map_p);
+            if(ret < 0)
+                return(-1);
+        }
 
-    if(ret == (int)remaining)
-    {
-        state->dz.eor = 1;
+        cp_size = ((len - total_bytes) >
+            (DARSHAN_DEF_COMP_BUF_SZ - state->dz.size)) ?
+            DARSHAN_DEF_COMP_BUF_SZ - state->dz.size : (len - total_bytes);
+        memcpy(state->dz.buf + state->dz.size, (char *)buf + total_bytes,
+            cp_size);
+        state->dz.size += cp_size;
+        total_bytes += cp_size;
     }
-    state->dz.size = read_size;
-    return(0);
+
+    return(total_bytes);
 }
 
-static int darshan_log_dzunload(darshan_fd fd, struct darshan_log_map *map_p)
+static int darshan_log_noz_flush(darshan_fd fd, int region_id)
 {
     struct darshan_fd_int_state *state = fd->state;
-    int ret;
+    struct darshan_log_map *map_p;
 
-    /* initialize map structure for this log region */
-    if(map_p->off == 0)
-        map_p->off = state->pos;
+    if(state->dz.size == 0)
+        return(0);
 
-    /* write more compressed data from staging buffer to file */
-    ret = darshan_log_write(fd, state->dz.buf, state->dz.size);
-    if(ret < (int)state->dz.size)
-    {
-        fprintf(stderr, "Error: unable to write compressed data to file.\n");
-        return(-1);
-    }
+    if(region_id == DARSHAN_JOB_REGION_ID)
+        map_p = &(fd->job_map);
+    else if(region_id == DARSHAN_NAME_MAP_REGION_ID)
+        map_p = &(fd->name_map);
+    else
+        map_p = &(fd->mod_map[region_id]);
 
-    map_p->len += state->dz.size;
-    state->dz.size = 0;
-    return (0);
+    return(darshan_log_noz_unload(fd, map_p));
 }
 
-/********************************************************
- *          backwards compatibility functions           *
- ********************************************************/
-
-static int darshan_log_get_namerecs_3_00(void *name_rec_buf, int buf_len,
-    int swap_flag, struct darshan_name_record_ref **hash,
-    darshan_record_id *whitelist, int whitelist_count)
+static int darshan_log_noz_unload(darshan_fd fd, struct darshan_log_map *map_p)
 {
-    struct darshan_name_record_ref *ref;
-    char *buf_ptr;
-    darshan_record_id *rec_id_ptr;
-    uint32_t *path_len_ptr;
-    char *path_ptr;
-    int rec_len;
-    int buf_processed = 0;
+    struct darshan_fd_int_state *state = fd->state;
+    char pad[sizeof(int64_t)] = {0};
+    int pad_len;
 
-    /* work through the name record buffer -- deserialize the mapping data and
-     * add to the output hash table
-     * NOTE: these mapping pairs are variable in length, so we have to be able
-     * to handle incomplete mappings temporarily here
+    /* start each region on an 8-byte boundary, so that records can be used
+     * in place when the log is mapped into memory for reading
      */
-    buf_ptr = name_rec_buf;
-    while(buf_len > (sizeof(darshan_record_id) + sizeof(uint32_t)))
+    if(map_p->off == 0 && (state->pos % sizeof(pad)))
     {
-        /* see if we have enough buf space to read in the next full record */
-        path_len_ptr = (uint32_t *)(buf_ptr + sizeof(darshan_record_id));
-        if(swap_flag)
-            DARSHAN_BSWAP32(path_len_ptr);
-        rec_len = sizeof(darshan_record_id) + sizeof(uint32_t) + *path_len_ptr;
+        pad_len = sizeof(pad) - (state->pos % sizeof(pad));
+        if(darshan_log_write(fd, pad, pad_len) != pad_len)
+        {
+            fprintf(stderr, "Error: unable to write data to file.\n");
+            return(-1);
+        }
+    }
 
-        /* we need to read more before we continue deserializing */
-        if(buf_len < rec_len)
-            break;
+    return(darshan_log_dzunload(fd, map_p));
+}
 
-        /* get pointers for each field of this darshan record */
-        /* NOTE: darshan record hash serialization method: 
-         *          ... darshan_record_id | (uint32_t) path_len | path ...
-         */
-        rec_id_ptr = (darshan_record_id *)buf_ptr;
-        path_ptr = (char *)(buf_ptr + sizeof(darshan_record_id) + sizeof(uint32_t));
+/* map the log file into memory for reading, if possible. Reads fall back
+ * to the staging buffer if this fails.
+ */
+static void darshan_log_mmap(darshan_fd fd)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    struct stat sbuf;
+    void *addr;
 
-        if(swap_flag)
-            /* we need to sort out endianness issues before deserializing */
-            DARSHAN_BSWAP64(rec_id_ptr);
+    if(fstat(state->fildes, &sbuf) < 0 || sbuf.st_size == 0)
+        return;
 
-        HASH_FIND(hlink, *hash, rec_id_ptr, sizeof(darshan_record_id), ref);
-        if(!ref && (!whitelist ||
-            whitelist_filter(*rec_id_ptr, whitelist, whitelist_count)))
-        {
+    addr = mmap(NULL, sbuf.st_size, PROT_READ, MAP_PRIVATE, state->fildes, 0);
+    if(addr == MAP_FAILED)
+        return;
+
+    state->mmap_buf = addr;
+    state->mmap_len = sbuf.st_size;
+    return;
+}
+
+/* like darshan_log_dzload(), but points at the rest of the region in the
+ * mapped log file rather than reading it into the staging buffer
+ */
+static int darshan_log_noz_mapload(darshan_fd fd, struct darshan_log_map map)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    uint64_t remaining;
+    int64_t start;
+
+    if(map.off + map.len > state->mmap_len)
+    {
+        fprintf(stderr, "Error: unable to read data from file.\n");
+        return(-1);
+    }
+
+    start = state->pos;
+    if((start < (int64_t)map.off) || (start >= (int64_t)(map.off + map.len)))
+        start = map.off;
+
+    remaining = (map.off + map.len) - start;
+    state->dz.size = (remaining > INT_MAX) ? INT_MAX : remaining;
+    state->dz.map_data = state->mmap_buf + start;
+    if(state->dz.size == remaining)
+        state->dz.eor = 1;
+
+    /* keep the file position consistent with the data consumed */
+    if(darshan_log_seek(fd, start + state->dz.size) < 0)
+    {
+        fprintf(stderr, "Error: unable to seek in darshan log file.\n");
+        return(-1);
+    }
+
+    return(0);
+}
+
+/* get a pointer to the next 'len' bytes of the given region of a mapped
+ * uncompressed log, rather than copying them out as
+ * darshan_log_dzread() does.
+ *
+ * returns 'len' on success, less than 'len' at the end of the region,
+ * -1 on failure
+ */
+static int darshan_log_noz_ref(darshan_fd fd, int region_id, void **ptr,
+    int len)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    int *buf_off = (int *)state->dz.comp_dat;
+    struct darshan_log_map map;
+    int avail;
+
+    /* if new log region, we reload buffers and clear eor flag */
+    if(region_id != state->dz.prev_reg_id)
+    {
+        state->dz.eor = 0;
+        state->dz.size = 0;
+        state->dz.strm_limit_flag = 0;
+        *buf_off = 0;
+    }
+    state->dz.prev_reg_id = region_id;
+
+    if(state->dz.strm_limit_flag)
+        map = state->dz.strm_map;
+    else
+        map = fd->mod_map[region_id];
+
+    if(*buf_off == state->dz.size)
+    {
+        /* future reads of this log region will restart at the beginning */
+        if(state->dz.eor)
+        {
+            state->dz.eor = 0;
+            return(0);
+        }
+
+        if(darshan_log_noz_mapload(fd, map) < 0)
+            return(-1);
+        *buf_off = 0;
+    }
+
+    avail = state->dz.size - *buf_off;
+    if(avail < len)
+    {
+        *buf_off = state->dz.size;
+        return(avail);
+    }
+
+    *ptr = state->dz.map_data + *buf_off;
+    *buf_off += len;
+    return(len);
+}
+
+/* discard any buffered log data and decompression stream state, so the
+ * next read of a log region starts a new stream at the file position
+ */
+static void darshan_log_dzreset(darshan_fd fd)
+{
+    struct darshan_fd_int_state *state = fd->state;
+
+    switch(fd->comp_type)
+    {
+        case DARSHAN_ZLIB_COMP:
+        {
+            z_stream *z_strmp = (z_stream *)state->dz.comp_dat;
+            inflateReset(z_strmp);
+            z_strmp->avail_in = 0;
+            break;
+        }
+#ifdef HAVE_LIBBZ2
+        case DARSHAN_BZIP2_COMP:
+        {
+            bz_stream *bz_strmp = (bz_stream *)state->dz.comp_dat;
+            BZ2_bzDecompressEnd(bz_strmp);
+            BZ2_bzDecompressInit(bz_strmp, 1, 0);
+            bz_strmp->avail_in = 0;
+            break;
+        }
+#endif
+#ifdef HAVE_LIBZSTD
+        case DARSHAN_ZSTD_COMP:
+        {
+            struct darshan_zstd_state *zs =
+                (struct darshan_zstd_state *)state->dz.comp_dat;
+            zs->in.size = zs->in.pos = 0;
+            ZSTD_DCtx_reset(zs->dctx, ZSTD_reset_session_only);
+            break;
+        }
+#endif
+        case DARSHAN_NO_COMP:
+            *(int *)state->dz.comp_dat = 0;
+            break;
+        default:
+            break;
+    }
+
+    state->dz.size = 0;
+    state->dz.eor = 0;
+    darshan_log_pzfree(fd);
+    return;
+}
+
+/* read an (uncompressed) index of 'entry_size' byte entries from the given
+ * log map. Index entries are made up of 64-bit fields only, so they can
+ * be byte swapped one word at a time.
+ */
+static int darshan_log_get_index(darshan_fd fd, struct darshan_log_map map,
+    int entry_size, void **entries, int *count)
+{
+    uint64_t *words;
+    uint64_t i;
+    int ret;
+
+    *entries = NULL;
+    *count = 0;
+    if(map.len < (uint64_t)entry_size)
+        return(0);
+
+    words = malloc(map.len);
+    if(!words)
+        return(-1);
+
+    ret = darshan_log_seek(fd, map.off);
+    if(ret == 0)
+        ret = darshan_log_read(fd, words, map.len);
+    if(ret != (int)map.len)
+    {
+        fprintf(stderr, "Error: failed to read darshan log index.\n");
+        free(words);
+        return(-1);
+    }
+
+    if(fd->swap_flag)
+    {
+        for(i = 0; i < map.len / sizeof(*words); i++)
+            DARSHAN_BSWAP64(&words[i]);
+    }
+
+    *entries = words;
+    *count = map.len / entry_size;
+    return(0);
+}
+
+/* read the chunk index into the fd state, if not read already */
+static int darshan_log_load_chunk_index(darshan_fd fd)
+{
+    struct darshan_fd_int_state *state = fd->state;
+
+    if(state->chunk_index || state->chunk_map.len == 0)
+        return(0);
+
+    return(darshan_log_get_index(fd, state->chunk_map,
+        sizeof(struct darshan_log_chunk), (void **)&state->chunk_index,
+        &state->chunk_index_count));
+}
+
+/* read the record index into the fd state, if not read already */
+static int darshan_log_load_rec_index(darshan_fd fd)
+{
+    struct darshan_fd_int_state *state = fd->state;
+
+    if(state->rec_index || state->rec_index_map.len == 0)
+        return(0);
+
+    return(darshan_log_get_index(fd, state->rec_index_map,
+        sizeof(struct darshan_log_rec_index), (void **)&state->rec_index,
+        &state->rec_index_count));
+}
+
+/* decompress one stream of a log region being decompressed in parallel */
+static int darshan_log_pz_decomp(struct darshan_pz_stream *strm, int comp_type)
+{
+    switch(comp_type)
+    {
+        case DARSHAN_ZLIB_COMP:
+        {
+            z_stream z_strm;
+            int ret;
+
+            memset(&z_strm, 0, sizeof(z_strm));
+            if(inflateInit2(&z_strm, 15) != Z_OK)
+                return(-1);
+            z_strm.next_in = strm->src;
+            z_strm.avail_in = strm->src_len;
+            z_strm.next_out = (unsigned char *)strm->dst;
+            z_strm.avail_out = strm->dst_len;
+            do
+            {
+                ret = inflate(&z_strm, Z_NO_FLUSH);
+                /* the stream may be made up of several concatenated streams */
+                if(ret == Z_STREAM_END && z_strm.avail_in > 0)
+                    ret = inflateReset(&z_strm);
+            } while(ret == Z_OK && z_strm.avail_in > 0 && z_strm.avail_out > 0);
+            inflateEnd(&z_strm);
+            if((ret != Z_OK && ret != Z_STREAM_END) || z_strm.avail_in > 0 ||
+                z_strm.avail_out > 0)
+                return(-1);
+            break;
+        }
+#ifdef HAVE_LIBBZ2
+        case DARSHAN_BZIP2_COMP:
+        {
+            bz_stream bz_strm;
+            int ret;
+
+            memset(&bz_strm, 0, sizeof(bz_strm));
+            if(BZ2_bzDecompressInit(&bz_strm, 1, 0) != BZ_OK)
+                return(-1);
+            bz_strm.next_in = (char *)strm->src;
+            bz_strm.avail_in = strm->src_len;
+            bz_strm.next_out = strm->dst;
+            bz_strm.avail_out = strm->dst_len;
+            do
+            {
+                ret = BZ2_bzDecompress(&bz_strm);
+                if(ret == BZ_STREAM_END && bz_strm.avail_in > 0)
+                {
+                    BZ2_bzDecompressEnd(&bz_strm);
+                    ret = BZ2_bzDecompressInit(&bz_strm, 1, 0);
+                }
+            } while(ret == BZ_OK && bz_strm.avail_in > 0 && bz_strm.avail_out > 0);
+            BZ2_bzDecompressEnd(&bz_strm);
+            if((ret != BZ_OK && ret != BZ_STREAM_END) || bz_strm.avail_in > 0 ||
+                bz_strm.avail_out > 0)
+                return(-1);
+            break;
+        }
+#endif
+#ifdef HAVE_LIBZSTD
+        case DARSHAN_ZSTD_COMP:
+        {
+            ZSTD_DCtx *dctx;
+            ZSTD_inBuffer in;
+            ZSTD_outBuffer out;
+            size_t ret;
+            char *tmp;
+
+            if(strm->dst_len > 0)
+            {
+                ret = ZSTD_decompress(strm->dst, strm->dst_len, strm->src,
+                    strm->src_len);
+                if(ZSTD_isError(ret) || ret != strm->dst_len)
+                    return(-1);
+                break;
+            }
+
+            /* the frame doesn't record its decompressed size, so grow the
+             * output buffer as needed
+             */
+            dctx = ZSTD_createDCtx();
+            if(!dctx)
+                return(-1);
+            in.src = strm->src;
+            in.size = strm->src_len;
+            in.pos = 0;
+            out.dst = NULL;
+            out.size = 0;
+            out.pos = 0;
+            while(1)
+            {
+                if(out.pos == out.size)
+                {
+                    tmp = realloc(out.dst, out.size + ZSTD_DStreamOutSize());
+                    if(!tmp)
+                    {
+                        ret = (size_t)-1;
+                        break;
+                    }
+                    out.dst = tmp;
+                    out.size += ZSTD_DStreamOutSize();
+                }
+                ret = ZSTD_decompressStream(dctx, &out, &in);
+                if(ZSTD_isError(ret) || (ret == 0 && in.pos == in.size))
+                    break;
+                /* truncated frame */
+                if(in.pos == in.size && out.pos < out.size)
+                    break;
+            }
+            ZSTD_freeDCtx(dctx);
+            strm->dst = out.dst;
+            strm->dst_len = out.pos;
+            if(ret != 0)
+                return(-1);
+            break;
+        }
+#endif
+        default:
+            return(-1);
+    }
+
+    return(0);
+}
+
+static void *darshan_log_pz_thread(void *arg)
+{
+    struct darshan_pz_state *pz = (struct darshan_pz_state *)arg;
+    int i;
+
+    while(1)
+    {
+        pthread_mutex_lock(&pz->mutex);
+        i = pz->next_stream++;
+        pthread_mutex_unlock(&pz->mutex);
+        if(i >= pz->nstreams)
+            break;
+
+        if(darshan_log_pz_decomp(&pz->streams[i], pz->comp_type) < 0)
+        {
+            pthread_mutex_lock(&pz->mutex);
+            pz->err = 1;
+            pthread_mutex_unlock(&pz->mutex);
+        }
+    }
+
+    return(NULL);
+}
+
+/* find the independently compressed streams making up the given region of
+ * 'comp_buf' (which holds the region's compressed data), using whichever of
+ * the log's chunk index or record index describes them. zstd frames can
+ * also be located by scanning the data, since they are self-delimiting.
+ *
+ * returns the number of streams found (0 if they can't be located)
+ */
+static int darshan_log_pz_streams(darshan_fd fd, int region_id,
+    struct darshan_log_map map, unsigned char *comp_buf,
+    struct darshan_pz_stream **streams_p)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_pz_stream *streams = NULL;
+    uint64_t next_off = map.off;
+    int nstreams = 0;
+    int i;
+
+    *streams_p = NULL;
+
+    if(darshan_log_load_chunk_index(fd) == 0 && state->chunk_index_count > 0)
+    {
+        streams = malloc(state->chunk_index_count * sizeof(*streams));
+        if(!streams)
+            return(0);
+        for(i = 0; i < state->chunk_index_count; i++)
+        {
+            if(state->chunk_index[i].region_id != region_id)
+                continue;
+            if(state->chunk_index[i].off != next_off)
+                break;
+            streams[nstreams].src = comp_buf + (next_off - map.off);
+            streams[nstreams].src_len = state->chunk_index[i].len;
+            streams[nstreams].dst_len = state->chunk_index[i].uncomp_len;
+            next_off += state->chunk_index[i].len;
+            nstreams++;
+        }
+        if(next_off != map.off + map.len)
+        {
+            free(streams);
+            streams = NULL;
+            next_off = map.off;
+            nstreams = 0;
+        }
+    }
+    if(!streams && region_id >= 0 && darshan_log_load_rec_index(fd) == 0 &&
+        state->rec_index_count > 0)
+    {
+        streams = malloc(state->rec_index_count * sizeof(*streams));
+        if(!streams)
+            return(0);
+        for(i = 0; i < state->rec_index_count; i++)
+        {
+            if(state->rec_index[i].region_id != region_id)
+                continue;
+            if(state->rec_index[i].off != next_off)
+                break;
+            streams[nstreams].src = comp_buf + (next_off - map.off);
+            streams[nstreams].src_len = state->rec_index[i].len;
+            streams[nstreams].dst_len = state->rec_index[i].uncomp_len;
+            next_off += state->rec_index[i].len;
+            nstreams++;
+        }
+        if(next_off != map.off + map.len)
+        {
+            free(streams);
+            streams = NULL;
+            next_off = map.off;
+            nstreams = 0;
+        }
+    }
+#ifdef HAVE_LIBZSTD
+    if(!streams && fd->comp_type == DARSHAN_ZSTD_COMP)
+    {
+        unsigned long long content_size;
+        size_t frame_size;
+        int nalloc = 0;
+        struct darshan_pz_stream *tmp;
+
+        while(next_off < map.off + map.len)
+        {
+            frame_size = ZSTD_findFrameCompressedSize(
+                comp_buf + (next_off - map.off), map.off + map.len - next_off);
+            if(ZSTD_isError(frame_size))
+                break;
+            if(nstreams == nalloc)
+            {
+                nalloc = nalloc ? nalloc * 2 : 16;
+                tmp = realloc(streams, nalloc * sizeof(*streams));
+                if(!tmp)
+                    break;
+                streams = tmp;
+            }
+            content_size = ZSTD_getFrameContentSize(
+                comp_buf + (next_off - map.off), frame_size);
+            streams[nstreams].src = comp_buf + (next_off - map.off);
+            streams[nstreams].src_len = frame_size;
+            streams[nstreams].dst_len = (content_size == ZSTD_CONTENTSIZE_UNKNOWN ||
+                content_size == ZSTD_CONTENTSIZE_ERROR) ? 0 : content_size;
+            next_off += frame_size;
+            nstreams++;
+        }
+    }
+#endif
+
+    /* the streams must cover the whole region, with known lengths for all
+     * but zstd frames
+     */
+    if(next_off != map.off + map.len || nstreams < 2)
+    {
+        free(streams);
+        return(0);
+    }
+    for(i = 0; i < nstreams; i++)
+    {
+        if(streams[i].dst_len == 0 && fd->comp_type != DARSHAN_ZSTD_COMP)
+        {
+            free(streams);
+            return(0);
+        }
+        streams[i].dst = NULL;
+    }
+
+    *streams_p = streams;
+    return(nstreams);
+}
+
+/* if possible, decompress all of the given log region at once, using
+ * several threads to decompress the independently compressed streams it
+ * is made of. Later reads of the region are served from the decompressed
+ * data. If the region's streams can't be located, or anything fails, the
+ * region is read with the usual streaming decompression instead.
+ */
+static void darshan_log_pzload(darshan_fd fd, int region_id)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_log_map map;
+    struct darshan_pz_stream *streams = NULL;
+    struct darshan_pz_state pz;
+    unsigned char *comp_buf = NULL;
+    pthread_t *threads = NULL;
+    uint64_t total = 0;
+    int nstreams, nthreads = 0;
+    int ret;
+    int i;
+
+    if(state->pz_buf && state->pz_reg_id == region_id)
+    {
+        /* new traversal of the region already loaded */
+        state->pz_pos = 0;
+        return;
+    }
+    darshan_log_pzfree(fd);
+
+    if(region_id == DARSHAN_NAME_MAP_REGION_ID)
+        map = fd->name_map;
+    else
+        map = fd->mod_map[region_id];
+    if(fd->comp_type == DARSHAN_NO_COMP || map.len == 0 || map.len > INT_MAX)
+        return;
+
+    comp_buf = malloc(map.len);
+    if(!comp_buf)
+        return;
+    ret = darshan_log_seek(fd, map.off);
+    if(ret == 0)
+        ret = darshan_log_read(fd, comp_buf, map.len);
+    if(ret != (int)map.len)
+        goto fallback;
+
+    nstreams = darshan_log_pz_streams(fd, region_id, map, comp_buf, &streams);
+    if(nstreams == 0)
+        goto fallback;
+
+    /* preallocate a buffer for the decompressed region if its size is
+     * known, otherwise assemble it from the streams afterwards
+     */
+    for(i = 0; i < nstreams; i++)
+    {
+        if(streams[i].dst_len == 0)
+        {
+            total = 0;
+            break;
+        }
+        total += streams[i].dst_len;
+    }
+    if(total > 0)
+    {
+        state->pz_buf = malloc(total);
+        if(!state->pz_buf)
+            goto fallback;
+        total = 0;
+        for(i = 0; i < nstreams; i++)
+        {
+            streams[i].dst = state->pz_buf + total;
+            total += streams[i].dst_len;
+        }
+    }
+
+    memset(&pz, 0, sizeof(pz));
+    pz.streams = streams;
+    pz.nstreams = nstreams;
+    pz.comp_type = fd->comp_type;
+    pthread_mutex_init(&pz.mutex, NULL);
+
+    nthreads = state->nthreads < nstreams ? state->nthreads : nstreams;
+    threads = malloc((nthreads - 1) * sizeof(*threads));
+    if(!threads)
+        nthreads = 1;
+    for(i = 0; i < nthreads - 1; i++)
+    {
+        if(pthread_create(&threads[i], NULL, darshan_log_pz_thread, &pz) != 0)
+            break;
+    }
+    nthreads = i + 1;
+    /* this thread decompresses streams too */
+    darshan_log_pz_thread(&pz);
+    for(i = 0; i < nthreads - 1; i++)
+        pthread_join(threads[i], NULL);
+    free(threads);
+    pthread_mutex_destroy(&pz.mutex);
+
+    if(!state->pz_buf)
+    {
+        if(!pz.err)
+        {
+            for(i = 0; i < nstreams; i++)
+                total += streams[i].dst_len;
+            state->pz_buf = malloc(total);
+        }
+        if(state->pz_buf)
+        {
+            total = 0;
+            for(i = 0; i < nstreams; i++)
+            {
+                memcpy(state->pz_buf + total, streams[i].dst,
+                    streams[i].dst_len);
+                total += streams[i].dst_len;
+            }
+        }
+        for(i = 0; i < nstreams; i++)
+            free(streams[i].dst);
+        if(!state->pz_buf)
+            pz.err = 1;
+    }
+    if(pz.err)
+        goto fallback;
+
+    state->pz_reg_id = region_id;
+    state->pz_size = total;
+    state->pz_pos = 0;
+    free(streams);
+    free(comp_buf);
+    return;
+
+fallback:
+    darshan_log_pzfree(fd);
+    free(streams);
+    free(comp_buf);
+    darshan_log_seek(fd, map.off);
+    return;
+}
+
+/* read from a log region decompressed by darshan_log_pzload(), following
+ * the same conventions as streaming reads: a read reaching the end of the
+ * region returns what is left, and the next read restarts at its beginning
+ */
+static int darshan_log_pzread(darshan_fd fd, void *buf, int len)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    uint64_t remaining = state->pz_size - state->pz_pos;
+    int partial = 0;
+
+    if(remaining == 0)
+    {
+        state->pz_pos = 0;
+        return(0);
+    }
+
+    if((uint64_t)len > remaining)
+    {
+        len = remaining;
+        partial = 1;
+    }
+    memcpy(buf, state->pz_buf + state->pz_pos, len);
+    state->pz_pos += len;
+    if(partial)
+        state->pz_pos = 0;
+
+    return(len);
+}
+
+static void darshan_log_pzfree(darshan_fd fd)
+{
+    struct darshan_fd_int_state *state = fd->state;
+
+    free(state->pz_buf);
+    state->pz_buf = NULL;
+    state->pz_size = 0;
+    state->pz_pos = 0;
+    return;
+}
+
+static int darshan_log_dzload(darshan_fd fd, struct darshan_log_map map)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    int ret;
+    unsigned int remaining;
+    unsigned int read_size;
+
+    /* seek to the appropriate portion of the log file, if out of range */
+    if((state->pos < map.off) || (state->pos >= (map.off + map.len)))
+    {
+        ret = darshan_log_seek(fd, map.off);
+        if(ret < 0)
+        {
+            fprintf(stderr, "Error: unable to seek in darshan log file.\n");
+            return(-1);
+        }
+    }
+
+    /* read more compressed data from file to staging buffer */
+    remaining = (map.off + map.len) - state->pos;
+    read_size = (remaining > DARSHAN_DEF_COMP_BUF_SZ) ?
+        DARSHAN_DEF_COMP_BUF_SZ : remaining;
+
+    ret = darshan_log_read(fd, state->dz.buf, read_size);
+    if(ret < (int)read_size)
+    {
+        fprintf(stderr, "Error: unable to read compressed data from file.\n");
+        return(-1);
+    }
+
+    if(ret == (int)remaining)
+    {
+        state->dz.eor = 1;
+    }
+    state->dz.size = read_size;
+    return(0);
+}
+
+static int darshan_log_dzunload(darshan_fd fd, struct darshan_log_map *map_p)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    int ret;
+
+    /* initialize map structure for this log region */
+    if(map_p->off == 0)
+        map_p->off = state->pos;
+
+    /* write more compressed data from staging buffer to file */
+    ret = darshan_log_write(fd, state->dz.buf, state->dz.size);
+    if(ret < (int)state->dz.size)
+    {
+        fprintf(stderr, "Error: unable to write compressed data to file.\n");
+        return(-1);
+    }
+
+    map_p->len += state->dz.size;
+    state->dz.size = 0;
+    return (0);
+}
+
+/********************************************************
+ *          backwards compatibility functions           *
+ ********************************************************/
+
+static int darshan_log_get_namerecs_3_00(void *name_rec_buf, int buf_len,
+    int swap_flag, struct darshan_name_record_ref **hash,
+    darshan_record_id *whitelist, int whitelist_count, char *prev_name)
+{
+    struct darshan_name_record_ref *ref;
+    char *buf_ptr;
+    darshan_record_id *rec_id_ptr;
+    uint32_t *path_len_ptr;
+    char *path_ptr;
+    int rec_len;
+    int buf_processed = 0;
+
+    /* work through the name record buffer -- deserialize the mapping data and
+     * add to the output hash table
+     * NOTE: these mapping pairs are variable in length, so we have to be able
+     * to handle incomplete mappings temporarily here
+     */
+    buf_ptr = name_rec_buf;
+    while(buf_len > (sizeof(darshan_record_id) + sizeof(uint32_t)))
+    {
+        /* see if we have enough buf space to read in the next full record */
+        path_len_ptr = (uint32_t *)(buf_ptr + sizeof(darshan_record_id));
+        if(swap_flag)
+            DARSHAN_BSWAP32(path_len_ptr);
+        rec_len = sizeof(darshan_record_id) + sizeof(uint32_t) + *path_len_ptr;
+
+        /* we need to read more before we continue deserializing */
+        if(buf_len < rec_len)
+            break;
+
+        /* get pointers for each field of this darshan record */
+        /* NOTE: darshan record hash serialization method: 
+         *          ... darshan_record_id | (uint32_t) path_len | path ...
+         */
+        rec_id_ptr = (darshan_record_id *)buf_ptr;
+        path_ptr = (char *)(buf_ptr + sizeof(darshan_record_id) + sizeof(uint32_t));
+
+        if(swap_flag)
+            /* we need to sort out endianness issues before deserializing */
+            DARSHAN_BSWAP64(rec_id_ptr);
+
+        HASH_FIND(hlink, *hash, rec_id_ptr, sizeof(darshan_record_id), ref);
+        if(!ref && (!whitelist ||
+            whitelist_filter(*rec_id_ptr, whitelist, whitelist_count)))
+        {
             ref = malloc(sizeof(*ref));
             if(!ref)
                 return(-1);
@@ -2176,6 +3666,84 @@ static int darshan_log_get_namerecs_3_00(void *name_rec_buf, int buf_len,
     return(buf_processed);
 }
 
+static int darshan_log_get_namerecs_3_41(void *name_rec_buf, int buf_len,
+    int swap_flag, struct darshan_name_record_ref **hash,
+    darshan_record_id *whitelist, int whitelist_count, char *prev_name)
+{
+    struct darshan_name_record_ref *ref;
+    struct darshan_name_record *name_rec;
+    char *tmp_p;
+    int buf_processed = 0;
+    int rec_len;
+
+    /* work through the name record buffer -- deserialize the record data
+     * and add to the output hash table
+     * NOTE: these mapping pairs are variable in length, so we have to be able
+     * to handle incomplete mappings temporarily here
+     */
+    name_rec = (struct darshan_name_record *)name_rec_buf;
+    while(buf_len >= sizeof(darshan_record_id) + 1)
+    {
+        if(strnlen(name_rec->name, buf_len - sizeof(darshan_record_id)) ==
+            (buf_len - sizeof(darshan_record_id)))
+        {
+            /* if this record name's terminating null character is not
+             * present, we need to read more of the buffer before continuing
+             */
+            break;
+        }
+        rec_len = sizeof(darshan_record_id) + strlen(name_rec->name) + 1;
+
+        if(swap_flag)
+        {
+            /* we need to sort out endianness issues before deserializing */
+            DARSHAN_BSWAP64(&(name_rec->id));
+        }
+
+        HASH_FIND(hlink, *hash, &(name_rec->id), sizeof(darshan_record_id), ref);
+        if(!ref && (!whitelist ||
+            whitelist_filter(name_rec->id, whitelist, whitelist_count)))
+        {
+            ref = malloc(sizeof(*ref));
+            if(!ref)
+                return(-1);
+
+            ref->name_record = malloc(rec_len);
+            if(!ref->name_record)
+            {
+                free(ref);
+                return(-1);
+            }
+
+            /* copy the name record over from the hash buffer */
+            memcpy(ref->name_record, name_rec, rec_len);
+
+            /* add this record to the hash */
+            HASH_ADD(hlink, *hash, name_record->id, sizeof(darshan_record_id), ref);
+        }
+        else if(ref && !strlen(ref->name_record->name) && strlen(name_rec->name) > 0)
+        {
+            free(ref->name_record);
+            ref->name_record = malloc(rec_len);
+            if(!ref->name_record)
+            {
+                free(ref);
+                return(-1);
+            }
+
+            /* copy the name record over from the hash buffer */
+            memcpy(ref->name_record, name_rec, rec_len);
+        }
+
+        tmp_p = (char *)name_rec + rec_len;
+        name_rec = (struct darshan_name_record *)tmp_p;
+        buf_len -= rec_len;
+        buf_processed += rec_len;
+    }
+
+    return(buf_processed);
+}
+
 /*
  * Support functions for use with other languages
  */
@@ -2350,6 +3918,249 @@ int darshan_log_get_record(darshan_fd fd,
     return r;
 }
 
+/* size of the records of the given module, for modules whose records
+ * have a fixed size (0 otherwise)
+ */
+static int darshan_log_fixed_rec_size(int mod_idx)
+{
+    switch(mod_idx)
+    {
+        case DARSHAN_NULL_MOD:
+            return(sizeof(struct darshan_null_record));
+        case DARSHAN_POSIX_MOD:
+            return(sizeof(struct darshan_posix_file));
+        case DARSHAN_MPIIO_MOD:
+            return(sizeof(struct darshan_mpiio_file));
+        case DARSHAN_H5F_MOD:
+            return(sizeof(struct darshan_hdf5_file));
+        case DARSHAN_H5D_MOD:
+            return(sizeof(struct darshan_hdf5_dataset));
+        case DARSHAN_PNETCDF_FILE_MOD:
+            return(sizeof(struct darshan_pnetcdf_file));
+        case DARSHAN_PNETCDF_VAR_MOD:
+            return(sizeof(struct darshan_pnetcdf_var));
+        case DARSHAN_BGQ_MOD:
+            return(sizeof(struct darshan_bgq_record));
+        case DARSHAN_STDIO_MOD:
+            return(sizeof(struct darshan_stdio_file));
+        case DARSHAN_DFS_MOD:
+            return(sizeof(struct darshan_dfs_file));
+        case DARSHAN_DAOS_MOD:
+            return(sizeof(struct darshan_daos_object));
+        default:
+            return(0);
+    }
+}
+
+/*
+ * darshan_log_get_record_ref
+ *
+ * Like darshan_log_get_record(), but returns a pointer to a record owned
+ * by the log file descriptor rather than a copy that must be freed by the
+ * caller. The record is valid until the next read from the log file or
+ * until the log is closed, and must not be modified. For uncompressed logs
+ * in the current format and byte order, fixed-size records point directly
+ * into a mapping of the log file, so no copies are made.
+ *
+ * returns 1 if a record was read, 0 at the end of the module's records,
+ * -1 on failure
+ */
+int darshan_log_get_record_ref(darshan_fd fd, int mod_idx, void **rec_p)
+{
+    struct darshan_fd_int_state *state;
+    void *rec = NULL;
+    int rec_size;
+    int ret;
+
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+    state = fd->state;
+    assert(state);
+
+    if(mod_idx < 0 || mod_idx >= DARSHAN_KNOWN_MODULE_COUNT ||
+        !mod_logutils[mod_idx])
+    {
+        fprintf(stderr, "Error: invalid Darshan module id.\n");
+        return(-1);
+    }
+
+    rec_size = darshan_log_fixed_rec_size(mod_idx);
+    if(state->mmap_buf && !fd->swap_flag && rec_size > 0 &&
+        fd->mod_ver[mod_idx] == darshan_module_versions[mod_idx])
+    {
+        if(fd->mod_map[mod_idx].len == 0)
+            return(0);
+
+        ret = darshan_log_noz_ref(fd, mod_idx, &rec, rec_size);
+        if(ret < 0)
+        {
+            fprintf(stderr,
+                "Error: failed to read module %s data from darshan log file.\n",
+                darshan_module_names[mod_idx]);
+            return(-1);
+        }
+        else if(ret < rec_size)
+            return(0);
+
+        if(((uintptr_t)rec % sizeof(int64_t)) == 0)
+        {
+            *rec_p = rec;
+            return(1);
+        }
+    }
+
+    /* otherwise, records are read into (or copied to) the fd's buffer. Its
+     * size is only tracked for fixed-size records, so that it can be reused.
+     */
+    if(rec_size == 0 || state->ref_buf_size < rec_size)
+    {
+        free(state->ref_buf);
+        state->ref_buf = NULL;
+        state->ref_buf_size = 0;
+        if(rec_size > 0)
+        {
+            state->ref_buf = malloc(rec_size);
+            if(!state->ref_buf)
+                return(-1);
+            state->ref_buf_size = rec_size;
+        }
+    }
+
+    if(rec)
+    {
+        /* a misaligned record in the mapped log */
+        memcpy(state->ref_buf, rec, rec_size);
+        ret = 1;
+    }
+    else
+        ret = mod_logutils[mod_idx]->log_get_record(fd, &state->ref_buf);
+
+    if(ret == 1)
+        *rec_p = state->ref_buf;
+    return(ret);
+}
+
+/* byte swap a batch of fixed-size records in place. These records consist
+ * entirely of 64-bit fields, apart from the pair of uuids in DFS and DAOS
+ * records, which are swapped as 128-bit values like their logutils do.
+ */
+static void darshan_log_swap_records(int mod_idx, char *buf, int rec_size,
+    int nrecs)
+{
+    int uuid_off = -1;
+    char *rec;
+    int off;
+    int i;
+
+    if(mod_idx == DARSHAN_DFS_MOD)
+        uuid_off = offsetof(struct darshan_dfs_file, pool_uuid);
+    else if(mod_idx == DARSHAN_DAOS_MOD)
+        uuid_off = offsetof(struct darshan_daos_object, pool_uuid);
+
+    for(i = 0; i < nrecs; i++)
+    {
+        rec = buf + (size_t)i * rec_size;
+        for(off = 0; off < rec_size; off += sizeof(int64_t))
+        {
+            if(off == uuid_off)
+            {
+                DARSHAN_BSWAP128(rec + off);
+                DARSHAN_BSWAP128(rec + off + 16);
+                off += 32 - sizeof(int64_t);
+            }
+            else
+                DARSHAN_BSWAP64(rec + off);
+        }
+    }
+}
+
+/*
+ * darshan_log_get_records
+ *
+ * Reads up to max_recs of a module's next records into buf, a caller-owned
+ * array of max_recs records of the module's record type, and sets nrecs to
+ * the number of records read (0 at the end of the module's records). Only
+ * modules with fixed-size records are supported. Records in the current
+ * format are read with a single read of the module's data and byte swapped
+ * as a batch; records in older formats are read (and upconverted) one at a
+ * time.
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_get_records(darshan_fd fd, int mod_idx, void *buf,
+    int max_recs, int *nrecs)
+{
+    void *rec;
+    int rec_size;
+    int chunk_recs;
+    int ret;
+
+    *nrecs = 0;
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+
+    if(mod_idx < 0 || mod_idx >= DARSHAN_KNOWN_MODULE_COUNT ||
+        !mod_logutils[mod_idx])
+    {
+        fprintf(stderr, "Error: invalid Darshan module id.\n");
+        return(-1);
+    }
+
+    rec_size = darshan_log_fixed_rec_size(mod_idx);
+    if(rec_size == 0)
+    {
+        fprintf(stderr, "Error: module %s records do not have a fixed size.\n",
+            darshan_module_names[mod_idx]);
+        return(-1);
+    }
+
+    if(fd->mod_ver[mod_idx] != darshan_module_versions[mod_idx])
+    {
+        while(*nrecs < max_recs)
+        {
+            rec = (char *)buf + (size_t)*nrecs * rec_size;
+            ret = mod_logutils[mod_idx]->log_get_record(fd, &rec);
+            if(ret < 0)
+                return(-1);
+            else if(ret == 0)
+                break;
+            (*nrecs)++;
+        }
+        return(0);
+    }
+
+    while(*nrecs < max_recs)
+    {
+        /* limit each read to what its int size can express */
+        chunk_recs = max_recs - *nrecs;
+        if(chunk_recs > INT_MAX / rec_size)
+            chunk_recs = INT_MAX / rec_size;
+
+        rec = (char *)buf + (size_t)*nrecs * rec_size;
+        ret = darshan_log_get_mod(fd, mod_idx, rec, chunk_recs * rec_size);
+        if(ret < 0)
+            return(-1);
+
+        /* a trailing partial record is ignored, as it is by the per-record
+         * readers
+         */
+        ret /= rec_size;
+        if(fd->swap_flag)
+            darshan_log_swap_records(mod_idx, rec, rec_size, ret);
+        *nrecs += ret;
+        if(ret < chunk_recs)
+            break;
+    }
+
+    return(0);
+}
+
 /*
  * darshan_free
  *
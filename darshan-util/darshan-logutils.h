@@ -216,6 +216,14 @@ int darshan_log_get_mod(darshan_fd fd, darshan_module_id mod_id,
     void *mod_buf, int mod_buf_sz);
 int darshan_log_put_mod(darshan_fd fd, darshan_module_id mod_id,
     void *mod_buf, int mod_buf_sz, int ver);
+int darshan_log_get_chunk_index(darshan_fd fd, struct darshan_log_chunk **chunks,
+    int *chunk_count);
+int darshan_log_get_record_index(darshan_fd fd, struct darshan_log_rec_index **index,
+    int *index_count);
+int darshan_log_seek_rank(darshan_fd fd, darshan_module_id mod_id, int64_t rank);
+int darshan_log_get_record_by_id(darshan_fd fd, darshan_module_id mod_id,
+    darshan_record_id rec_id, void **buf);
+int darshan_log_set_threads(darshan_fd fd, int nthreads);
 void darshan_log_close(darshan_fd file);
 void darshan_log_print_version_warnings(const char *version_string);
 char *darshan_log_get_lib_version(void);
@@ -228,6 +236,9 @@ void darshan_log_get_filtered_name_records(darshan_fd fd,
     struct darshan_name_record_info **mods, int* count,
     darshan_record_id *whitelist, int whitelist_count);
 int darshan_log_get_record(darshan_fd fd, int mod_idx, void **buf);
+int darshan_log_get_record_ref(darshan_fd fd, int mod_idx, void **rec_p);
+int darshan_log_get_records(darshan_fd fd, int mod_idx, void *buf,
+    int max_recs, int *nrecs);
 void darshan_free(void *ptr);
 
 
@@ -403,6 +414,13 @@ struct darshan_derived_metrics {
     /* array of derived metrics broken down by different categories */
     struct darshan_file_category_counters
         category_counters[DARSHAN_FILE_CATEGORY_MAX];
+
+    /* slowest rank time across partially shared files that were reduced
+     * over a subset of ranks (rank = -N).  These files are typically
+     * accessed concurrently by disjoint groups of ranks (e.g., one file per
+     * node), so this is the maximum over those files rather than a sum.
+     */
+    double part_shared_io_total_time_by_slowest;
 };
 
 /* Emit derived metrics _and_ a combined aggregate record from an accumulator.
@@ -419,4 +437,88 @@ int darshan_accumulator_destroy(darshan_accumulator accumulator);
 
 /*****************************************************************/
 
+/*****************************************************************
+ * The functions in this section make up the summary sidecar API.  A
+ * sidecar is a small file stored alongside a log that holds the log's
+ * header and job data, along with the derived metrics and aggregate record
+ * of each module that supports the accumulator API, so that job-level
+ * summaries can be reported without reading any records from the log.
+ */
+
+/* default sidecar path is the log's path with this suffix appended */
+#define DARSHAN_SUMMARY_SUFFIX ".summary"
+
+struct darshan_summary_module
+{
+    int64_t record_count;                   /* records accumulated */
+    struct darshan_derived_metrics metrics;
+    int agg_record_size;
+    void *agg_record;                       /* in the module's record format */
+};
+
+struct darshan_log_summary
+{
+    char version[8];                        /* log format version */
+    enum darshan_comp_type comp_type;
+    uint64_t partial_flag;
+    uint32_t mod_ver[DARSHAN_MAX_MODS];
+    uint64_t mod_len[DARSHAN_MAX_MODS];     /* compressed module data sizes */
+    struct darshan_job job;
+    char *exe;
+    /* NULL for modules that are not in the log or have no summary */
+    struct darshan_summary_module *mods[DARSHAN_MAX_MODS];
+};
+
+/* Read all records of the log at log_path and write its sidecar to
+ * summary_path (or the default sidecar path if NULL).  Returns 0 on
+ * success, -1 on failure.
+ */
+int darshan_log_summary_create(const char *log_path, const char *summary_path);
+
+/* Read the sidecar of the log at log_path from summary_path (or the default
+ * sidecar path if NULL).  Returns 0 on success, 1 if there is no usable
+ * sidecar (it is missing, corrupt, or out of date with respect to the log),
+ * or -1 on failure.  The summary is freed with darshan_log_summary_free().
+ */
+int darshan_log_summary_read(const char *log_path, const char *summary_path,
+                             struct darshan_log_summary **summary);
+
+void darshan_log_summary_free(struct darshan_log_summary *summary);
+
+/*****************************************************************/
+
+/*****************************************************************
+ * The functions in this section make up the columnar export API, which
+ * writes log data as tables that can be loaded directly by dataframe and
+ * analytics tools.  Each table is written in batches of rows, so memory
+ * use is bounded regardless of the size of the log.
+ */
+
+enum darshan_columnar_format
+{
+    DARSHAN_COLUMNAR_ARROW = 0,    /* Arrow IPC file format (Feather v2) */
+    DARSHAN_COLUMNAR_PARQUET
+};
+
+/* Write the log's name records to path as a table with "id" and "name"
+ * columns.  Returns 0 on success, -1 on failure.
+ */
+int darshan_log_export_names(darshan_fd fd,
+                             enum darshan_columnar_format format,
+                             const char *path);
+
+/* Write the records of a module to path as a table with "id" and "rank"
+ * columns followed by one column per counter.  DXT modules are written as
+ * one row per traced I/O segment instead.  Records are read from the
+ * module's current position, so no records of the module should have been
+ * read beforehand.  Returns 0 on success, 1 if the module has no columnar
+ * layout (nothing is written), or -1 on failure.
+ */
+int darshan_log_export_module(darshan_fd fd,
+                              darshan_module_id mod_id,
+                              enum darshan_columnar_format format,
+                              const char *path);
+
+/*****************************************************************/
+
 #endif
@@ -37,6 +37,7 @@ static void darshan_log_print_lustre_record_diff(void *rec1, char *file_name1,
 static void darshan_log_agg_lustre_records(void *rec, void *agg_rec, int init_flag);
 
 static int darshan_log_get_lustre_record_v1(darshan_fd fd, void** lustre_buf_p);
+static int darshan_log_sizeof_lustre_record(void* lustre_buf_p);
 
 struct darshan_mod_logutil_funcs lustre_logutils =
 {
@@ -45,9 +46,20 @@ struct darshan_mod_logutil_funcs lustre_logutils =
     .log_print_record = &darshan_log_print_lustre_record,
     .log_print_description = &darshan_log_print_lustre_description,
     .log_print_diff = &darshan_log_print_lustre_record_diff,
-    .log_agg_records = &darshan_log_agg_lustre_records
+    .log_agg_records = &darshan_log_agg_lustre_records,
+    .log_sizeof_record = &darshan_log_sizeof_lustre_record
 };
 
+static int darshan_log_sizeof_lustre_record(void* lustre_buf_p)
+{
+    struct darshan_lustre_record *rec = (struct darshan_lustre_record *)lustre_buf_p;
+
+    /* components and OST ids trail the fixed-size portion of the record */
+    return(sizeof(struct darshan_lustre_record) +
+        rec->num_comps * sizeof(struct darshan_lustre_component) +
+        rec->num_stripes * sizeof(OST_ID));
+}
+
 static int darshan_log_get_lustre_record(darshan_fd fd, void** lustre_buf_p)
 {
     struct darshan_lustre_record *rec = *((struct darshan_lustre_record **)lustre_buf_p);
@@ -8,17 +8,61 @@
 #include <string.h>
 #include <getopt.h>
 #include <glob.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
 
 #include "uthash-1.9.2/src/uthash.h"
 
 #include "darshan-logutils.h"
 
+/* default limit on the amount of record data buffered in memory before
+ * records are spilled to temporary logs, in MiB
+ */
+#define DEF_MERGE_MAX_MEM 1024
+
 struct darshan_shared_record_ref
 {
     darshan_record_id id;
     int ref_cnt;
-    char agg_rec[DEF_MOD_BUF_SIZE];
     UT_hash_handle hlink;
+    char agg_rec[]; /* sized to fit the first record aggregated */
+};
+
+/* list of records (each allocated separately) read for a single module */
+struct merge_rec_list
+{
+    void **recs;
+    int count;
+    int size;
+};
+
+/* everything read from a single input log */
+struct merge_input
+{
+    char *path;
+    int done;
+    int err;
+    uint64_t partial_flag;
+    struct darshan_job job;
+    char exe[DARSHAN_EXE_LEN+1];
+    struct darshan_mnt_info *mnt_array;
+    int mnt_count;
+    struct darshan_name_record_ref *name_hash;
+    struct merge_rec_list mod_recs[DARSHAN_KNOWN_MODULE_COUNT];
+};
+
+/* state shared between the main thread and the input reading threads */
+struct merge_read_state
+{
+    struct merge_input *inputs;
+    int n_inputs;
+    int next_input;
+    int merged;
+    int window;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
 };
 
 void usage(char *exename)
@@ -26,26 +70,34 @@ void usage(char *exename)
     fprintf(stderr, "Usage: %s --output <output_path> [options] <input_log_glob>\n", exename);
     fprintf(stderr, "This utility merges multiple Darshan log files into a single output log file.\n");
     fprintf(stderr, "<input_log_glob> is a pattern that matches all input log files (e.g., /log-path/*.darshan).\n");
+    fprintf(stderr, "Patterns are expanded by the utility itself, so they may be quoted to avoid shell argument limits.\n");
     fprintf(stderr, "Options:\n");
     fprintf(stderr, "\t--help \t\tprints this help message and exits\n");
     fprintf(stderr, "\t--version \tprints Darshan version number and exits\n");
     fprintf(stderr, "\t--output\t(REQUIRED) Full path of the output darshan log file.\n");
     fprintf(stderr, "\t--shared-redux\tReduce globally shared records into a single record.\n");
     fprintf(stderr, "\t--job-end-time\tSet the output log's job end time (requires argument of seconds since Epoch).\n");
+    fprintf(stderr, "\t-j, --jobs\tNumber of input logs to read in parallel (default: 1).\n");
+    fprintf(stderr, "\t--max-mem\tMiB of record data to buffer in memory before spilling to temporary files (default: %d).\n", DEF_MERGE_MAX_MEM);
 
     exit(1);
 }
 
-void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
-    char **outlog_path, int *shared_redux, int64_t *job_end_time)
+void parse_args(int argc, char **argv, glob_t *infile_glob,
+    char **outlog_path, int *shared_redux, int64_t *job_end_time,
+    int *njobs, int64_t *max_mem)
 {
     int index;
     char *check;
+    int i;
+    int ret;
     static struct option long_opts[] =
     {
         {"output", required_argument, NULL, 'o'},
         {"shared-redux", no_argument, NULL, 's'},
         {"job-end-time", required_argument, NULL, 'e'},
+        {"jobs", required_argument, NULL, 'j'},
+        {"max-mem", required_argument, NULL, 'm'},
         {"version",  0, NULL, 'v'},
         {"help",  0, NULL, 0},
         {0, 0, 0, 0}
@@ -54,10 +106,12 @@ void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
     *shared_redux = 0;
     *outlog_path = NULL;
     *job_end_time = 0;
+    *njobs = 1;
+    *max_mem = DEF_MERGE_MAX_MEM;
 
     while(1)
     {
-        int c = getopt_long(argc, argv, "", long_opts, &index);
+        int c = getopt_long(argc, argv, "j:", long_opts, &index);
 
         if(c == -1) break;
 
@@ -77,6 +131,22 @@ void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
                     exit(1);
                 }
                 break;
+            case 'j':
+                *njobs = strtol(optarg, &check, 10);
+                if(optarg == check || *njobs < 1)
+                {
+                    fprintf(stderr, "Error: invalid number of jobs.\n");
+                    exit(1);
+                }
+                break;
+            case 'm':
+                *max_mem = strtoll(optarg, &check, 10);
+                if(optarg == check || *max_mem < 0)
+                {
+                    fprintf(stderr, "Error: invalid memory limit.\n");
+                    exit(1);
+                }
+                break;
             case 'v':
                 printf("%s\n", PACKAGE_VERSION);
                 exit(0);
@@ -92,256 +162,577 @@ void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
         usage(argv[0]);
     }
 
-    *infile_list = &argv[optind];
-    *n_files = argc - optind;
+    /* expand each input pattern, keeping any that match nothing so that
+     * opening them reports an error
+     */
+    memset(infile_glob, 0, sizeof(*infile_glob));
+    for(i = optind; i < argc; i++)
+    {
+        ret = glob(argv[i], GLOB_NOCHECK | (i > optind ? GLOB_APPEND : 0),
+            NULL, infile_glob);
+        if(ret != 0)
+        {
+            fprintf(stderr, "Error: unable to expand input log pattern %s.\n",
+                argv[i]);
+            exit(1);
+        }
+    }
 
     return;
 }
 
-int build_mod_shared_rec_hash(char **infile_list, int n_infiles,
-    darshan_module_id mod_id, int nprocs, char *mod_buf,
-    struct darshan_shared_record_ref **shared_rec_hash)
+static int merge_rec_list_add(struct merge_rec_list *list, void *rec)
+{
+    void **tmp_recs;
+
+    if(list->count == list->size)
+    {
+        tmp_recs = realloc(list->recs, (list->size ? list->size * 2 : 64) *
+            sizeof(*tmp_recs));
+        if(!tmp_recs)
+            return(-1);
+        list->recs = tmp_recs;
+        list->size = list->size ? list->size * 2 : 64;
+    }
+    list->recs[list->count++] = rec;
+
+    return(0);
+}
+
+static int64_t merge_rec_size(int mod_id, void *rec)
+{
+    if(mod_logutils[mod_id]->log_sizeof_record)
+        return(mod_logutils[mod_id]->log_sizeof_record(rec));
+    return(sizeof(struct darshan_base_record));
+}
+
+/* read the job data, name records, and module records of a single input
+ * log into memory. returns 0 on success, -1 on failure
+ */
+static int merge_read_input(struct merge_input *input, int first)
 {
     darshan_fd in_fd;
-    struct darshan_base_record *base_rec;
-    struct darshan_shared_record_ref *ref, *tmp;
-    int init_rank = -1;
-    int ret;
+    struct stat sbuf;
+    void *rec;
     int i;
+    int ret;
 
-    /* if this module has no method for aggregating shared records, do nothing */
-    if(!(mod_logutils[mod_id]->log_agg_records))
-        return(0);
+    in_fd = darshan_log_open(input->path);
+    if(in_fd == NULL)
+    {
+        fprintf(stderr,
+            "Error: unable to open input Darshan log file %s.\n",
+            input->path);
+        return(-1);
+    }
+    input->partial_flag = in_fd->partial_flag;
 
-    /* loop over each input log file */
-    for(i = 0; i < n_infiles; i++)
+    /* read job-level metadata from the input file */
+    ret = darshan_log_get_job(in_fd, &input->job);
+    if(ret < 0)
     {
-        in_fd = darshan_log_open(infile_list[i]);
-        if(in_fd == NULL)
+        fprintf(stderr,
+            "Error: unable to read job data from input Darshan log file %s.\n",
+            input->path);
+        darshan_log_close(in_fd);
+        return(-1);
+    }
+
+    /* mmap logs of processes that did not shut down have no end time, so
+     * use the last time the process updated its log instead
+     */
+    if(input->job.end_time_sec == 0 && stat(input->path, &sbuf) == 0)
+    {
+        input->job.end_time_sec = (int64_t)sbuf.st_mtim.tv_sec;
+        input->job.end_time_nsec = (int64_t)sbuf.st_mtim.tv_nsec;
+    }
+
+#if 0
+    /* XXX: the darshan_shutdown tag is never set in darshan-core, currently */
+    /* if the input darshan log has metadata set indicating the darshan
+     * shutdown procedure was called on the log, then we error out. if the
+     * shutdown procedure was started, then it's possible the log has
+     * incomplete or corrupt data, so we just throw out the data for now.
+     */
+    if(strstr(input->job.metadata, "darshan_shutdown=yes"))
+    {
+        fprintf(stderr,
+            "Error: potentially corrupt data found in input log file %s.\n",
+            input->path);
+        darshan_log_close(in_fd);
+        return(-1);
+    }
+#endif
+
+    if(first)
+    {
+        /* exe & mounts are only taken from the first input log */
+        ret = darshan_log_get_exe(in_fd, input->exe);
+        if(ret < 0)
         {
             fprintf(stderr,
-                "Error: unable to open input Darshan log file %s.\n",
-                infile_list[i]);
+                "Error: unable to read exe string from input Darshan log file %s.\n",
+                input->path);
+            darshan_log_close(in_fd);
             return(-1);
         }
 
-        while((ret = mod_logutils[mod_id]->log_get_record(in_fd, (void **)&mod_buf)) == 1)
+        ret = darshan_log_get_mounts(in_fd, &input->mnt_array, &input->mnt_count);
+        if(ret < 0)
         {
-            base_rec = (struct darshan_base_record *)mod_buf;
-            if(init_rank == -1)
-                init_rank = base_rec->rank;
-
-            /* initialize the hash with the first rank's records */
-            if(base_rec->rank == init_rank)
-            {
-                struct darshan_base_record *agg_base;
+            fprintf(stderr,
+                "Error: unable to read mount info from input Darshan log file %s.\n",
+                input->path);
+            darshan_log_close(in_fd);
+            return(-1);
+        }
+    }
 
-                /* create a new ref and add to the hash */
-                ref = malloc(sizeof(*ref));
-                if(!ref)
-                {
-                    darshan_log_close(in_fd);
-                    return(-1);
-                }
-                memset(ref, 0, sizeof(*ref));
+    /* read the hash of ids->names for the input log */
+    ret = darshan_log_get_namehash(in_fd, &input->name_hash);
+    if(ret < 0)
+    {
+        fprintf(stderr,
+            "Error: unable to read job data from input Darshan log file %s.\n",
+            input->path);
+        darshan_log_close(in_fd);
+        return(-1);
+    }
 
-                /* initialize the aggregate record with this rank's record */
-                mod_logutils[mod_id]->log_agg_records(mod_buf, ref->agg_rec, 1);
-                agg_base = (struct darshan_base_record *)ref->agg_rec;
-                agg_base->id = base_rec->id;
-                agg_base->rank = -1;
+    /* read every module's records, each into its own buffer */
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(!mod_logutils[i]) continue;
 
-                ref->id = base_rec->id;
-                ref->ref_cnt = 1;
-                HASH_ADD(hlink, *shared_rec_hash, id, sizeof(darshan_record_id), ref);
-            }
-            else
-           {
-                /* search for this record in shared record hash */
-                HASH_FIND(hlink, *shared_rec_hash, &(base_rec->id),
-                    sizeof(darshan_record_id), ref);
-                if(ref)
-                {
-                    /* if found, aggregate this rank's record into the shared record */
-                    mod_logutils[mod_id]->log_agg_records(mod_buf, ref->agg_rec, 0);
-                    ref->ref_cnt++;
-                }
+        rec = NULL;
+        while((ret = mod_logutils[i]->log_get_record(in_fd, &rec)) == 1)
+        {
+            if(merge_rec_list_add(&input->mod_recs[i], rec) < 0)
+            {
+                ret = -1;
+                break;
             }
+            rec = NULL;
         }
+        free(rec);
         if(ret < 0)
         {
             fprintf(stderr,
                 "Error: unable to read %s module record from input log file %s.\n",
-                darshan_module_names[mod_id], infile_list[i]);
+                darshan_module_names[i], input->path);
             darshan_log_close(in_fd);
             return(-1);
         }
+    }
 
-        darshan_log_close(in_fd);
+    darshan_log_close(in_fd);
+
+    return(0);
+}
+
+static void *merge_read_thread(void *arg)
+{
+    struct merge_read_state *rs = (struct merge_read_state *)arg;
+    int idx;
+    int ret;
+
+    while(1)
+    {
+        /* only read ahead a bounded number of inputs of the main thread */
+        pthread_mutex_lock(&rs->mutex);
+        while(rs->next_input < rs->n_inputs &&
+              rs->next_input >= rs->merged + rs->window)
+            pthread_cond_wait(&rs->cond, &rs->mutex);
+        if(rs->next_input >= rs->n_inputs)
+        {
+            pthread_mutex_unlock(&rs->mutex);
+            break;
+        }
+        idx = rs->next_input++;
+        pthread_mutex_unlock(&rs->mutex);
+
+        ret = merge_read_input(&rs->inputs[idx], idx == 0);
+
+        pthread_mutex_lock(&rs->mutex);
+        rs->inputs[idx].err = ret;
+        rs->inputs[idx].done = 1;
+        pthread_cond_broadcast(&rs->cond);
+        pthread_mutex_unlock(&rs->mutex);
     }
 
-    /* prune any non-shared records from the hash one last time */
-    HASH_ITER(hlink, *shared_rec_hash, ref, tmp)
+    return(NULL);
+}
+
+/* write all buffered records of each module to that module's temporary
+ * (uncompressed) log and free them. returns 0 on success, -1 on failure
+ */
+static int merge_spill_records(char *spill_dir, darshan_fd *spill_fds,
+    struct merge_rec_list *mod_recs)
+{
+    char spill_path[PATH_MAX];
+    int i, j;
+    int ret;
+
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
     {
-        if(ref->ref_cnt != nprocs)
+        if(mod_recs[i].count == 0) continue;
+
+        if(!spill_fds[i])
         {
-            HASH_DELETE(hlink, *shared_rec_hash, ref);
-            free(ref);
+            snprintf(spill_path, PATH_MAX, "%s/%s.darshan", spill_dir,
+                darshan_module_names[i]);
+            spill_fds[i] = darshan_log_create(spill_path, DARSHAN_NO_COMP, 0);
+            if(!spill_fds[i])
+            {
+                fprintf(stderr, "Error: unable to create temporary log %s.\n",
+                    spill_path);
+                return(-1);
+            }
         }
+
+        for(j = 0; j < mod_recs[i].count; j++)
+        {
+            ret = mod_logutils[i]->log_put_record(spill_fds[i], mod_recs[i].recs[j]);
+            if(ret < 0)
+            {
+                fprintf(stderr,
+                    "Error: unable to write %s module record to temporary log.\n",
+                    darshan_module_names[i]);
+                return(-1);
+            }
+            free(mod_recs[i].recs[j]);
+        }
+        mod_recs[i].count = 0;
     }
 
     return(0);
 }
 
+static void merge_cleanup_spill(char *spill_dir, darshan_fd *spill_fds)
+{
+    char spill_path[PATH_MAX];
+    int i;
+
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(!mod_logutils[i]) continue;
+
+        if(spill_fds[i])
+        {
+            darshan_log_close(spill_fds[i]);
+            spill_fds[i] = NULL;
+        }
+        snprintf(spill_path, PATH_MAX, "%s/%s.darshan", spill_dir,
+            darshan_module_names[i]);
+        unlink(spill_path);
+    }
+    rmdir(spill_dir);
+
+    return;
+}
+
 int main(int argc, char *argv[])
 {
+    glob_t infile_glob;
     char **infile_list;
     int n_infiles;
     int shared_redux;
     int64_t job_end_time = 0;
+    int njobs;
+    int64_t max_mem;
     char *outlog_path;
-    darshan_fd in_fd, merge_fd;
-    struct darshan_job in_job, merge_job;
+    darshan_fd spill_fd, merge_fd;
+    struct darshan_job merge_job;
+    uint64_t merge_partial_flag = 0;
     char merge_exe[DARSHAN_EXE_LEN+1] = {0};
-    struct darshan_mnt_info *merge_mnt_array;
+    struct darshan_mnt_info *merge_mnt_array = NULL;
     int merge_mnt_count = 0;
-    struct darshan_name_record_ref *in_hash = NULL;
     struct darshan_name_record_ref *merge_hash = NULL;
     struct darshan_name_record_ref *ref, *tmp, *found;
-    struct darshan_shared_record_ref *shared_rec_hash = NULL;
+    struct darshan_shared_record_ref *shared_rec_hash[DARSHAN_KNOWN_MODULE_COUNT] = {0};
     struct darshan_shared_record_ref *sref, *stmp;
+    int init_rank[DARSHAN_KNOWN_MODULE_COUNT];
+    struct merge_rec_list mod_recs[DARSHAN_KNOWN_MODULE_COUNT] = {0};
+    darshan_fd spill_fds[DARSHAN_KNOWN_MODULE_COUNT] = {0};
+    char spill_dir[PATH_MAX] = {0};
+    char *tmpdir;
+    int64_t mem_bytes = 0;
+    struct merge_read_state rs;
+    pthread_t *threads = NULL;
+    struct merge_input *input;
     struct darshan_base_record *base_rec;
-    char *mod_buf;
-    int i, j;
-    int ret;
+    char *mod_buf = NULL;
+    void *rec, *agg_src;
+    int rec_size;
+    int i, j, k;
+    int ret = 0;
 
     /* grab command line arguments */
-    parse_args(argc, argv, &infile_list, &n_infiles, &outlog_path, &shared_redux, &job_end_time);
+    parse_args(argc, argv, &infile_glob, &outlog_path, &shared_redux,
+        &job_end_time, &njobs, &max_mem);
+    infile_list = infile_glob.gl_pathv;
+    n_infiles = infile_glob.gl_pathc;
+    max_mem *= 1024 * 1024;
 
     memset(&merge_job, 0, sizeof(struct darshan_job));
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+        init_rank[i] = -1;
 
-    /* first pass at merging together logs:
-     *      - compose output job-level metadata structure (including exe & mount data)
-     *      - compose output record_id->file_name mapping 
-     */
-    for(i = 0; i < n_infiles; i++)
+    memset(&rs, 0, sizeof(rs));
+    rs.inputs = calloc(n_infiles, sizeof(*rs.inputs));
+    if(n_infiles && !rs.inputs)
     {
-        memset(&in_job, 0, sizeof(struct darshan_job));
+        fprintf(stderr, "Error: unable to allocate input log state.\n");
+        return(-1);
+    }
+    for(i = 0; i < n_infiles; i++)
+        rs.inputs[i].path = infile_list[i];
+    rs.n_inputs = n_infiles;
+    rs.window = 2 * njobs;
+    pthread_mutex_init(&rs.mutex, NULL);
+    pthread_cond_init(&rs.cond, NULL);
 
-        in_fd = darshan_log_open(infile_list[i]);
-        if(in_fd == NULL)
+    if(shared_redux)
+    {
+        mod_buf = calloc(1, DEF_MOD_BUF_SIZE);
+        if(!mod_buf)
         {
-            fprintf(stderr,
-                "Error: unable to open input Darshan log file %s.\n",
-                infile_list[i]);
+            fprintf(stderr, "Error: unable to allocate record buffer.\n");
             return(-1);
         }
+    }
 
-        /* read job-level metadata from the input file */
-        ret = darshan_log_get_job(in_fd, &in_job);
-        if(ret < 0)
+    /* records that don't fit in memory are spilled to temporary logs */
+    tmpdir = getenv("TMPDIR");
+    snprintf(spill_dir, PATH_MAX, "%s/darshan-merge-XXXXXX",
+        (tmpdir && *tmpdir) ? tmpdir : "/tmp");
+    if(!mkdtemp(spill_dir))
+    {
+        fprintf(stderr, "Error: unable to create temporary directory %s.\n",
+            spill_dir);
+        return(-1);
+    }
+
+    if(njobs > 1 && n_infiles > 1)
+    {
+        threads = malloc(njobs * sizeof(*threads));
+        if(!threads)
         {
-            fprintf(stderr,
-                "Error: unable to read job data from input Darshan log file %s.\n",
-                infile_list[i]);
-            darshan_log_close(in_fd);
+            fprintf(stderr, "Error: unable to allocate input log state.\n");
+            rmdir(spill_dir);
             return(-1);
         }
+        for(i = 0; i < njobs; i++)
+        {
+            if(pthread_create(&threads[i], NULL, merge_read_thread, &rs) != 0)
+                break;
+        }
+        njobs = i;
+        if(njobs == 0)
+        {
+            free(threads);
+            threads = NULL;
+        }
+    }
 
-#if 0
-        /* XXX: the darshan_shutdown tag is never set in darshan-core, currently */
-        /* if the input darshan log has metadata set indicating the darshan
-         * shutdown procedure was called on the log, then we error out. if the
-         * shutdown procedure was started, then it's possible the log has
-         * incomplete or corrupt data, so we just throw out the data for now.
-         */
-        if(strstr(in_job.metadata, "darshan_shutdown=yes"))
+    /* single pass over the input logs, which are read once (possibly by
+     * several threads) but always merged in order:
+     *      - compose output job-level metadata structure (including exe & mount data)
+     *      - compose output record_id->file_name mapping
+     *      - build each module's hash of shared records
+     *      - buffer each module's records, spilling them if memory runs short
+     */
+    for(i = 0; i < n_infiles; i++)
+    {
+        input = &rs.inputs[i];
+
+        if(threads)
         {
-            fprintf(stderr,
-                "Error: potentially corrupt data found in input log file %s.\n",
-                infile_list[i]);
-            darshan_log_close(in_fd);
-            return(-1);
+            pthread_mutex_lock(&rs.mutex);
+            while(!input->done)
+                pthread_cond_wait(&rs.cond, &rs.mutex);
+            pthread_mutex_unlock(&rs.mutex);
         }
-#endif
+        else
+            input->err = merge_read_input(input, i == 0);
+        if(input->err < 0)
+        {
+            ret = -1;
+            goto cleanup;
+        }
+
+        /* modules that ran out of memory in any input are partial in the output */
+        merge_partial_flag |= input->partial_flag;
 
         if(i == 0)
         {
             /* get job data, exe, & mounts directly from the first input log */
-            memcpy(&merge_job, &in_job, sizeof(struct darshan_job));
-
-            ret = darshan_log_get_exe(in_fd, merge_exe);
-            if(ret < 0)
-            {
-                fprintf(stderr,
-                    "Error: unable to read exe string from input Darshan log file %s.\n",
-                    infile_list[i]);
-                darshan_log_close(in_fd);
-                return(-1);
-            }
-
-            ret = darshan_log_get_mounts(in_fd, &merge_mnt_array, &merge_mnt_count);
-            if(ret < 0)
-            {
-                fprintf(stderr,
-                    "Error: unable to read mount info from input Darshan log file %s.\n",
-                    infile_list[i]);
-                darshan_log_close(in_fd);
-                return(-1);
-            }
+            memcpy(&merge_job, &input->job, sizeof(struct darshan_job));
+            memcpy(merge_exe, input->exe, sizeof(merge_exe));
+            merge_mnt_array = input->mnt_array;
+            merge_mnt_count = input->mnt_count;
         }
         else
         {
             /* potentially update job timestamps using remaining logs */
-            if((in_job.start_time_sec < merge_job.start_time_sec) ||
-               ((in_job.start_time_sec == merge_job.start_time_sec) &&
-                (in_job.start_time_nsec < merge_job.start_time_nsec)))
+            if((input->job.start_time_sec < merge_job.start_time_sec) ||
+               ((input->job.start_time_sec == merge_job.start_time_sec) &&
+                (input->job.start_time_nsec < merge_job.start_time_nsec)))
             {
-                merge_job.start_time_sec = in_job.start_time_sec;
-                merge_job.start_time_nsec = in_job.start_time_nsec;
+                merge_job.start_time_sec = input->job.start_time_sec;
+                merge_job.start_time_nsec = input->job.start_time_nsec;
             }
-            if((in_job.end_time_sec > merge_job.end_time_sec) ||
-               ((in_job.end_time_sec == merge_job.end_time_sec) &&
-                (in_job.end_time_nsec > merge_job.end_time_nsec)))
+            if((input->job.end_time_sec > merge_job.end_time_sec) ||
+               ((input->job.end_time_sec == merge_job.end_time_sec) &&
+                (input->job.end_time_nsec > merge_job.end_time_nsec)))
             {
-                merge_job.end_time_sec = in_job.end_time_sec;
-                merge_job.end_time_nsec = in_job.end_time_nsec;
+                merge_job.end_time_sec = input->job.end_time_sec;
+                merge_job.end_time_nsec = input->job.end_time_nsec;
             }
         }
 
-        /* read the hash of ids->names for the input log */
-        ret = darshan_log_get_namehash(in_fd, &in_hash);
-        if(ret < 0)
-        {
-            fprintf(stderr,
-                "Error: unable to read job data from input Darshan log file %s.\n",
-                infile_list[i]);
-            darshan_log_close(in_fd);
-            return(-1);
-        }
-
-        /* iterate the input hash, copying over record id->name mappings
+        /* iterate the input hash, moving over record id->name mappings
          * that have not already been copied to the output hash
          */
-        HASH_ITER(hlink, in_hash, ref, tmp)
+        HASH_ITER(hlink, input->name_hash, ref, tmp)
         {
+            HASH_DELETE(hlink, input->name_hash, ref);
             HASH_FIND(hlink, merge_hash, &(ref->name_record->id),
                 sizeof(darshan_record_id), found);
             if(!found)
             {
                 HASH_ADD(hlink, merge_hash, name_record->id,
                     sizeof(darshan_record_id), ref);
+                continue;
             }
             else if(strcmp(ref->name_record->name, found->name_record->name))
             {
                 fprintf(stderr,
                     "Error: invalid Darshan record table entry.\n");
-                darshan_log_close(in_fd);
-                return(-1);
+                free(ref->name_record);
+                free(ref);
+                ret = -1;
+                break;
             }
+            free(ref->name_record);
+            free(ref);
         }
+        if(ret < 0)
+            goto cleanup;
 
-        darshan_log_close(in_fd);
+        for(j = 0; j < DARSHAN_KNOWN_MODULE_COUNT; j++)
+        {
+            for(k = 0; k < input->mod_recs[j].count; k++)
+            {
+                rec = input->mod_recs[j].recs[k];
+                rec_size = merge_rec_size(j, rec);
+
+                if(shared_redux && mod_logutils[j]->log_agg_records)
+                {
+                    base_rec = (struct darshan_base_record *)rec;
+
+                    /* some modules use the bytes following a record as scratch
+                     * space while aggregating, so aggregate from a full buffer
+                     */
+                    agg_src = rec;
+                    if(mod_logutils[j]->log_sizeof_record &&
+                       rec_size <= DEF_MOD_BUF_SIZE)
+                    {
+                        memcpy(mod_buf, rec, rec_size);
+                        agg_src = mod_buf;
+                    }
+
+                    if(init_rank[j] == -1)
+                        init_rank[j] = base_rec->rank;
+
+                    /* initialize the hash with the first rank's records */
+                    if(base_rec->rank == init_rank[j])
+                    {
+                        struct darshan_base_record *agg_base;
+
+                        /* create a new ref and add to the hash */
+                        sref = calloc(1, sizeof(*sref) +
+                            (mod_logutils[j]->log_sizeof_record ?
+                             rec_size : DEF_MOD_BUF_SIZE));
+                        if(!sref)
+                        {
+                            fprintf(stderr,
+                                "Error: unable to build list of %s module's shared records.\n",
+                                darshan_module_names[j]);
+                            ret = -1;
+                            goto cleanup;
+                        }
+
+                        /* initialize the aggregate record with this rank's record */
+                        mod_logutils[j]->log_agg_records(agg_src, sref->agg_rec, 1);
+                        agg_base = (struct darshan_base_record *)sref->agg_rec;
+                        agg_base->id = base_rec->id;
+                        agg_base->rank = -1;
+
+                        sref->id = base_rec->id;
+                        sref->ref_cnt = 1;
+                        HASH_ADD(hlink, shared_rec_hash[j], id,
+                            sizeof(darshan_record_id), sref);
+                    }
+                    else
+                    {
+                        /* search for this record in shared record hash */
+                        HASH_FIND(hlink, shared_rec_hash[j], &(base_rec->id),
+                            sizeof(darshan_record_id), sref);
+                        if(sref)
+                        {
+                            /* if found, aggregate this rank's record into the shared record */
+                            mod_logutils[j]->log_agg_records(agg_src, sref->agg_rec, 0);
+                            sref->ref_cnt++;
+                        }
+                    }
+                }
+
+                /* hand the record over to the module's merged list */
+                if(merge_rec_list_add(&mod_recs[j], rec) < 0)
+                {
+                    fprintf(stderr, "Error: unable to buffer %s module records.\n",
+                        darshan_module_names[j]);
+                    for(; k < input->mod_recs[j].count; k++)
+                        free(input->mod_recs[j].recs[k]);
+                    ret = -1;
+                    goto cleanup;
+                }
+                mem_bytes += rec_size;
+            }
+            free(input->mod_recs[j].recs);
+            memset(&input->mod_recs[j], 0, sizeof(input->mod_recs[j]));
+        }
+
+        if(threads)
+        {
+            /* let the reading threads move on to further inputs */
+            pthread_mutex_lock(&rs.mutex);
+            rs.merged = i + 1;
+            pthread_cond_broadcast(&rs.cond);
+            pthread_mutex_unlock(&rs.mutex);
+        }
+
+        if(mem_bytes > max_mem)
+        {
+            ret = merge_spill_records(spill_dir, spill_fds, mod_recs);
+            if(ret < 0)
+                goto cleanup;
+            mem_bytes = 0;
+        }
+    }
+
+    /* prune any non-shared records from the hashes */
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        HASH_ITER(hlink, shared_rec_hash[i], sref, stmp)
+        {
+            if(sref->ref_cnt != merge_job.nprocs)
+            {
+                HASH_DELETE(hlink, shared_rec_hash[i], sref);
+                free(sref);
+            }
+        }
     }
 
     /* if a job end time was passed in, apply it to the output job */
@@ -352,11 +743,13 @@ int main(int argc, char *argv[])
     }
 
     /* create the output "merged" log */
-    merge_fd = darshan_log_create(outlog_path, DARSHAN_ZLIB_COMP, 1);
+    merge_fd = darshan_log_create(outlog_path, DARSHAN_ZLIB_COMP,
+        merge_partial_flag);
     if(merge_fd == NULL)
     {
         fprintf(stderr, "Error: unable to create output darshan log.\n");
-        return(-1);
+        ret = -1;
+        goto cleanup;
     }
 
     /* write the darshan job info, exe string, and mount data to output file */
@@ -364,27 +757,21 @@ int main(int argc, char *argv[])
     if(ret < 0)
     {
         fprintf(stderr, "Error: unable to write job data to output darshan log.\n");
-        darshan_log_close(merge_fd);
-        unlink(outlog_path);
-        return(-1);
+        goto cleanup_output;
     }
 
     ret = darshan_log_put_exe(merge_fd, merge_exe);
     if(ret < 0)
     {
         fprintf(stderr, "Error: unable to write exe string to output darshan log.\n");
-        darshan_log_close(merge_fd);
-        unlink(outlog_path);
-        return(-1);
+        goto cleanup_output;
     }
 
     ret = darshan_log_put_mounts(merge_fd, merge_mnt_array, merge_mnt_count);
     if(ret < 0)
     {
         fprintf(stderr, "Error: unable to write mount data to output darshan log.\n");
-        darshan_log_close(merge_fd);
-        unlink(outlog_path);
-        return(-1);
+        goto cleanup_output;
     }
 
     /* write the merged table of records to output file */
@@ -392,132 +779,128 @@ int main(int argc, char *argv[])
     if(ret < 0)
     {
         fprintf(stderr, "Error: unable to write record table to output darshan log.\n");
-        darshan_log_close(merge_fd);
-        unlink(outlog_path);
-        return(-1);
-    }
-
-    mod_buf = malloc(DEF_MOD_BUF_SIZE);
-    if(!mod_buf)
-    {
-        fprintf(stderr, "Error: unable to write record table to output darshan log.\n");
-        darshan_log_close(merge_fd);
-        unlink(outlog_path);
-        return(-1);
+        goto cleanup_output;
     }
 
-    /* iterate over active darshan modules and gather module data to write
-     * to the merged output log
+    /* iterate over active darshan modules and write their shared records,
+     * then any spilled records, then the records still buffered in memory
      */
     for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
     {
         if(!mod_logutils[i]) continue;
 
-        if(shared_redux)
+        HASH_ITER(hlink, shared_rec_hash[i], sref, stmp)
         {
-            /* build the hash of records shared globally by this module */
-            ret = build_mod_shared_rec_hash(infile_list, n_infiles, i,
-                merge_job.nprocs, mod_buf, &shared_rec_hash);
+            ret = mod_logutils[i]->log_put_record(merge_fd, sref->agg_rec);
             if(ret < 0)
             {
                 fprintf(stderr,
-                    "Error: unable to build list of %s module's shared records.\n",
+                    "Error: unable to write %s module record to output darshan log.\n",
                     darshan_module_names[i]);
-                darshan_log_close(merge_fd);
-                unlink(outlog_path);
-                free(mod_buf);
-                return(-1);
+                goto cleanup_output;
             }
-
         }
 
-        for(j = 0; j < n_infiles; j++)
+        if(spill_fds[i])
         {
-            in_fd = darshan_log_open(infile_list[j]);
-            if(in_fd == NULL)
-            {
-                fprintf(stderr,
-                    "Error: unable to open input Darshan log file %s.\n",
-                    infile_list[j]);
-                darshan_log_close(merge_fd);
-                unlink(outlog_path);
-                free(mod_buf);
-                return(-1);
-            }
+            char spill_path[PATH_MAX];
 
-            if(j == 0 && shared_rec_hash)
+            darshan_log_close(spill_fds[i]);
+            spill_fds[i] = NULL;
+
+            snprintf(spill_path, PATH_MAX, "%s/%s.darshan", spill_dir,
+                darshan_module_names[i]);
+            spill_fd = darshan_log_open(spill_path);
+            if(spill_fd == NULL)
             {
-                /* write out the shared records first */
-                HASH_ITER(hlink, shared_rec_hash, sref, stmp)
-                {
-                    ret = mod_logutils[i]->log_put_record(merge_fd, sref->agg_rec);
-                    if(ret < 0)
-                    {
-                        fprintf(stderr,
-                            "Error: unable to write %s module record to output darshan log.\n",
-                            darshan_module_names[i]);
-                        darshan_log_close(in_fd);
-                        darshan_log_close(merge_fd);
-                        unlink(outlog_path);
-                        free(mod_buf);
-                        return(-1);
-                    }
-                }
+                fprintf(stderr,
+                    "Error: unable to open temporary log %s.\n", spill_path);
+                ret = -1;
+                goto cleanup_output;
             }
 
-            /* loop over module records and write them to output file */
-            while((ret = mod_logutils[i]->log_get_record(in_fd, (void **)&mod_buf)) == 1)
+            while((ret = darshan_log_get_record_ref(spill_fd, i, &rec)) == 1)
             {
-                base_rec = (struct darshan_base_record *)mod_buf;
+                base_rec = (struct darshan_base_record *)rec;
 
-                HASH_FIND(hlink, shared_rec_hash, &(base_rec->id), sizeof(darshan_record_id), sref);
+                HASH_FIND(hlink, shared_rec_hash[i], &(base_rec->id),
+                    sizeof(darshan_record_id), sref);
                 if(sref)
                     continue; /* skip shared records */
 
-                ret = mod_logutils[i]->log_put_record(merge_fd, mod_buf);
+                ret = mod_logutils[i]->log_put_record(merge_fd, rec);
                 if(ret < 0)
-                {
-                    fprintf(stderr,
-                        "Error: unable to write %s module record to output log file %s.\n",
-                        darshan_module_names[i], infile_list[j]);
-                    darshan_log_close(in_fd);
-                    darshan_log_close(merge_fd);
-                    unlink(outlog_path);
-                    free(mod_buf);
-                    return(-1);
-                }
+                    break;
             }
+            darshan_log_close(spill_fd);
             if(ret < 0)
             {
                 fprintf(stderr,
-                    "Error: unable to read %s module record from input log file %s.\n",
-                    darshan_module_names[i], infile_list[j]);
-                darshan_log_close(in_fd);
-                darshan_log_close(merge_fd);
-                unlink(outlog_path);
-                free(mod_buf);
-                return(-1);
+                    "Error: unable to copy %s module records from temporary log %s.\n",
+                    darshan_module_names[i], spill_path);
+                goto cleanup_output;
             }
-
-            darshan_log_close(in_fd);
         }
 
-        /* clear the shared record hash for the next module */
-        if(shared_redux)
+        for(j = 0; j < mod_recs[i].count; j++)
         {
-            HASH_ITER(hlink, shared_rec_hash, sref, stmp)
+            base_rec = (struct darshan_base_record *)mod_recs[i].recs[j];
+
+            HASH_FIND(hlink, shared_rec_hash[i], &(base_rec->id),
+                sizeof(darshan_record_id), sref);
+            if(sref)
+                continue; /* skip shared records */
+
+            ret = mod_logutils[i]->log_put_record(merge_fd, base_rec);
+            if(ret < 0)
             {
-                HASH_DELETE(hlink, shared_rec_hash, sref);
-                free(sref);
+                fprintf(stderr,
+                    "Error: unable to write %s module record to output darshan log.\n",
+                    darshan_module_names[i]);
+                goto cleanup_output;
             }
         }
     }
+    ret = 0;
 
-    free(mod_buf);
-
+cleanup_output:
     darshan_log_close(merge_fd);
+    if(ret < 0)
+        unlink(outlog_path);
+cleanup:
+    if(threads)
+    {
+        if(ret < 0)
+        {
+            /* stop handing out further inputs to the reading threads */
+            pthread_mutex_lock(&rs.mutex);
+            rs.next_input = rs.n_inputs;
+            pthread_cond_broadcast(&rs.cond);
+            pthread_mutex_unlock(&rs.mutex);
+        }
+        for(i = 0; i < njobs; i++)
+            pthread_join(threads[i], NULL);
+        free(threads);
+    }
+    merge_cleanup_spill(spill_dir, spill_fds);
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        for(j = 0; j < mod_recs[i].count; j++)
+            free(mod_recs[i].recs[j]);
+        free(mod_recs[i].recs);
+        HASH_ITER(hlink, shared_rec_hash[i], sref, stmp)
+        {
+            HASH_DELETE(hlink, shared_rec_hash[i], sref);
+            free(sref);
+        }
+    }
+    free(mod_buf);
+    free(rs.inputs);
+    globfree(&infile_glob);
+    pthread_mutex_destroy(&rs.mutex);
+    pthread_cond_destroy(&rs.cond);
 
-    return(0);
+    return(ret);
 }
 
 /*
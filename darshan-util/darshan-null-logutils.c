@@ -43,6 +43,7 @@ static void darshan_log_print_null_description(int ver);
 static void darshan_log_print_null_record_diff(void *file_rec1, char *file_name1,
     void *file_rec2, char *file_name2);
 static void darshan_log_agg_null_records(void *rec, void *agg_rec, int init_flag);
+static int darshan_log_sizeof_null_record(void* null_buf_p);
 
 /* structure storing each function needed for implementing the darshan
  * logutil interface. these functions are used for reading, writing, and
@@ -55,9 +56,16 @@ struct darshan_mod_logutil_funcs null_logutils =
     .log_print_record = &darshan_log_print_null_record,
     .log_print_description = &darshan_log_print_null_description,
     .log_print_diff = &darshan_log_print_null_record_diff,
-    .log_agg_records = &darshan_log_agg_null_records
+    .log_agg_records = &darshan_log_agg_null_records,
+    .log_sizeof_record = &darshan_log_sizeof_null_record
 };
 
+static int darshan_log_sizeof_null_record(void* null_buf_p)
+{
+    /* NULL records have a fixed size */
+    return(sizeof(struct darshan_null_record));
+}
+
 /* retrieve a NULL record from log file descriptor 'fd', storing the
  * data in the buffer address pointed to by 'null_buf_p'. Return 1 on
  * successful record read, 0 on no more data, and -1 on error.
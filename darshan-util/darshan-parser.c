@@ -33,6 +33,7 @@
 #define OPTION_FILE    (1 << 3)  /* file count totals */
 #define OPTION_VERSION (1 << 4)  /* print Darshan version number */
 #define OPTION_SHOW_INCOMPLETE  (1 << 7)  /* show what we have, even if log is incomplete */
+#define OPTION_THREADS (1 << 8)  /* decompress log data with multiple threads */
 #define OPTION_ALL (\
   OPTION_BASE|\
   OPTION_TOTAL|\
@@ -66,11 +67,12 @@ int usage (char *exename)
     fprintf(stderr, "    --perf    : derived perf data\n");
     fprintf(stderr, "    --total   : aggregated Darshan field data\n");
     fprintf(stderr, "    --show-incomplete : display results even if log is incomplete\n");
+    fprintf(stderr, "    --threads <N> : decompress log data using N threads\n");
 
     exit(1);
 }
 
-int parse_args (int argc, char **argv, char **filename)
+int parse_args (int argc, char **argv, char **filename, int *nthreads)
 {
     int index;
     int mask;
@@ -82,12 +84,14 @@ int parse_args (int argc, char **argv, char **filename)
         {"perf",  0, NULL, OPTION_PERF},
         {"total", 0, NULL, OPTION_TOTAL},
         {"show-incomplete", 0, NULL, OPTION_SHOW_INCOMPLETE},
+        {"threads", 1, NULL, OPTION_THREADS},
         {"help",  0, NULL, 0},
         {"version",  0, NULL, OPTION_VERSION},
         {0, 0, 0, 0}
     };
 
     mask = 0;
+    *nthreads = 1;
 
     while(1)
     {
@@ -105,6 +109,11 @@ int parse_args (int argc, char **argv, char **filename)
             case OPTION_SHOW_INCOMPLETE:
                 mask |= c;
                 break;
+            case OPTION_THREADS:
+                *nthreads = atoi(optarg);
+                if (*nthreads < 1)
+                    usage(argv[0]);
+                break;
             case OPTION_VERSION:
                 printf("%s\n", PACKAGE_VERSION);
                 exit(0);
@@ -138,6 +147,7 @@ int main(int argc, char **argv)
 {
     int ret;
     int mask;
+    int nthreads;
     int i, j;
     char *filename;
     char *comp_str;
@@ -155,16 +165,24 @@ int main(int argc, char **argv)
     char buffer[DARSHAN_JOB_METADATA_LEN];
     int empty_mods = 0;
     char *mod_buf;
+    void *rec_buf;
 
     darshan_accumulator acc = NULL;
     struct darshan_derived_metrics metrics;
+    struct darshan_log_summary *summary = NULL;
 
-    mask = parse_args(argc, argv, &filename);
+    mask = parse_args(argc, argv, &filename, &nthreads);
 
     fd = darshan_log_open(filename);
     if(!fd)
         return(-1);
 
+    if(nthreads > 1 && darshan_log_set_threads(fd, nthreads) < 0)
+    {
+        darshan_log_close(fd);
+        return(-1);
+    }
+
     /* read darshan job info */
     ret = darshan_log_get_job(fd, &job);
     if(ret < 0)
@@ -189,9 +207,21 @@ int main(int argc, char **argv)
         return(-1);
     }
 
-    /* read hash of darshan records */
-    ret = darshan_log_get_namehash(fd, &name_hash);
-    if(ret < 0)
+    /* record names are only printed with the base output; otherwise, the
+     * totals and derived metrics can come from the log's summary sidecar
+     * (if it has one) without reading any records
+     */
+    if(mask & OPTION_BASE)
+    {
+        /* read hash of darshan records */
+        ret = darshan_log_get_namehash(fd, &name_hash);
+        if(ret < 0)
+        {
+            darshan_log_close(fd);
+            return(-1);
+        }
+    }
+    else if(darshan_log_summary_read(filename, NULL, &summary) < 0)
     {
         darshan_log_close(fd);
         return(-1);
@@ -206,6 +236,8 @@ int main(int argc, char **argv)
         comp_str = "BZIP2";
     else if (fd->comp_type == DARSHAN_NO_COMP)
         comp_str = "NONE";
+    else if (fd->comp_type == DARSHAN_ZSTD_COMP)
+        comp_str = "ZSTD";
     else
         comp_str = "UNKNOWN";
 
@@ -391,18 +423,28 @@ int main(int argc, char **argv)
             }
         }
 
-        /* create an accumulator, if supported */
-        /* no explicit error checking; we will just skip injecting if null */
-        darshan_accumulator_create(i, job.nprocs, &acc);
+        if(summary && summary->mods[i])
+        {
+            metrics = summary->mods[i]->metrics;
+            memcpy(mod_buf, summary->mods[i]->agg_record,
+                summary->mods[i]->agg_record_size);
+            ret = 0;
+        }
+        else
+        {
+            /* create an accumulator, if supported */
+            /* no explicit error checking; we will just skip injecting if null */
+            darshan_accumulator_create(i, job.nprocs, &acc);
+        }
 
         /* loop over each of this module's records and print them */
-        while(1)
+        while(!(summary && summary->mods[i]))
         {
             char *mnt_pt = NULL;
             char *fs_type = NULL;
             char *rec_name = NULL;
 
-            ret = mod_logutils[i]->log_get_record(fd, (void **)&mod_buf);
+            ret = darshan_log_get_record_ref(fd, i, &rec_buf);
             if(ret < 1)
             {
                 if(ret == -1)
@@ -412,7 +454,7 @@ int main(int argc, char **argv)
                 }
                 break;
             }
-            base_rec = (struct darshan_base_record *)mod_buf;
+            base_rec = (struct darshan_base_record *)rec_buf;
 
             /* get the pathname for this record */
             HASH_FIND(hlink, name_hash, &(base_rec->id), sizeof(darshan_record_id), ref);
@@ -447,13 +489,13 @@ int main(int argc, char **argv)
             if(mask & OPTION_BASE)
             {
                 /* print the corresponding module data for this record */
-                mod_logutils[i]->log_print_record(mod_buf, rec_name,
+                mod_logutils[i]->log_print_record(rec_buf, rec_name,
                     mnt_pt, fs_type);
             }
 
             /* accumulated and derived metrics, if supported */
             if(acc)
-                darshan_accumulator_inject(acc, mod_buf, 1);
+                darshan_accumulator_inject(acc, rec_buf, 1);
         }
         if(ret == -1)
             continue; /* move on to the next module if there was an error with this one */
@@ -562,6 +604,7 @@ int main(int argc, char **argv)
             printf("# I/O timing for shared files (seconds):\n");
             printf("# ...........................\n");
             printf("# shared files: time_by_slowest: %lf\n", metrics.shared_io_total_time_by_slowest);
+            printf("# partially shared files: time_by_slowest: %lf\n", metrics.part_shared_io_total_time_by_slowest);
             printf("#\n");
             printf("# Aggregate performance, including both shared and unique files:\n");
             printf("# ...........................\n");
@@ -581,6 +624,7 @@ int main(int argc, char **argv)
 
     darshan_log_close(fd);
     free(mod_buf);
+    darshan_log_summary_free(summary);
 
     /* free record hash data */
     HASH_ITER(hlink, name_hash, ref, tmp_ref)
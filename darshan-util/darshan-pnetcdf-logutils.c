@@ -61,6 +61,8 @@ static void darshan_log_print_pnetcdf_var_description(int ver);
 static void darshan_log_print_pnetcdf_var_diff(void *var_rec1, char *var_name1,
     void *var_rec2, char *var_name2);
 static void darshan_log_agg_pnetcdf_vars(void *rec, void *agg_rec, int init_flag);
+static int darshan_log_sizeof_pnetcdf_file(void* pnetcdf_buf_p);
+static int darshan_log_sizeof_pnetcdf_var(void* pnetcdf_buf_p);
 
 struct darshan_mod_logutil_funcs pnetcdf_file_logutils =
 {
@@ -69,9 +71,16 @@ struct darshan_mod_logutil_funcs pnetcdf_file_logutils =
     .log_print_record = &darshan_log_print_pnetcdf_file,
     .log_print_description = &darshan_log_print_pnetcdf_file_description,
     .log_print_diff = &darshan_log_print_pnetcdf_file_diff,
-    .log_agg_records = &darshan_log_agg_pnetcdf_files
+    .log_agg_records = &darshan_log_agg_pnetcdf_files,
+    .log_sizeof_record = &darshan_log_sizeof_pnetcdf_file
 };
 
+static int darshan_log_sizeof_pnetcdf_file(void* pnetcdf_buf_p)
+{
+    /* PNETCDF_FILE records have a fixed size */
+    return(sizeof(struct darshan_pnetcdf_file));
+}
+
 struct darshan_mod_logutil_funcs pnetcdf_var_logutils =
 {
     .log_get_record = &darshan_log_get_pnetcdf_var,
@@ -79,9 +88,16 @@ struct darshan_mod_logutil_funcs pnetcdf_var_logutils =
     .log_print_record = &darshan_log_print_pnetcdf_var,
     .log_print_description = &darshan_log_print_pnetcdf_var_description,
     .log_print_diff = &darshan_log_print_pnetcdf_var_diff,
-    .log_agg_records = &darshan_log_agg_pnetcdf_vars
+    .log_agg_records = &darshan_log_agg_pnetcdf_vars,
+    .log_sizeof_record = &darshan_log_sizeof_pnetcdf_var
 };
 
+static int darshan_log_sizeof_pnetcdf_var(void* pnetcdf_buf_p)
+{
+    /* PNETCDF_VAR records have a fixed size */
+    return(sizeof(struct darshan_pnetcdf_var));
+}
+
 static int darshan_log_get_pnetcdf_file(darshan_fd fd, void** pnetcdf_buf_p)
 {
     struct darshan_pnetcdf_file *file = *((struct darshan_pnetcdf_file **)pnetcdf_buf_p);
@@ -98,9 +98,12 @@ static int darshan_log_record_metrics_posix_file(void*    posix_buf_p,
 
     *rank = psx_rec->base_rec.rank;
     /* nprocs is 1 per record, unless rank is negative, in which case we
-     * report -1 as the rank value to represent "all"
+     * report -1 as the rank value to represent "all". Records reduced over
+     * a subset of processes store the negated process count as their rank.
      */
-    if(psx_rec->base_rec.rank < 0)
+    if(psx_rec->base_rec.rank < -1)
+        *nprocs = -psx_rec->base_rec.rank;
+    else if(psx_rec->base_rec.rank < 0)
         *nprocs = -1;
     else
         *nprocs = 1;
@@ -525,7 +528,7 @@ static void darshan_log_agg_posix_files(void *rec, void *agg_rec, int init_flag)
      * records already have derived values, while unique file records do
      * not.  Handle both cases here so that this function can be generic.
      */
-    if(psx_rec->base_rec.rank == -1)
+    if(psx_rec->base_rec.rank < 0)
     {
         /* shared files should have pre-calculated fastest and slowest
          * counters */
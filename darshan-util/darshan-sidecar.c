@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+/* Creates summary sidecars (see darshan_log_summary_create()) for archived
+ * darshan logs, so that later job-level reports on those logs, e.g.
+ * darshan-parser --total/--perf/--file, do not need to read their records.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+#include "darshan-logutils.h"
+
+static void usage(char *exename)
+{
+    fprintf(stderr, "Usage: %s [options] <log> [<log> ...]\n", exename);
+    fprintf(stderr, "       Writes a summary sidecar (<log>%s) for each log, holding\n",
+        DARSHAN_SUMMARY_SUFFIX);
+    fprintf(stderr, "       the job data and per-module totals and derived metrics.\n");
+    fprintf(stderr, "       --force Recreate sidecars that are already up to date.\n");
+    fprintf(stderr, "       --output <path> Write the sidecar to <path> (single log only).\n");
+    fprintf(stderr, "       --help prints this help message and exits\n");
+    fprintf(stderr, "       --version prints Darshan version number and exits\n");
+
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    struct darshan_log_summary *summary;
+    char *output = NULL;
+    int force = 0;
+    int index;
+    int ret;
+    int nerr = 0;
+    int i;
+
+    static struct option long_opts[] =
+    {
+        {"force", 0, NULL, 'f'},
+        {"output", 1, NULL, 'o'},
+        {"version", 0, NULL, 'v'},
+        {"help", 0, NULL, 0},
+        { 0, 0, 0, 0 }
+    };
+
+    while(1)
+    {
+        int c = getopt_long(argc, argv, "", long_opts, &index);
+
+        if(c == -1) break;
+
+        switch(c)
+        {
+            case 'f':
+                force = 1;
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            case 'v':
+                printf("%s\n", PACKAGE_VERSION);
+                exit(0);
+            case 0:
+            case '?':
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    if(optind >= argc || (output && optind + 1 != argc))
+        usage(argv[0]);
+
+    for(i = optind; i < argc; i++)
+    {
+        if(!force)
+        {
+            /* skip logs whose sidecar still matches them */
+            ret = darshan_log_summary_read(argv[i], output, &summary);
+            if(ret == 0)
+            {
+                darshan_log_summary_free(summary);
+                continue;
+            }
+        }
+
+        ret = darshan_log_summary_create(argv[i], output);
+        if(ret < 0)
+        {
+            fprintf(stderr, "Error: failed to create summary for %s.\n", argv[i]);
+            nerr++;
+        }
+    }
+
+    return(nerr ? -1 : 0);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
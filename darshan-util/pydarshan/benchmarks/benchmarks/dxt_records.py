@@ -0,0 +1,27 @@
+import darshan.backend.cffi_backend as backend
+from darshan.log_utils import get_log_path
+
+
+class DXTRecordDecode:
+
+    params = [['structured', 'dict', 'pandas'],
+              ["dxt.darshan",
+               "sample-dxt-simple.darshan",
+              ],
+              ["DXT_POSIX",
+               "DXT_MPIIO",
+              ],
+              ]
+    param_names = ['dtype', 'darshan_logfile', 'mod']
+
+    def setup(self, dtype, darshan_logfile, mod):
+        self.logfile = get_log_path(darshan_logfile)
+
+    def time_log_get_dxt_record(self, dtype, darshan_logfile, mod):
+        # decode every DXT record of the module, which is dominated
+        # by segment conversion for traces with many segments
+        log = backend.log_open(self.logfile)
+        rec = backend.log_get_dxt_record(log, mod, dtype=dtype)
+        while rec is not None:
+            rec = backend.log_get_dxt_record(log, mod, dtype=dtype)
+        backend.log_close(log)
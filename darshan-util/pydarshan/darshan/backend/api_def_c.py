@@ -30,6 +30,7 @@ struct darshan_derived_metrics {
     double agg_perf_by_slowest;
     double agg_time_by_slowest;
     struct darshan_file_category_counters category_counters[7];
+    double part_shared_io_total_time_by_slowest;
 };
 
 struct darshan_mnt_info
@@ -76,12 +77,54 @@ struct darshan_job
     char metadata[1024];
 };
 
+/* from darshan-logutils.h, summary sidecar API */
+struct darshan_summary_module
+{
+    int64_t record_count;
+    struct darshan_derived_metrics metrics;
+    int agg_record_size;
+    void *agg_record;
+};
+
+struct darshan_log_summary
+{
+    char version[8];
+    int comp_type;
+    uint64_t partial_flag;
+    uint32_t mod_ver[64];
+    uint64_t mod_len[64];
+    struct darshan_job job;
+    char *exe;
+    struct darshan_summary_module *mods[64];
+};
+
 struct darshan_base_record
 {
     darshan_record_id id;
     int64_t rank;
 };
 
+/* from darshan-log-format.h, log chunk and record indexes */
+struct darshan_log_chunk
+{
+    int64_t region_id;
+    uint64_t off;
+    uint64_t len;
+    uint64_t uncomp_len;
+};
+
+struct darshan_log_rec_index
+{
+    int64_t region_id;
+    int64_t rank;
+    uint64_t off;
+    uint64_t len;
+    uint64_t uncomp_len;
+    darshan_record_id min_id;
+    darshan_record_id max_id;
+    uint64_t id_filter[4];
+};
+
 struct darshan_name_record
 {
     darshan_record_id id;
@@ -239,6 +282,18 @@ int darshan_log_get_exe(void*, char *);
 int darshan_log_get_mounts(void*, struct darshan_mnt_info **, int*);
 void darshan_log_get_modules(void*, struct darshan_mod_info **, int*);
 int darshan_log_get_record(void*, int, void **);
+int darshan_log_get_record_ref(void*, int, void **);
+int darshan_log_get_records(void*, int, void *, int, int *);
+int darshan_log_get_record_by_id(void*, int, darshan_record_id, void **);
+int darshan_log_get_chunk_index(void*, struct darshan_log_chunk **, int *);
+int darshan_log_get_record_index(void*, struct darshan_log_rec_index **, int *);
+int darshan_log_seek_rank(void*, int, int64_t);
+int darshan_log_set_threads(void*, int);
+int darshan_log_export_names(void*, int, const char*);
+int darshan_log_export_module(void*, int, int, const char*);
+int darshan_log_summary_create(const char *, const char *);
+int darshan_log_summary_read(const char *, const char *, struct darshan_log_summary **);
+void darshan_log_summary_free(struct darshan_log_summary *);
 char* darshan_log_get_lib_version(void);
 int darshan_log_get_job_runtime(void *, struct darshan_job job, double *runtime);
 void darshan_free(void *);
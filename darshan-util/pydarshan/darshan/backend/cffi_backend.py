@@ -76,6 +76,9 @@ _mod_names = [
 def mod_name_to_idx(mod_name):
     return _mod_names.index(mod_name)
 
+# derived metrics (cdata object) and summary record (dict) of a module
+AccumulatedRecords = namedtuple("AccumulatedRecords", ['derived_metrics', 'summary_record'])
+
 _structdefs = {
     "BG/Q": "struct darshan_bgq_record **",
     "DXT_MPIIO": "struct dxt_file_record **",
@@ -115,18 +118,21 @@ def get_lib_version():
     return version
 
 
-def log_open(filename):
+def log_open(filename, threads=1):
     """
     Opens a darshan logfile.
 
     Args:
         filename (str): Path to a darshan log file
+        threads (int): number of threads used to decompress log data
 
     Return:
         log handle
     """
     b_fname = filename.encode()
     handle = libdutil.darshan_log_open(b_fname)
+    if handle and threads > 1:
+        libdutil.darshan_log_set_threads(handle, threads)
     log = {"handle": handle, 'modules': None, 'name_records': None}
 
     return log
@@ -323,13 +329,15 @@ def log_lookup_name_records(log, ids=[]):
 
 
 
-def log_get_record(log, mod, dtype='numpy'):
+def log_get_record(log, mod, dtype='numpy', rec_id=None):
     """
     Standard entry point fetch records via mod string.
 
     Args:
         log: Handle returned by darshan.open
         mod_name (str): Name of the Darshan module
+        rec_id (int): Id of the record to fetch, rather than the next
+            record of the module. (Default: None)
 
     Return:
         log record of type dtype
@@ -337,19 +345,179 @@ def log_get_record(log, mod, dtype='numpy'):
     """
 
     if mod in ['LUSTRE']:
-        rec = _log_get_lustre_record(log, dtype=dtype)
+        rec = _log_get_lustre_record(log, dtype=dtype, rec_id=rec_id)
     elif mod in ['HEATMAP']:
-        rec = _log_get_heatmap_record(log)
+        rec = _log_get_heatmap_record(log, rec_id=rec_id)
     elif mod in ['DXT_POSIX', 'DXT_MPIIO']:
-        rec = log_get_dxt_record(log, mod, dtype=dtype)
+        rec = log_get_dxt_record(log, mod, dtype=dtype, rec_id=rec_id)
     else:
-        rec = log_get_generic_record(log, mod, dtype=dtype)
+        rec = log_get_generic_record(log, mod, dtype=dtype, rec_id=rec_id)
 
     return rec
 
 
+def log_get_record_by_id(log, mod, rec_id, dtype='numpy'):
+    """
+    Fetches a single record of a module by its record id. If the log has a
+    record index, only the data of processes that may hold the record is
+    decompressed, making this much cheaper than reading all records of a
+    module. The module's record traversal restarts afterwards.
+
+    Args:
+        log: Handle returned by darshan.open
+        mod (str): Name of the Darshan module
+        rec_id (int): Id of the record to fetch
+
+    Return:
+        log record of type dtype, or None if no such record exists
+
+    """
+    return log_get_record(log, mod, dtype=dtype, rec_id=rec_id)
+
+
+def log_seek_rank(log, mod, rank):
+    """
+    Positions a module's record traversal at the first record stored by the
+    given rank (or the next higher rank that stored any records). Requires
+    a log with a record index.
+
+    Args:
+        log: Handle returned by darshan.open
+        mod (str): Name of the Darshan module
+        rank (int): Rank to seek to
+
+    Return:
+        bool: True on success, False if the log has no record index
+        or the module has no records
+
+    """
+    modules = log_get_modules(log)
+    if mod not in modules:
+        return False
+    r = libdutil.darshan_log_seek_rank(log['handle'], modules[mod]['idx'], rank)
+    return r == 0
+
+
+_columnar_formats = {"arrow": 0, "parquet": 1}
 
-def log_get_generic_record(log, mod_name, dtype='numpy'):
+
+def log_get_chunk_index(log):
+    """
+    Returns the chunk index of a log, which lists the independently
+    compressed chunks of each log region. Logs with a chunk index can be
+    decompressed in parallel (see the threads argument of log_open).
+
+    Args:
+        log: Handle returned by darshan.open
+
+    Return:
+        list: one dict per chunk with 'region_id' (a module index, as in
+        log_get_modules), 'off', 'len' and 'uncomp_len' keys, sorted by
+        region and offset; empty if the log has no chunk index
+
+    """
+    chunks = ffi.new("struct darshan_log_chunk **")
+    cnt = ffi.new("int *")
+    r = libdutil.darshan_log_get_chunk_index(log['handle'], chunks, cnt)
+    if r < 0:
+        raise RuntimeError("failed to read the chunk index")
+
+    chunklst = []
+    for i in range(cnt[0]):
+        c = chunks[0][i]
+        chunklst.append({"region_id": c.region_id, "off": c.off,
+                         "len": c.len, "uncomp_len": c.uncomp_len})
+    if cnt[0] > 0:
+        libdutil.darshan_free(chunks[0])
+
+    return chunklst
+
+
+def log_get_record_index(log):
+    """
+    Returns the record index of a log, which lists where the data each
+    process stored for each module is located (see log_get_record_by_id
+    and log_seek_rank).
+
+    Args:
+        log: Handle returned by darshan.open
+
+    Return:
+        list: one dict per entry with 'region_id' (a module index, as in
+        log_get_modules), 'rank', 'off', 'len', 'uncomp_len', 'min_id' and
+        'max_id' keys, sorted by module and offset; empty if the log has no
+        record index
+
+    """
+    index = ffi.new("struct darshan_log_rec_index **")
+    cnt = ffi.new("int *")
+    r = libdutil.darshan_log_get_record_index(log['handle'], index, cnt)
+    if r < 0:
+        raise RuntimeError("failed to read the record index")
+
+    indexlst = []
+    for i in range(cnt[0]):
+        e = index[0][i]
+        indexlst.append({"region_id": e.region_id, "rank": e.rank,
+                         "off": e.off, "len": e.len,
+                         "uncomp_len": e.uncomp_len,
+                         "min_id": e.min_id, "max_id": e.max_id})
+    if cnt[0] > 0:
+        libdutil.darshan_free(index[0])
+
+    return indexlst
+
+
+def log_export_columnar(log, path, mod=None, fmt="arrow"):
+    """
+    Writes a module's records (or the log's name records if mod is None)
+    to path as an Arrow IPC or Parquet table. Arrow files can be loaded
+    without copying using pyarrow.ipc.open_file(pyarrow.memory_map(path)).
+    Must be called before any records of the module are read from log.
+
+    Args:
+        log: Handle returned by darshan.open
+        path (str): Output file path
+        mod (str): Name of the Darshan module, or None for name records
+        fmt (str): Either "arrow" or "parquet"
+
+    Return:
+        bool: True if the table was written, False if the module is not
+        in the log or has no columnar layout
+
+    """
+    if fmt not in _columnar_formats:
+        raise ValueError(f"unsupported columnar format: {fmt}")
+    if mod is None:
+        r = libdutil.darshan_log_export_names(log['handle'],
+                                              _columnar_formats[fmt],
+                                              path.encode())
+    else:
+        modules = log_get_modules(log)
+        if mod not in modules:
+            return False
+        r = libdutil.darshan_log_export_module(log['handle'],
+                                               modules[mod]['idx'],
+                                               _columnar_formats[fmt],
+                                               path.encode())
+    if r < 0:
+        raise RuntimeError(f"failed to export {mod or 'name'} records to {path}")
+    return r == 0
+
+
+def _log_read_record(log, mod_idx, buf, rec_id=None):
+    """
+    Reads the next record of a module into buf, or the record with the
+    given id if rec_id is set. Returns 1 if a record was read.
+    """
+    if rec_id is None:
+        return libdutil.darshan_log_get_record(log['handle'], mod_idx, buf)
+    return libdutil.darshan_log_get_record_by_id(log['handle'], mod_idx,
+                                                 rec_id, buf)
+
+
+
+def log_get_generic_record(log, mod_name, dtype='numpy', rec_id=None):
     """
     Returns a dictionary holding a generic darshan log record.
 
@@ -375,16 +543,103 @@ def log_get_generic_record(log, mod_name, dtype='numpy'):
     mod_type = _structdefs[mod_name]
 
     buf = ffi.new("void **")
-    r = libdutil.darshan_log_get_record(log['handle'], modules[mod_name]['idx'], buf)
+    if rec_id is None:
+        # the record is owned by the log handle (and read in place from
+        # uncompressed logs), so it is copied below but not freed
+        r = libdutil.darshan_log_get_record_ref(log['handle'],
+                                                modules[mod_name]['idx'], buf)
+    else:
+        r = _log_read_record(log, modules[mod_name]['idx'], buf, rec_id)
     if r < 1:
         return None
     rbuf = ffi.cast(mod_type, buf)
 
     rec = _make_generic_record(rbuf, mod_name, dtype)
-    libdutil.darshan_free(buf[0])
+    if rec_id is not None:
+        libdutil.darshan_free(buf[0])
 
     return rec
 
+def _generic_records_dtype(mod_name):
+    """
+    Returns a numpy structured dtype matching the layout of a module's
+    (fixed-size) record struct.
+    """
+    rec_type = _structdefs[mod_name].rstrip(" *")
+    names = ["id", "rank"]
+    formats = [np.uint64, np.int64]
+    offsets = [ffi.offsetof(rec_type, "base_rec") +
+               ffi.offsetof("struct darshan_base_record", f) for f in names]
+    if mod_name == 'H5D' or mod_name == 'PNETCDF_VAR':
+        names.append("file_rec_id")
+        formats.append(np.uint64)
+        offsets.append(ffi.offsetof(rec_type, "file_rec_id"))
+    names += ["counters", "fcounters"]
+    formats += [(np.int64, len(counter_names(mod_name))),
+                (np.float64, len(fcounter_names(mod_name)))]
+    offsets += [ffi.offsetof(rec_type, "counters"),
+                ffi.offsetof(rec_type, "fcounters")]
+    return np.dtype({"names": names, "formats": formats, "offsets": offsets,
+                     "itemsize": ffi.sizeof(rec_type)})
+
+
+def log_get_records(log, mod_name, dtype='numpy'):
+    """
+    Reads all remaining records of a module at once, without a Python call
+    per record. Only modules with fixed-size records (i.e., not DXT, LUSTRE
+    or HEATMAP) are supported.
+
+    Args:
+        log: Handle returned by darshan.open
+        mod_name (str): Name of the Darshan module
+        dtype (str): 'numpy' for arrays (default), 'pandas' for DataFrames
+
+    Return:
+        dict: 'id' and 'rank' arrays (and 'file_rec_id' for H5D and
+        PNETCDF_VAR) with one entry per record, and 2-D 'counters' and
+        'fcounters' arrays with one row per record. For 'pandas', the
+        counters and fcounters are DataFrames with id and rank columns.
+
+    Example:
+
+    >>> darshan.log_get_records(log, "POSIX")
+    {'id': array([...], dtype=uint64), 'rank': array([...]),
+     'counters': array([[...]]), 'fcounters': array([[...]])}
+
+    """
+    modules = log_get_modules(log)
+    if mod_name not in modules:
+        return None
+    rec_dtype = _generic_records_dtype(mod_name)
+
+    batches = []
+    nrecs = ffi.new("int *")
+    batch_size = 1024
+    while True:
+        batch = np.empty(batch_size, dtype=rec_dtype)
+        r = libdutil.darshan_log_get_records(log['handle'],
+                                             modules[mod_name]['idx'],
+                                             ffi.from_buffer(batch),
+                                             batch_size, nrecs)
+        if r < 0:
+            raise RuntimeError(f"failed to read {mod_name} records")
+        batches.append(batch[:nrecs[0]])
+        if nrecs[0] < batch_size:
+            break
+        batch_size = min(batch_size * 2, 1 << 20)
+    recs = np.concatenate(batches)
+
+    rec = {name: recs[name] for name in rec_dtype.names}
+    if dtype == "pandas":
+        for ct_key, cols in [("counters", counter_names(mod_name)),
+                             ("fcounters", fcounter_names(mod_name))]:
+            df = pd.DataFrame(rec[ct_key], columns=cols)
+            df.insert(0, "rank", rec["rank"])
+            df.insert(0, "id", rec["id"])
+            rec[ct_key] = df
+    return rec
+
+
 def _make_generic_record(rbuf, mod_name, dtype='numpy'):
     """
     Returns a record dictionary for an input record buffer for a given module.
@@ -491,7 +746,7 @@ def fcounter_names(mod_name):
     return counter_names(mod_name, fcnts=True)
 
 
-def _log_get_lustre_record(log, dtype='numpy'):
+def _log_get_lustre_record(log, dtype='numpy', rec_id=None):
     """
     Returns a darshan log record for Lustre.
 
@@ -504,7 +759,7 @@ def _log_get_lustre_record(log, dtype='numpy'):
 
     rec = {}
     buf = ffi.new("void **")
-    r = libdutil.darshan_log_get_record(log['handle'], modules['LUSTRE']['idx'], buf)
+    r = _log_read_record(log, modules['LUSTRE']['idx'], buf, rec_id)
     if r < 1:
         return None
     rbuf = ffi.cast("struct darshan_lustre_record **", buf)
@@ -566,24 +821,46 @@ def _log_get_lustre_record(log, dtype='numpy'):
 
 
 
-def log_get_dxt_record(log, mod_name, reads=True, writes=True, dtype='dict'):
+def _dxt_segment_dtype():
+    """
+    Returns a numpy structured dtype matching the layout of
+    struct segment_info, so DXT segments can be viewed without copying.
+    """
+    fields = {"offset": "<i8", "length": "<i8", "start_time": "<f8",
+              "end_time": "<f8", "pthread_id": "<u8"}
+    return np.dtype({
+        "names": list(fields),
+        "formats": list(fields.values()),
+        "offsets": [ffi.offsetof("struct segment_info", f) for f in fields],
+        "itemsize": ffi.sizeof("struct segment_info"),
+    })
+
+
+_dxt_seg_dtype = _dxt_segment_dtype()
+
+
+def log_get_dxt_record(log, mod_name, reads=True, writes=True, dtype='dict',
+                       rec_id=None):
     """
     Returns a dictionary holding a dxt darshan log record.
 
     Args:
         log: Handle returned by darshan.open
         mod_name (str): Name of the Darshan module
-        mod_type (str): String containing the C type
+        dtype (str): 'numpy' or 'dict' for lists of dictionaries (default),
+            'pandas' for DataFrames, 'structured' for numpy structured arrays
+        rec_id (int): Id of the record to read, or None for the next one
 
     Return:
         dict: generic log record
 
     Example:
 
-    The typical darshan log record provides two arrays, on for integer counters
-    and one for floating point counters:
+    The typical DXT record provides arrays of write and read segments,
+    each with offset, length, start_time and end_time fields (and
+    pthread_id for newer logs):
 
-    >>> darshan.log_get_dxt_record(log, "DXT_POSIX", "struct dxt_file_record **")
+    >>> darshan.log_get_dxt_record(log, "DXT_POSIX")
     {'rank': 0, 'read_count': 11, 'read_segments': array([...]), ...}
 
 
@@ -613,7 +890,7 @@ def log_get_dxt_record(log, mod_name, reads=True, writes=True, dtype='dict'):
 
     rec = {}
     buf = ffi.new("void **")
-    r = libdutil.darshan_log_get_record(log['handle'], modules[mod_name]['idx'], buf)
+    r = _log_read_record(log, modules[mod_name]['idx'], buf, rec_id)
     if r < 1:
         return None
     filerec = ffi.cast(mod_type, buf)
@@ -628,53 +905,40 @@ def log_get_dxt_record(log, mod_name, reads=True, writes=True, dtype='dict'):
 
     rec['write_count'] = wcnt
     rec['read_count'] = rcnt
- 
-    rec['write_segments'] = []
-    rec['read_segments'] = []
-
 
+    # the segments trail the file record in the same buffer, write
+    # segments first; copy them out as one structured array so that the
+    # record buffer can be freed right away
     size_of = ffi.sizeof("struct dxt_file_record")
-    segments = ffi.cast("struct segment_info *", buf[0] + size_of  )
-
-    for i in range(wcnt):
-        seg = {
-            "offset": segments[i].offset,
-            "length": segments[i].length,
-            "start_time": segments[i].start_time,
-            "end_time": segments[i].end_time
-        }
-
-        if append_pthread_id:
-            # append field of pthread_id
-            seg["pthread_id"] = segments[i].pthread_id
-
-        rec['write_segments'].append(seg)
-
-    for i in range(rcnt):
-        i = i + wcnt
-
-        seg = {
-            "offset": segments[i].offset,
-            "length": segments[i].length,
-            "start_time": segments[i].start_time,
-            "end_time": segments[i].end_time
-        }
+    segments = np.frombuffer(
+            ffi.buffer(buf[0], size_of + (wcnt + rcnt) * _dxt_seg_dtype.itemsize),
+            dtype=_dxt_seg_dtype, count=wcnt + rcnt, offset=size_of).copy()
+    libdutil.darshan_free(buf[0])
+    if not append_pthread_id:
+        segments = segments[["offset", "length", "start_time", "end_time"]]
 
-        if append_pthread_id:
-            # append field of pthread_id
-            seg["pthread_id"] = segments[i].pthread_id
+    if dtype == "structured":
+        rec['write_segments'] = segments[:wcnt]
+        rec['read_segments'] = segments[wcnt:]
+    elif dtype == "pandas":
+        rec['write_segments'] = pd.DataFrame(segments[:wcnt])
+        rec['read_segments'] = pd.DataFrame(segments[wcnt:])
+    else:
+        rec['write_segments'] = _dxt_segments_to_dicts(segments[:wcnt])
+        rec['read_segments'] = _dxt_segments_to_dicts(segments[wcnt:])
 
-        rec['read_segments'].append(seg)
+    return rec
 
-    if dtype == "pandas":
-        rec['read_segments'] = pd.DataFrame(rec['read_segments'])
-        rec['write_segments'] = pd.DataFrame(rec['write_segments'])
 
-    libdutil.darshan_free(buf[0])
-    return rec
+def _dxt_segments_to_dicts(segments):
+    """
+    Converts a structured array of DXT segments to a list of dictionaries.
+    """
+    names = segments.dtype.names
+    return [dict(zip(names, seg)) for seg in segments.tolist()]
 
 
-def _log_get_heatmap_record(log):
+def _log_get_heatmap_record(log, rec_id=None):
     """
     Returns a dictionary holding a heatmap darshan log record.
 
@@ -695,7 +959,7 @@ def _log_get_heatmap_record(log):
 
     rec = {}
     buf = ffi.new("void **")
-    r = libdutil.darshan_log_get_record(log['handle'], modules[mod_name]['idx'], buf)
+    r = _log_read_record(log, modules[mod_name]['idx'], buf, rec_id)
     if r < 1:
         return None
     
@@ -848,6 +1112,61 @@ def accumulate_records(rec_dict, mod_name, nprocs):
 
     summary_rec = _make_generic_record(summary_rbuf, mod_name, dtype='pandas')
 
-    # create namedtuple type to hold return values
-    AccumulatedRecords = namedtuple("AccumulatedRecords", ['derived_metrics', 'summary_record'])
     return AccumulatedRecords(derived_metrics, summary_rec)
+
+
+def log_create_summary(filename, summary_path=None):
+    """
+    Creates a summary sidecar for a log, holding its job data and the
+    accumulated records and derived metrics of each module that supports
+    the accumulator interface.
+
+    Parameters:
+        filename: Path to the Darshan log.
+        summary_path: Path of the sidecar (default: filename + ".summary").
+    """
+    spath = summary_path.encode() if summary_path else ffi.NULL
+    r = libdutil.darshan_log_summary_create(filename.encode(), spath)
+    if r != 0:
+        raise RuntimeError("A nonzero exit code was received from "
+                           "darshan_log_summary_create() at the C level. "
+                           "It may be possible "
+                           "to retrieve additional information from the stderr "
+                           "stream.")
+
+
+def log_get_summary(filename, summary_path=None):
+    """
+    Reads the summary sidecar of a log, without opening the log itself.
+
+    Parameters:
+        filename: Path to the Darshan log.
+        summary_path: Path of the sidecar (default: filename + ".summary").
+
+    Returns:
+        None if the log has no sidecar or it is out of date, otherwise a
+        dictionary mapping module names to the same namedtuple returned
+        by accumulate_records().
+    """
+    spath = summary_path.encode() if summary_path else ffi.NULL
+    summary = ffi.new("struct darshan_log_summary **")
+    r = libdutil.darshan_log_summary_read(filename.encode(), spath, summary)
+    if r < 0:
+        raise RuntimeError("A nonzero exit code was received from "
+                           "darshan_log_summary_read() at the C level.")
+    if r > 0:
+        return None
+
+    mods = {}
+    for mod_idx, mod_name in enumerate(_mod_names):
+        mod_sum = summary[0].mods[mod_idx]
+        if mod_sum == ffi.NULL:
+            continue
+        derived_metrics = ffi.new("struct darshan_derived_metrics *", mod_sum.metrics)
+        summary_rbuf = ffi.cast(_structdefs[mod_name].replace("**", "*"),
+                                mod_sum.agg_record)
+        summary_rec = _make_generic_record(summary_rbuf, mod_name, dtype='pandas')
+        mods[mod_name] = AccumulatedRecords(derived_metrics, summary_rec)
+    libdutil.darshan_log_summary_free(summary[0])
+
+    return mods
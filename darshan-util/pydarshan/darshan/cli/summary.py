@@ -14,7 +14,7 @@ from mako.template import Template
 
 import darshan
 import darshan.cli
-from darshan.backend.cffi_backend import accumulate_records
+from darshan.backend.cffi_backend import accumulate_records, log_get_summary
 from darshan.lib.accum import log_file_count_summary_table, log_module_overview_table
 from darshan.experimental.plots import (
     plot_dxt_heatmap,
@@ -155,6 +155,11 @@ class ReportData:
         # if DXT heatmaps requested, additionally read-in DXT data
         if self.enable_dxt_heatmap:
             self.report.read_all_dxt_records(filter_patterns=filter_patterns, filter_mode=filter_mode)
+        # use the log's summary sidecar, if it has one, for module totals
+        # and derived metrics; these cover all records, so not when filtering
+        self.accumulated = {}
+        if not filter_patterns:
+            self.accumulated = log_get_summary(log_path) or {}
         # create the header/footer
         self.get_header()
         self.get_footer()
@@ -516,11 +521,13 @@ class ReportData:
 
             try:
                 if mod in ["POSIX", "MPI-IO", "STDIO", "DFS", "DAOS"]:
-                    # get the module's record dataframe and then pass to
-                    # Darshan accumulator interface to generate a cumulative
-                    # record and derived metrics
-                    rec_dict = self.report.records[mod].to_df()
-                    acc = accumulate_records(rec_dict, mod, self.report.metadata['job']['nprocs'])
+                    # unless the sidecar has them, get the module's record
+                    # dataframe and then pass to Darshan accumulator interface
+                    # to generate a cumulative record and derived metrics
+                    acc = self.accumulated.get(mod)
+                    if acc is None:
+                        rec_dict = self.report.records[mod].to_df()
+                        acc = accumulate_records(rec_dict, mod, self.report.metadata['job']['nprocs'])
 
                     mod_overview_fig = ReportFigure(
                             section_title=sect_title,
@@ -414,3 +414,61 @@ def get_heatmap_df(agg_df: pd.DataFrame,
     hmap_df = cats.groupby("rank").sum()
     hmap_df = hmap_df.reindex(index=range(nprocs), fill_value=0.0)
     return hmap_df
+
+
+def get_file_heatmap_df(
+    report: Any,
+    mod: str = "POSIX",
+    ops: Sequence[str] = ["read", "write"],
+    top_n: Optional[int] = None,
+) -> pd.DataFrame:
+    """
+    Builds a dataframe of the per-file heatmaps recorded by the runtime
+    heatmap module (see the ``HEATMAP_PER_FILE`` runtime setting), with one
+    row per file, summed over all ranks that accessed it.
+
+    Parameters
+    ----------
+
+    report: a ``darshan.DarshanReport`` with heatmap records read.
+
+    mod: the module to get per-file heatmaps for (i.e. "POSIX",
+    "MPIIO", or "STDIO"). Default is ``"POSIX"``.
+
+    ops: a sequence of keys designating which Darshan operations to use for
+    data aggregation. Default is ``["read", "write"]``.
+
+    top_n: if given, only return the ``top_n`` files with the largest peak
+    bins.
+
+    Returns
+    -------
+
+    file_hmap_df: dataframe with time intervals for columns and file path
+    index for rows, where each element contains the data read/written to
+    the corresponding file in the given time interval. Rows are sorted by
+    their peak bin, in descending order, so that the files responsible for
+    the largest bandwidth spikes come first.
+
+    Raises
+    ------
+
+    ValueError: raised if the report has no per-file heatmaps for the
+    selected module.
+
+    """
+    file_heatmaps = report.file_heatmaps.get(mod)
+    if not file_heatmaps:
+        raise ValueError(f"No per-file heatmaps available for module {mod}.")
+
+    rows = {}
+    for path, heatmap in file_heatmaps.items():
+        rows[path] = heatmap.to_df(ops=ops).sum(axis=0)
+    file_hmap_df = pd.DataFrame.from_dict(rows, orient="index")
+    file_hmap_df.index.name = "file"
+
+    peaks = file_hmap_df.max(axis=1).sort_values(ascending=False, kind="stable")
+    file_hmap_df = file_hmap_df.loc[peaks.index]
+    if top_n is not None:
+        file_hmap_df = file_hmap_df.iloc[:top_n]
+    return file_hmap_df
@@ -310,7 +310,8 @@ class DarshanReport(object):
             start_time=None, end_time=None,
             automatic_summary=False,
             read_all=True,
-            filter_patterns=None, filter_mode="exclude"):
+            filter_patterns=None, filter_mode="exclude",
+            threads=1):
         """
         Args:
             filename (str): filename to open (optional)
@@ -319,6 +320,7 @@ class DarshanReport(object):
             read_all (bool): whether to read all records for log
             filter_patterns (list of strings): list of Python regex strings to match against
             filter_mode (str): filter mode to use (either "exclude" or "include")
+            threads (int): number of threads used to decompress log data
 
         Return:
             None
@@ -350,6 +352,7 @@ class DarshanReport(object):
         self._mounts = {}
         self.name_records = {}
         self._heatmaps = {}
+        self._file_heatmaps = {}
 
         # initialize report/summary namespace
         self.summary_revision = 0       # counter to check if summary needs update (see data_revision)
@@ -372,7 +375,8 @@ class DarshanReport(object):
         self.provenance_reports = {}
 
         if filename:
-            self.open(filename, read_all=read_all, filter_patterns=filter_patterns, filter_mode=filter_mode)
+            self.open(filename, read_all=read_all, filter_patterns=filter_patterns,
+                      filter_mode=filter_mode, threads=threads)
 
 
     @property
@@ -391,6 +395,10 @@ class DarshanReport(object):
     def heatmaps(self):
         return self._heatmaps
 
+    @property
+    def file_heatmaps(self):
+        return self._file_heatmaps
+
 #    @property
 #    def counters(self):
 #        return self._counters
@@ -406,7 +414,8 @@ class DarshanReport(object):
 #   
       
 
-    def open(self, filename, read_all=False, filter_patterns=None, filter_mode="exclude"):
+    def open(self, filename, read_all=False, filter_patterns=None, filter_mode="exclude",
+             threads=1):
         """
         Open log file via CFFI backend.
 
@@ -415,6 +424,7 @@ class DarshanReport(object):
             read_all (bool): whether to read all records for log
             filter_patterns (list of strings): list of Python regex strings to match against
             filter_mode (str): filter mode to use (either "exclude" or "include")
+            threads (int): number of threads used to decompress log data
 
         Return:
             None
@@ -424,7 +434,7 @@ class DarshanReport(object):
         self.filename = filename
 
         if filename:
-            self.log = backend.log_open(self.filename)
+            self.log = backend.log_open(self.filename, threads=threads)
             if not bool(self.log['handle']):
                 raise RuntimeError("Failed to open file.")
 
@@ -592,7 +602,10 @@ class DarshanReport(object):
 
         .. note::
             As the module is encoded in a name_record, all heatmap data is read
-            and then exposed through the report.heatmaps property.
+            and then exposed through the report.heatmaps property. Per-file
+            heatmaps (named "heatmap:<module>:<path>", see the HEATMAP_PER_FILE
+            runtime setting) are exposed through the report.file_heatmaps
+            property, keyed by module and then by file path.
 
         Args:
             None
@@ -612,28 +625,46 @@ class DarshanReport(object):
             4131494093108637317: "heatmap:DAOS"
         }
 
+        file_nrecs = None
+
         def heatmap_rec_to_module_name(rec, nrecs=None):
+            nonlocal file_nrecs
             if rec['id'] in nrecs:
                 name = nrecs[rec['id']]
                 mod = name.split(":")[1]
-            else:
-                mod = rec['id']
-            return mod
+                return mod, None
+            # per-file heatmaps have ids generated from the file path, so
+            # resolve them through the (unfiltered) name records
+            if file_nrecs is None:
+                file_nrecs = backend.log_get_name_records(self.log)
+            name = file_nrecs.get(rec['id'], "")
+            fields = name.split(":", 2)
+            if len(fields) == 3 and fields[0] == "heatmap":
+                return fields[1], fields[2]
+            return rec['id'], None
 
         heatmaps = {}
+        file_heatmaps = {}
 
         # fetch records
         rec = backend._log_get_heatmap_record(self.log)
         while rec is not None:            
-            mod = heatmap_rec_to_module_name(rec, nrecs=_nrecs_heatmap)
-            if mod not in heatmaps:
-                heatmaps[mod] = Heatmap(mod)
-            heatmaps[mod].add_record(rec)
+            mod, path = heatmap_rec_to_module_name(rec, nrecs=_nrecs_heatmap)
+            if path is None:
+                if mod not in heatmaps:
+                    heatmaps[mod] = Heatmap(mod)
+                heatmaps[mod].add_record(rec)
+            else:
+                mod_heatmaps = file_heatmaps.setdefault(mod, {})
+                if path not in mod_heatmaps:
+                    mod_heatmaps[path] = Heatmap(mod)
+                mod_heatmaps[path].add_record(rec)
 
             # fetch next
             rec = backend._log_get_heatmap_record(self.log)
 
         self._heatmaps = heatmaps
+        self._file_heatmaps = file_heatmaps
 
 
     def mod_read_all_records(self, mod, dtype=None, warnings=True,
@@ -979,6 +1010,35 @@ class DarshanReport(object):
             rec = backend.log_get_generic_record(self.log, mod, dtype=dtype)
 
 
+    def get_record(self, mod, rec, dtype='numpy'):
+        """
+        Fetch a single record of a module without reading the module's
+        other records. For logs written with a record index (see
+        DARSHAN_RECORD_INDEX), only the data of processes that may hold
+        the record is decompressed, keeping per-file drill-down of large
+        logs interactive.
+
+        Args:
+            mod (str): Identifier of module to fetch the record from
+            rec (int or str): Record id, or record name (e.g., a file path)
+            dtype (str): 'numpy' for ndarray (default), 'dict' for python dictionary
+
+        Return:
+            The record, or None if the module has no such record.
+
+        """
+        if isinstance(rec, str):
+            if not self.name_records_read:
+                self.read_name_records()
+            rec_ids = [rec_id for rec_id, name in self.name_records.items()
+                       if name == rec]
+            if not rec_ids:
+                return None
+            rec = rec_ids[0]
+
+        return backend.log_get_record_by_id(self.log, mod, rec, dtype=dtype)
+
+
     def info(self, metadata=False):
         """
         Print information about the record for inspection.
@@ -2,10 +2,13 @@
 # that are not specific to any particular
 # mod
 
+import os
 import re
+import shutil
 
 import pytest
 import numpy as np
+import pandas as pd
 from numpy.testing import assert_array_equal, assert_allclose
 import darshan
 import darshan.backend.cffi_backend as backend
@@ -272,3 +275,284 @@ def test_reverse_record_array(python_filter, expected_counts):
                         actual_wo_files,
                         actual_rw_files],
                         expected_counts)
+
+
+def _read_one_at_a_time(log_path, mod, dtype="dict", threads=1):
+    # reference for the other ways of reading records: every record of a
+    # module, read with log_get_record() in log order
+    log = backend.log_open(log_path, threads=threads)
+    recs = []
+    rec = backend.log_get_record(log, mod, dtype=dtype)
+    while rec is not None:
+        recs.append(rec)
+        rec = backend.log_get_record(log, mod, dtype=dtype)
+    backend.log_close(log)
+    assert len(recs) > 0
+    return recs
+
+
+def _assert_records_match(actual, expected):
+    assert len(actual) == len(expected)
+    for act_rec, exp_rec in zip(actual, expected):
+        assert act_rec.keys() == exp_rec.keys()
+        for key, exp_val in exp_rec.items():
+            if isinstance(exp_val, np.ndarray):
+                assert_array_equal(act_rec[key], exp_val)
+            else:
+                assert act_rec[key] == exp_val
+
+
+@pytest.mark.parametrize("log_name, mod", [
+    ("shane_macsio_id29959_5-22-32552-7035573431850780836_1590156158.darshan", "POSIX"),
+    ("shane_macsio_id29959_5-22-32552-7035573431850780836_1590156158.darshan", "MPI-IO"),
+    ("dxt.darshan", "DXT_POSIX"),
+    # 3.42 log written with DARSHAN_RECORD_INDEX=1 by 4 ranks
+    ("record-index-chunked.darshan", "POSIX"),
+    ("record-index-chunked.darshan", "MPI-IO"),
+    ("record-index-chunked.darshan", "STDIO"),
+])
+def test_log_get_record_by_id(log_name, mod):
+    # records fetched by id must match those read in order, also for
+    # logs without a record index (the whole module is searched)
+    log_path = get_log_path(log_name)
+    expected = _read_one_at_a_time(log_path, mod)
+
+    log = backend.log_open(log_path)
+    mod_idx = backend.log_get_modules(log)[mod]["idx"]
+    index = [entry for entry in backend.log_get_record_index(log)
+             if entry["region_id"] == mod_idx]
+    actual = [backend.log_get_record_by_id(log, mod, exp_rec["id"], dtype="dict")
+              for exp_rec in expected[::-1]]
+    _assert_records_match(actual[::-1], expected)
+
+    assert backend.log_get_record_by_id(log, mod, 12345) is None
+    # traversal restarts from the first record afterwards
+    assert backend.log_get_record(log, mod, dtype="dict")["id"] == expected[0]["id"]
+
+    if log_name.startswith("record-index"):
+        # every record is stored by a rank whose index entry covers its id
+        # (shared records are stored by rank 0)
+        for exp_rec in expected:
+            rank = max(exp_rec["rank"], 0)
+            assert any(entry["rank"] == rank and
+                       entry["min_id"] <= exp_rec["id"] <= entry["max_id"]
+                       for entry in index)
+        # seeking by rank starts at the first record that rank stored
+        last_rank = index[-1]["rank"]
+        assert backend.log_seek_rank(log, mod, last_rank)
+        first = [max(rec["rank"], 0) for rec in expected].index(last_rank)
+        actual = []
+        rec = backend.log_get_record(log, mod, dtype="dict")
+        while rec is not None:
+            actual.append(rec)
+            rec = backend.log_get_record(log, mod, dtype="dict")
+        _assert_records_match(actual, expected[first:])
+    else:
+        # seeking by rank requires a record index
+        assert index == []
+        assert not backend.log_seek_rank(log, mod, 0)
+    backend.log_close(log)
+
+    with darshan.DarshanReport(log_path, read_all=False) as report:
+        report.read_name_records()
+        name = report.name_records[expected[-1]["id"]]
+        rec = report.get_record(mod, name, dtype="dict")
+        assert rec["id"] == expected[-1]["id"]
+        assert report.get_record(mod, "/no/such/file") is None
+
+
+@pytest.mark.parametrize("log_name", [
+    "shane_macsio_id29959_5-22-32552-7035573431850780836_1590156158.darshan",
+    "dxt.darshan",
+    # 3.42 log written with DARSHAN_COMP_THREADS=2 by 4 ranks
+    "record-index-chunked.darshan",
+])
+def test_log_open_threads(log_name):
+    # records read with multiple decompression threads must match those
+    # read sequentially
+    log_path = get_log_path(log_name)
+    log = backend.log_open(log_path)
+    modules = backend.log_get_modules(log)
+    chunks = backend.log_get_chunk_index(log)
+    backend.log_close(log)
+
+    for mod, mod_info in modules.items():
+        _assert_records_match(_read_one_at_a_time(log_path, mod, threads=4),
+                              _read_one_at_a_time(log_path, mod))
+        if log_name.startswith("record-index"):
+            # the module's data is split into chunks that together cover
+            # it, one per rank that stored any (MPI-IO only has the shared
+            # file, stored by rank 0), so it is decompressed in parallel
+            mod_chunks = [c for c in chunks if c["region_id"] == mod_info["idx"]]
+            assert len(mod_chunks) == (1 if mod == "MPI-IO" else 4)
+            assert sum(c["len"] for c in mod_chunks) == mod_info["len"]
+        else:
+            assert chunks == []
+
+    with darshan.DarshanReport(log_path) as report:
+        with darshan.DarshanReport(log_path, threads=4) as report_threads:
+            assert report.name_records == report_threads.name_records
+
+
+@pytest.mark.parametrize("fmt", ["arrow", "parquet"])
+def test_log_export_columnar(tmp_path, fmt):
+    # exported tables must hold the same values as the records read
+    # through the CFFI backend
+    pa = pytest.importorskip("pyarrow")
+    import pyarrow.ipc
+    import pyarrow.parquet
+
+    def read_table(path):
+        if fmt == "arrow":
+            return pyarrow.ipc.open_file(pa.memory_map(str(path))).read_all()
+        return pyarrow.parquet.read_table(str(path))
+
+    log_path = get_log_path("sample-dxt-simple.darshan")
+    log = backend.log_open(log_path)
+    names_path = tmp_path / f"names.{fmt}"
+    posix_path = tmp_path / f"posix.{fmt}"
+    dxt_path = tmp_path / f"dxt.{fmt}"
+    assert backend.log_export_columnar(log, str(names_path), fmt=fmt)
+    assert backend.log_export_columnar(log, str(posix_path), "POSIX", fmt)
+    assert backend.log_export_columnar(log, str(dxt_path), "DXT_POSIX", fmt)
+    assert not backend.log_export_columnar(log, str(tmp_path / "x"), "LUSTRE", fmt)
+    backend.log_close(log)
+
+    log = backend.log_open(log_path)
+    names = read_table(names_path).to_pydict()
+    assert dict(zip(names["id"], names["name"])) == \
+        backend.log_get_name_records(log)
+    backend.log_close(log)
+
+    # one column per counter, one row per record
+    posix = read_table(posix_path)
+    assert posix.column_names == ["id", "rank"] + \
+        backend.counter_names("POSIX") + backend.fcounter_names("POSIX")
+    actual = []
+    for row in posix.to_pylist():
+        actual.append({"id": row["id"], "rank": row["rank"],
+            "counters": {name: row[name]
+                         for name in backend.counter_names("POSIX")},
+            "fcounters": {name: row[name]
+                          for name in backend.fcounter_names("POSIX")}})
+    _assert_records_match(actual, _read_one_at_a_time(log_path, "POSIX"))
+
+    # one row per DXT segment, with the record's id, rank and hostname
+    expected = _read_one_at_a_time(log_path, "DXT_POSIX")
+    dxt = read_table(dxt_path).to_pylist()
+    assert {row["operation"] for row in dxt} <= {"read", "write"}
+    actual = []
+    for row in dxt:
+        if not actual or (row["id"], row["rank"]) != \
+                (actual[-1]["id"], actual[-1]["rank"]):
+            actual.append({"id": row["id"], "rank": row["rank"],
+                           "hostname": row["hostname"],
+                           "write_count": 0, "read_count": 0,
+                           "write_segments": [], "read_segments": []})
+        op = row["operation"]
+        actual[-1][f"{op}_count"] += 1
+        actual[-1][f"{op}_segments"].append(
+            {key: row[key]
+             for key in ["offset", "length", "start_time", "end_time"]})
+    # records without any segments have no rows
+    _assert_records_match(actual, [rec for rec in expected
+                                   if rec["write_count"] + rec["read_count"]])
+
+
+@pytest.mark.parametrize("log_name, mod", [
+    ("sample-dxt-simple.darshan", "POSIX"),
+    ("sample-dxt-simple.darshan", "MPI-IO"),
+    ("ior_hdf5_example.darshan", "STDIO"),
+    ("shane_macsio_id29959_5-22-32552-7035573431850780836_1590156158.darshan", "H5D"),
+    ("shane_macsio_id29959_5-22-32552-7035573431850780836_1590156158.darshan", "H5F"),
+    # older module versions are upconverted record by record
+    ("ior_hdf5_example.darshan", "H5D"),
+    ("example.darshan", "POSIX"),
+    ("sample-badost.darshan", "STDIO"),
+])
+@pytest.mark.parametrize("dtype", ["numpy", "pandas"])
+def test_log_get_records(log_name, mod, dtype):
+    # records read as a batch must match those read one at a time
+    log_path = get_log_path(log_name)
+    expected = _read_one_at_a_time(log_path, mod, dtype="numpy")
+
+    # a batch holds the records not read yet
+    log = backend.log_open(log_path)
+    assert backend.log_get_record(log, mod)["id"] == expected[0]["id"]
+    recs = backend.log_get_records(log, mod, dtype=dtype)
+    assert len(recs["id"]) == len(expected) - 1
+    backend.log_close(log)
+
+    log = backend.log_open(log_path)
+    recs = backend.log_get_records(log, mod, dtype=dtype)
+    backend.log_close(log)
+
+    # with one row of counters per record
+    if dtype == "pandas":
+        assert_array_equal(recs["counters"]["id"], recs["id"])
+        assert_array_equal(recs["fcounters"]["rank"], recs["rank"])
+        assert list(recs["counters"].columns[2:]) == backend.counter_names(mod)
+        recs["counters"] = recs["counters"].iloc[:, 2:].to_numpy()
+        recs["fcounters"] = recs["fcounters"].iloc[:, 2:].to_numpy()
+    assert recs["counters"].shape == \
+        (len(expected), len(backend.counter_names(mod)))
+    actual = [{key: recs[key][i] for key in expected[0]}
+              for i in range(len(recs["id"]))]
+    _assert_records_match(actual, expected)
+
+
+@pytest.mark.parametrize("log_name", [
+    "sample-dxt-simple.darshan",
+    "ior_hdf5_example.darshan",
+    "record-index-chunked.darshan",
+    # older module versions
+    "example.darshan",
+])
+def test_log_summary_sidecar(tmp_path, log_name):
+    # a sidecar must hold the same totals and derived metrics as
+    # accumulating the log's records, and only while the log is unchanged
+    log_path = str(tmp_path / log_name)
+    shutil.copy(get_log_path(log_name), log_path)
+    assert backend.log_get_summary(log_path) is None
+
+    # sidecars are looked up next to the log unless a path is given
+    other_path = str(tmp_path / "other.summary")
+    backend.log_create_summary(log_path, other_path)
+    assert backend.log_get_summary(log_path) is None
+    assert backend.log_get_summary(log_path, other_path) is not None
+    backend.log_create_summary(log_path)
+    assert os.path.exists(log_path + ".summary")
+    summary = backend.log_get_summary(log_path)
+    assert summary is not None
+
+    log = backend.log_open(log_path)
+    nprocs = backend.log_get_job(log)["nprocs"]
+    expected_mods = [mod for mod in backend.log_get_modules(log)
+                     if mod in ["POSIX", "MPI-IO", "STDIO", "DFS", "DAOS"]]
+    backend.log_close(log)
+    assert len(expected_mods) > 0
+    assert sorted(summary) == sorted(expected_mods)
+    for mod in expected_mods:
+        recs = _read_one_at_a_time(log_path, mod, dtype="pandas")
+        rec_dict = {ct_key: pd.concat([rec[ct_key] for rec in recs],
+                                      ignore_index=True)
+                    for ct_key in ["counters", "fcounters"]}
+        expected = backend.accumulate_records(rec_dict, mod, nprocs)
+        actual = summary[mod]
+        assert ffi.buffer(actual.derived_metrics)[:] == \
+            ffi.buffer(expected.derived_metrics)[:]
+        for ct_key in ["counters", "fcounters"]:
+            assert_array_equal(actual.summary_record[ct_key],
+                               expected.summary_record[ct_key])
+
+    # modifying the log invalidates its sidecar
+    st = os.stat(log_path)
+    os.utime(log_path, (st.st_atime, st.st_mtime + 10))
+    assert backend.log_get_summary(log_path) is None
+
+    # including changes within the same second
+    backend.log_create_summary(log_path)
+    assert backend.log_get_summary(log_path) is not None
+    st = os.stat(log_path)
+    os.utime(log_path, ns=(st.st_atime_ns, st.st_mtime_ns + 1000))
+    assert backend.log_get_summary(log_path) is None
@@ -4,6 +4,7 @@ from numpy.testing import assert_array_equal, assert_allclose
 import pandas as pd
 
 import darshan
+from darshan.datatypes.heatmap import Heatmap
 from darshan.experimental.plots import heatmap_handling
 from darshan.log_utils import get_log_path
 
@@ -602,3 +603,59 @@ def test_get_heatmap_df(
             assert actual_hmap_data.values.sum() == 4202504
         elif ops[0] == "write":
             assert actual_hmap_data.values.sum() == 4195800
+
+
+@pytest.fixture(scope="function")
+def file_heatmap_report():
+    # mock report holding per-file POSIX heatmaps, as read from a log
+    # generated with the HEATMAP_PER_FILE runtime setting
+    class MockReport:
+        file_heatmaps = {"POSIX": {}}
+
+    bins = {
+        # path: (rank, write_bins, read_bins)
+        "/tmp/a": [(0, [0, 10, 0], [0, 0, 5]), (1, [0, 10, 0], [0, 0, 0])],
+        "/tmp/b": [(0, [0, 0, 40], [0, 0, 0])],
+        "/tmp/c": [(1, [1, 1, 1], [2, 2, 2])],
+    }
+    report = MockReport()
+    for path, recs in bins.items():
+        heatmap = Heatmap("POSIX")
+        for rank, write_bins, read_bins in recs:
+            heatmap.add_record({"id": 1, "rank": rank, "nbins": 3,
+                                "bin_width_seconds": 0.5,
+                                "write_bins": np.array(write_bins),
+                                "read_bins": np.array(read_bins)})
+        report.file_heatmaps["POSIX"][path] = heatmap
+    return report
+
+
+@pytest.mark.parametrize(
+    "ops, top_n, expected_files, expected_data",
+    [
+        (
+            ["read", "write"],
+            None,
+            ["/tmp/b", "/tmp/a", "/tmp/c"],
+            [[0, 0, 40], [0, 20, 5], [3, 3, 3]],
+        ),
+        (["write"], 2, ["/tmp/b", "/tmp/a"], [[0, 0, 40], [0, 20, 0]]),
+        (["read"], 1, ["/tmp/a"], [[0, 0, 5]]),
+    ],
+)
+def test_get_file_heatmap_df(file_heatmap_report, ops, top_n,
+                             expected_files, expected_data):
+    # per-file heatmaps are summed over ranks and sorted by peak bin
+    actual = heatmap_handling.get_file_heatmap_df(
+        report=file_heatmap_report, mod="POSIX", ops=ops, top_n=top_n
+    )
+    assert list(actual.index) == expected_files
+    assert_array_equal(actual.values, expected_data)
+    assert actual.columns[-1].right == 1.5
+
+
+def test_get_file_heatmap_df_no_data(file_heatmap_report):
+    with pytest.raises(ValueError, match="No per-file heatmaps"):
+        heatmap_handling.get_file_heatmap_df(
+            report=file_heatmap_report, mod="MPIIO"
+        )
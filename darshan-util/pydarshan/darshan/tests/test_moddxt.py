@@ -1,6 +1,8 @@
 import os
 
 import pytest
+import numpy as np
+import pandas as pd
 import darshan.backend.cffi_backend as backend
 from darshan.log_utils import get_log_path
 
@@ -37,3 +39,37 @@ def test_dxt_records(logfile, mod, expected_dict):
     log = backend.log_open(logfile)
     rec = backend.log_get_record(log, mod)
     assert rec == expected_dict
+
+
+@pytest.mark.parametrize("logfile, mod", [
+    ("sample-dxt-simple.darshan", "DXT_POSIX"),
+    ("sample-dxt-simple.darshan", "DXT_MPIIO"),
+    ("dxt.darshan", "DXT_POSIX"),
+    ])
+def test_dxt_records_vectorized(logfile, mod):
+    # the structured array and DataFrame segments must
+    # hold the same values as the per-segment dictionaries
+    logfile = get_log_path(logfile)
+    recs = {}
+    for dtype in ["dict", "structured", "pandas"]:
+        log = backend.log_open(logfile)
+        recs[dtype] = []
+        rec = backend.log_get_record(log, mod, dtype=dtype)
+        while rec is not None:
+            recs[dtype].append(rec)
+            rec = backend.log_get_record(log, mod, dtype=dtype)
+        backend.log_close(log)
+
+    assert len(recs["dict"]) > 0
+    for drec, nrec, prec in zip(recs["dict"], recs["structured"], recs["pandas"]):
+        for key in ["id", "rank", "hostname", "write_count", "read_count"]:
+            assert drec[key] == nrec[key] == prec[key]
+        for seg_key in ["write_segments", "read_segments"]:
+            segs = nrec[seg_key]
+            assert isinstance(segs, np.ndarray)
+            assert isinstance(prec[seg_key], pd.DataFrame)
+            assert len(segs) == len(prec[seg_key]) == len(drec[seg_key])
+            for field in segs.dtype.names:
+                expected = [seg[field] for seg in drec[seg_key]]
+                np.testing.assert_array_equal(segs[field], expected)
+                np.testing.assert_array_equal(prec[seg_key][field], expected)
@@ -11,6 +11,7 @@
 
 static MunitResult inject_shared_file_records(const MunitParameter params[], void* data);
 static MunitResult inject_unique_file_records(const MunitParameter params[], void* data);
+static MunitResult inject_part_shared_file_records(const MunitParameter params[], void* data);
 static void* test_context_setup(const MunitParameter params[], void* user_data);
 static void test_context_tear_down(void *data);
 
@@ -28,6 +29,12 @@ static char* module_name_params[] = {"POSIX", "STDIO", "MPI-IO", NULL};
 static MunitParameterEnum test_params[]
     = {{"module_name", module_name_params}, {NULL, NULL}};
 
+/* only these modules reduce records over a subset of ranks */
+static char* part_shared_module_name_params[] = {"POSIX", "MPI-IO", NULL};
+
+static MunitParameterEnum part_shared_test_params[]
+    = {{"module_name", part_shared_module_name_params}, {NULL, NULL}};
+
 static MunitTest tests[]
     = {{"/inject-shared-file-records", inject_shared_file_records,
         test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
@@ -35,6 +42,9 @@ static MunitTest tests[]
        {"/inject-unique-file-records", inject_unique_file_records,
         test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
         test_params},
+       {"/inject-part-shared-file-records", inject_part_shared_file_records,
+        test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
+        part_shared_test_params},
        {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
 
 static const MunitSuite test_suite = {
@@ -237,6 +247,82 @@ static MunitResult inject_unique_file_records(const MunitParameter params[], voi
     return MUNIT_OK;
 }
 
+/* test accumulating data on partially shared files (records that were
+ * already reduced over a subset of ranks, marked with rank = -N)
+ */
+static MunitResult inject_part_shared_file_records(const MunitParameter params[], void* data)
+{
+    struct test_context* ctx = (struct test_context*)data;
+    int ret;
+    darshan_accumulator acc;
+    struct darshan_derived_metrics metrics;
+    void* record1;
+    void* record2;
+    void* record_agg;
+    struct darshan_base_record* base_rec;
+
+    record1 = malloc(DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record1);
+    record2 = malloc(DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record2);
+    record_agg = malloc(DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record_agg);
+
+    /* make sure we have a function defined to set example records */
+    munit_assert_not_null(set_dummy_fn[ctx->mod_id]);
+
+    /* create example records for two different files, each one already
+     * reduced over 2 of the 4 ranks in the job
+     */
+    set_dummy_fn[ctx->mod_id](record1);
+    set_dummy_fn[ctx->mod_id](record2);
+    base_rec = record1;
+    base_rec->rank = -2;
+    base_rec = record2;
+    base_rec->rank = -2;
+    base_rec->id++;
+    if(ctx->mod_id == DARSHAN_POSIX_MOD) {
+        ((struct darshan_posix_file*)record1)->fcounters[POSIX_F_SLOWEST_RANK_TIME] = 0.040990;
+        ((struct darshan_posix_file*)record2)->fcounters[POSIX_F_SLOWEST_RANK_TIME] = 0.030387;
+    }
+    else {
+        ((struct darshan_mpiio_file*)record1)->fcounters[MPIIO_F_SLOWEST_RANK_TIME] = 0.040990;
+        ((struct darshan_mpiio_file*)record2)->fcounters[MPIIO_F_SLOWEST_RANK_TIME] = 0.030387;
+    }
+
+    /**** partially shared file aggregation ****/
+
+    ret = darshan_accumulator_create(ctx->mod_id, 4, &acc);
+    munit_assert_int(ret, ==, 0);
+
+    /* inject two example records */
+    ret = darshan_accumulator_inject(acc, record1, 1);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_inject(acc, record2, 1);
+    munit_assert_int(ret, ==, 0);
+
+    /* emit results */
+    ret = darshan_accumulator_emit(acc, &metrics, record_agg);
+    munit_assert_int(ret, ==, 0);
+
+    /* both files are partially shared, not globally shared */
+    munit_assert_int64(metrics.category_counters[DARSHAN_PART_SHARED_FILES].count, ==, 2);
+    munit_assert_int64(metrics.category_counters[DARSHAN_SHARED_FILES].count, ==, 0);
+    munit_assert_double_equal(metrics.shared_io_total_time_by_slowest, 0, 6);
+
+    /* the partially shared files are not added up serially */
+    munit_assert_double_equal(metrics.part_shared_io_total_time_by_slowest, 0.040990, 6);
+    munit_assert_double_equal(metrics.agg_time_by_slowest, 0.040990, 6);
+
+    ret = darshan_accumulator_destroy(acc);
+    munit_assert_int(ret, ==, 0);
+
+    free(record1);
+    free(record2);
+    free(record_agg);
+
+    return MUNIT_OK;
+}
 
 int main(int argc, char **argv)
 {
@@ -10,8 +10,9 @@
 #define DARSHAN_HEATMAP_VER 1
 
 /* record structure for a Darshan heatmap.  These should be one per
- * API/category that registers heatmap data.  Each is variable size
- * according to the nbins field.
+ * API/category that registers heatmap data (named "heatmap:<API>"), plus
+ * optionally one per file (named "heatmap:<API>:<file name>").  Each is
+ * variable size according to the nbins field.
  */
 struct darshan_heatmap_record
 {
@@ -24,7 +24,7 @@
  * log format version, NOT when a new version of a module record is
  * introduced -- we have module-specific versions to handle that
  */
-#define DARSHAN_LOG_VERSION "3.41"
+#define DARSHAN_LOG_VERSION "3.42"
 
 /* magic number for validating output files and checking byte order */
 #define DARSHAN_MAGIC_NR 6567223
@@ -49,6 +49,7 @@ enum darshan_comp_type
     DARSHAN_ZLIB_COMP,
     DARSHAN_BZIP2_COMP,
     DARSHAN_NO_COMP,
+    DARSHAN_ZSTD_COMP,
 };
 
 typedef uint64_t darshan_record_id;
@@ -64,8 +65,69 @@ struct darshan_log_map
     uint64_t len;
 };
 
+/* the darshan_log_chunk structure describes an independently compressed
+ * chunk of data within a log region. 'region_id' is the module identifier
+ * for module data (-1 for the name record region), 'off' and 'len' are the
+ * offset and length of the chunk in the file (in compressed terms), and
+ * 'uncomp_len' is the length of the chunk once decompressed
+ */
+struct darshan_log_chunk
+{
+    int64_t region_id;
+    uint64_t off;
+    uint64_t len;
+    uint64_t uncomp_len;
+};
+
+/* the darshan_log_rec_index structure describes the data one process wrote
+ * to a module's log region, so that a reader can decompress just that data
+ * rather than the whole region. 'region_id' is the module identifier,
+ * 'rank' is the rank of the process that wrote the data, 'off' and 'len'
+ * are the offset and length of the data in the file (in compressed terms),
+ * and 'uncomp_len' is its length once decompressed. 'min_id' and 'max_id'
+ * bound the ids of the records it holds, and 'id_filter' is a bloom filter
+ * of those ids. Records of shared files (rank -1) are stored by rank 0.
+ */
+#define DARSHAN_REC_INDEX_FILTER_WORDS 4
+struct darshan_log_rec_index
+{
+    int64_t region_id;
+    int64_t rank;
+    uint64_t off;
+    uint64_t len;
+    uint64_t uncomp_len;
+    darshan_record_id min_id;
+    darshan_record_id max_id;
+    uint64_t id_filter[DARSHAN_REC_INDEX_FILTER_WORDS];
+};
+
+/* the low three bytes of a record id each select one bit of the
+ * 256-bit bloom filter in a darshan_log_rec_index
+ */
+#define DARSHAN_REC_INDEX_FILTER_BIT(__id, __k) (((__id) >> (8 * (__k))) & 0xFF)
+#define DARSHAN_REC_INDEX_FILTER_SET(__filter, __id) do { \
+    int __k, __bit; \
+    for(__k = 0; __k < 3; __k++) { \
+        __bit = DARSHAN_REC_INDEX_FILTER_BIT(__id, __k); \
+        (__filter)[__bit / 64] |= (1ULL << (__bit % 64)); \
+    } \
+} while(0)
+#define DARSHAN_REC_INDEX_FILTER_ISSET(__filter, __id, __k) \
+    (((__filter)[DARSHAN_REC_INDEX_FILTER_BIT(__id, __k) / 64] >> \
+      (DARSHAN_REC_INDEX_FILTER_BIT(__id, __k) % 64)) & 1)
+#define DARSHAN_REC_INDEX_FILTER_TEST(__filter, __id) \
+    (DARSHAN_REC_INDEX_FILTER_ISSET(__filter, __id, 0) && \
+     DARSHAN_REC_INDEX_FILTER_ISSET(__filter, __id, 1) && \
+     DARSHAN_REC_INDEX_FILTER_ISSET(__filter, __id, 2))
+
 /* the darshan header stores critical metadata needed for correctly
- * reading the contents of the corresponding Darshan log
+ * reading the contents of the corresponding Darshan log. 'chunk_map' and
+ * 'rec_index_map' locate optional (uncompressed) indexes of
+ * darshan_log_chunk and darshan_log_rec_index structures, sorted by region
+ * and offset, and have zero length if the log was written without them.
+ * 'name_enc' tells how the name records are encoded (one of the
+ * DARSHAN_NAME_ENC values below). These three fields are only present in
+ * logs of version 3.42 or later
  */
 struct darshan_header
 {
@@ -76,6 +138,9 @@ struct darshan_header
     struct darshan_log_map name_map;
     struct darshan_log_map mod_map[DARSHAN_MAX_MODS];
     uint32_t mod_ver[DARSHAN_MAX_MODS];
+    struct darshan_log_map chunk_map;
+    uint64_t name_enc;
+    struct darshan_log_map rec_index_map;
 };
 
 /* job-level metadata stored for this application */
@@ -99,6 +164,23 @@ struct darshan_name_record
     char name[1];
 };
 
+/* NOTE: as of log version 3.42, each process stores its name records in the
+ * log sorted by name and front coded. Each encoded record consists of the
+ * record id, the length of the prefix its name shares with the previous
+ * name written by the same process (one byte if less than 128, otherwise
+ * two bytes, big-endian, with the high bit of the first byte set), and the
+ * remaining suffix of the name, including its terminating null character.
+ * A name record is only stored once, by the lowest rank that opened it.
+ */
+#define DARSHAN_NAME_PREFIX_MAX 0x7FFF
+
+/* name record encodings: logs written at shutdown store front coded name
+ * records, while the logs the runtime's mmap log mechanism maintains in
+ * place store plain darshan_name_record structures as they are registered
+ */
+#define DARSHAN_NAME_ENC_PLAIN 0
+#define DARSHAN_NAME_ENC_FRONT_CODED 1
+
 /* base record definition that can be used by modules */
 struct darshan_base_record
 {
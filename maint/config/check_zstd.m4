@@ -0,0 +1,57 @@
+dnl @synopsis CHECK_ZSTD()
+dnl
+dnl This macro searches for an installed Zstandard (zstd) library. If
+dnl --with-zstd=DIR is specified, it will look for DIR/include/zstd.h and
+dnl DIR/lib/libzstd; otherwise the default compiler search paths are used.
+dnl If --without-zstd is specified, the library is not searched at all.
+dnl
+dnl zstd is optional: if either the header or the library is not found, a
+dnl warning is printed and Darshan is built without zstd support. The macro
+dnl defines the symbol HAVE_LIBZSTD and substitutes LIBZSTD if the library
+dnl is found.
+
+AC_DEFUN([CHECK_ZSTD],
+[
+AC_ARG_WITH(zstd,
+[  --with-zstd=DIR root directory path of zstd installation [defaults to
+                    compiler search paths]
+  --without-zstd to disable zstd usage completely],
+[if test "$withval" != no ; then
+  if test -d "$withval"
+  then
+    ZSTD_HOME="$withval"
+  elif test "$withval" != yes ; then
+    AC_MSG_WARN([Sorry, $withval does not exist, checking usual places])
+  fi
+else
+  DISABLE_ZSTD=1
+fi])
+
+if test -z "${DISABLE_ZSTD}"
+then
+        ZSTD_OLD_LDFLAGS=$LDFLAGS
+        ZSTD_OLD_CPPFLAGS=$CPPFLAGS
+        if test -n "${ZSTD_HOME}"
+        then
+            LDFLAGS="$LDFLAGS -L${ZSTD_HOME}/lib"
+            CPPFLAGS="$CPPFLAGS -I${ZSTD_HOME}/include"
+        fi
+        AC_CHECK_LIB(zstd, ZSTD_compressStream2, [zstd_cv_libzstd=yes], [zstd_cv_libzstd=no])
+        AC_CHECK_HEADER(zstd.h, [zstd_cv_zstd_h=yes], [zstd_cv_zstd_h=no])
+        if test "$zstd_cv_libzstd" = "yes" -a "$zstd_cv_zstd_h" = "yes"
+        then
+                AC_DEFINE(HAVE_LIBZSTD, 1, [Define if zstd library is available])
+                LIBZSTD=-lzstd
+                if test -n "${ZSTD_HOME}"
+                then
+                    LIBZSTD="-L${ZSTD_HOME}/lib -lzstd"
+                fi
+                LIBS="$LIBS -lzstd"
+        else
+                LDFLAGS="$ZSTD_OLD_LDFLAGS"
+                CPPFLAGS="$ZSTD_OLD_CPPFLAGS"
+                AC_MSG_WARN(libzstd not found; Darshan will be built without zstd compression support.)
+        fi
+fi
+AC_SUBST(LIBZSTD)
+])